@@ -0,0 +1,4 @@
+TEMPLATE = app
+
+SOURCES += main.cpp
+
@@ -5,10 +5,12 @@ TEMPLATE = app
 
 SOURCES += main.cpp \
     mainwindow.cpp \
-    connectdialog.cpp
+    connectdialog.cpp \
+    receivedframesmodel.cpp
 
 HEADERS += mainwindow.h \
-    connectdialog.h
+    connectdialog.h \
+    receivedframesmodel.h
 
 FORMS   += mainwindow.ui \
     connectdialog.ui
@@ -41,16 +41,24 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "connectdialog.h"
+#include "receivedframesmodel.h"
 
 #include <QCanBusFrame>
 #include <QCanBus>
 #include <QCloseEvent>
+#include <QHeaderView>
+#include <QScrollBar>
 #include <QTimer>
 
 #include <QtCore/qbytearray.h>
 #include <QtCore/qvariant.h>
 #include <QtCore/qdebug.h>
 
+// Number of received frames kept for display.
+static const int MaximumHistory = 100000;
+// The view is updated at most this often, independent of the bus load.
+static const int UpdateIntervalMs = 1000 / 30;
+
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
     m_ui(new Ui::MainWindow),
@@ -62,6 +70,24 @@ MainWindow::MainWindow(QWidget *parent) :
 
     m_status = new QLabel;
     m_ui->statusBar->addWidget(m_status);
+    m_statistics = new QLabel;
+    m_ui->statusBar->addPermanentWidget(m_statistics);
+
+    m_receivedFrames = new ReceivedFramesModel(MaximumHistory, this);
+    m_ui->receivedMessagesView->setModel(m_receivedFrames);
+
+    // With a fixed row height the view never has to measure rows, which keeps
+    // scrolling and row insertion cheap even with a full history.
+    QHeaderView *rows = m_ui->receivedMessagesView->verticalHeader();
+    rows->setSectionResizeMode(QHeaderView::Fixed);
+    rows->setDefaultSectionSize(fontMetrics().height() + 4);
+    rows->hide();
+    m_ui->receivedMessagesView->horizontalHeader()->setStretchLastSection(true);
+
+    m_updateTimer = new QTimer(this);
+    m_updateTimer->setInterval(UpdateIntervalMs);
+    connect(m_updateTimer, &QTimer::timeout, this, &MainWindow::updateView);
+    resetStatistics();
 
     m_ui->sendMessagesBox->setEnabled(false);
 
@@ -124,9 +150,9 @@ void MainWindow::connectDevice()
     connect(m_canDevice, &QCanBusDevice::errorOccurred,
             this, &MainWindow::receiveError);
     connect(m_canDevice, &QCanBusDevice::framesReceived,
-            this, &MainWindow::checkMessages);
+            this, &MainWindow::processReceivedFrames);
     connect(m_canDevice, &QCanBusDevice::framesWritten,
-            this, &MainWindow::framesWritten);
+            this, &MainWindow::processFramesWritten);
 
     if (p.useConfigurationEnabled) {
         foreach (const ConnectDialog::ConfigurationItem &item, p.configurations)
@@ -144,6 +170,9 @@ void MainWindow::connectDevice()
 
         m_ui->sendMessagesBox->setEnabled(true);
 
+        resetStatistics();
+        m_updateTimer->start();
+
         QVariant bitRate = m_canDevice->configurationParameter(QCanBusDevice::BitRateKey);
         if (bitRate.isValid()) {
             showStatusMessage(tr("Backend: %1, connected to %2 at %3 kBit/s")
@@ -165,6 +194,9 @@ void MainWindow::disconnectDevice()
     delete m_canDevice;
     m_canDevice = nullptr;
 
+    m_updateTimer->stop();
+    updateView();
+
     m_ui->actionConnect->setEnabled(true);
     m_ui->actionDisconnect->setEnabled(false);
 
@@ -173,9 +205,9 @@ void MainWindow::disconnectDevice()
     showStatusMessage(tr("Disconnected"));
 }
 
-void MainWindow::framesWritten(qint64 count)
+void MainWindow::processFramesWritten(qint64 count)
 {
-    qDebug() << "Number of frames written:" << count;
+    m_numberFramesWritten += count;
 }
 
 void MainWindow::closeEvent(QCloseEvent *event)
@@ -184,52 +216,61 @@ void MainWindow::closeEvent(QCloseEvent *event)
     event->accept();
 }
 
-static QByteArray dataToHex(const QByteArray &data)
-{
-    QByteArray result = data.toHex().toUpper();
-
-    for (int i = 0; i < result.size(); i += 3)
-        result.insert(i, ' ');
-
-    return result;
-}
-
-void MainWindow::checkMessages()
+void MainWindow::processReceivedFrames()
 {
     if (!m_canDevice)
         return;
 
-    const QCanBusFrame frame = m_canDevice->readFrame();
-
-    const qint8 dataLength = frame.payload().size();
-
-    const qint32 id = frame.frameId();
-
-    QString view;
-    if (frame.frameType() == QCanBusFrame::ErrorFrame) {
-        interpretError(view, frame);
-    } else {
-        const char *format =
-                frame.hasExtendedFrameFormat() ? "Id: %08X" : "Id:      %03X";
-        view += QString::asprintf(format, static_cast<uint>(id));
-        view += QLatin1String(" bytes: ");
-        view += QString::number(dataLength, 10);
-        if (frame.frameType() != QCanBusFrame::RemoteRequestFrame) {
-            view += QLatin1String(" data: ");
-            view += dataToHex(frame.payload());
+    // Take everything that arrived in one go. The frames are only collected
+    // here; the view is updated by updateView() at a fixed rate.
+    const QVector<QCanBusFrame> frames = m_canDevice->readAllFrames();
+    m_numberFramesReceived += frames.size();
+
+    for (const QCanBusFrame &frame : frames) {
+        if (frame.frameType() == QCanBusFrame::ErrorFrame) {
+            QString view;
+            interpretError(view, frame);
+            m_ui->errorList->addItem(view);
+            m_ui->errorList->scrollToBottom();
+        } else {
+            m_receivedFrames->appendFrame(frame);
         }
     }
+}
 
-    if (frame.frameType() == QCanBusFrame::RemoteRequestFrame) {
-        m_ui->requestList->addItem(view);
-        m_ui->requestList->scrollToBottom();
-    } else if (frame.frameType() == QCanBusFrame::ErrorFrame) {
-        m_ui->errorList->addItem(view);
-        m_ui->errorList->scrollToBottom();
-    } else {
-        m_ui->receiveList->addItem(view);
-        m_ui->receiveList->scrollToBottom();
+void MainWindow::updateView()
+{
+    QScrollBar *scrollBar = m_ui->receivedMessagesView->verticalScrollBar();
+    const bool followTail = scrollBar->value() == scrollBar->maximum();
+
+    m_receivedFrames->commitPendingFrames();
+    if (followTail)
+        m_ui->receivedMessagesView->scrollToBottom();
+
+    const qint64 elapsed = m_rateClock.elapsed();
+    if (elapsed >= 1000) {
+        m_receiveRate = (m_numberFramesReceived - m_framesAtLastRateUpdate) * 1000. / elapsed;
+        m_framesAtLastRateUpdate = m_numberFramesReceived;
+        m_rateClock.restart();
     }
+
+    m_statistics->setText(tr("Received: %1 (%2 frames/s), written: %3, not displayed: %4")
+                          .arg(m_numberFramesReceived)
+                          .arg(m_receiveRate, 0, 'f', 0)
+                          .arg(m_numberFramesWritten)
+                          .arg(m_receivedFrames->droppedFrames()));
+}
+
+void MainWindow::resetStatistics()
+{
+    m_receivedFrames->clear();
+    m_ui->errorList->clear();
+    m_numberFramesReceived = 0;
+    m_numberFramesWritten = 0;
+    m_framesAtLastRateUpdate = 0;
+    m_receiveRate = 0.;
+    m_rateClock.start();
+    updateView();
 }
 
 static QByteArray dataFromHex(const QString &hex)
@@ -43,14 +43,17 @@
 
 #include <QCanBusDevice> // for CanBusError
 
+#include <QElapsedTimer>
 #include <QMainWindow>
 
 class ConnectDialog;
+class ReceivedFramesModel;
 
 QT_BEGIN_NAMESPACE
 
 class QCanBusFrame;
 class QLabel;
+class QTimer;
 
 namespace Ui {
 class MainWindow;
@@ -67,12 +70,13 @@ public:
     ~MainWindow();
 
 private Q_SLOTS:
-    void checkMessages();
+    void processReceivedFrames();
     void sendMessage() const;
     void receiveError(QCanBusDevice::CanBusError) const;
     void connectDevice();
     void disconnectDevice();
-    void framesWritten(qint64);
+    void processFramesWritten(qint64);
+    void updateView();
 
 protected:
     void closeEvent(QCloseEvent *event);
@@ -81,11 +85,21 @@ private:
     void showStatusMessage(const QString &message);
     void initActionsConnections();
     void interpretError(QString &, const QCanBusFrame &);
+    void resetStatistics();
 
     Ui::MainWindow *m_ui;
     QLabel *m_status;
+    QLabel *m_statistics;
     ConnectDialog *m_connectDialog;
     QCanBusDevice *m_canDevice;
+    ReceivedFramesModel *m_receivedFrames;
+    QTimer *m_updateTimer;
+
+    qint64 m_numberFramesReceived = 0;
+    qint64 m_numberFramesWritten = 0;
+    qint64 m_framesAtLastRateUpdate = 0;
+    double m_receiveRate = 0.;
+    QElapsedTimer m_rateClock;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,211 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the examples of the QtSerialBus module.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of The Qt Company Ltd nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "receivedframesmodel.h"
+
+/*
+    Keeps the last capacity() received frames in a ring buffer.
+
+    Frames are collected with appendFrame() without notifying any view.
+    commitPendingFrames() publishes them in one beginInsertRows() call and
+    drops the oldest rows in one beginRemoveRows() call, so a view has to
+    relayout at most once per commit, no matter how many frames arrived.
+
+    If more frames arrive between two commits than fit into the model, only
+    the newest ones are kept and the others are counted as dropped.
+*/
+
+ReceivedFramesModel::ReceivedFramesModel(int capacity, QObject *parent) :
+    QAbstractTableModel(parent),
+    m_capacity(qMax(1, capacity)),
+    m_frames(m_capacity)
+{
+}
+
+int ReceivedFramesModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_count;
+}
+
+int ReceivedFramesModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+static QString dataToHex(const QByteArray &data)
+{
+    static const char digits[] = "0123456789ABCDEF";
+
+    QString result(data.size() * 3 - (data.isEmpty() ? 0 : 1), QLatin1Char(' '));
+    QChar *out = result.data();
+    for (int i = 0; i < data.size(); ++i) {
+        const uchar byte = uchar(data.at(i));
+        out[i * 3] = QLatin1Char(digits[byte >> 4]);
+        out[i * 3 + 1] = QLatin1Char(digits[byte & 0x0f]);
+    }
+    return result;
+}
+
+static QString frameFlags(const QCanBusFrame &frame)
+{
+    QString result;
+    if (frame.frameType() == QCanBusFrame::RemoteRequestFrame)
+        result += QLatin1String("RTR ");
+    if (frame.hasExtendedFrameFormat())
+        result += QLatin1String("EFF ");
+    if (frame.hasCanXlFormat())
+        result += QLatin1String("XL ");
+    else if (frame.payload().size() > 8)
+        result += QLatin1String("FD ");
+    result.chop(1);
+    return result;
+}
+
+QVariant ReceivedFramesModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_count)
+        return QVariant();
+
+    // Only the visible rows are ever formatted, the model keeps the plain frames.
+    if (role == Qt::TextAlignmentRole) {
+        if (index.column() == DataColumn || index.column() == FlagsColumn)
+            return int(Qt::AlignLeft | Qt::AlignVCenter);
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    }
+
+    if (role != Qt::DisplayRole)
+        return QVariant();
+
+    const QCanBusFrame &frame = frameAt(index.row());
+    switch (index.column()) {
+    case TimeStampColumn: {
+        const QCanBusFrame::TimeStamp stamp = frame.timeStamp();
+        return QString::asprintf("%lld.%06lld", stamp.seconds(), stamp.microSeconds());
+    }
+    case FlagsColumn:
+        return frameFlags(frame);
+    case IdColumn:
+        return QString::asprintf(frame.hasExtendedFrameFormat() ? "%08X" : "%03X",
+                                 static_cast<uint>(frame.frameId()));
+    case LengthColumn:
+        return frame.payload().size();
+    case DataColumn:
+        if (frame.frameType() == QCanBusFrame::RemoteRequestFrame)
+            return QString();
+        return dataToHex(frame.payload());
+    default:
+        break;
+    }
+    return QVariant();
+}
+
+QVariant ReceivedFramesModel::headerData(int section, Qt::Orientation orientation,
+                                         int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal)
+        return QVariant();
+
+    switch (section) {
+    case TimeStampColumn:
+        return tr("Timestamp");
+    case FlagsColumn:
+        return tr("Flags");
+    case IdColumn:
+        return tr("CAN-ID");
+    case LengthColumn:
+        return tr("DLC");
+    case DataColumn:
+        return tr("Data");
+    default:
+        break;
+    }
+    return QVariant();
+}
+
+void ReceivedFramesModel::appendFrame(const QCanBusFrame &frame)
+{
+    // Anything beyond one model full of frames would be removed again on commit.
+    if (m_pendingFrames.size() == m_capacity) {
+        const int drop = m_capacity / 4 + 1;
+        m_pendingFrames.remove(0, drop);
+        m_droppedFrames += drop;
+    }
+    m_pendingFrames.append(frame);
+}
+
+void ReceivedFramesModel::commitPendingFrames()
+{
+    const int pending = m_pendingFrames.size();
+    if (pending == 0)
+        return;
+
+    const int overflow = m_count + pending - m_capacity;
+    if (overflow > 0) {
+        beginRemoveRows(QModelIndex(), 0, overflow - 1);
+        m_first = (m_first + overflow) % m_capacity;
+        m_count -= overflow;
+        endRemoveRows();
+    }
+
+    beginInsertRows(QModelIndex(), m_count, m_count + pending - 1);
+    const QVector<QCanBusFrame> &frames = m_pendingFrames;
+    for (const QCanBusFrame &frame : frames)
+        m_frames[(m_first + m_count++) % m_capacity] = frame;
+    endInsertRows();
+
+    // keeps the allocation for the next batch
+    m_pendingFrames.resize(0);
+}
+
+void ReceivedFramesModel::clear()
+{
+    beginResetModel();
+    m_frames.fill(QCanBusFrame());
+    m_first = 0;
+    m_count = 0;
+    m_pendingFrames.clear();
+    m_droppedFrames = 0;
+    endResetModel();
+}
+
+const QCanBusFrame &ReceivedFramesModel::frameAt(int row) const
+{
+    return m_frames.at((m_first + row) % m_capacity);
+}
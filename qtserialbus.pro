@@ -8,6 +8,7 @@ load(configure)
 qtCompileTest(language)
 qtCompileTest(socketcan)
 qtCompileTest(socketcan_fd)
+qtCompileTest(sdt)
 load(qt_parts)
 
 requires(config_language) # enforce defined set of C++11
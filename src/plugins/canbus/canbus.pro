@@ -4,4 +4,4 @@ config_socketcan {
     SUBDIRS += socketcan
 }
 
-SUBDIRS += peakcan tinycan
+SUBDIRS += peakcan tinycan slcan
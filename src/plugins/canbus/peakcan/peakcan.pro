@@ -1,6 +1,8 @@
 TARGET = qtpeakcanbus
 
-QT = core-private serialbus
+QT = core-private serialbus-private
+
+config_sdt: DEFINES += QT_SERIALBUS_TRACE_USDT
 
 PUBLIC_HEADERS += \
     peakcanbackend.h
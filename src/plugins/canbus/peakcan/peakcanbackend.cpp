@@ -40,6 +40,8 @@
 #include "peakcan_symbols_p.h"
 
 #include <QtSerialBus/qcanbusdevice.h>
+#include <QtSerialBus/private/qserialbusflightrecorder_p.h>
+#include <QtSerialBus/private/qserialbustrace_p.h>
 
 #include <QtCore/qtimer.h>
 #include <QtCore/qcoreevent.h>
@@ -248,6 +250,8 @@ bool PeakCanBackendPrivate::setConfigurationParameter(int key, const QVariant &v
     switch (key) {
     case QCanBusDevice::BitRateKey:
         return verifyBitRate(value.toInt());
+    case QCanBusDevice::TimeStampNormalizationKey:
+        return true; // applied by QCanBusDevice
     default:
         q->setError(PeakCanBackend::tr("Unsupported configuration key: %1").arg(key),
                     QCanBusDevice::ConfigurationError);
@@ -357,10 +361,13 @@ void PeakCanBackendPrivate::canWriteNotification()
         ::memcpy(message.DATA, payload.constData(), sizeof(message.DATA));
 
     const TPCANStatus st = ::CAN_Write(channelIndex, &message);
-    if (st != PCAN_ERROR_OK)
+    if (st != PCAN_ERROR_OK) {
         q->setError(systemErrorString(st), QCanBusDevice::WriteError);
-    else
+    } else {
+        Q_SERIALBUS_TRACE_FRAME(CanFrameWritten, frame);
+        qt_serialbus_record_frame(q, frame, true);
         emit q->framesWritten(qint64(1));
+    }
 
     if (q->hasOutgoingFrames())
         enableWriteNotification(true);
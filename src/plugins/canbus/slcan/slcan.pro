@@ -0,0 +1,20 @@
+TARGET = qtslcanbus
+
+QT = core-private serialbus-private serialport
+
+config_sdt: DEFINES += QT_SERIALBUS_TRACE_USDT
+
+HEADERS += \
+    slcanbackend.h \
+    slcancodec.h
+
+SOURCES += main.cpp \
+    slcanbackend.cpp \
+    slcancodec.cpp
+
+OTHER_FILES = plugin.json
+
+PLUGIN_TYPE = canbus
+PLUGIN_EXTENDS = serialbus
+PLUGIN_CLASS_NAME = SlcanBusPlugin
+load(qt_plugin)
@@ -0,0 +1,372 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "slcanbackend.h"
+#include "slcancodec.h"
+
+#include <QtSerialBus/private/qserialbusflightrecorder_p.h>
+#include <QtSerialBus/private/qserialbustrace_p.h>
+
+#include <QtCore/qtimer.h>
+#include <QtCore/qvector.h>
+
+#include <chrono>
+
+QT_BEGIN_NAMESPACE
+
+enum {
+    DefaultSerialBaudRate = 115200,
+    InitialBufferSize = 4096
+};
+
+static inline bool isFrameLine(char command)
+{
+    switch (command) {
+    case 't': case 'T':
+    case 'r': case 'R':
+    case 'd': case 'D':
+    case 'b': case 'B':
+        return true;
+    default:
+        return false;
+    }
+}
+
+SlcanBackend::SlcanBackend(const QString &name, QObject *parent) :
+    QCanBusDevice(parent),
+    serialPort(new QSerialPort(this)),
+    portName(name),
+    canFdOptionEnabled(false),
+    transmitFrames(0),
+    flushScheduled(false),
+    framesSent(0),
+    framesAnswered(0)
+{
+    // reserved capacity survives resize(0), so the buffers are allocated once
+    receiveBuffer.reserve(InitialBufferSize);
+    transmitBuffer.reserve(InitialBufferSize);
+
+    connect(serialPort, &QSerialPort::readyRead, this, &SlcanBackend::readSerialPort);
+    using TypeId = void (QSerialPort::*)(QSerialPort::SerialPortError);
+    connect(serialPort, static_cast<TypeId>(&QSerialPort::error),
+            this, &SlcanBackend::handleSerialPortError);
+
+    QCanBusDevice::setConfigurationParameter(QCanBusDevice::CanFdKey, false);
+    QCanBusDevice::setConfigurationParameter(SerialBaudRateKey, int(DefaultSerialBaudRate));
+}
+
+SlcanBackend::~SlcanBackend()
+{
+    close();
+}
+
+bool SlcanBackend::open()
+{
+    if (!serialPort->isOpen()) {
+        serialPort->setPortName(portName);
+        serialPort->setBaudRate(configurationParameter(SerialBaudRateKey).toInt());
+        serialPort->setDataBits(QSerialPort::Data8);
+        serialPort->setParity(QSerialPort::NoParity);
+        serialPort->setStopBits(QSerialPort::OneStop);
+        serialPort->setFlowControl(QSerialPort::NoFlowControl);
+        if (!serialPort->open(QIODevice::ReadWrite)) {
+            setError(serialPort->errorString(), QCanBusDevice::CanBusError::ConnectionError);
+            close(); // sets UnconnectedState
+            return false;
+        }
+    }
+
+    receiveBuffer.resize(0);
+    transmitBuffer.resize(0);
+    transmitFrames = 0;
+    framesSent = 0;
+    framesAnswered = 0;
+    pendingCommands.clear();
+
+    // The channel may still be open from a previous session, and the bit
+    // rate can only be set while it is closed.
+    const QByteArray bitRate =
+            SlcanCodec::bitRateCommand(configurationParameter(QCanBusDevice::BitRateKey).toInt());
+    sendCommands(QByteArrayLiteral("C\r") + bitRate + QByteArrayLiteral("O\r"),
+                 bitRate.isEmpty() ? QByteArrayLiteral("CO") : QByteArrayLiteral("CSO"));
+
+    setState(QCanBusDevice::ConnectedState);
+    return true;
+}
+
+void SlcanBackend::close()
+{
+    if (serialPort->isOpen()) {
+        // an unplugged adapter cannot be told anything anymore
+        if (serialPort->error() != QSerialPort::ResourceError) {
+            flushTransmitBuffer();
+            serialPort->write("C\r", 2);
+            serialPort->flush();
+        }
+        serialPort->close();
+    }
+
+    receiveBuffer.resize(0);
+    transmitBuffer.resize(0);
+    transmitFrames = 0;
+    framesSent = 0;
+    framesAnswered = 0;
+    pendingCommands.clear();
+
+    setState(QCanBusDevice::UnconnectedState);
+}
+
+void SlcanBackend::setConfigurationParameter(int key, const QVariant &value)
+{
+    switch (key) {
+    case QCanBusDevice::BitRateKey:
+        if (SlcanCodec::bitRateCommand(value.toInt()).isEmpty()) {
+            setError(tr("Unsupported bitrate value"),
+                     QCanBusDevice::CanBusError::ConfigurationError);
+            return;
+        }
+        break;
+    case SerialBaudRateKey:
+        if (value.toInt() <= 0) {
+            setError(tr("Invalid serial baud rate"),
+                     QCanBusDevice::CanBusError::ConfigurationError);
+            return;
+        }
+        break;
+    case QCanBusDevice::CanFdKey:
+    case QCanBusDevice::TimeStampNormalizationKey:
+        break;
+    default:
+        setError(tr("SlcanBackend: No such configuration as %1 in SlcanBackend").arg(key),
+                 QCanBusDevice::CanBusError::ConfigurationError);
+        return;
+    }
+
+    QCanBusDevice::setConfigurationParameter(key, value);
+
+    if (key == QCanBusDevice::CanFdKey)
+        canFdOptionEnabled = value.toBool();
+
+    if (state() != QCanBusDevice::ConnectedState)
+        return;
+
+    if (key == QCanBusDevice::BitRateKey) {
+        sendCommands(QByteArrayLiteral("C\r") + SlcanCodec::bitRateCommand(value.toInt())
+                     + QByteArrayLiteral("O\r"), QByteArrayLiteral("CSO"));
+    } else if (key == SerialBaudRateKey) {
+        serialPort->setBaudRate(value.toInt());
+    }
+}
+
+bool SlcanBackend::writeFrame(const QCanBusFrame &newData)
+{
+    if (state() != QCanBusDevice::ConnectedState)
+        return false;
+
+    if (!newData.isValid()) {
+        setError(tr("Cannot write invalid QCanBusFrame"), QCanBusDevice::WriteError);
+        return false;
+    }
+
+    if (newData.payload().size() > 8 && !canFdOptionEnabled) {
+        setError(tr("Sending CAN FD frame although CAN FD option not enabled."),
+                 QCanBusDevice::WriteError);
+        return false;
+    }
+
+    if (!SlcanCodec::encodeFrame(newData, &transmitBuffer)) {
+        setError(tr("The frame type cannot be sent by SLCAN adapters."),
+                 QCanBusDevice::WriteError);
+        return false;
+    }
+    ++transmitFrames;
+
+    Q_SERIALBUS_TRACE_FRAME(CanFrameWritten, newData);
+    qt_serialbus_record_frame(this, newData, true);
+
+    // frames written in one go are sent to the serial port in one write
+    if (!flushScheduled) {
+        flushScheduled = true;
+        QTimer::singleShot(0, this, &SlcanBackend::flushTransmitBuffer);
+    }
+    return true;
+}
+
+QString SlcanBackend::interpretErrorFrame(const QCanBusFrame &errorFrame)
+{
+    Q_UNUSED(errorFrame);
+
+    // SLCAN adapters do not report error frames
+    return QString();
+}
+
+void SlcanBackend::readSerialPort()
+{
+    const qint64 available = serialPort->bytesAvailable();
+    if (available <= 0)
+        return;
+
+    // read behind the incomplete line left by the last read
+    const int kept = receiveBuffer.size();
+    receiveBuffer.resize(kept + int(available));
+    const qint64 bytesRead = serialPort->read(receiveBuffer.data() + kept, available);
+    receiveBuffer.resize(kept + int(qMax<qint64>(bytesRead, 0)));
+
+    // The frames of one read arrived within a few milliseconds; they share
+    // the time stamp instead of reading the clock for each of them.
+    const qint64 now = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+    const QCanBusFrame::TimeStamp stamp(now / 1000000, now % 1000000);
+
+    QVector<QCanBusFrame> newFrames;
+    const char *data = receiveBuffer.constData();
+    const int size = receiveBuffer.size();
+    int lineStart = 0;
+    for (int i = 0; i < size; ++i) {
+        const char c = data[i];
+        if (c != '\r' && c != '\a')
+            continue;
+
+        const char *line = data + lineStart;
+        const int length = i - lineStart;
+        lineStart = i + 1;
+
+        QCanBusFrame frame;
+        if (c == '\a') {
+            handleReply(false);
+        } else if (length == 0) {
+            handleReply(true);
+        } else if (length == 1 && (line[0] == 'z' || line[0] == 'Z')) {
+            ++framesAnswered;
+        } else if (SlcanCodec::decodeFrame(line, length, &frame)) {
+            frame.setTimeStamp(stamp);
+            newFrames.append(frame);
+        } else if (isFrameLine(line[0])) {
+            setError(tr("ERROR SlcanBackend: invalid SLCAN frame"),
+                     QCanBusDevice::CanBusError::ReadError);
+        }
+        // anything else answers a command sent by someone else, e.g. V for the version
+
+        // a rejected command or an error slot may have closed the device
+        if (!serialPort->isOpen())
+            return;
+    }
+    receiveBuffer.remove(0, lineStart);
+
+    // a line can never be that long, the port does not speak SLCAN
+    if (receiveBuffer.size() > SlcanCodec::MaximumLineLength) {
+        receiveBuffer.resize(0);
+        setError(tr("ERROR SlcanBackend: invalid SLCAN frame"),
+                 QCanBusDevice::CanBusError::ReadError);
+    }
+
+    enqueueReceivedFrames(newFrames);
+}
+
+void SlcanBackend::flushTransmitBuffer()
+{
+    flushScheduled = false;
+    if (transmitBuffer.isEmpty() || !serialPort->isOpen())
+        return;
+
+    const qint64 frames = transmitFrames;
+    const qint64 bytesWritten = serialPort->write(transmitBuffer);
+    const bool complete = (bytesWritten == transmitBuffer.size());
+    transmitBuffer.resize(0);
+    transmitFrames = 0;
+
+    if (!complete) {
+        setError(serialPort->errorString(), QCanBusDevice::CanBusError::WriteError);
+        return;
+    }
+    framesSent += quint64(frames);
+    emit framesWritten(frames);
+}
+
+void SlcanBackend::sendCommands(const QByteArray &commands, const QByteArray &replies)
+{
+    // keep the order of commands and frames written before
+    flushTransmitBuffer();
+    for (char command : replies)
+        pendingCommands.append(PendingCommand { command, framesSent });
+    serialPort->write(commands);
+}
+
+void SlcanBackend::handleReply(bool accepted)
+{
+    // The adapter answers in order: frames sent before the oldest pending
+    // command still owe their z/Z or BEL, so a BEL belongs to one of them.
+    if (pendingCommands.isEmpty()
+            || (!accepted && framesAnswered < pendingCommands.first().framesBefore)) {
+        if (!accepted) {
+            ++framesAnswered;
+            setError(tr("The adapter did not accept a frame."),
+                     QCanBusDevice::CanBusError::WriteError);
+        }
+        return;
+    }
+
+    const PendingCommand command = pendingCommands.takeFirst();
+    // adapters not acknowledging frames catch up here
+    framesAnswered = qMax(framesAnswered, command.framesBefore);
+    if (!accepted && command.command != 'C') {
+        setError(tr("The adapter did not open the CAN channel."),
+                 QCanBusDevice::CanBusError::ConnectionError);
+        close();
+    }
+}
+
+void SlcanBackend::handleSerialPortError(QSerialPort::SerialPortError error)
+{
+    switch (error) {
+    case QSerialPort::ResourceError:
+        // the adapter was unplugged
+        setError(serialPort->errorString(), QCanBusDevice::CanBusError::ConnectionError);
+        close();
+        break;
+    case QSerialPort::ReadError:
+        setError(serialPort->errorString(), QCanBusDevice::CanBusError::ReadError);
+        break;
+    case QSerialPort::WriteError:
+        setError(serialPort->errorString(), QCanBusDevice::CanBusError::WriteError);
+        break;
+    default:
+        // errors while opening the port are reported by open()
+        break;
+    }
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,105 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef SLCANBACKEND_H
+#define SLCANBACKEND_H
+
+#include <QtSerialBus/qcanbusframe.h>
+#include <QtSerialBus/qcanbusdevice.h>
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qvariant.h>
+#include <QtCore/qvector.h>
+#include <QtSerialPort/qserialport.h>
+
+QT_BEGIN_NAMESPACE
+
+class SlcanBackend : public QCanBusDevice
+{
+    Q_OBJECT
+public:
+    enum {
+        // the baud rate of the serial port, only relevant for adapters with a real UART
+        SerialBaudRateKey = QCanBusDevice::UserKey
+    };
+
+    explicit SlcanBackend(const QString &name, QObject *parent = nullptr);
+    ~SlcanBackend();
+
+    bool open() override;
+    void close() override;
+
+    void setConfigurationParameter(int key, const QVariant &value) override;
+
+    bool writeFrame(const QCanBusFrame &newData) override;
+
+    QString interpretErrorFrame(const QCanBusFrame &errorFrame) override;
+
+private:
+    void readSerialPort();
+    void flushTransmitBuffer();
+    void handleReply(bool accepted);
+    void handleSerialPortError(QSerialPort::SerialPortError error);
+    void sendCommands(const QByteArray &commands, const QByteArray &replies);
+
+    QSerialPort *serialPort;
+    QString portName;
+    bool canFdOptionEnabled;
+
+    QByteArray receiveBuffer;
+    QByteArray transmitBuffer;
+    qint64 transmitFrames;
+    bool flushScheduled;
+
+    // frames sent to the adapter and frames it answered with z/Z or BEL
+    quint64 framesSent;
+    quint64 framesAnswered;
+
+    // Replies still expected to the commands opening the channel; a rejected
+    // close command is fine, as the channel may not have been open. Only bare
+    // CR or BEL lines answer commands, z/Z lines acknowledge frames.
+    struct PendingCommand
+    {
+        char command;
+        quint64 framesBefore;   // framesSent when the command was sent
+    };
+    QVector<PendingCommand> pendingCommands;
+};
+
+QT_END_NAMESPACE
+
+#endif // SLCANBACKEND_H
@@ -0,0 +1,268 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "slcancodec.h"
+
+QT_BEGIN_NAMESPACE
+
+/*
+    The Lawicel SLCAN protocol transfers each frame as one line of ASCII
+    text, terminated by a carriage return:
+
+        tiiil<data>     data frame with an 11 bit identifier
+        Tiiiiiiiil<data> data frame with a 29 bit identifier
+        riiil           remote request with an 11 bit identifier
+        Riiiiiiiil      remote request with a 29 bit identifier
+        d, D            CAN FD frame, as t and T
+        b, B            CAN FD frame with bit rate switch, as t and T
+
+    The length code l is a single digit; for CAN FD frames it is the DLC
+    from 0 to F. The payload follows as two hex digits per byte. Adapters
+    with time stamps enabled append four more hex digits, which are ignored.
+*/
+
+// -1 for characters that are not hex digits, so a whole field can be
+// validated by OR-ing the looked up values.
+static const signed char hexValues[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+static const quint8 fdLengths[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64 };
+
+static inline quint32 decodeIdentifier(const char *digits, int count, bool *ok)
+{
+    quint32 value = 0;
+    int invalid = 0;
+    for (int i = 0; i < count; ++i) {
+        const int digit = hexValues[uchar(digits[i])];
+        invalid |= digit;
+        value = (value << 4) | quint32(digit & 0xf);
+    }
+    *ok = (invalid >= 0);
+    return value;
+}
+
+static inline char *encodeHex(char *out, quint32 value, int count)
+{
+    for (int i = count - 1; i >= 0; --i) {
+        out[i] = hexDigits[value & 0xf];
+        value >>= 4;
+    }
+    return out + count;
+}
+
+/*
+    Decodes the frame in \a line of \a length characters, without the
+    terminating carriage return, into \a frame. Returns \c false if the line
+    is not a valid frame.
+*/
+bool SlcanCodec::decodeFrame(const char *line, int length, QCanBusFrame *frame)
+{
+    if (length < 1)
+        return false;
+
+    bool extended = false;
+    bool remote = false;
+    bool flexibleDataRate = false;
+    switch (line[0]) {
+    case 'T':
+        extended = true;
+        break;
+    case 't':
+        break;
+    case 'R':
+        extended = true;
+        remote = true;
+        break;
+    case 'r':
+        remote = true;
+        break;
+    case 'D':
+    case 'B':
+        extended = true;
+        flexibleDataRate = true;
+        break;
+    case 'd':
+    case 'b':
+        flexibleDataRate = true;
+        break;
+    default:
+        return false;
+    }
+
+    const int idDigits = extended ? 8 : 3;
+    const int header = 1 + idDigits + 1;
+    if (length < header)
+        return false;
+
+    bool ok = false;
+    const quint32 frameId = decodeIdentifier(line + 1, idDigits, &ok);
+    if (!ok || frameId > (extended ? 0x1FFFFFFFU : 0x7FFU))
+        return false;
+
+    const int lengthCode = hexValues[uchar(line[idDigits + 1])];
+    if (lengthCode < 0 || (!flexibleDataRate && lengthCode > 8))
+        return false;
+    const int payloadLength = fdLengths[lengthCode];
+
+    // the payload, optionally followed by a time stamp
+    const int dataDigits = remote ? 0 : 2 * payloadLength;
+    if (length != header + dataDigits && length != header + dataDigits + 4)
+        return false;
+
+    QByteArray payload(payloadLength, Qt::Uninitialized);
+    if (remote) {
+        // the expected length of the response, see QCanBusFrame::setPayload()
+        payload.fill(0);
+    } else {
+        char *out = payload.data();
+        const char *digits = line + header;
+        int invalid = 0;
+        for (int i = 0; i < payloadLength; ++i) {
+            const int high = hexValues[uchar(digits[2 * i])];
+            const int low = hexValues[uchar(digits[2 * i + 1])];
+            invalid |= high | low;
+            out[i] = char((high << 4) | (low & 0xf));
+        }
+        if (invalid < 0)
+            return false;
+    }
+
+    *frame = QCanBusFrame(remote ? QCanBusFrame::RemoteRequestFrame : QCanBusFrame::DataFrame);
+    frame->setExtendedFrameFormat(extended);
+    frame->setFrameId(frameId);
+    frame->setPayload(payload);
+    return true;
+}
+
+/*
+    Appends the line transmitting \a frame, including the terminating
+    carriage return, to \a out. Returns \c false if the frame cannot be sent
+    over SLCAN. CAN FD payloads are padded with zeros to the next valid
+    length.
+*/
+bool SlcanCodec::encodeFrame(const QCanBusFrame &frame, QByteArray *out)
+{
+    const bool remote = (frame.frameType() == QCanBusFrame::RemoteRequestFrame);
+    if ((!remote && frame.frameType() != QCanBusFrame::DataFrame) || frame.hasCanXlFormat())
+        return false;
+
+    const QByteArray payload = frame.payload();
+    const bool extended = frame.hasExtendedFrameFormat();
+    const bool flexibleDataRate = payload.size() > 8;
+    if (payload.size() > 64 || (remote && flexibleDataRate))
+        return false;
+
+    int lengthCode = 0;
+    while (fdLengths[lengthCode] < payload.size())
+        ++lengthCode;
+
+    char line[MaximumLineLength];
+    char *p = line;
+    if (remote)
+        *p++ = extended ? 'R' : 'r';
+    else if (flexibleDataRate)
+        *p++ = extended ? 'D' : 'd';
+    else
+        *p++ = extended ? 'T' : 't';
+    p = encodeHex(p, frame.frameId(), extended ? 8 : 3);
+    *p++ = hexDigits[lengthCode];
+
+    if (!remote) {
+        const uchar *data = reinterpret_cast<const uchar *>(payload.constData());
+        for (int i = 0; i < payload.size(); ++i) {
+            *p++ = hexDigits[data[i] >> 4];
+            *p++ = hexDigits[data[i] & 0xf];
+        }
+        for (int i = payload.size(); i < fdLengths[lengthCode]; ++i) {
+            *p++ = '0';
+            *p++ = '0';
+        }
+    }
+    *p++ = '\r';
+
+    out->append(line, int(p - line));
+    return true;
+}
+
+/*
+    Returns the command setting the CAN bit rate to \a bitRate, or an empty
+    byte array if the adapters do not support it.
+*/
+QByteArray SlcanCodec::bitRateCommand(int bitRate)
+{
+    switch (bitRate) {
+    case 10000:
+        return QByteArrayLiteral("S0\r");
+    case 20000:
+        return QByteArrayLiteral("S1\r");
+    case 50000:
+        return QByteArrayLiteral("S2\r");
+    case 100000:
+        return QByteArrayLiteral("S3\r");
+    case 125000:
+        return QByteArrayLiteral("S4\r");
+    case 250000:
+        return QByteArrayLiteral("S5\r");
+    case 500000:
+        return QByteArrayLiteral("S6\r");
+    case 800000:
+        return QByteArrayLiteral("S7\r");
+    case 1000000:
+        return QByteArrayLiteral("S8\r");
+    default:
+        return QByteArray();
+    }
+}
+
+QT_END_NAMESPACE
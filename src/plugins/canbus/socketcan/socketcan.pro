@@ -1,12 +1,18 @@
 TARGET = qtsocketcanbus
 
-QT = core-private serialbus
+QT = core-private serialbus-private
+
+config_sdt: DEFINES += QT_SERIALBUS_TRACE_USDT
 
 HEADERS += \
     socketcanbackend.h \
+    socketcanfilter.h \
+    socketcanlinkmonitor.h \
 
 SOURCES += main.cpp \
     socketcanbackend.cpp \
+    socketcanfilter.cpp \
+    socketcanlinkmonitor.cpp \
 
 OTHER_FILES = plugin.json
 
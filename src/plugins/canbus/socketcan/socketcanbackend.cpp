@@ -36,6 +36,9 @@
 
 #include "socketcanbackend.h"
 
+#include <QtSerialBus/private/qserialbusflightrecorder_p.h>
+#include <QtSerialBus/private/qserialbustrace_p.h>
+
 #include <QtCore/qdebug.h>
 #include <QtCore/qdatastream.h>
 #include <QtCore/qsocketnotifier.h>
@@ -72,13 +75,50 @@ struct canfd_frame {
 
 #endif
 
+#ifndef CAN_RAW_JOIN_FILTERS
+// Added by Linux kernel 4.1
+#define CAN_RAW_JOIN_FILTERS 6
+#endif
+
+#ifndef CANXL_MTU
+// CAN XL support was added by Linux kernel 6.2
+// For prior kernel headers we redefine the missing defines here
+// they are taken from linux/can/raw.h & linux/can.h
+
+enum {
+    CAN_RAW_XL_FRAMES = 7
+};
+
+#define CANXL_PRIO_MASK 0x7FFU  /* 11 bit priority mask */
+#define CANXL_XLF 0x80          /* mandatory CAN XL frame flag */
+#define CANXL_SEC 0x01          /* simple extended content */
+#define CANXL_MIN_DLEN 1
+#define CANXL_MAX_DLEN 2048
+struct canxl_frame {
+    canid_t prio;   /* 11 bit priority for arbitration */
+    __u8    flags;  /* additional flags for CAN XL */
+    __u8    sdt;    /* SDU (service data unit) type */
+    __u16   len;    /* frame payload length in byte */
+    __u32   af;     /* acceptance field */
+    __u8    data[CANXL_MAX_DLEN];
+};
+#define CANXL_MTU       (sizeof(struct canxl_frame))
+#define CANXL_HDR_SIZE  (offsetof(struct canxl_frame, data))
+
+#endif
+
 QT_BEGIN_NAMESPACE
 
 SocketCanBackend::SocketCanBackend(const QString &name) :
     canSocket(-1),
+    canInterfaceIndex(0),
     notifier(nullptr),
     canSocketName(name),
-    canFdOptionEnabled(false)
+    canFdOptionEnabled(false),
+    canXlOptionEnabled(false),
+    rawFilterJoined(false),
+    userspaceFilterEnabled(false),
+    linkMonitor(nullptr)
 {
     resetConfigurations();
 }
@@ -99,6 +139,8 @@ void SocketCanBackend::resetConfigurations()
                 QVariant::fromValue(QCanBusFrame::FrameErrors(QCanBusFrame::AnyError)));
     QCanBusDevice::setConfigurationParameter(
                 QCanBusDevice::CanFdKey, false);
+    QCanBusDevice::setConfigurationParameter(
+                QCanBusDevice::CanXlKey, false);
 }
 
 bool SocketCanBackend::open()
@@ -119,9 +161,127 @@ void SocketCanBackend::close()
     ::close(canSocket);
     canSocket = -1;
 
+    delete linkMonitor;
+    linkMonitor = nullptr;
+
     setState(QCanBusDevice::UnconnectedState);
 }
 
+bool SocketCanBackend::applyRawFilter(const QVariant &value, quint64 falsePositiveBudget)
+{
+    const QList<QCanBusDevice::Filter> filterList
+            = value.value<QList<QCanBusDevice::Filter> >();
+
+    // a previous filter list may have used joined filters
+    if (rawFilterJoined) {
+        const int noJoin = 0;
+        setsockopt(canSocket, SOL_CAN_RAW, CAN_RAW_JOIN_FILTERS, &noJoin, sizeof(noJoin));
+        rawFilterJoined = false;
+    }
+    userspaceFilterEnabled = false;
+
+    if (!value.isValid() || filterList.isEmpty()) {
+        // permit every frame - no restrictions (filter reset)
+        can_filter filters = {0, 0};
+        socklen_t s = sizeof(can_filter);
+        if (setsockopt(canSocket, SOL_CAN_RAW, CAN_RAW_FILTER,
+                       &filters, s) != 0) {
+            qWarning() << "Cannot unset socket filters";
+            setError(qt_error_string(errno),
+                     QCanBusDevice::CanBusError::ConfigurationError);
+            return false;
+        }
+        return true;
+    }
+
+    QVector<can_filter> filters;
+    filters.resize(filterList.size());
+    for (int i = 0; i < filterList.size(); i++) {
+        const QCanBusDevice::Filter f = filterList.at(i);
+        can_filter filter;
+        filter.can_id = f.frameId;
+        filter.can_mask = f.frameIdMask;
+
+        // frame type filter
+        switch (f.type) {
+        default:
+            // any other type cannot be filtered upon
+            setError(tr("Cannot set filter for frame type: %1").arg(f.type),
+                     QCanBusDevice::CanBusError::ConfigurationError);
+            return false;
+        case QCanBusFrame::InvalidFrame:
+            break;
+        case QCanBusFrame::DataFrame:
+            filter.can_mask |= CAN_RTR_FLAG;
+            break;
+        case QCanBusFrame::ErrorFrame:                          // ErrorFrame
+            filter.can_mask |= CAN_ERR_FLAG;
+            filter.can_id |= CAN_ERR_FLAG;
+            break;
+        case QCanBusFrame::RemoteRequestFrame:
+            filter.can_mask |= CAN_RTR_FLAG;
+            filter.can_id |= CAN_RTR_FLAG;
+            break;
+        }
+
+        // frame format filter
+        if ((f.format & QCanBusDevice::Filter::MatchBaseAndExtendedFormat)
+                == QCanBusDevice::Filter::MatchBaseAndExtendedFormat) {
+            // nothing
+        } else if (f.format & QCanBusDevice::Filter::MatchBaseFormat) {
+            filter.can_mask |= CAN_EFF_FLAG;
+        } else if (f.format & QCanBusDevice::Filter::MatchExtendedFormat) {
+            filter.can_mask |= CAN_EFF_FLAG;
+            filter.can_id |= CAN_EFF_FLAG;
+        }
+
+        filters[i] = filter;
+    }
+
+    rawFilter = SocketCanFilter(filters, falsePositiveBudget);
+    if (rawFilter.joinFilters()) {
+        const int join = 1;
+        if (setsockopt(canSocket, SOL_CAN_RAW, CAN_RAW_JOIN_FILTERS, &join, sizeof(join)) == 0)
+            rawFilterJoined = true;
+        else // kernel before 4.1
+            rawFilter = SocketCanFilter(filters, falsePositiveBudget, false);
+    }
+
+    const QVector<can_filter> kernelFilters = rawFilter.kernelFilters();
+    if (setsockopt(canSocket, SOL_CAN_RAW, CAN_RAW_FILTER,                              // фильтр
+                   kernelFilters.constData(), sizeof(kernelFilters[0]) * kernelFilters.size()) < 0) {
+        setError(qt_error_string(errno),
+                 QCanBusDevice::CanBusError::ConfigurationError);
+        return false;
+    }
+
+    // the kernel lets some frames pass that the filter list does not select
+    userspaceFilterEnabled = rawFilter.falsePositives() > 0;
+    return true;
+}
+
+bool SocketCanBackend::applyBusStatusInterval(int interval)
+{
+    if (interval <= 0) {
+        delete linkMonitor;
+        linkMonitor = nullptr;
+        return true;
+    }
+
+    if (!linkMonitor) {
+        linkMonitor = new SocketCanLinkMonitor(canInterfaceIndex, this);
+        connect(linkMonitor, &SocketCanLinkMonitor::statisticsReceived,
+                this, &SocketCanBackend::setBusStatistics);
+    }
+    if (!linkMonitor->start(interval)) {
+        setError(linkMonitor->errorString(), QCanBusDevice::CanBusError::ConfigurationError);
+        delete linkMonitor;
+        linkMonitor = nullptr;
+        return false;
+    }
+    return true;
+}
+
 bool SocketCanBackend::applyConfigurationParameter(int key, const QVariant &value)
 {
     bool success = false;
@@ -163,69 +323,17 @@ bool SocketCanBackend::applyConfigurationParameter(int key, const QVariant &valu
         break;
     }
     case QCanBusDevice::RawFilterKey:
+        success = applyRawFilter(value,
+            configurationParameter(QCanBusDevice::RawFilterFalsePositiveBudgetKey).toULongLong());
+        break;
+    case QCanBusDevice::RawFilterFalsePositiveBudgetKey:
+        success = applyRawFilter(configurationParameter(QCanBusDevice::RawFilterKey),
+                                 value.toULongLong());
+        break;
+    case QCanBusDevice::CanFdKey:
     {
-        const QList<QCanBusDevice::Filter> filterList
-                = value.value<QList<QCanBusDevice::Filter> >();
-        if (!value.isValid() || filterList.isEmpty()) {
-            // permit every frame - no restrictions (filter reset)
-            can_filter filters = {0, 0};
-            socklen_t s = sizeof(can_filter);
-            if (setsockopt(canSocket, SOL_CAN_RAW, CAN_RAW_FILTER,
-                           &filters, s) != 0) {
-                qWarning() << "Cannot unset socket filters";
-                setError(qt_error_string(errno),
-                         QCanBusDevice::CanBusError::ConfigurationError);
-                break;
-            }
-            success = true;
-            break;
-        }
-
-        QVector<can_filter> filters;
-        filters.resize(filterList.size());
-        for (int i = 0; i < filterList.size(); i++) {
-            const QCanBusDevice::Filter f = filterList.at(i);
-            can_filter filter;
-            filter.can_id = f.frameId;
-            filter.can_mask = f.frameIdMask;
-
-            // frame type filter
-            switch (f.type) {
-            default:
-                // any other type cannot be filtered upon
-                setError(tr("Cannot set filter for frame type: %1").arg(f.type),
-                         QCanBusDevice::CanBusError::ConfigurationError);
-                return false;
-            case QCanBusFrame::InvalidFrame:
-                break;
-            case QCanBusFrame::DataFrame:
-                filter.can_mask |= CAN_RTR_FLAG;
-                break;
-            case QCanBusFrame::ErrorFrame:                          // ErrorFrame
-                filter.can_mask |= CAN_ERR_FLAG;
-                filter.can_id |= CAN_ERR_FLAG;
-                break;
-            case QCanBusFrame::RemoteRequestFrame:
-                filter.can_mask |= CAN_RTR_FLAG;
-                filter.can_id |= CAN_RTR_FLAG;
-                break;
-            }
-
-            // frame format filter
-            if ((f.format & QCanBusDevice::Filter::MatchBaseAndExtendedFormat)
-                    == QCanBusDevice::Filter::MatchBaseAndExtendedFormat) {
-                // nothing
-            } else if (f.format & QCanBusDevice::Filter::MatchBaseFormat) {
-                filter.can_mask |= CAN_EFF_FLAG;
-            } else if (f.format & QCanBusDevice::Filter::MatchExtendedFormat) {
-                filter.can_mask |= CAN_EFF_FLAG;
-                filter.can_id |= CAN_EFF_FLAG;
-            }
-
-            filters[i] = filter;
-        }
-        if (setsockopt(canSocket, SOL_CAN_RAW, CAN_RAW_FILTER,                              // фильтр
-                       filters.constData(), sizeof(filters[0]) * filters.size()) < 0) {
+        const int fd_frames = value.toBool() ? 1 : 0;
+        if (setsockopt(canSocket, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &fd_frames, sizeof(fd_frames)) < 0) {
             setError(qt_error_string(errno),
                      QCanBusDevice::CanBusError::ConfigurationError);
             break;
@@ -233,10 +341,11 @@ bool SocketCanBackend::applyConfigurationParameter(int key, const QVariant &valu
         success = true;
         break;
     }
-    case QCanBusDevice::CanFdKey:
+    case QCanBusDevice::CanXlKey:
     {
-        const int fd_frames = value.toBool() ? 1 : 0;
-        if (setsockopt(canSocket, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &fd_frames, sizeof(fd_frames)) < 0) {
+        // the kernel implicitly enables CAN FD frames together with CAN XL frames
+        const int xl_frames = value.toBool() ? 1 : 0;
+        if (setsockopt(canSocket, SOL_CAN_RAW, CAN_RAW_XL_FRAMES, &xl_frames, sizeof(xl_frames)) < 0) {
             setError(qt_error_string(errno),
                      QCanBusDevice::CanBusError::ConfigurationError);
             break;
@@ -244,6 +353,12 @@ bool SocketCanBackend::applyConfigurationParameter(int key, const QVariant &valu
         success = true;
         break;
     }
+    case QCanBusDevice::BusStatusIntervalKey:
+        success = applyBusStatusInterval(value.toInt());
+        break;
+    case QCanBusDevice::TimeStampNormalizationKey:
+        success = true; // applied by QCanBusDevice
+        break;
     default:
         setError(tr("SocketCanBackend: No such configuration as %1 in SocketCanBackend").arg(key),
                  QCanBusDevice::CanBusError::ConfigurationError);
@@ -272,6 +387,7 @@ bool SocketCanBackend::connectSocket()
         return false;
     }
 
+    canInterfaceIndex = interface.ifr_ifindex;
     address.can_family  = AF_CAN;
     address.can_ifindex = interface.ifr_ifindex;
 
@@ -338,6 +454,8 @@ void SocketCanBackend::setConfigurationParameter(int key, const QVariant &value)
     // we need to check CAN FD option a lot -> cache it and avoid QVector lookup
     if (key == QCanBusDevice::CanFdKey)
         canFdOptionEnabled = value.toBool();
+    else if (key == QCanBusDevice::CanXlKey)
+        canXlOptionEnabled = value.toBool();
 }
 
 bool SocketCanBackend::writeFrame(const QCanBusFrame &newData)
@@ -350,6 +468,9 @@ bool SocketCanBackend::writeFrame(const QCanBusFrame &newData)
         return false;
     }
 
+    if (newData.hasCanXlFormat())
+        return writeCanXlFrame(newData);
+
     canid_t canId = newData.frameId();
     if (newData.hasExtendedFrameFormat())
         canId |= CAN_EFF_FLAG;
@@ -402,6 +523,44 @@ bool SocketCanBackend::writeFrame(const QCanBusFrame &newData)
         return false;
     }
 
+    Q_SERIALBUS_TRACE_FRAME(CanFrameWritten, newData);
+    qt_serialbus_record_frame(this, newData, true);
+    emit framesWritten(1);
+
+    return true;
+}
+
+bool SocketCanBackend::writeCanXlFrame(const QCanBusFrame &newData)
+{
+    if (!canXlOptionEnabled) {
+        setError(tr("Sending CAN XL frame although CAN XL option not enabled."),
+                 QCanBusDevice::WriteError);
+        return false;
+    }
+
+    const QByteArray payload = newData.payload();
+
+    // only the header and the actual payload are initialized and written
+    canxl_frame frame;
+    memset(&frame, 0, CANXL_HDR_SIZE);
+    frame.prio = newData.frameId() & CANXL_PRIO_MASK;
+    frame.flags = CANXL_XLF;
+    if (newData.hasSimpleExtendedContent())
+        frame.flags |= CANXL_SEC;
+    frame.sdt = newData.serviceDataUnitType();
+    frame.len = payload.size();
+    frame.af = newData.acceptanceField();
+    ::memcpy(frame.data, payload.constData(), frame.len);
+
+    const qint64 bytesWritten = ::write(canSocket, &frame, CANXL_HDR_SIZE + frame.len);
+    if (bytesWritten < 0) {
+        setError(qt_error_string(errno),
+                 QCanBusDevice::CanBusError::WriteError);
+        return false;
+    }
+
+    Q_SERIALBUS_TRACE_FRAME(CanFrameWritten, newData);
+    qt_serialbus_record_frame(this, newData, true);
     emit framesWritten(1);
 
     return true;
@@ -575,23 +734,58 @@ void SocketCanBackend::readSocket()
     QVector<QCanBusFrame> newFrames;
 
     while (true) {
-        struct canfd_frame frame;
+        // CAN XL frames have a variable size, the others CAN_MTU or CANFD_MTU.
+        // Only read into the large buffer if CAN XL frames can arrive at all.
+        union {
+            canfd_frame fd;
+            canxl_frame xl;
+        } frame;
         int bytesReceived;
 
-        bytesReceived = ::read(canSocket, &frame, sizeof(frame));
+        bytesReceived = ::read(canSocket, &frame,
+                               canXlOptionEnabled ? sizeof(frame.xl) : sizeof(frame.fd));
+
+        // The flags byte of a CAN XL frame is the length byte of CAN and CAN FD
+        // frames, whose values never have the CANXL_XLF bit set.
+        const bool isCanXl = canXlOptionEnabled
+                && bytesReceived >= int(CANXL_HDR_SIZE + CANXL_MIN_DLEN)
+                && (frame.xl.flags & CANXL_XLF);
 
         if (bytesReceived <= 0) {
             break;
+        } else if (isCanXl) {
+            if (bytesReceived != int(CANXL_HDR_SIZE + frame.xl.len)
+                    || frame.xl.len > CANXL_MAX_DLEN) {
+                setError(tr("ERROR SocketCanBackend: invalid CAN XL frame length"),
+                         QCanBusDevice::CanBusError::ReadError);
+                continue;
+            }
         } else if (bytesReceived != CANFD_MTU && bytesReceived != CAN_MTU) {
             setError(tr("ERROR SocketCanBackend: incomplete CAN frame"),
                      QCanBusDevice::CanBusError::ReadError);
             continue;
-        } else if (frame.len > bytesReceived - offsetof(canfd_frame, data)) {
+        } else if (frame.fd.len > bytesReceived - offsetof(canfd_frame, data)) {
             setError(tr("ERROR SocketCanBackend: invalid CAN frame length"),
                      QCanBusDevice::CanBusError::ReadError);
             continue;
         }
 
+        // Drop what only passed the kernel because of merged filter entries.
+        // This is done before SIOCGSTAMP on purpose: a dropped frame needs
+        // no time stamp, so it does not cost the additional system call.
+        if (userspaceFilterEnabled) {
+            const canid_t canId = isCanXl ? frame.xl.prio : frame.fd.can_id;
+            if (!(canId & CAN_ERR_FLAG) && !rawFilter.matches(canId)) {
+                Q_SERIALBUS_TRACE(CanFrameFiltered,
+                                  canId & (isCanXl ? CANXL_PRIO_MASK : CAN_EFF_MASK),
+                                  (isCanXl ? 0x400 : 0) | ((canId & CAN_EFF_FLAG) ? 0x100 : 0)
+                                  | ((canId & CAN_RTR_FLAG) ? QCanBusFrame::RemoteRequestFrame
+                                                            : QCanBusFrame::DataFrame),
+                                  isCanXl ? frame.xl.len : frame.fd.len);
+                continue;
+            }
+        }
+
         struct timeval timeStamp;
         if (ioctl(canSocket, SIOCGSTAMP, &timeStamp) < 0) {     // Точную временную метку можно получить с помощью вызова ioctl (2) после чтения. сообщение из розетки.
             setError(qt_error_string(errno),
@@ -607,17 +801,29 @@ void SocketCanBackend::readSocket()
         QCanBusFrame bufferedFrame;
         bufferedFrame.setTimeStamp(stamp);
 
-        bufferedFrame.setExtendedFrameFormat(frame.can_id & CAN_EFF_FLAG);
-        Q_ASSERT(frame.len <= CANFD_MAX_DLEN);
+        if (isCanXl) {
+            bufferedFrame.setCanXlFormat(true);
+            bufferedFrame.setFrameId(frame.xl.prio & CANXL_PRIO_MASK);
+            bufferedFrame.setSimpleExtendedContent(frame.xl.flags & CANXL_SEC);
+            bufferedFrame.setServiceDataUnitType(frame.xl.sdt);
+            bufferedFrame.setAcceptanceField(frame.xl.af);
+            bufferedFrame.setPayload(QByteArray(reinterpret_cast<char *>(frame.xl.data),
+                                                frame.xl.len));
+            newFrames.append(bufferedFrame);
+            continue;
+        }
+
+        bufferedFrame.setExtendedFrameFormat(frame.fd.can_id & CAN_EFF_FLAG);
+        Q_ASSERT(frame.fd.len <= CANFD_MAX_DLEN);
 
-        if (frame.can_id & CAN_RTR_FLAG)
+        if (frame.fd.can_id & CAN_RTR_FLAG)
             bufferedFrame.setFrameType(QCanBusFrame::RemoteRequestFrame);
-        if (frame.can_id & CAN_ERR_FLAG)
+        if (frame.fd.can_id & CAN_ERR_FLAG)
             bufferedFrame.setFrameType(QCanBusFrame::ErrorFrame);
 
-        bufferedFrame.setFrameId(frame.can_id & CAN_EFF_MASK);
+        bufferedFrame.setFrameId(frame.fd.can_id & CAN_EFF_MASK);
 
-        QByteArray load(reinterpret_cast<char *>(frame.data), frame.len);
+        QByteArray load(reinterpret_cast<char *>(frame.fd.data), frame.fd.len);
         bufferedFrame.setPayload(load);
 
         newFrames.append(bufferedFrame);
@@ -40,6 +40,9 @@
 #include <QtSerialBus/qcanbusframe.h>
 #include <QtSerialBus/qcanbusdevice.h>
 
+#include "socketcanfilter.h"
+#include "socketcanlinkmonitor.h"
+
 #include <QtCore/qsocketnotifier.h>
 #include <QtCore/qstring.h>
 #include <QtCore/qvariant.h>
@@ -69,11 +72,20 @@ private:
     void resetConfigurations();
     bool connectSocket();
     bool applyConfigurationParameter(int key, const QVariant &value);
+    bool applyRawFilter(const QVariant &value, quint64 falsePositiveBudget);
+    bool writeCanXlFrame(const QCanBusFrame &newData);
+    bool applyBusStatusInterval(int interval);
 
     qint64 canSocket;
+    int canInterfaceIndex;
     QSocketNotifier *notifier;
     QString canSocketName;
     bool canFdOptionEnabled;
+    bool canXlOptionEnabled;
+    SocketCanFilter rawFilter;
+    bool rawFilterJoined;
+    bool userspaceFilterEnabled;
+    SocketCanLinkMonitor *linkMonitor;
 };
 
 QT_END_NAMESPACE
@@ -0,0 +1,251 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "socketcanfilter.h"
+
+#include <QtCore/qalgorithms.h>
+
+#include <linux/can/raw.h>
+
+#include <algorithm>
+#include <limits>
+
+#ifndef CAN_RAW_FILTER_MAX
+#define CAN_RAW_FILTER_MAX 512
+#endif
+
+QT_BEGIN_NAMESPACE
+
+static const canid_t FlagBits = CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG;
+
+/*
+    Compiles the filter list set with QCanBusDevice::RawFilterKey into a list
+    for CAN_RAW_FILTER that the kernel can evaluate quickly.
+
+    The kernel checks every received frame against every filter entry, so
+    the cost per frame grows with the number of entries. Entries that match
+    exactly one frame id are therefore merged into entries with a wider mask,
+    each covering an aligned block of ids. Merges that do not add any id are
+    always done. Merges that let additional ids pass are done cheapest first
+    until \a falsePositiveBudget additional ids are used up. Frames with those
+    ids have to be removed again in userspace with matches().
+
+    If the list selects more than half of all base format ids, the ids that
+    are not selected may need fewer entries. In that case the result consists
+    of inverted entries for these ids, which only work together with
+    CAN_RAW_JOIN_FILTERS; see joinFilters(). Pass false for \a allowJoin if
+    the kernel does not support that option.
+
+    Independent of the budget, the result never exceeds the kernel limit of
+    CAN_RAW_FILTER_MAX entries.
+*/
+SocketCanFilter::SocketCanFilter(const QVector<can_filter> &filters,
+                                 quint64 falsePositiveBudget, bool allowJoin)
+{
+    QVector<Block> blocks;
+    for (const can_filter &filter : filters) {
+        idsByMask[filter.can_mask].insert(filter.can_id & filter.can_mask);
+
+        const canid_t flagMask = filter.can_mask & FlagBits;
+        const canid_t flagId = filter.can_id & flagMask;
+        const bool baseFormatOnly = (flagMask & CAN_EFF_FLAG) && !(flagId & CAN_EFF_FLAG);
+        const canid_t idMask = baseFormatOnly ? CAN_SFF_MASK : CAN_EFF_MASK;
+
+        // Entries with a mask are rare and kept as they are.
+        if ((filter.can_mask & idMask) != idMask) {
+            compiled.append(filter);
+            continue;
+        }
+
+        int group = 0;
+        while (group < groups.size() && (groups.at(group).flagMask != flagMask
+                || groups.at(group).flagId != flagId || groups.at(group).idMask != idMask)) {
+            ++group;
+        }
+        if (group == groups.size())
+            groups.append({ flagMask, flagId, idMask });
+
+        blocks.append({ group, filter.can_id & idMask, 0, 1 });
+    }
+
+    std::sort(blocks.begin(), blocks.end(), [](const Block &a, const Block &b) {
+        return a.group != b.group ? a.group < b.group : a.first < b.first;
+    });
+    blocks.erase(std::unique(blocks.begin(), blocks.end(), [](const Block &a, const Block &b) {
+        return a.group == b.group && a.first == b.first;
+    }), blocks.end());
+
+    // Selecting most of the base format ids: try to exclude the others instead.
+    QVector<Block> excluded;
+    if (allowJoin && compiled.isEmpty() && groups.size() == 1
+            && groups.first().idMask == CAN_SFF_MASK && blocks.size() > (CAN_SFF_MASK + 1) / 2) {
+        const QVector<Block> &selected = blocks;
+        canid_t next = 0;
+        for (const Block &block : selected) {
+            for (; next < block.first; ++next)
+                excluded.append({ 0, next, 0, 1 });
+            next = block.first + 1;
+        }
+        for (; next <= CAN_SFF_MASK; ++next)
+            excluded.append({ 0, next, 0, 1 });
+        mergeBlocks(excluded, 0, std::numeric_limits<int>::max());
+    }
+
+    const int passThrough = compiled.size();
+    additionalFrameIds = mergeBlocks(blocks, falsePositiveBudget,
+                                     qMax(1, CAN_RAW_FILTER_MAX - passThrough));
+
+    if (!excluded.isEmpty() && excluded.size() + 1 < blocks.size()
+            && excluded.size() < CAN_RAW_FILTER_MAX) {
+        const Group &group = groups.first();
+        compiled.append({ group.flagId, group.flagMask });
+        emitBlocks(excluded, true);
+        joined = true;
+        additionalFrameIds = 0;
+    } else {
+        emitBlocks(blocks, false);
+    }
+}
+
+/*
+    Returns true if the original filter list accepts \a canId. This is only
+    needed if falsePositives() is not 0.
+*/
+bool SocketCanFilter::matches(canid_t canId) const
+{
+    for (auto it = idsByMask.cbegin(), end = idsByMask.cend(); it != end; ++it) {
+        if (it.value().contains(canId & it.key()))
+            return true;
+    }
+    return false;
+}
+
+/*
+    Merges neighboring blocks of the same group into the smallest aligned
+    block covering both, together with all blocks in between. Since all
+    blocks are aligned, any two of them are either nested or disjoint, and
+    the number of ids gained by a merge is known exactly.
+
+    Returns the number of ids that pass in addition to the original ones.
+*/
+quint64 SocketCanFilter::mergeBlocks(QVector<Block> &blocks, quint64 budget, int maximumEntries)
+{
+    quint64 added = 0;
+
+    forever {
+        int bestStart = -1;
+        int bestEnd = -1;
+        int bestFreeBits = 0;
+        quint64 bestCost = 0;
+
+        for (int i = 0; i + 1 < blocks.size(); ++i) {
+            const int group = blocks.at(i).group;
+            if (blocks.at(i + 1).group != group)
+                continue;
+
+            const canid_t difference = blocks.at(i).first ^ blocks.at(i + 1).last();
+            int freeBits = 0;
+            while (freeBits < 32 && (quint64(difference) >> freeBits))
+                ++freeBits;
+            const quint64 size = quint64(1) << freeBits;
+            const canid_t first = canid_t(blocks.at(i).first & ~(size - 1));
+            const canid_t last = canid_t(first + size - 1);
+
+            int start = i;
+            while (start > 0 && blocks.at(start - 1).group == group
+                   && blocks.at(start - 1).first >= first) {
+                --start;
+            }
+            int end = i + 1;
+            while (end + 1 < blocks.size() && blocks.at(end + 1).group == group
+                   && blocks.at(end + 1).last() <= last) {
+                ++end;
+            }
+
+            quint64 covered = 0;
+            for (int k = start; k <= end; ++k)
+                covered += blocks.at(k).size();
+            const quint64 cost = size - covered;
+
+            // cheapest cost per removed entry
+            if (bestStart < 0 || cost * (bestEnd - bestStart) < bestCost * (end - start)) {
+                bestStart = start;
+                bestEnd = end;
+                bestFreeBits = freeBits;
+                bestCost = cost;
+            }
+        }
+
+        if (bestStart < 0)
+            break;
+        if (bestCost > 0 && added + bestCost > budget && blocks.size() <= maximumEntries)
+            break;
+
+        Block merged = blocks.at(bestStart);
+        merged.freeBits = bestFreeBits;
+        merged.first &= ~canid_t(merged.size() - 1);
+        merged.members = 0;
+        for (int k = bestStart; k <= bestEnd; ++k)
+            merged.members += blocks.at(k).members;
+
+        blocks[bestStart] = merged;
+        blocks.remove(bestStart + 1, bestEnd - bestStart);
+        added += bestCost;
+    }
+
+    return added;
+}
+
+void SocketCanFilter::emitBlocks(const QVector<Block> &blocks, bool inverted)
+{
+    for (const Block &block : blocks) {
+        const Group &group = groups.at(block.group);
+        const canid_t idMask = group.idMask & ~canid_t(block.size() - 1);
+
+        can_filter filter;
+        if (inverted) {
+            // frames of other formats and types are rejected by the first entry
+            filter.can_id = block.first | CAN_INV_FILTER;
+            filter.can_mask = idMask;
+        } else {
+            filter.can_id = group.flagId | block.first;
+            filter.can_mask = group.flagMask | idMask;
+        }
+        compiled.append(filter);
+    }
+}
+
+QT_END_NAMESPACE
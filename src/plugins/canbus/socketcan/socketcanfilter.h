@@ -0,0 +1,93 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef SOCKETCANFILTER_H
+#define SOCKETCANFILTER_H
+
+#include <QtCore/qhash.h>
+#include <QtCore/qset.h>
+#include <QtCore/qvector.h>
+
+#include <linux/can.h>
+
+QT_BEGIN_NAMESPACE
+
+class SocketCanFilter
+{
+public:
+    SocketCanFilter() = default;
+    SocketCanFilter(const QVector<can_filter> &filters, quint64 falsePositiveBudget,
+                    bool allowJoin = true);
+
+    QVector<can_filter> kernelFilters() const { return compiled; }
+    bool joinFilters() const { return joined; }
+    quint64 falsePositives() const { return additionalFrameIds; }
+
+    bool matches(canid_t canId) const;
+
+private:
+    struct Block {
+        int group;
+        canid_t first;
+        int freeBits;
+        quint64 members;
+
+        quint64 size() const { return quint64(1) << freeBits; }
+        canid_t last() const { return canid_t(first + size() - 1); }
+    };
+
+    struct Group {
+        canid_t flagMask;
+        canid_t flagId;
+        canid_t idMask;
+    };
+
+    static quint64 mergeBlocks(QVector<Block> &blocks, quint64 budget, int maximumEntries);
+    void emitBlocks(const QVector<Block> &blocks, bool inverted);
+
+    QVector<can_filter> compiled;
+    bool joined = false;
+    quint64 additionalFrameIds = 0;
+
+    QVector<Group> groups;
+
+    // the original filter list for matches(), one id set per distinct mask
+    QHash<canid_t, QSet<canid_t> > idsByMask;
+};
+
+QT_END_NAMESPACE
+
+#endif // SOCKETCANFILTER_H
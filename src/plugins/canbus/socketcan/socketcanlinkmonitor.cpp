@@ -0,0 +1,286 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "socketcanlinkmonitor.h"
+
+#include <QtCore/qsocketnotifier.h>
+
+#include <linux/can/netlink.h>
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+QT_BEGIN_NAMESPACE
+
+/*
+    Reads the state of the CAN controller and the statistics of the network
+    interface from rtnetlink, as "ip -details -statistics link show" does.
+
+    Every interval one RTM_GETLINK request for the interface is sent on a
+    non-blocking NETLINK_ROUTE socket; the reply is parsed when the socket
+    becomes readable. Compared with error frames, this costs one request per
+    interval, no matter how many errors happen on the bus.
+*/
+
+SocketCanLinkMonitor::SocketCanLinkMonitor(int interfaceIndex, QObject *parent)
+    : QObject(parent),
+      interfaceIndex(interfaceIndex)
+{
+    connect(&timer, &QTimer::timeout, this, &SocketCanLinkMonitor::requestStatistics);
+}
+
+SocketCanLinkMonitor::~SocketCanLinkMonitor()
+{
+    if (netlinkSocket != -1)
+        ::close(netlinkSocket);
+}
+
+bool SocketCanLinkMonitor::start(int interval)
+{
+    if (netlinkSocket == -1) {
+        netlinkSocket = ::socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                                 NETLINK_ROUTE);
+        if (netlinkSocket < 0) {
+            errorText = qt_error_string(errno);
+            return false;
+        }
+
+        notifier = new QSocketNotifier(netlinkSocket, QSocketNotifier::Read, this);
+        connect(notifier, &QSocketNotifier::activated,
+                this, &SocketCanLinkMonitor::readSocket);
+    }
+
+    timer.start(interval);
+    requestStatistics();
+    return true;
+}
+
+void SocketCanLinkMonitor::requestStatistics()
+{
+    struct {
+        nlmsghdr header;
+        ifinfomsg info;
+    } request;
+    memset(&request, 0, sizeof(request));
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(ifinfomsg));
+    request.header.nlmsg_type = RTM_GETLINK;
+    request.header.nlmsg_flags = NLM_F_REQUEST;
+    request.header.nlmsg_seq = ++sequence;
+    request.info.ifi_family = AF_UNSPEC;
+    request.info.ifi_index = interfaceIndex;
+
+    sockaddr_nl kernel;
+    memset(&kernel, 0, sizeof(kernel));
+    kernel.nl_family = AF_NETLINK;
+
+    // a failed request is simply repeated with the next interval
+    ::sendto(netlinkSocket, &request, request.header.nlmsg_len, 0,
+             reinterpret_cast<sockaddr *>(&kernel), sizeof(kernel));
+}
+
+void SocketCanLinkMonitor::readSocket()
+{
+    // large enough for a link message with all attributes of a CAN interface
+    alignas(nlmsghdr) char buffer[16384];
+
+    forever {
+        const ssize_t size = ::recv(netlinkSocket, buffer, sizeof(buffer), 0);
+        if (size <= 0)
+            return;
+
+        QCanBusDevice::BusStatistics statistics;
+        if (parseLinkMessages(buffer, int(size), interfaceIndex, &statistics))
+            emit statisticsReceived(statistics);
+    }
+}
+
+static QCanBusDevice::CanBusStatus busStatus(quint32 state)
+{
+    switch (state) {
+    case CAN_STATE_ERROR_ACTIVE:
+        return QCanBusDevice::GoodStatus;
+    case CAN_STATE_ERROR_WARNING:
+        return QCanBusDevice::WarningStatus;
+    case CAN_STATE_ERROR_PASSIVE:
+        return QCanBusDevice::ErrorStatus;
+    case CAN_STATE_BUS_OFF:
+        return QCanBusDevice::BusOffStatus;
+    default: // stopped or sleeping
+        return QCanBusDevice::UnknownStatus;
+    }
+}
+
+// IFLA_INFO_DATA of a CAN interface
+static void parseCanData(const rtattr *data, QCanBusDevice::BusStatistics *statistics)
+{
+    int length = RTA_PAYLOAD(data);
+    for (const rtattr *attribute = static_cast<const rtattr *>(RTA_DATA(data));
+         RTA_OK(attribute, length); attribute = RTA_NEXT(attribute, length)) {
+        switch (attribute->rta_type) {
+        case IFLA_CAN_STATE:
+            if (RTA_PAYLOAD(attribute) >= sizeof(quint32)) {
+                quint32 state;
+                memcpy(&state, RTA_DATA(attribute), sizeof(state));
+                statistics->status = busStatus(state);
+            }
+            break;
+        case IFLA_CAN_BERR_COUNTER:
+            if (RTA_PAYLOAD(attribute) >= sizeof(can_berr_counter)) {
+                can_berr_counter counter;
+                memcpy(&counter, RTA_DATA(attribute), sizeof(counter));
+                statistics->transmitErrorCounter = counter.txerr;
+                statistics->receiveErrorCounter = counter.rxerr;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// IFLA_LINKINFO; the data is only interpreted for interfaces of kind "can"
+static void parseLinkInfo(const rtattr *linkInfo, QCanBusDevice::BusStatistics *statistics)
+{
+    const rtattr *data = nullptr;
+    const rtattr *extendedStatistics = nullptr;
+    bool isCan = false;
+
+    int length = RTA_PAYLOAD(linkInfo);
+    for (const rtattr *attribute = static_cast<const rtattr *>(RTA_DATA(linkInfo));
+         RTA_OK(attribute, length); attribute = RTA_NEXT(attribute, length)) {
+        switch (attribute->rta_type) {
+        case IFLA_INFO_KIND:
+            isCan = qstrncmp(static_cast<const char *>(RTA_DATA(attribute)), "can",
+                             RTA_PAYLOAD(attribute)) == 0;
+            break;
+        case IFLA_INFO_DATA:
+            data = attribute;
+            break;
+        case IFLA_INFO_XSTATS:
+            extendedStatistics = attribute;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (!isCan)
+        return;
+    if (data)
+        parseCanData(data, statistics);
+    if (extendedStatistics && RTA_PAYLOAD(extendedStatistics) >= sizeof(can_device_stats)) {
+        can_device_stats counters;
+        memcpy(&counters, RTA_DATA(extendedStatistics), sizeof(counters));
+        statistics->busErrors = counters.bus_error;
+        statistics->restarts = counters.restarts;
+    }
+}
+
+template <typename Counters>
+static bool hasCounters(const rtattr *attribute)
+{
+    return RTA_PAYLOAD(attribute) >= offsetof(Counters, rx_over_errors)
+            + sizeof(Counters::rx_over_errors);
+}
+
+template <typename Counters>
+static Counters readCounters(const rtattr *attribute)
+{
+    Counters counters;
+    memset(&counters, 0, sizeof(counters));
+    memcpy(&counters, RTA_DATA(attribute), qMin(size_t(RTA_PAYLOAD(attribute)), sizeof(counters)));
+    return counters;
+}
+
+/*
+    Parses the RTM_NEWLINK message of the interface with interfaceIndex out of
+    the size bytes of netlink messages at data. Returns false if there is none,
+    for example if the interface was removed.
+*/
+bool SocketCanLinkMonitor::parseLinkMessages(const char *data, int size, int interfaceIndex,
+                                             QCanBusDevice::BusStatistics *statistics)
+{
+    bool found = false;
+    int remaining = size;
+    for (const nlmsghdr *header = reinterpret_cast<const nlmsghdr *>(data);
+         NLMSG_OK(header, remaining); header = NLMSG_NEXT(header, remaining)) {
+        if (header->nlmsg_type != RTM_NEWLINK
+                || header->nlmsg_len < NLMSG_LENGTH(sizeof(ifinfomsg))) {
+            continue;
+        }
+        const ifinfomsg *info = static_cast<const ifinfomsg *>(NLMSG_DATA(header));
+        if (info->ifi_index != interfaceIndex)
+            continue;
+
+        bool haveStatistics64 = false;
+        int length = IFLA_PAYLOAD(header);
+        for (const rtattr *attribute = IFLA_RTA(info); RTA_OK(attribute, length);
+             attribute = RTA_NEXT(attribute, length)) {
+            switch (attribute->rta_type) {
+            case IFLA_STATS64:
+                // older kernels report fewer counters, the ones needed are at the start
+                if (hasCounters<rtnl_link_stats64>(attribute)) {
+                    const rtnl_link_stats64 counters = readCounters<rtnl_link_stats64>(attribute);
+                    statistics->receiveDropped = counters.rx_dropped;
+                    statistics->receiveOverErrors = counters.rx_over_errors;
+                    haveStatistics64 = true;
+                }
+                break;
+            case IFLA_STATS:
+                if (!haveStatistics64 && hasCounters<rtnl_link_stats>(attribute)) {
+                    const rtnl_link_stats counters = readCounters<rtnl_link_stats>(attribute);
+                    statistics->receiveDropped = counters.rx_dropped;
+                    statistics->receiveOverErrors = counters.rx_over_errors;
+                }
+                break;
+            case IFLA_LINKINFO:
+                parseLinkInfo(attribute, statistics);
+                break;
+            default:
+                break;
+            }
+        }
+        found = true;
+    }
+    return found;
+}
+
+QT_END_NAMESPACE
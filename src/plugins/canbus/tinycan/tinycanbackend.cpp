@@ -41,6 +41,8 @@
 #include "tinycan_symbols_p.h"
 
 #include <QtSerialBus/qcanbusdevice.h>
+#include <QtSerialBus/private/qserialbusflightrecorder_p.h>
+#include <QtSerialBus/private/qserialbustrace_p.h>
 
 #include <QtCore/qtimer.h>
 #include <QtCore/qmutex.h>
@@ -218,6 +220,8 @@ bool TinyCanBackendPrivate::setConfigurationParameter(int key, const QVariant &v
     switch (key) {
     case QCanBusDevice::BitRateKey:
         return setBitRate(value.toInt());
+    case QCanBusDevice::TimeStampNormalizationKey:
+        return true; // applied by QCanBusDevice
     default:
         q->setError(TinyCanBackend::tr("Unsupported configuration key: %1").arg(key),
                     QCanBusDevice::ConfigurationError);
@@ -365,10 +369,13 @@ void TinyCanBackendPrivate::canWriteNotification()
         const qint32 messagesToWrite = 1;
         ::memcpy(message.Data.Bytes, payload.constData(), sizeof(message.Data.Bytes));
         const int ret = ::CanTransmit(channelIndex, &message, messagesToWrite);
-        if (ret < 0)
+        if (ret < 0) {
             q->setError(systemErrorString(ret), QCanBusDevice::CanBusError::WriteError);
-        else
+        } else {
+            Q_SERIALBUS_TRACE_FRAME(CanFrameWritten, frame);
+            qt_serialbus_record_frame(q, frame, true);
             emit q->framesWritten(messagesToWrite);
+        }
     }
 
     if (q->hasOutgoingFrames())
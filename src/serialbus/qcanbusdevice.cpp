@@ -36,11 +36,19 @@
 
 #include "qcanbusdevice.h"
 #include "qcanbusdevice_p.h"
+#include "qcanbuse2echecker_p.h"
+#include "qserialbusflightrecorder_p.h"
+#include "qserialbustrace_p.h"
 
 #include "qcanbusframe.h"
 
 #include <QtCore/qdebug.h>
 #include <QtCore/qdatastream.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qeventloop.h>
+#include <QtCore/qscopedvaluerollback.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qtimer.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -78,6 +86,27 @@ QT_BEGIN_NAMESPACE
     \value ClosingState     The device is being closed.
 */
 
+/*!
+    \enum QCanBusDevice::CanBusStatus
+    \since 5.7
+
+    This enum describes the state of the CAN controller as defined by the
+    CAN specification, based on its transmit and receive error counters.
+
+    \value UnknownStatus    The backend does not report the controller state, or
+                            the device is not connected.
+    \value GoodStatus       The controller is error active: both error counters
+                            are below 96.
+    \value WarningStatus    At least one error counter reached the warning
+                            level of 96.
+    \value ErrorStatus      The controller is error passive: at least one error
+                            counter reached 128.
+    \value BusOffStatus     The controller is bus off and does not take part in
+                            the bus communication.
+
+    \sa busStatus(), busStatusChanged()
+*/
+
 /*!
     \enum QCanBusDevice::ConfigurationKey
     This enum describes the possible configuration options for
@@ -99,6 +128,34 @@ QT_BEGIN_NAMESPACE
     \value BitRateKey       This key defines the bitrate in bits per second.
     \value CanFdKey         This key defines whether sending and receiving of CAN FD frames
                             should be enabled. The expected value for this key is \c bool.
+    \value CanXlKey         This key defines whether sending and receiving of CAN XL frames
+                            should be enabled. The expected value for this key is \c bool.
+                            This value was introduced in Qt 5.7.
+    \value RawFilterFalsePositiveBudgetKey
+                            This key defines how many frame identifiers that are not
+                            selected by RawFilterKey a backend may let pass when it merges
+                            the filter list into fewer, wider hardware or kernel filters.
+                            Such frames are removed again before they are queued, so this
+                            key only trades filter cost in the driver against work in the
+                            application. The expected value for this key is \c quint64; the
+                            default is 0. This value was introduced in Qt 5.7.
+    \value BusStatusIntervalKey
+                            This key defines the interval in milliseconds at which the
+                            backend reads the controller state and the interface
+                            statistics returned by busStatistics(). The expected value
+                            for this key is \c int; 0, the default, disables the
+                            monitoring. Not every backend supports it. This value was
+                            introduced in Qt 5.7.
+    \value TimeStampNormalizationKey
+                            This key defines whether the device estimates how the
+                            timestamps of received frames map onto the monotonic clock
+                            of the system (\c CLOCK_MONOTONIC on Linux). The offset and the drift of
+                            the backend's clock are estimated continuously from the
+                            times the frames are received, so frames of different
+                            devices can be compared and merged. The frames keep the
+                            timestamp of the backend; toNormalizedTimeStamp() maps it.
+                            The expected value for this key is \c bool; the default is
+                            \c false. This value was introduced in Qt 5.7.
     \value UserKey          This key defines the range where custom keys start. It's most
                             common purpose is to permit platform-specific configuration
                             options.
@@ -122,6 +179,69 @@ QT_BEGIN_NAMESPACE
     \snippet snippetmain.cpp Filter Examples
 */
 
+/*!
+    \class QCanBusDevice::BusStatistics
+    \inmodule QtSerialBus
+    \since 5.7
+
+    \brief The QCanBusDevice::BusStatistics struct holds a snapshot of the
+    controller state and the error statistics of a CAN interface.
+
+    Backends that can read the state of the CAN controller update the
+    snapshot periodically, as configured with
+    \l QCanBusDevice::BusStatusIntervalKey. This allows an application to
+    monitor the health of the bus without receiving error frames, which a
+    faulty node can cause at a high rate.
+
+    \sa QCanBusDevice::busStatistics()
+*/
+
+/*!
+    \variable QCanBusDevice::BusStatistics::status
+
+    \brief the state of the CAN controller.
+*/
+
+/*!
+    \variable QCanBusDevice::BusStatistics::transmitErrorCounter
+
+    \brief the transmit error counter of the CAN controller, or \c -1 if
+    the driver does not report it.
+*/
+
+/*!
+    \variable QCanBusDevice::BusStatistics::receiveErrorCounter
+
+    \brief the receive error counter of the CAN controller, or \c -1 if the
+    driver does not report it.
+*/
+
+/*!
+    \variable QCanBusDevice::BusStatistics::busErrors
+
+    \brief the number of bus errors detected by the controller.
+*/
+
+/*!
+    \variable QCanBusDevice::BusStatistics::restarts
+
+    \brief the number of times the controller was restarted after bus off.
+*/
+
+/*!
+    \variable QCanBusDevice::BusStatistics::receiveDropped
+
+    \brief the number of received frames dropped by the driver or the
+    network stack, for example because a socket receive buffer was full.
+*/
+
+/*!
+    \variable QCanBusDevice::BusStatistics::receiveOverErrors
+
+    \brief the number of received frames lost because the controller ran
+    out of receive buffers.
+*/
+
 /*!
     \enum QCanBusDevice::Filter::FormatFilter
     This enum describes the format pattern, which is used to filter incoming
@@ -202,6 +322,12 @@ QT_BEGIN_NAMESPACE
 QCanBusDevice::QCanBusDevice(QObject *parent) :
     QObject(*new QCanBusDevicePrivate, parent)
 {
+    Q_D(QCanBusDevice);
+
+    // Backends emit framesWritten() themselves; track it for waitForFramesWritten().
+    connect(this, &QCanBusDevice::framesWritten, this, [d]() {
+        d->wakeWaiters(&d->writtenGeneration);
+    }, Qt::DirectConnection);
 }
 
 
@@ -220,8 +346,16 @@ void QCanBusDevice::setError(const QString &errorText, CanBusError errorId)
 
     d->errorText = errorText;
     d->lastError = errorId;
+    d->wakeWaiters(&d->errorGeneration);
+
+    if (QSerialBusFlightRecorderPrivate *recorder = d->flightRecorder.loadAcquire()) {
+        const QByteArray text = errorText.toUtf8();
+        recorder->record(d->flightRecorderInterface, QSerialBusFlightRecorderPrivate::Error, 0,
+                         quint32(errorId), 0, text.constData(), text.size());
+    }
 
     emit errorOccurred(errorId);
+    d->callReceiveHook();
 }
 
 /*!
@@ -239,10 +373,33 @@ void QCanBusDevice::enqueueReceivedFrames(const QVector<QCanBusFrame> &newFrames
     if (newFrames.isEmpty())
         return;
 
+    QVector<QCanBusFrame> frames = newFrames;
+    if (d->normalizeTimeStamps)
+        d->sampleTimeStampsOf(frames);
+
+    if (Q_SERIALBUS_TRACE_ENABLED(CanFrameReceived)) {
+        for (const QCanBusFrame &frame : frames)
+            Q_SERIALBUS_TRACE_FRAME(CanFrameReceived, frame);
+    }
+    if (QSerialBusFlightRecorderPrivate *recorder = d->flightRecorder.loadAcquire()) {
+        for (const QCanBusFrame &frame : frames)
+            recorder->recordFrame(d->flightRecorderInterface, frame, false);
+    }
+    if (QCanBusE2ECheckerPrivate *checker = d->e2eChecker.loadAcquire()) {
+        checker->check(&frames);
+        if (frames.isEmpty())
+            return;
+    }
+
     d->incomingFramesGuard.lock();
-    d->incomingFrames.append(newFrames);
+    d->incomingFrames.append(frames);
+    Q_SERIALBUS_TRACE(CanFramesEnqueued, frames.size(), d->incomingFrames.size(),
+                      QSerialBusTrace::ReceiveQueue);
+    if (d->waiters.load())
+        d->waitCondition.wakeAll();
     d->incomingFramesGuard.unlock();
     emit framesReceived();
+    d->callReceiveHook();
 }
 
 /*!
@@ -256,6 +413,9 @@ void QCanBusDevice::enqueueOutgoingFrame(const QCanBusFrame &newFrame)
     Q_D(QCanBusDevice);
 
     d->outgoingFrames.append(newFrame);
+    d->outgoingFramesCount.ref();
+    Q_SERIALBUS_TRACE(CanFramesEnqueued, 1, d->outgoingFrames.size(),
+                      QSerialBusTrace::TransmitQueue);
 }
 
 /*!
@@ -269,6 +429,9 @@ QCanBusFrame QCanBusDevice::dequeueOutgoingFrame()
 
     if (d->outgoingFrames.isEmpty())
         return QCanBusFrame(QCanBusFrame::InvalidFrame);
+    Q_SERIALBUS_TRACE(CanFramesDequeued, 1, d->outgoingFrames.size() - 1,
+                      QSerialBusTrace::TransmitQueue);
+    d->outgoingFramesCount.deref();
     return d->outgoingFrames.takeFirst();
 }
 
@@ -300,6 +463,12 @@ void QCanBusDevice::setConfigurationParameter(int key, const QVariant &value)
 {
     Q_D(QCanBusDevice);
 
+    // applied by enqueueReceivedFrames(), independent of the backend
+    if (key == TimeStampNormalizationKey) {
+        d->normalizeTimeStamps = value.toBool();
+        d->timeStampNormalizer.reset();
+    }
+
     for (int i = 0; i < d->configOptions.size(); i++) {
         if (d->configOptions.at(i).first == key) {
             if (value.isValid()) {
@@ -382,6 +551,87 @@ QString QCanBusDevice::errorString() const
     return d->errorText;
 }
 
+/*!
+    \since 5.7
+
+    Returns the state of the CAN controller as of the last update of the
+    bus statistics.
+
+    \sa busStatistics(), busStatusChanged()
+*/
+QCanBusDevice::CanBusStatus QCanBusDevice::busStatus() const
+{
+    return d_func()->busStatistics.status;
+}
+
+/*!
+    \since 5.7
+
+    Returns the last snapshot of the controller state and the interface
+    statistics. The snapshot is updated by the backend at the interval set
+    with \l BusStatusIntervalKey; calling this function does not access the
+    device. If the backend does not support it or the device is not
+    connected, the status is \l UnknownStatus.
+
+    \sa setBusStatistics()
+*/
+QCanBusDevice::BusStatistics QCanBusDevice::busStatistics() const
+{
+    return d_func()->busStatistics;
+}
+
+static qint64 toMicroseconds(const QCanBusFrame::TimeStamp &stamp)
+{
+    return stamp.seconds() * 1000000 + stamp.microSeconds();
+}
+
+/*!
+    \since 5.7
+
+    Returns \a timeStamp, a timestamp of a frame received by this device, on
+    the monotonic clock of the system (\c CLOCK_MONOTONIC on Linux). Frames of
+    different devices can be compared and merged by their mapped timestamps.
+
+    The mapping is estimated from the frames received while
+    \l TimeStampNormalizationKey is set; received frames keep the timestamp of
+    the backend. If the key is not set, no frame has been received yet, or
+    \a timeStamp is zero because the backend does not stamp frames, a null
+    timestamp is returned.
+
+    \sa QCanBusFrame::setNormalizedTimeStamp()
+*/
+QCanBusFrame::TimeStamp QCanBusDevice::toNormalizedTimeStamp(const QCanBusFrame::TimeStamp &timeStamp) const
+{
+    Q_D(const QCanBusDevice);
+
+    const qint64 raw = toMicroseconds(timeStamp);
+    if (!d->normalizeTimeStamps || !d->timeStampNormalizer.isValid() || raw == 0)
+        return QCanBusFrame::TimeStamp();
+
+    // a frame cannot have been received in the future
+    const qint64 mapped = qMin(d->timeStampNormalizer.toMonotonic(raw),
+                               QCanBusTimeStampNormalizer::monotonicMicroseconds());
+    return QCanBusFrame::TimeStamp(mapped / 1000000, mapped % 1000000);
+}
+
+/*!
+    \since 5.7
+
+    Replaces the snapshot returned by busStatistics() with \a statistics and
+    emits \l busStatusChanged() if the controller state changed. CAN bus
+    implementations that monitor the controller must use this function to
+    report its state.
+*/
+void QCanBusDevice::setBusStatistics(const QCanBusDevice::BusStatistics &statistics)
+{
+    Q_D(QCanBusDevice);
+
+    const CanBusStatus previous = d->busStatistics.status;
+    d->busStatistics = statistics;
+    if (statistics.status != previous)
+        emit busStatusChanged(statistics.status);
+}
+
 /*!
     \fn qint64 QCanBusDevice::framesAvailable() const
 
@@ -392,7 +642,10 @@ QString QCanBusDevice::errorString() const
 */
 qint64 QCanBusDevice::framesAvailable() const
 {
-    return d_func()->incomingFrames.size();
+    Q_D(const QCanBusDevice);
+
+    QMutexLocker locker(&d->incomingFramesGuard);
+    return d->incomingFrames.size();
 }
 
 /*!
@@ -404,7 +657,8 @@ qint64 QCanBusDevice::framesAvailable() const
 */
 qint64 QCanBusDevice::framesToWrite() const
 {
-    return d_func()->outgoingFrames.size();
+    Q_D(const QCanBusDevice);
+    return d->outgoingFramesCount.load() + d->submittedFramesCount.load();
 }
 
 /*!
@@ -468,9 +722,185 @@ QCanBusFrame QCanBusDevice::readFrame()
     if (d->incomingFrames.isEmpty())
         return QCanBusFrame(QCanBusFrame::InvalidFrame);
 
+    Q_SERIALBUS_TRACE(CanFramesDequeued, 1, d->incomingFrames.size() - 1,
+                      QSerialBusTrace::ReceiveQueue);
     return d->incomingFrames.takeFirst();
 }
 
+/*!
+    \since 5.7
+
+    Returns all frames from the queue and clears it; otherwise returns an
+    empty vector. This takes the lock protecting the queue only once, which
+    makes it the preferred way to consume frames in a tight processing loop.
+
+    \sa readFrame(), waitForFramesReceived()
+*/
+QVector<QCanBusFrame> QCanBusDevice::readAllFrames()
+{
+    Q_D(QCanBusDevice);
+
+    QVector<QCanBusFrame> frames;
+    if (d->state != ConnectedState)
+        return frames;
+
+    QMutexLocker locker(&d->incomingFramesGuard);
+    frames.swap(d->incomingFrames);
+    Q_SERIALBUS_TRACE(CanFramesDequeued, frames.size(), 0, QSerialBusTrace::ReceiveQueue);
+    return frames;
+}
+
+/*!
+    \overload
+    \since 5.7
+
+    Replaces the contents of \a frames with all frames from the queue and
+    clears the queue. Returns the number of frames read.
+
+    The storage previously held by \a frames is handed to the device and
+    filled with the frames received next. A consumer that passes the same
+    vector on every call therefore alternates between two buffers and does
+    not allocate in a steady state.
+*/
+int QCanBusDevice::readAllFrames(QVector<QCanBusFrame> *frames)
+{
+    Q_D(QCanBusDevice);
+
+    // resize() keeps the capacity, unlike clear()
+    frames->resize(0);
+    if (d->state != ConnectedState)
+        return 0;
+
+    QMutexLocker locker(&d->incomingFramesGuard);
+    frames->swap(d->incomingFrames);
+    Q_SERIALBUS_TRACE(CanFramesDequeued, frames->size(), 0, QSerialBusTrace::ReceiveQueue);
+    return frames->size();
+}
+
+/*!
+    \typedef QCanBusDevice::ReceiveHook
+    \since 5.7
+
+    Function called by the device with the \c data pointer passed to
+    setReceiveHook().
+*/
+
+/*!
+    \since 5.7
+
+    Sets \a hook to be called with \a data the next time frames were queued,
+    an error occurred or the state changed. The hook is called once and then
+    reset. Passing \c nullptr removes a previously set hook.
+
+    The hook is not called from within the backend, but by a queued
+    invocation in the thread the device lives in, after the corresponding
+    signal was emitted; it must be set from that thread. Frames, errors and
+    state changes up to that point result in a single call. Unlike a
+    connection to \l framesReceived(), the hook does not go through signal
+    dispatch. It is meant for adaptors that resume a waiting operation, such
+    as the awaitables in \c qserialbuscoroutine.h.
+
+    Only one hook can be set at a time. An adaptor that waits together with
+    others has to read the current hook with receiveHook() and
+    receiveHookData() first and call it from its own hook.
+
+    \sa readAllFrames()
+*/
+void QCanBusDevice::setReceiveHook(ReceiveHook hook, void *data)
+{
+    Q_D(QCanBusDevice);
+    d->receiveHook = hook;
+    d->receiveHookData = data;
+}
+
+/*!
+    \since 5.7
+
+    Returns the hook set by setReceiveHook(), or \c nullptr if there is none.
+
+    \sa receiveHookData()
+*/
+QCanBusDevice::ReceiveHook QCanBusDevice::receiveHook() const
+{
+    Q_D(const QCanBusDevice);
+    return d->receiveHook;
+}
+
+/*!
+    \since 5.7
+
+    Returns the data pointer set together with receiveHook().
+*/
+void *QCanBusDevice::receiveHookData() const
+{
+    Q_D(const QCanBusDevice);
+    return d->receiveHookData;
+}
+
+/*!
+    \since 5.7
+
+    Blocks until new frames are available for reading, or until \a msecs
+    milliseconds have passed. If \a msecs is -1, this function does not time
+    out. Returns \c true immediately if frames are already queued. Returns
+    \c false if the wait timed out, the device is not connected or an error
+    occurred.
+
+    When called from a thread other than the one the device lives in, the
+    calling thread sleeps on a condition that is signaled whenever the
+    backend queues received frames; no event loop is needed in the calling
+    thread. When called from the device's own thread, a local event loop is
+    run so that the backend can still process its I/O.
+
+    \warning Calling this function from the device's thread may cause your
+    user interface to freeze. Recursive calls from the device's thread are
+    not supported and return \c false.
+
+    \sa readAllFrames(), framesReceived()
+*/
+bool QCanBusDevice::waitForFramesReceived(int msecs)
+{
+    Q_D(QCanBusDevice);
+
+    // state and queue may change under our feet, so check them with the lock held
+    if (QThread::currentThread() != thread())
+        return d->waitInOtherThread(QCanBusDevicePrivate::FramesReceived, msecs);
+
+    if (d->state != ConnectedState)
+        return false;
+    if (framesAvailable() > 0)
+        return true;
+    return d->waitInDeviceThread(QCanBusDevicePrivate::FramesReceived, msecs);
+}
+
+/*!
+    \since 5.7
+
+    Blocks until frames pending in framesToWrite() have been written, as
+    indicated by the framesWritten() signal, or until \a msecs milliseconds
+    have passed. If \a msecs is -1, this function does not time out.
+    Returns \c false if there is nothing to write, the wait timed out, the
+    device is not connected or an error occurred.
+
+    The threading behavior is the same as for waitForFramesReceived(). From
+    another thread this is typically used after submitFrame().
+
+    \sa submitFrame(), framesWritten()
+*/
+bool QCanBusDevice::waitForFramesWritten(int msecs)
+{
+    Q_D(QCanBusDevice);
+
+    if (QThread::currentThread() != thread())
+        return d->waitInOtherThread(QCanBusDevicePrivate::FramesWritten, msecs);
+
+    if (d->state != ConnectedState)
+        return false;
+    if (framesToWrite() == 0)
+        return false;
+    return d->waitInDeviceThread(QCanBusDevicePrivate::FramesWritten, msecs);
+}
+
 /*!
     \fn void QCanBusDevice::framesWritten(qint64 framesCount)
 
@@ -498,9 +928,41 @@ QCanBusFrame QCanBusDevice::readFrame()
     this function it may still be required to set an arbitrary payload on \a frame. The length of
     the arbitrary payload is what is set as size expectation for the RTR frame.
 
-    \sa QCanBusFrame::setPayload()
+    \sa QCanBusFrame::setPayload(), submitFrame()
 */
 
+/*!
+    \since 5.7
+
+    Queues \a frame for writing and returns \c true if the frame is valid;
+    otherwise returns \c false and the frame is discarded.
+
+    Unlike writeFrame(), this function is thread-safe and may be called from
+    any number of threads at the same time. The frame is appended to a
+    lock-free queue, which is drained in batches by the thread the device
+    lives in, passing each frame to writeFrame(). Frames submitted by the same
+    thread are written in the order they were submitted. Only the first
+    submission into an empty queue posts an event to the device thread.
+
+    Submitted frames that were not handed to writeFrame() yet are included in
+    framesToWrite(). Errors are reported through errorOccurred() as for
+    writeFrame().
+
+    \sa writeFrame(), framesWritten()
+*/
+bool QCanBusDevice::submitFrame(const QCanBusFrame &frame)
+{
+    Q_D(QCanBusDevice);
+
+    if (!frame.isValid())
+        return false;
+
+    d->submittedFramesCount.ref();
+    if (d->submittedFrames.enqueue(frame))
+        QMetaObject::invokeMethod(this, "_q_writeSubmittedFrames", Qt::QueuedConnection);
+    return true;
+}
+
 /*!
     \fn QString interpretErrorFrame(const QCanBusFrame &frame)
 
@@ -568,6 +1030,16 @@ void QCanBusDevice::disconnectDevice()
     \sa setState(), state()
 */
 
+/*!
+    \fn void QCanBusDevice::busStatusChanged(QCanBusDevice::CanBusStatus status)
+    \since 5.7
+
+    This signal is emitted when the state of the CAN controller changes to
+    \a status, for example when it turns error passive or bus off.
+
+    \sa busStatus(), busStatistics()
+*/
+
 /*!
     Returns the current state of the device.
 
@@ -590,7 +1062,168 @@ void QCanBusDevice::setState(QCanBusDevice::CanBusDeviceState newState)
         return;
 
     d->state = newState;
+    // full barrier, pairs with the registration in waitInOtherThread()
+    d->sharedState.fetchAndStoreOrdered(newState);
+    d->wakeWaiters(nullptr);
+    // nothing is known about the controller of a disconnected device
+    if (newState == QCanBusDevice::UnconnectedState)
+        setBusStatistics(QCanBusDevice::BusStatistics());
+    if (QSerialBusFlightRecorderPrivate *recorder = d->flightRecorder.loadAcquire()) {
+        recorder->record(d->flightRecorderInterface, QSerialBusFlightRecorderPrivate::StateChange,
+                         0, quint32(newState), 0);
+    }
     emit stateChanged(newState);
+    d->callReceiveHook();
+}
+
+void QCanBusDevicePrivate::callReceiveHook()
+{
+    Q_Q(QCanBusDevice);
+
+    // resume from the event loop of the device thread, not from deep inside
+    // the backend; frames queued meanwhile are picked up in one go
+    if (receiveHook && !receiveHookQueued) {
+        receiveHookQueued = true;
+        QMetaObject::invokeMethod(q, "_q_callReceiveHook", Qt::QueuedConnection);
+    }
+}
+
+void QCanBusDevicePrivate::_q_callReceiveHook()
+{
+    receiveHookQueued = false;
+    // reset first, the hook may well set itself again
+    if (QCanBusDevice::ReceiveHook hook = receiveHook) {
+        receiveHook = nullptr;
+        hook(receiveHookData);
+    }
+}
+
+void QCanBusDevicePrivate::sampleTimeStampsOf(const QVector<QCanBusFrame> &frames)
+{
+    // The newest frame has the shortest delay, pair it with the time of reception.
+    for (int i = frames.size() - 1; i >= 0; --i) {
+        const QCanBusFrame &frame = frames.at(i);
+        if (frame.hasNormalizedTimeStamp())
+            continue;
+        const qint64 raw = toMicroseconds(frame.timeStamp());
+        if (raw != 0) {
+            timeStampNormalizer.addSample(raw, QCanBusTimeStampNormalizer::monotonicMicroseconds());
+            break;
+        }
+    }
+}
+
+void QCanBusDevicePrivate::_q_writeSubmittedFrames()
+{
+    Q_Q(QCanBusDevice);
+
+    // Bound the batch, so that busy producers cannot starve the event loop.
+    enum { MaximumBatchSize = 256 };
+
+    submittedFrames.beginDrain();
+    const int written = submittedFrames.drain([this, q](const QCanBusFrame &frame) {
+        q->writeFrame(frame);
+        submittedFramesCount.deref();
+    }, MaximumBatchSize);
+
+    // Lets waitForFramesWritten() notice an emptied queue.
+    wakeWaiters(nullptr);
+
+    if (written == MaximumBatchSize && submittedFrames.claimWakeUp())
+        QMetaObject::invokeMethod(q, "_q_writeSubmittedFrames", Qt::QueuedConnection);
+}
+
+bool QCanBusDevicePrivate::waitInDeviceThread(WaitTarget target, int msecs)
+{
+    Q_Q(QCanBusDevice);
+
+    if (waitingInDeviceThread) {
+        qWarning("QCanBusDevice: recursive wait calls are not supported");
+        return false;
+    }
+    QScopedValueRollback<bool> guard(waitingInDeviceThread, true);
+
+    enum { Signaled, TimedOut, Failed };
+    QEventLoop loop;
+    if (target == FramesReceived) {
+        QObject::connect(q, &QCanBusDevice::framesReceived, &loop,
+                         [&loop]() { loop.exit(Signaled); });
+    } else {
+        QObject::connect(q, &QCanBusDevice::framesWritten, &loop,
+                         [&loop]() { loop.exit(Signaled); });
+    }
+    QObject::connect(q, &QCanBusDevice::errorOccurred, &loop, [&loop]() { loop.exit(Failed); });
+    QObject::connect(q, &QCanBusDevice::stateChanged, &loop,
+                     [&loop](QCanBusDevice::CanBusDeviceState state) {
+        if (state != QCanBusDevice::ConnectedState)
+            loop.exit(Failed);
+    });
+
+    QTimer timer;
+    timer.setSingleShot(true);
+    QObject::connect(&timer, &QTimer::timeout, &loop, [&loop]() { loop.exit(TimedOut); });
+    if (msecs >= 0)
+        timer.start(msecs);
+
+    return loop.exec(QEventLoop::ExcludeUserInputEvents) == Signaled;
+}
+
+bool QCanBusDevicePrivate::waitInOtherThread(WaitTarget target, int msecs)
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    QMutexLocker locker(&incomingFramesGuard);
+    const quint64 written = writtenGeneration;
+    const quint64 errors = errorGeneration;
+
+    const auto pendingFrames = [this]() {
+        return outgoingFramesCount.load() + submittedFramesCount.load();
+    };
+
+    // there has to be something to wait for when we start
+    if (target == FramesWritten && pendingFrames() == 0)
+        return false;
+
+    waiters.ref();
+    bool result = false;
+    forever {
+        if (errorGeneration != errors || sharedState.load() != QCanBusDevice::ConnectedState)
+            break;
+        if (target == FramesReceived && !incomingFrames.isEmpty()) {
+            result = true;
+            break;
+        }
+        if (target == FramesWritten && (writtenGeneration != written || pendingFrames() == 0)) {
+            result = true;
+            break;
+        }
+
+        unsigned long remaining = ULONG_MAX;
+        if (msecs >= 0) {
+            const qint64 left = msecs - elapsed.elapsed();
+            if (left <= 0)
+                break;
+            remaining = left;
+        }
+        waitCondition.wait(&incomingFramesGuard, remaining);
+    }
+    waiters.deref();
+    return result;
 }
 
+void QCanBusDevicePrivate::wakeWaiters(quint64 *generation)
+{
+    // Events before a waiter registered itself are not of interest to it.
+    if (!waiters.load())
+        return;
+
+    QMutexLocker locker(&incomingFramesGuard);
+    if (generation)
+        ++*generation;
+    waitCondition.wakeAll();
+}
+
+#include "moc_qcanbusdevice.cpp"
+
 QT_END_NAMESPACE
@@ -69,6 +69,15 @@ public:
     };
     Q_ENUM(CanBusDeviceState)
 
+    enum CanBusStatus {
+        UnknownStatus,
+        GoodStatus,
+        WarningStatus,
+        ErrorStatus,
+        BusOffStatus
+    };
+    Q_ENUM(CanBusStatus)
+
     enum ConfigurationKey {
         RawFilterKey = 0,
         ErrorFilterKey,
@@ -76,6 +85,10 @@ public:
         ReceiveOwnKey,
         BitRateKey,
         CanFdKey,
+        CanXlKey,
+        RawFilterFalsePositiveBudgetKey,
+        BusStatusIntervalKey,
+        TimeStampNormalizationKey,
         UserKey = 30
     };
     Q_ENUM(ConfigurationKey)
@@ -95,6 +108,17 @@ public:
         FormatFilter format = MatchBaseAndExtendedFormat;
     };
 
+    struct BusStatistics
+    {
+        CanBusStatus status = UnknownStatus;
+        int transmitErrorCounter = -1;
+        int receiveErrorCounter = -1;
+        quint32 busErrors = 0;
+        quint32 restarts = 0;
+        quint64 receiveDropped = 0;
+        quint64 receiveOverErrors = 0;
+    };
+
     explicit QCanBusDevice(QObject *parent = nullptr);
 
     virtual void setConfigurationParameter(int key, const QVariant &value);
@@ -102,10 +126,21 @@ public:
     QVector<int> configurationKeys() const;
 
     virtual bool writeFrame(const QCanBusFrame &frame) = 0;
+    bool submitFrame(const QCanBusFrame &frame);
     QCanBusFrame readFrame();
+    QVector<QCanBusFrame> readAllFrames();
+    int readAllFrames(QVector<QCanBusFrame> *frames);
     qint64 framesAvailable() const;
     qint64 framesToWrite() const;
 
+    bool waitForFramesReceived(int msecs);
+    bool waitForFramesWritten(int msecs);
+
+    typedef void (*ReceiveHook)(void *data);
+    void setReceiveHook(ReceiveHook hook, void *data);
+    ReceiveHook receiveHook() const;
+    void *receiveHookData() const;
+
     // TODO rename these once QIODevice dependency has been removed
     bool connectDevice();
     void disconnectDevice();
@@ -115,6 +150,11 @@ public:
     CanBusError error() const;
     QString errorString() const;
 
+    CanBusStatus busStatus() const;
+    BusStatistics busStatistics() const;
+
+    QCanBusFrame::TimeStamp toNormalizedTimeStamp(const QCanBusFrame::TimeStamp &timeStamp) const;
+
     virtual QString interpretErrorFrame(const QCanBusFrame &errorFrame) = 0;
 
 Q_SIGNALS:
@@ -122,10 +162,12 @@ Q_SIGNALS:
     void framesReceived();
     void framesWritten(qint64 framesCount);
     void stateChanged(QCanBusDevice::CanBusDeviceState state);
+    void busStatusChanged(QCanBusDevice::CanBusStatus status);
 
 protected:
     void setState(QCanBusDevice::CanBusDeviceState newState);
     void setError(const QString &errorText, QCanBusDevice::CanBusError);
+    void setBusStatistics(const QCanBusDevice::BusStatistics &statistics);
 
     void enqueueReceivedFrames(const QVector<QCanBusFrame> &newFrames);
 
@@ -137,10 +179,16 @@ protected:
     //      Can be folded into one call to connectDevice() & disconnectDevice()
     virtual bool open() = 0;
     virtual void close() = 0;
+
+private:
+    Q_PRIVATE_SLOT(d_func(), void _q_writeSubmittedFrames())
+    Q_PRIVATE_SLOT(d_func(), void _q_callReceiveHook())
 };
 
 Q_DECLARE_TYPEINFO(QCanBusDevice::CanBusError, Q_PRIMITIVE_TYPE);
 Q_DECLARE_TYPEINFO(QCanBusDevice::CanBusDeviceState, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(QCanBusDevice::CanBusStatus, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(QCanBusDevice::BusStatistics, Q_PRIMITIVE_TYPE);
 Q_DECLARE_TYPEINFO(QCanBusDevice::ConfigurationKey, Q_PRIMITIVE_TYPE);
 Q_DECLARE_TYPEINFO(QCanBusDevice::Filter, Q_PRIMITIVE_TYPE);
 Q_DECLARE_TYPEINFO(QCanBusDevice::Filter::FormatFilter, Q_PRIMITIVE_TYPE);
@@ -38,9 +38,12 @@
 #define QCANBUSDEVICE_P_H
 
 #include <QtCore/qmutex.h>
+#include <QtCore/qwaitcondition.h>
 #include <QtSerialBus/qcanbusdevice.h>
 
 #include <private/qobject_p.h>
+#include <private/qmpscqueue_p.h>
+#include <private/qcanbustimestampnormalizer_p.h>
 
 //
 //  W A R N I N G
@@ -55,6 +58,9 @@
 
 QT_BEGIN_NAMESPACE
 
+class QCanBusE2ECheckerPrivate;
+class QSerialBusFlightRecorderPrivate;
+
 typedef QPair<int, QVariant > ConfigEntry;
 
 class QCanBusDevicePrivate : public QObjectPrivate
@@ -70,11 +76,51 @@ public:
     QCanBusDevice::CanBusError lastError;
     QCanBusDevice::CanBusDeviceState state;
     QString errorText;
+    QCanBusDevice::BusStatistics busStatistics;
 
     QVector<QCanBusFrame> incomingFrames;
-    QMutex incomingFramesGuard;
+    mutable QMutex incomingFramesGuard;
     QVector<QCanBusFrame> outgoingFrames;
+    // mirrors of outgoingFrames.size() and state for waiters in other threads
+    QAtomicInt outgoingFramesCount;
+    QAtomicInt sharedState;
     QVector<ConfigEntry> configOptions;
+
+    enum WaitTarget { FramesReceived, FramesWritten };
+    bool waitInDeviceThread(WaitTarget target, int msecs);
+    bool waitInOtherThread(WaitTarget target, int msecs);
+    void wakeWaiters(quint64 *generation);
+
+    void _q_writeSubmittedFrames();
+
+    // Waiters in other threads block on waitCondition, guarded by incomingFramesGuard.
+    QWaitCondition waitCondition;
+    QAtomicInt waiters;
+    quint64 writtenGeneration = 0;
+    quint64 errorGeneration = 0;
+    bool waitingInDeviceThread = false;
+
+    QMpscQueue<QCanBusFrame> submittedFrames;
+    QAtomicInt submittedFramesCount;
+
+    void callReceiveHook();
+    void _q_callReceiveHook();
+
+    QCanBusDevice::ReceiveHook receiveHook = nullptr;
+    void *receiveHookData = nullptr;
+    bool receiveHookQueued = false;
+
+    void sampleTimeStampsOf(const QVector<QCanBusFrame> &frames);
+
+    QCanBusTimeStampNormalizer timeStampNormalizer;
+    bool normalizeTimeStamps = false;
+
+    // set by QSerialBusFlightRecorder::attach(), read in any thread
+    QAtomicPointer<QSerialBusFlightRecorderPrivate> flightRecorder;
+    quint16 flightRecorderInterface = 0;
+
+    // set by QCanBusE2EChecker::attach(), read in any thread
+    QAtomicPointer<QCanBusE2ECheckerPrivate> e2eChecker;
 };
 
 QT_END_NAMESPACE
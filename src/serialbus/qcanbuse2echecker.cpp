@@ -0,0 +1,574 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qcanbuse2echecker.h"
+#include "qcanbuse2echecker_p.h"
+#include "qcanbusdevice.h"
+#include "qcanbusdevice_p.h"
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QCanBusE2EChecker
+    \inmodule QtSerialBus
+    \since 5.7
+
+    \brief The QCanBusE2EChecker class verifies the end-to-end (E2E)
+    protection of received CAN frames.
+
+    Safety-relevant signals are commonly protected end-to-end in the style of
+    AUTOSAR E2E: the sender adds a CRC, computed over the payload and a data
+    identifier known to both sides, and a counter that is incremented for
+    every frame. A receiver detects corrupted, repeated, lost and
+    out-of-sequence frames from them.
+
+    A checker attached to a QCanBusDevice verifies each batch of received
+    frames before it is queued for \l QCanBusDevice::readFrame(). The result
+    is stored in the frames, see \l QCanBusFrame::e2eStatus(). Frames that
+    failed the check are dropped instead if \l setDropsFailedFrames() is
+    enabled. Error statistics are kept for every protected identifier.
+
+    \code
+    QCanBusE2EChecker::Protection protection;
+    protection.crcType = QCanBusE2EChecker::Crc8SaeJ1850;
+    protection.dataId = 0x0123;
+    protection.crcOffset = 0;
+    protection.counterOffset = 1;
+
+    auto checker = new QCanBusE2EChecker(this);
+    checker->setProtection(0x100, protection);
+    checker->attach(canDevice);
+    \endcode
+
+    The CRCs are computed with lookup tables and the protections are found by
+    a single hash lookup per frame, so checking hundreds of identifiers at bus
+    rate adds little to the cost of receiving the frames. \l check() can also
+    be called directly, for example on recorded frames.
+
+    A device can be attached to one checker at a time. Attach and detach
+    devices in the thread the checker lives in, and destroy the checker only
+    after the attached devices stopped receiving frames, for example because
+    they were disconnected. Devices in different threads can share a checker.
+*/
+
+/*!
+    \enum QCanBusE2EChecker::CrcType
+
+    This enum describes the CRCs protecting a frame. The CRC covers the
+    payload without the CRC itself, and the data identifier as two bytes,
+    low byte first.
+
+    \value Crc8SaeJ1850     The 8 bit CRC of SAE J1850 (polynomial \c 0x1D,
+                            start value and final XOR value \c 0xFF), as used
+                            by AUTOSAR E2E profiles 1 and 11. The data
+                            identifier precedes the payload.
+    \value Crc8H2F          The 8 bit CRC with polynomial \c 0x2F (start value
+                            and final XOR value \c 0xFF), known as CRC8H2F in
+                            AUTOSAR. The data identifier precedes the
+                            payload.
+    \value Crc16CcittFalse  The 16 bit CRC of CCITT (polynomial \c 0x1021,
+                            start value \c 0xFFFF, no final XOR), as used by
+                            AUTOSAR E2E profile 5. The CRC is stored in
+                            little-endian byte order, and the data identifier
+                            follows the payload.
+*/
+
+/*!
+    \class QCanBusE2EChecker::Protection
+    \inmodule QtSerialBus
+    \since 5.7
+
+    \brief The QCanBusE2EChecker::Protection struct describes how the frames
+    with one identifier are protected.
+
+    \sa QCanBusE2EChecker::setProtection()
+*/
+
+/*!
+    \variable QCanBusE2EChecker::Protection::crcType
+
+    \brief the CRC protecting the frames. The default is \l Crc8SaeJ1850.
+*/
+
+/*!
+    \variable QCanBusE2EChecker::Protection::dataId
+
+    \brief the data identifier included in the CRC.
+*/
+
+/*!
+    \variable QCanBusE2EChecker::Protection::crcOffset
+
+    \brief the position of the first byte of the CRC in the payload. The
+    default is \c 0.
+*/
+
+/*!
+    \variable QCanBusE2EChecker::Protection::counterOffset
+
+    \brief the position of the byte holding the counter in the payload. The
+    default is \c 1.
+*/
+
+/*!
+    \variable QCanBusE2EChecker::Protection::counterBits
+
+    \brief the number of bits of the counter, from 1 to 8. The counter is
+    stored in the lowest bits of its byte. The default is \c 4.
+*/
+
+/*!
+    \variable QCanBusE2EChecker::Protection::maxDeltaCounter
+
+    \brief the largest permitted increment of the counter between two frames.
+    The default is \c 1, which means that no frame may be lost.
+*/
+
+/*!
+    \class QCanBusE2EChecker::Statistics
+    \inmodule QtSerialBus
+    \since 5.7
+
+    \brief The QCanBusE2EChecker::Statistics struct holds the error
+    statistics of one protected identifier.
+
+    \sa QCanBusE2EChecker::statistics()
+*/
+
+/*!
+    \variable QCanBusE2EChecker::Statistics::checkedFrames
+
+    \brief the number of frames checked.
+*/
+
+/*!
+    \variable QCanBusE2EChecker::Statistics::lostFrames
+
+    \brief the number of frames lost, as derived from the counter increments
+    of frames with status \l QCanBusFrame::E2EOkSomeLost.
+*/
+
+/*!
+    \variable QCanBusE2EChecker::Statistics::repeatedFrames
+
+    \brief the number of frames with status \l QCanBusFrame::E2ERepeated.
+*/
+
+/*!
+    \variable QCanBusE2EChecker::Statistics::wrongSequenceFrames
+
+    \brief the number of frames with status \l QCanBusFrame::E2EWrongSequence.
+*/
+
+/*!
+    \variable QCanBusE2EChecker::Statistics::wrongCrcFrames
+
+    \brief the number of frames with status \l QCanBusFrame::E2EWrongCrc.
+*/
+
+/*!
+    \variable QCanBusE2EChecker::Statistics::wrongLengthFrames
+
+    \brief the number of frames with status \l QCanBusFrame::E2EWrongLength.
+*/
+
+/*!
+    Constructs a checker without any protection with the specified \a parent.
+*/
+QCanBusE2EChecker::QCanBusE2EChecker(QObject *parent)
+    : QObject(*new QCanBusE2ECheckerPrivate, parent)
+{
+}
+
+/*!
+    Destroys the checker and detaches it from all devices.
+*/
+QCanBusE2EChecker::~QCanBusE2EChecker()
+{
+    Q_D(QCanBusE2EChecker);
+    while (!d->m_devices.isEmpty())
+        detach(d->m_devices.first());
+}
+
+/*!
+    Checks the frames with the identifier \a frameId as described by
+    \a protection. Any protection set before for the identifier is replaced,
+    and its statistics and counter are reset.
+*/
+void QCanBusE2EChecker::setProtection(quint32 frameId, const Protection &protection)
+{
+    Q_D(QCanBusE2EChecker);
+    QCanBusE2ECheckerPrivate::Entry entry;
+    entry.protection = protection;
+    entry.protection.counterBits = qBound(1, protection.counterBits, 8);
+
+    QMutexLocker locker(&d->m_mutex);
+    d->m_entries.insert(frameId, entry);
+}
+
+/*!
+    Stops checking the frames with the identifier \a frameId.
+*/
+void QCanBusE2EChecker::removeProtection(quint32 frameId)
+{
+    Q_D(QCanBusE2EChecker);
+    QMutexLocker locker(&d->m_mutex);
+    d->m_entries.remove(frameId);
+}
+
+/*!
+    Returns the protection of the frames with the identifier \a frameId, or
+    a default constructed protection if the frames are not checked.
+*/
+QCanBusE2EChecker::Protection QCanBusE2EChecker::protection(quint32 frameId) const
+{
+    Q_D(const QCanBusE2EChecker);
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_entries.value(frameId).protection;
+}
+
+/*!
+    Returns the identifiers of the checked frames in ascending order.
+*/
+QVector<quint32> QCanBusE2EChecker::protectedFrameIds() const
+{
+    Q_D(const QCanBusE2EChecker);
+    QVector<quint32> frameIds;
+    {
+        QMutexLocker locker(&d->m_mutex);
+        frameIds.reserve(d->m_entries.size());
+        for (auto it = d->m_entries.cbegin(); it != d->m_entries.cend(); ++it)
+            frameIds.append(it.key());
+    }
+    std::sort(frameIds.begin(), frameIds.end());
+    return frameIds;
+}
+
+/*!
+    Returns \c true if frames that fail the check are dropped; otherwise
+    \c false. The default is \c false.
+
+    \sa setDropsFailedFrames()
+*/
+bool QCanBusE2EChecker::dropsFailedFrames() const
+{
+    Q_D(const QCanBusE2EChecker);
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_dropsFailedFrames;
+}
+
+/*!
+    Drops frames that fail the check if \a drop is \c true; otherwise they
+    are kept with their \l QCanBusFrame::e2eStatus() set. Frames fail the
+    check with the status \l QCanBusFrame::E2ERepeated,
+    \l QCanBusFrame::E2EWrongSequence, \l QCanBusFrame::E2EWrongCrc or
+    \l QCanBusFrame::E2EWrongLength.
+*/
+void QCanBusE2EChecker::setDropsFailedFrames(bool drop)
+{
+    Q_D(QCanBusE2EChecker);
+    QMutexLocker locker(&d->m_mutex);
+    d->m_dropsFailedFrames = drop;
+}
+
+/*!
+    Starts checking the frames received by \a device. The device is
+    detached from any other checker.
+*/
+void QCanBusE2EChecker::attach(QCanBusDevice *device)
+{
+    Q_D(QCanBusE2EChecker);
+    if (!device)
+        return;
+
+    detach(device);
+    d->m_devices.append(device);
+    QCanBusDevicePrivate *dd = static_cast<QCanBusDevicePrivate *>(QObjectPrivate::get(device));
+    dd->e2eChecker.storeRelease(d);
+}
+
+/*!
+    Stops checking the frames received by \a device.
+*/
+void QCanBusE2EChecker::detach(QCanBusDevice *device)
+{
+    Q_D(QCanBusE2EChecker);
+    d->m_devices.removeAll(device);
+    if (!device)
+        return;
+
+    QCanBusDevicePrivate *dd = static_cast<QCanBusDevicePrivate *>(QObjectPrivate::get(device));
+    if (QCanBusE2ECheckerPrivate *other = dd->e2eChecker.load()) {
+        // a device attached to another checker is detached from that one
+        if (other != d)
+            other->q_func()->detach(device);
+        else
+            dd->e2eChecker.storeRelease(nullptr);
+    }
+}
+
+/*!
+    Checks the protected frames in \a frames and sets their
+    \l QCanBusFrame::e2eStatus(). If \l dropsFailedFrames() is \c true,
+    frames that failed the check are removed from \a frames. Returns the
+    number of frames that failed the check.
+
+    Frames are checked in order and update the counters of their
+    identifier, so a batch must not be checked twice.
+*/
+int QCanBusE2EChecker::check(QVector<QCanBusFrame> *frames)
+{
+    Q_D(QCanBusE2EChecker);
+    if (!frames)
+        return 0;
+    return d->check(frames);
+}
+
+/*!
+    Returns the error statistics of the frames with the identifier
+    \a frameId.
+*/
+QCanBusE2EChecker::Statistics QCanBusE2EChecker::statistics(quint32 frameId) const
+{
+    Q_D(const QCanBusE2EChecker);
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_entries.value(frameId).statistics;
+}
+
+/*!
+    Resets the error statistics of all identifiers.
+*/
+void QCanBusE2EChecker::resetStatistics()
+{
+    Q_D(QCanBusE2EChecker);
+    QMutexLocker locker(&d->m_mutex);
+    for (auto it = d->m_entries.begin(); it != d->m_entries.end(); ++it)
+        it->statistics = Statistics();
+}
+
+/*!
+    Forgets the last counter of all identifiers, so the next frame of each
+    is accepted with status \l QCanBusFrame::E2EInitial. Call this function
+    when the frames of the senders were interrupted, for example after the
+    device reconnected.
+*/
+void QCanBusE2EChecker::resetCounters()
+{
+    Q_D(QCanBusE2EChecker);
+    QMutexLocker locker(&d->m_mutex);
+    for (auto it = d->m_entries.begin(); it != d->m_entries.end(); ++it)
+        it->lastCounter = -1;
+}
+
+static bool isFailure(QCanBusFrame::E2EStatus status)
+{
+    switch (status) {
+    case QCanBusFrame::E2ERepeated:
+    case QCanBusFrame::E2EWrongSequence:
+    case QCanBusFrame::E2EWrongCrc:
+    case QCanBusFrame::E2EWrongLength:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int QCanBusE2ECheckerPrivate::check(QVector<QCanBusFrame> *frames)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_entries.isEmpty())
+        return 0;
+
+    int failed = 0;
+    int kept = 0;
+    for (int i = 0; i < frames->size(); ++i) {
+        const QCanBusFrame &frame = frames->at(i);
+        QCanBusFrame::E2EStatus status = QCanBusFrame::E2ENotChecked;
+        if (frame.frameType() == QCanBusFrame::DataFrame) {
+            const auto it = m_entries.find(frame.frameId());
+            if (it != m_entries.end()) {
+                status = checkFrame(&*it, frame);
+                // only detaches the frames if a protected one was received
+                (*frames)[i].setE2EStatus(status);
+            }
+        }
+
+        if (isFailure(status)) {
+            ++failed;
+            if (m_dropsFailedFrames)
+                continue;
+        }
+        if (kept != i)
+            (*frames)[kept] = frames->at(i);
+        ++kept;
+    }
+    if (kept != frames->size())
+        frames->resize(kept);
+    return failed;
+}
+
+QCanBusFrame::E2EStatus QCanBusE2ECheckerPrivate::checkFrame(Entry *entry,
+                                                               const QCanBusFrame &frame)
+{
+    const QCanBusE2EChecker::Protection &protection = entry->protection;
+    QCanBusE2EChecker::Statistics &statistics = entry->statistics;
+    ++statistics.checkedFrames;
+
+    // payload() would copy a CAN XL payload of up to 2048 bytes under the lock
+    const int headerSize = frame.hasCanXlFormat() ? int(QCanBusFrame::XlHeaderSize) : 0;
+    const int size = frame.load.size() - headerSize;
+    const int crcSize = (protection.crcType == QCanBusE2EChecker::Crc16CcittFalse) ? 2 : 1;
+    if (protection.crcOffset < 0 || protection.counterOffset < 0
+            || size < protection.crcOffset + crcSize
+            || size <= protection.counterOffset) {
+        ++statistics.wrongLengthFrames;
+        return QCanBusFrame::E2EWrongLength;
+    }
+
+    const uchar *data = reinterpret_cast<const uchar *>(frame.load.constData()) + headerSize;
+    quint16 received = data[protection.crcOffset];
+    if (crcSize == 2)
+        received |= quint16(data[protection.crcOffset + 1] << 8);
+    if (crc(protection.crcType, protection.dataId, data, size,
+            protection.crcOffset) != received) {
+        ++statistics.wrongCrcFrames;
+        return QCanBusFrame::E2EWrongCrc;
+    }
+
+    const int mask = (1 << protection.counterBits) - 1;
+    const int counter = data[protection.counterOffset] & mask;
+    const int lastCounter = entry->lastCounter;
+    entry->lastCounter = counter;
+    if (lastCounter < 0)
+        return QCanBusFrame::E2EInitial;
+
+    const int delta = (counter - lastCounter) & mask;
+    if (delta == 0) {
+        ++statistics.repeatedFrames;
+        return QCanBusFrame::E2ERepeated;
+    }
+    if (delta == 1)
+        return QCanBusFrame::E2EOk;
+    if (delta <= protection.maxDeltaCounter) {
+        statistics.lostFrames += delta - 1;
+        return QCanBusFrame::E2EOkSomeLost;
+    }
+    // synchronize to the new counter, the next frame in sequence is fine again
+    ++statistics.wrongSequenceFrames;
+    return QCanBusFrame::E2EWrongSequence;
+}
+
+namespace {
+
+// Byte-wise lookup tables for the MSB-first CRCs. Classic and CAN FD payloads
+// have at most 64 bytes, too short for slicing or carry-less multiplication to
+// pay off; the rare CAN XL payload of up to 2048 bytes does not justify it either.
+struct CrcTables
+{
+    CrcTables()
+    {
+        for (int i = 0; i < 256; ++i) {
+            quint8 sae = quint8(i);
+            quint8 h2f = quint8(i);
+            quint16 ccitt = quint16(i << 8);
+            for (int bit = 0; bit < 8; ++bit) {
+                sae = quint8((sae & 0x80) ? (sae << 1) ^ 0x1D : sae << 1);
+                h2f = quint8((h2f & 0x80) ? (h2f << 1) ^ 0x2F : h2f << 1);
+                ccitt = quint16((ccitt & 0x8000) ? (ccitt << 1) ^ 0x1021 : ccitt << 1);
+            }
+            saeJ1850[i] = sae;
+            h2F[i] = h2f;
+            ccittFalse[i] = ccitt;
+        }
+    }
+
+    quint8 saeJ1850[256];
+    quint8 h2F[256];
+    quint16 ccittFalse[256];
+};
+
+const CrcTables &crcTables()
+{
+    static const CrcTables tables;
+    return tables;
+}
+
+inline quint8 crc8(const quint8 *table, quint8 crc, const uchar *data, int length)
+{
+    for (int i = 0; i < length; ++i)
+        crc = table[crc ^ data[i]];
+    return crc;
+}
+
+inline quint16 crc16(const quint16 *table, quint16 crc, const uchar *data, int length)
+{
+    for (int i = 0; i < length; ++i)
+        crc = quint16((crc << 8) ^ table[(crc >> 8) ^ data[i]]);
+    return crc;
+}
+
+} // namespace
+
+/*!
+    \internal
+
+    Returns the CRC of type \a type over the \a length bytes of \a data,
+    except for the CRC at \a crcOffset, and \a dataId.
+*/
+quint16 QCanBusE2ECheckerPrivate::crc(QCanBusE2EChecker::CrcType type, quint16 dataId,
+                                      const uchar *data, int length, int crcOffset)
+{
+    const CrcTables &tables = crcTables();
+    const uchar id[2] = { uchar(dataId & 0xff), uchar(dataId >> 8) };
+
+    if (type == QCanBusE2EChecker::Crc16CcittFalse) {
+        const int tail = crcOffset + 2;
+        quint16 crc = crc16(tables.ccittFalse, 0xffff, data, crcOffset);
+        crc = crc16(tables.ccittFalse, crc, data + tail, length - tail);
+        return crc16(tables.ccittFalse, crc, id, 2);
+    }
+
+    const quint8 *table = (type == QCanBusE2EChecker::Crc8H2F) ? tables.h2F : tables.saeJ1850;
+    const int tail = crcOffset + 1;
+    quint8 crc = crc8(table, 0xff, id, 2);
+    crc = crc8(table, crc, data, crcOffset);
+    crc = crc8(table, crc, data + tail, length - tail);
+    return quint8(crc ^ 0xff);
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,109 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCANBUSE2ECHECKER_H
+#define QCANBUSE2ECHECKER_H
+
+#include <QtCore/qobject.h>
+#include <QtCore/qvector.h>
+#include <QtSerialBus/qcanbusframe.h>
+#include <QtSerialBus/qserialbusglobal.h>
+
+QT_BEGIN_NAMESPACE
+
+class QCanBusDevice;
+class QCanBusE2ECheckerPrivate;
+
+class Q_SERIALBUS_EXPORT QCanBusE2EChecker : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QCanBusE2EChecker)
+
+public:
+    enum CrcType {
+        Crc8SaeJ1850,
+        Crc8H2F,
+        Crc16CcittFalse
+    };
+    Q_ENUM(CrcType)
+
+    struct Protection
+    {
+        CrcType crcType = Crc8SaeJ1850;
+        quint16 dataId = 0;
+        int crcOffset = 0;
+        int counterOffset = 1;
+        int counterBits = 4;
+        int maxDeltaCounter = 1;
+    };
+
+    struct Statistics
+    {
+        quint64 checkedFrames = 0;
+        quint64 lostFrames = 0;
+        quint64 repeatedFrames = 0;
+        quint64 wrongSequenceFrames = 0;
+        quint64 wrongCrcFrames = 0;
+        quint64 wrongLengthFrames = 0;
+    };
+
+    explicit QCanBusE2EChecker(QObject *parent = nullptr);
+    ~QCanBusE2EChecker();
+
+    void setProtection(quint32 frameId, const Protection &protection);
+    void removeProtection(quint32 frameId);
+    Protection protection(quint32 frameId) const;
+    QVector<quint32> protectedFrameIds() const;
+
+    bool dropsFailedFrames() const;
+    void setDropsFailedFrames(bool drop);
+
+    void attach(QCanBusDevice *device);
+    void detach(QCanBusDevice *device);
+
+    int check(QVector<QCanBusFrame> *frames);
+
+    Statistics statistics(quint32 frameId) const;
+    void resetStatistics();
+    void resetCounters();
+};
+
+Q_DECLARE_TYPEINFO(QCanBusE2EChecker::Protection, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(QCanBusE2EChecker::Statistics, Q_PRIMITIVE_TYPE);
+
+QT_END_NAMESPACE
+
+#endif // QCANBUSE2ECHECKER_H
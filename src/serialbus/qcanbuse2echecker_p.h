@@ -0,0 +1,87 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCANBUSE2ECHECKER_P_H
+#define QCANBUSE2ECHECKER_P_H
+
+#include <QtCore/qhash.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qpointer.h>
+#include <QtSerialBus/qcanbuse2echecker.h>
+
+#include <private/qobject_p.h>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+class QCanBusE2ECheckerPrivate : public QObjectPrivate
+{
+    Q_DECLARE_PUBLIC(QCanBusE2EChecker)
+
+public:
+    struct Entry
+    {
+        QCanBusE2EChecker::Protection protection;
+        QCanBusE2EChecker::Statistics statistics;
+        int lastCounter = -1;   // -1 until the first frame passed the CRC check
+    };
+
+    int check(QVector<QCanBusFrame> *frames);
+    static QCanBusFrame::E2EStatus checkFrame(Entry *entry, const QCanBusFrame &frame);
+    static quint16 crc(QCanBusE2EChecker::CrcType type, quint16 dataId,
+                       const uchar *data, int length, int crcOffset);
+
+    // Guards the entries, devices in different threads may share a checker.
+    mutable QMutex m_mutex;
+    QHash<quint32, Entry> m_entries;
+    bool m_dropsFailedFrames = false;
+
+    QVector<QPointer<QCanBusDevice>> m_devices;
+};
+
+QT_END_NAMESPACE
+
+#endif // QCANBUSE2ECHECKER_P_H
@@ -72,6 +72,11 @@ QT_BEGIN_NAMESPACE
     the \l hasExtendedFrameFormat() is not set although \l frameId() is longer than 11 bit or
     the payload is longer than the maximal permitted payload length of 64 byte.
 
+    For frames in \l {hasCanXlFormat()}{CAN XL format}, this function returns
+    \c false unless the frame is a \l DataFrame with an 11 bit priority
+    identifier, \l hasExtendedFrameFormat() not set and a payload of 1 to
+    2048 bytes.
+
     Otherwise this function returns \c true.
 */
 
@@ -90,7 +95,8 @@ QT_BEGIN_NAMESPACE
 
     Sets \a data as the payload for the CAN frame. The maximum size of payload is 8 bytes, which can
     be extended up to 64 bytes by supporting \e {Flexible Data-Rate}. Flexible Data-Rate has to be
-    enabled on the \l QCanBusDevice by setting the \l QCanBusDevice::CanFdKey.
+    enabled on the \l QCanBusDevice by setting the \l QCanBusDevice::CanFdKey. CAN XL frames
+    carry up to 2048 bytes, see \l hasCanXlFormat().
 
     Frames of type \l RemoteRequestFrame (RTR) do not have a payload. However they have to
     provide an indication of the responses expected payload length. To set the length expection it
@@ -107,15 +113,144 @@ QT_BEGIN_NAMESPACE
     \sa payload()
 */
 
+/*!
+    \fn bool QCanBusFrame::hasCanXlFormat() const
+    \since 5.7
+
+    Returns \c true if the frame is a CAN XL frame; otherwise \c false.
+
+    CAN XL frames carry up to 2048 bytes of payload. Their \l frameId() is
+    the 11 bit priority identifier used for arbitration. In addition, they
+    have a \l serviceDataUnitType(), an \l acceptanceField() and the
+    \l {hasSimpleExtendedContent()}{SEC} flag. Sending and receiving CAN XL
+    frames has to be enabled on the \l QCanBusDevice by setting the
+    \l QCanBusDevice::CanXlKey.
+
+    \sa setCanXlFormat()
+*/
+
+/*!
+    \fn void QCanBusFrame::setCanXlFormat(bool isCanXl)
+    \since 5.7
+
+    Marks the frame as CAN XL frame if \a isCanXl is \c true. The payload is
+    kept; the acceptance field is reset when the format changes.
+
+    \sa hasCanXlFormat()
+*/
+
+/*!
+    \fn quint8 QCanBusFrame::serviceDataUnitType() const
+    \since 5.7
+
+    Returns the service data unit (SDU) type of a CAN XL frame, which
+    describes the content of the payload.
+
+    \sa setServiceDataUnitType(), hasCanXlFormat()
+*/
+
+/*!
+    \fn void QCanBusFrame::setServiceDataUnitType(quint8 type)
+    \since 5.7
+
+    Sets the service data unit type of a CAN XL frame to \a type.
+
+    \sa serviceDataUnitType()
+*/
+
+/*!
+    \fn bool QCanBusFrame::hasSimpleExtendedContent() const
+    \since 5.7
+
+    Returns \c true if the simple extended content (SEC) flag of a CAN XL
+    frame is set; otherwise \c false.
+
+    \sa setSimpleExtendedContent(), hasCanXlFormat()
+*/
+
+/*!
+    \fn void QCanBusFrame::setSimpleExtendedContent(bool sec)
+    \since 5.7
+
+    Sets the simple extended content flag of a CAN XL frame to \a sec.
+
+    \sa hasSimpleExtendedContent()
+*/
+
+/*!
+    \fn quint32 QCanBusFrame::acceptanceField() const
+    \since 5.7
+
+    Returns the 32 bit acceptance field of a CAN XL frame. For other frames,
+    this function returns 0.
+
+    \sa setAcceptanceField(), hasCanXlFormat()
+*/
+
+/*!
+    \fn void QCanBusFrame::setAcceptanceField(quint32 field)
+    \since 5.7
+
+    Sets the acceptance field of a CAN XL frame to \a field. This function
+    does nothing unless hasCanXlFormat() returns \c true, so the format has
+    to be set first.
+
+    \sa acceptanceField()
+*/
+
+/*!
+    \fn QCanBusFrame::E2EStatus QCanBusFrame::e2eStatus() const
+    \since 5.7
+
+    Returns the result of the end-to-end protection check of the frame. Frames
+    received by a device with a QCanBusE2EChecker attached carry the result of
+    the check.
+
+    \sa setE2EStatus()
+*/
+
+/*!
+    \fn void QCanBusFrame::setE2EStatus(E2EStatus status)
+    \since 5.7
+
+    Sets the result of the end-to-end protection check of the frame to
+    \a status.
+
+    \sa e2eStatus()
+*/
+
 /*!
     \fn QCanBusFrame::setTimeStamp(const TimeStamp &ts)
 
     Sets \a ts as the timestamp for the CAN frame. Usually, this function is not needed, because the
     timestamp is created during the read operation and not needed during the write operation.
 
+    The frame no longer has a normalized timestamp afterwards.
+
     \sa QCanBusFrame::TimeStamp
 */
 
+/*!
+    \fn bool QCanBusFrame::hasNormalizedTimeStamp() const
+    \since 5.7
+
+    Returns \c true if timeStamp() has been mapped onto the monotonic clock of
+    the system; otherwise \c false. Received frames carry the timestamp of the
+    backend; \l QCanBusDevice::toNormalizedTimeStamp() maps it.
+
+    \sa setNormalizedTimeStamp()
+*/
+
+/*!
+    \fn void QCanBusFrame::setNormalizedTimeStamp(const TimeStamp &ts)
+    \since 5.7
+
+    Sets \a ts, the timestamp of the frame on the monotonic clock of the
+    system, as timeStamp(). The timestamp set so far is replaced.
+
+    \sa hasNormalizedTimeStamp()
+*/
+
 /*!
     \fn quint32 QCanBusFrame::frameId() const
 
@@ -181,6 +316,31 @@ QT_BEGIN_NAMESPACE
     \value AnyError                     Matches every other error type.
 */
 
+/*!
+    \enum QCanBusFrame::E2EStatus
+    \since 5.7
+
+    This enum describes the result of the end-to-end (E2E) protection check
+    of a received frame, see QCanBusE2EChecker.
+
+    \value E2ENotChecked        The frame was not checked, because no
+                                protection is configured for its identifier.
+    \value E2EOk                The CRC is correct and the counter was
+                                incremented by one.
+    \value E2EInitial           The CRC is correct; the frame is the first
+                                one checked for its identifier, so the
+                                counter could not be verified.
+    \value E2EOkSomeLost        The CRC is correct; the counter skipped some
+                                values, but not more than permitted.
+    \value E2ERepeated          The CRC is correct, but the counter did not
+                                change.
+    \value E2EWrongSequence     The CRC is correct, but the counter skipped
+                                more values than permitted.
+    \value E2EWrongCrc          The CRC does not match the frame.
+    \value E2EWrongLength       The payload is too short to contain the CRC
+                                and the counter.
+*/
+
 /*!
     \fn FrameType QCanBusFrame::frameType() const
 
@@ -208,7 +368,11 @@ QT_BEGIN_NAMESPACE
 /*!
     \fn TimeStamp QCanBusFrame::timeStamp() const
 
-    Returns the timestamp of the frame.
+    Returns the timestamp of the frame. If hasNormalizedTimeStamp() returns
+    \c true, it is a timestamp on the monotonic clock of the system, which can
+    be compared across devices. Otherwise, the clock behind the timestamp
+    depends on the backend: SocketCAN uses the wall clock time of the kernel,
+    while other backends count from a point in time defined by their driver.
 
     \sa QCanBusFrame::TimeStamp, QCanBusFrame::setTimeStamp()
 */
@@ -283,17 +447,44 @@ QT_BEGIN_NAMESPACE
 
     Writes a \a frame to the stream (\a out) and returns a reference
     to the it.
+
+    Each frame carries the version of its layout. Frames written by Qt 5.6
+    have version 0, which is still used for classic and CAN FD frames.
+    CAN XL frames are written as version 1, which appends the CAN XL fields,
+    and frames with a normalized timestamp as version 2, which also appends
+    the normalized flag.
+
+    \note Readers from before Qt 5.7 ignore the version and do not skip the
+    appended fields, so they lose track of a stream as soon as it contains a
+    CAN XL frame or a frame with a normalized timestamp. Streams meant for
+    such readers must contain neither.
+
+    \sa QCanBusFrame::hasCanXlFormat(), QCanBusFrame::hasNormalizedTimeStamp()
 */
 QDataStream &operator<<(QDataStream &out, const QCanBusFrame &frame)
 {
+    // CAN XL frames are written as version 1, which appends the CAN XL fields.
+    // Frames with a normalized timestamp are written as version 2, which also
+    // appends the normalized flag. All other frames keep the version 0 layout.
+    const quint8 version = frame.hasNormalizedTimeStamp() ? 2
+        : frame.hasCanXlFormat() ? 1 : frame.version;
+
     out << frame.frameId();
     out << static_cast<quint8>(frame.frameType());
-    out << static_cast<quint8>(frame.version);
+    out << version;
     out << frame.hasExtendedFrameFormat();
     out << frame.payload();
     const QCanBusFrame::TimeStamp stamp = frame.timeStamp();
     out << stamp.seconds();
     out << stamp.microSeconds();
+    if (version >= 1) {
+        out << frame.hasCanXlFormat();
+        out << frame.serviceDataUnitType();
+        out << frame.hasSimpleExtendedContent();
+        out << frame.acceptanceField();
+    }
+    if (version >= 2)
+        out << frame.hasNormalizedTimeStamp();
     return out;
 }
 
@@ -301,6 +492,10 @@ QDataStream &operator<<(QDataStream &out, const QCanBusFrame &frame)
 
     Reads a \a frame from the stream (\a in) and returns a
     reference to the it.
+
+    Frames of version 0, 1 and 2 can be mixed in one stream; the fields
+    appended by a later version are read according to the version of each
+    frame.
 */
 QDataStream &operator>>(QDataStream &in, QCanBusFrame &frame)
 {
@@ -315,14 +510,32 @@ QDataStream &operator>>(QDataStream &in, QCanBusFrame &frame)
     in >> frameId >> frameType >> version >> extendedFrameFormat
        >> payload >> seconds >> microSeconds;
 
+    bool canXlFormat = false;
+    quint8 serviceDataUnitType = 0;
+    bool simpleExtendedContent = false;
+    quint32 acceptanceField = 0;
+    if (version >= 1)
+        in >> canXlFormat >> serviceDataUnitType >> simpleExtendedContent >> acceptanceField;
+
+    bool normalizedTimeStamp = false;
+    if (version >= 2)
+        in >> normalizedTimeStamp;
+
     frame.setFrameId(frameId);
     frame.version = version;
+    frame.setCanXlFormat(canXlFormat);
+    frame.setServiceDataUnitType(serviceDataUnitType);
+    frame.setSimpleExtendedContent(simpleExtendedContent);
+    frame.setAcceptanceField(acceptanceField);
 
     frame.setFrameType(static_cast<QCanBusFrame::FrameType>(frameType));
     frame.setExtendedFrameFormat(extendedFrameFormat);
     frame.setPayload(payload);
 
-    frame.setTimeStamp(QCanBusFrame::TimeStamp(seconds, microSeconds));
+    if (normalizedTimeStamp)
+        frame.setNormalizedTimeStamp(QCanBusFrame::TimeStamp(seconds, microSeconds));
+    else
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(seconds, microSeconds));
 
     return in;
 }
@@ -37,6 +37,7 @@
 #ifndef QCANBUSFRAME_H
 #define QCANBUSFRAME_H
 
+#include <QtCore/qendian.h>
 #include <QtCore/qmetatype.h>
 #include <QtCore/qobject.h>
 #include <QtSerialBus/qserialbusglobal.h>
@@ -98,6 +99,17 @@ public:
     Q_DECLARE_FLAGS(FrameErrors, FrameError)
     Q_FLAGS(FrameErrors)
 
+    enum E2EStatus {
+        E2ENotChecked       = 0,
+        E2EOk               = 1,
+        E2EInitial          = 2,
+        E2EOkSomeLost       = 3,
+        E2ERepeated         = 4,
+        E2EWrongSequence    = 5,
+        E2EWrongCrc         = 6,
+        E2EWrongLength      = 7
+    };
+
     explicit QCanBusFrame(quint32 identifier = 0, const QByteArray &data = QByteArray()) :
         canId(identifier & 0x1FFFFFFFU),
         format(DataFrame),
@@ -106,7 +118,6 @@ public:
         extra(0x0),
         load(data)
     {
-        Q_UNUSED(extra);
         memset(reserved, 0, sizeof(reserved));
     }
 
@@ -115,6 +126,12 @@ public:
         if (format == InvalidFrame)
             return false;
 
+        // CAN XL: data frames with 11 bit priority and 1 to 2048 byte payload
+        if (extra & XlFormatBit) {
+            return format == DataFrame && !isExtendedFrame && !(canId & 0x1FFFF800U)
+                    && load.length() > XlHeaderSize && load.length() <= XlHeaderSize + 2048;
+        }
+
         // long id used, but extended flag not set
         if (!isExtendedFrame && (canId & 0x1FFFF800U))
             return false;
@@ -173,12 +190,67 @@ public:
         setExtendedFrameFormat(isExtendedFrame || (newFrameId & 0x1FFFF800U));
     }
 
-    inline void setPayload(const QByteArray &data) { load = data; }
-    inline void setTimeStamp(const TimeStamp &ts) { stamp = ts; }
+    inline bool hasCanXlFormat() const { return (extra & XlFormatBit); }
+    inline void setCanXlFormat(bool isCanXl)
+    {
+        if (isCanXl == hasCanXlFormat())
+            return;
+        if (isCanXl) {
+            load.prepend(QByteArray(XlHeaderSize, 0));
+            extra = (extra | XlFormatBit);
+        } else {
+            load.remove(0, XlHeaderSize);
+            extra = (extra & ~XlFormatBit);
+        }
+    }
 
-    QByteArray payload() const { return load; }
+    inline quint8 serviceDataUnitType() const { return reserved[XlSduType]; }
+    inline void setServiceDataUnitType(quint8 type) { reserved[XlSduType] = type; }
+
+    inline bool hasSimpleExtendedContent() const { return (reserved[XlFlags] & XlSecBit); }
+    inline void setSimpleExtendedContent(bool sec)
+    {
+        reserved[XlFlags] = sec ? (reserved[XlFlags] | XlSecBit) : (reserved[XlFlags] & ~XlSecBit);
+    }
+
+    inline quint32 acceptanceField() const
+    {
+        if (!hasCanXlFormat())
+            return 0;
+        return qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(load.constData()));
+    }
+    inline void setAcceptanceField(quint32 field)
+    {
+        if (hasCanXlFormat())
+            qToBigEndian<quint32>(field, reinterpret_cast<uchar *>(load.data()));
+    }
+
+    inline E2EStatus e2eStatus() const { return E2EStatus(reserved[E2EStatusIndex]); }
+    inline void setE2EStatus(E2EStatus status) { reserved[E2EStatusIndex] = quint8(status); }
+
+    inline void setPayload(const QByteArray &data)
+    {
+        if (hasCanXlFormat())
+            load = load.left(XlHeaderSize) + data;
+        else
+            load = data;
+    }
+    inline void setTimeStamp(const TimeStamp &ts)
+    {
+        stamp = ts;
+        extra = (extra & ~NormalizedTimeStampBit);
+    }
+
+    QByteArray payload() const { return hasCanXlFormat() ? load.mid(XlHeaderSize) : load; }
     TimeStamp timeStamp() const { return stamp; }
 
+    inline bool hasNormalizedTimeStamp() const { return (extra & NormalizedTimeStampBit); }
+    inline void setNormalizedTimeStamp(const TimeStamp &ts)
+    {
+        stamp = ts;
+        extra = (extra | NormalizedTimeStampBit);
+    }
+
     QCanBusFrame::FrameErrors error() const
     {
         if (format != ErrorFrame)
@@ -199,16 +271,28 @@ public:
 #endif
 
 private:
+    // reads the payload in place, without the copy payload() makes for CAN XL
+    friend class QCanBusE2ECheckerPrivate;
+
+    enum { XlFormatBit = 0x1 };                 // in extra
+    enum { NormalizedTimeStampBit = 0x2 };      // in extra
+    enum { XlSduType = 0, XlFlags = 1, E2EStatusIndex = 2 }; // indices into reserved
+    enum { XlSecBit = 0x1 };                    // in reserved[XlFlags]
+    enum { XlHeaderSize = 4 };                  // acceptance field in front of the payload
+
     quint32 canId:29; // acts as container for error codes too
     quint8 format:3; // max of 8 frame types
 
     quint8 isExtendedFrame:1;
     quint8 version:5;
-    quint8 extra: 2; // unused
+    quint8 extra: 2; // bit 0: CAN XL format, bit 1: normalized time stamp
 
-    // reserved for future use
+    // CAN XL SDU type and flags, E2E status
     quint8 reserved[3];
 
+    // implicitly shared, so queuing and copying a 2048 byte CAN XL frame
+    // costs the same as a classic frame; CAN XL frames keep their acceptance
+    // field in front of the payload, so classic frames do not grow
     QByteArray load;
     TimeStamp stamp;
 };
@@ -216,6 +300,7 @@ private:
 Q_DECLARE_TYPEINFO(QCanBusFrame, Q_MOVABLE_TYPE);
 Q_DECLARE_TYPEINFO(QCanBusFrame::FrameError, Q_PRIMITIVE_TYPE);
 Q_DECLARE_TYPEINFO(QCanBusFrame::FrameType, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(QCanBusFrame::E2EStatus, Q_PRIMITIVE_TYPE);
 Q_DECLARE_TYPEINFO(QCanBusFrame::TimeStamp, Q_PRIMITIVE_TYPE);
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(QCanBusFrame::FrameErrors)
@@ -0,0 +1,189 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qcanbustimestampnormalizer_p.h"
+
+#include <QtCore/qelapsedtimer.h>
+
+#include <cmath>
+
+#if defined(Q_OS_LINUX)
+#  include <time.h>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \internal
+    \class QCanBusTimeStampNormalizer
+
+    Maps the timestamps of one CAN device onto the monotonic clock of the
+    system, so that frames of different devices can be compared and merged.
+
+    The device pairs the raw timestamp of a received frame with the monotonic
+    time at which it was received. The difference between both is the offset
+    of the device clock plus the delay until the frame was read, which is
+    never negative but varies a lot. Over a sliding window of such pairs, a
+    least squares fit yields the drift of the device clock. The fitted line is
+    then lowered onto the pair with the shortest delay, so a mapped timestamp
+    is never later than the time the frame was received.
+
+    Pairs are collected in slots of SampleSpacing, so the window covers enough
+    time to see the drift; of the pairs in one slot only the one with the
+    shortest delay is kept. If a pair deviates by more than ResetThreshold
+    from the estimate, one of the clocks was set or wrapped and the estimate
+    starts over.
+
+    All times are in microseconds.
+*/
+
+/*!
+    \internal
+
+    Returns the current time of the monotonic clock in microseconds. On Linux,
+    this is \c CLOCK_MONOTONIC; on other platforms the monotonic clock used by
+    QElapsedTimer, counted from the first call.
+*/
+qint64 QCanBusTimeStampNormalizer::monotonicMicroseconds()
+{
+#if defined(Q_OS_LINUX)
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return qint64(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+#else
+    static const QElapsedTimer timer = []() {
+        QElapsedTimer started;
+        started.start();
+        return started;
+    }();
+    return timer.nsecsElapsed() / 1000;
+#endif
+}
+
+/*!
+    \internal
+
+    Adds the pair of the \a raw timestamp of a frame and the \a monotonic time
+    it was received at.
+*/
+void QCanBusTimeStampNormalizer::addSample(qint64 raw, qint64 monotonic)
+{
+    const qint64 delta = monotonic - raw;
+
+    if (m_count > 0) {
+        const qint64 deviation = delta - (toMonotonic(raw) - raw);
+        if (deviation > ResetThreshold || deviation < -ResetThreshold)
+            reset();
+    }
+
+    if (m_count > 0 && raw - m_slotStart < SampleSpacing) {
+        Sample &newest = sample(m_count - 1);
+        if (delta < newest.delta) {
+            newest.raw = raw;
+            newest.delta = delta;
+            update();
+        }
+        return;
+    }
+
+    if (m_count == WindowSize) {
+        m_first = (m_first + 1) % WindowSize;
+        --m_count;
+    }
+    Sample &added = sample(m_count++);
+    added.raw = raw;
+    added.delta = delta;
+    m_slotStart = raw;
+    update();
+}
+
+/*!
+    \internal
+
+    Returns the monotonic time corresponding to the \a raw timestamp. Without
+    any sample, \a raw is returned.
+*/
+qint64 QCanBusTimeStampNormalizer::toMonotonic(qint64 raw) const
+{
+    if (!isValid())
+        return raw;
+    return raw + m_deltaBase
+        + qint64(std::floor(m_intercept + m_slope * double(raw - m_rawBase) + 0.5));
+}
+
+void QCanBusTimeStampNormalizer::update()
+{
+    // Relative to the newest sample, so the doubles stay small and exact.
+    const Sample &newest = sample(m_count - 1);
+    m_rawBase = newest.raw;
+    m_deltaBase = newest.delta;
+
+    double meanX = 0.;
+    double meanY = 0.;
+    for (int i = 0; i < m_count; ++i) {
+        meanX += double(sample(i).raw - m_rawBase);
+        meanY += double(sample(i).delta - m_deltaBase);
+    }
+    meanX /= m_count;
+    meanY /= m_count;
+
+    double sxx = 0.;
+    double sxy = 0.;
+    for (int i = 0; i < m_count; ++i) {
+        const double x = double(sample(i).raw - m_rawBase) - meanX;
+        const double y = double(sample(i).delta - m_deltaBase) - meanY;
+        sxx += x * x;
+        sxy += x * y;
+    }
+
+    // Quartz oscillators stay far below 1000 ppm, more is noise of a short window.
+    const double maximumDrift = 1e-3;
+    m_slope = (sxx > 0.) ? qBound(-maximumDrift, sxy / sxx, maximumDrift) : 0.;
+    m_intercept = meanY - m_slope * meanX;
+
+    // Lower the line onto the sample with the shortest delay.
+    double lowest = 0.;
+    for (int i = 0; i < m_count; ++i) {
+        const double x = double(sample(i).raw - m_rawBase);
+        const double residual = double(sample(i).delta - m_deltaBase)
+            - (m_intercept + m_slope * x);
+        if (i == 0 || residual < lowest)
+            lowest = residual;
+    }
+    m_intercept += lowest;
+}
+
+QT_END_NAMESPACE
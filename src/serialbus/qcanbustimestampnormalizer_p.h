@@ -0,0 +1,98 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCANBUSTIMESTAMPNORMALIZER_P_H
+#define QCANBUSTIMESTAMPNORMALIZER_P_H
+
+#include <QtCore/qglobal.h>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+class Q_AUTOTEST_EXPORT QCanBusTimeStampNormalizer
+{
+public:
+    enum {
+        WindowSize = 64,
+        SampleSpacing = 250000,     // us, samples within one slot are merged
+        ResetThreshold = 1000000    // us, a larger deviation means a clock jumped
+    };
+
+    static qint64 monotonicMicroseconds();
+
+    void addSample(qint64 raw, qint64 monotonic);
+    qint64 toMonotonic(qint64 raw) const;
+
+    bool isValid() const { return m_count > 0; }
+    double drift() const { return m_slope; }
+    void reset() { m_count = 0; m_slope = 0.; }
+
+private:
+    struct Sample
+    {
+        qint64 raw;
+        qint64 delta; // monotonic - raw
+    };
+
+    Sample &sample(int index) { return m_samples[(m_first + index) % WindowSize]; }
+    const Sample &sample(int index) const { return m_samples[(m_first + index) % WindowSize]; }
+    void update();
+
+    Sample m_samples[WindowSize];
+    int m_first = 0;
+    int m_count = 0;
+    qint64 m_slotStart = 0;
+
+    // delta(raw) = m_deltaBase + m_intercept + m_slope * (raw - m_rawBase)
+    qint64 m_rawBase = 0;
+    qint64 m_deltaBase = 0;
+    double m_intercept = 0.;
+    double m_slope = 0.;
+};
+
+QT_END_NAMESPACE
+
+#endif // QCANBUSTIMESTAMPNORMALIZER_P_H
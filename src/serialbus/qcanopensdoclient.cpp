@@ -0,0 +1,781 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qcanopensdoclient.h"
+#include "qcanopensdoclient_p.h"
+#include "qcanopensdoreply_p.h"
+
+#include <QtCore/qendian.h>
+
+QT_BEGIN_NAMESPACE
+
+// COB-IDs of the default SDO channel
+enum { SdoRequestBase = 0x600, SdoResponseBase = 0x580 };
+
+// Command specifiers, already shifted into the upper three bits.
+enum {
+    DownloadSegmentRequest = 0x00,
+    InitiateDownloadRequest = 0x20,
+    InitiateUploadRequest = 0x40,
+    UploadSegmentRequest = 0x60,
+    AbortTransfer = 0x80,
+    BlockUploadRequest = 0xA0,
+    BlockDownloadRequest = 0xC0,
+
+    UploadSegmentResponse = 0x00,
+    DownloadSegmentResponse = 0x20,
+    InitiateUploadResponse = 0x40,
+    InitiateDownloadResponse = 0x60,
+    BlockDownloadResponse = 0xA0,
+    BlockUploadResponse = 0xC0,
+
+    CommandMask = 0xE0
+};
+
+// SDO abort codes, see CiA 301
+enum : quint32 {
+    ToggleBitNotAlternated = 0x05030000,
+    SdoProtocolTimedOut = 0x05040000,
+    InvalidCommandSpecifier = 0x05040001,
+    InvalidBlockSize = 0x05040002,
+    InvalidSequenceNumber = 0x05040003,
+    CrcErrorAbort = 0x05040004
+};
+
+enum { SegmentSize = 7, MaximumBlockSize = 127 };
+
+/*!
+    \class QCanOpenSdoClient
+    \inmodule QtSerialBus
+    \since 5.7
+
+    \brief The QCanOpenSdoClient class reads and writes entries of the
+    object dictionary of CANopen nodes through service data objects (SDO).
+
+    The client uses the default SDO channel of each node, with the COB-IDs
+    0x600 + node id for requests and 0x580 + node id for responses. It
+    consumes all frames received by its \l QCanBusDevice. Frames that do not
+    belong to a running transfer are passed on with
+    \l unhandledFramesReceived().
+
+    \l upload() reads and \l download() writes an entry. Both return a
+    \l QCanOpenSdoReply that reports the result. With \l SegmentedTransfer,
+    values of up to four bytes are sent in a single expedited frame and
+    larger values in segments of seven bytes, each confirmed by the node.
+    With \l BlockTransfer, up to \l blockSize() segments are sent before the
+    node confirms them, and the data is protected with a CRC. This is several
+    times faster for large values such as firmware images, but not every
+    node supports it.
+
+    Transfers with different nodes run concurrently. Transfers with the same
+    node are queued and run one after the other. All frames produced while
+    handling one batch of received frames are written together.
+*/
+
+/*!
+    \enum QCanOpenSdoClient::TransferMode
+
+    This enum describes how a value is transferred.
+
+    \value SegmentedTransfer    Expedited transfer for values of up to four
+                                bytes, segmented transfer otherwise.
+    \value BlockTransfer        Block transfer with CRC.
+*/
+
+/*!
+    Constructs a client transferring data over \a device, with the specified
+    \a parent. The device has to be connected before transfers are started.
+*/
+QCanOpenSdoClient::QCanOpenSdoClient(QCanBusDevice *device, QObject *parent)
+    : QObject(*new QCanOpenSdoClientPrivate, parent)
+{
+    Q_D(QCanOpenSdoClient);
+    d->m_device = device;
+    d->m_clock.start();
+    d->m_timeoutTimer.setInterval(qMax(10, d->m_timeout / 4));
+    connect(&d->m_timeoutTimer, SIGNAL(timeout()), this, SLOT(_q_checkTimeouts()));
+
+    if (device) {
+        connect(device, SIGNAL(framesReceived()), this, SLOT(_q_framesReceived()));
+        connect(device, SIGNAL(stateChanged(QCanBusDevice::CanBusDeviceState)),
+                this, SLOT(_q_stateChanged(QCanBusDevice::CanBusDeviceState)));
+    }
+}
+
+/*!
+    Destroys the client. Running transfers are not aborted on the bus.
+*/
+QCanOpenSdoClient::~QCanOpenSdoClient()
+{
+    Q_D(QCanOpenSdoClient);
+    qDeleteAll(d->m_active);
+    for (const QQueue<QCanOpenSdoClientPrivate::Session *> &queue : d->m_waiting)
+        qDeleteAll(queue);
+}
+
+/*!
+    Returns the CAN bus device used by the client.
+*/
+QCanBusDevice *QCanOpenSdoClient::device() const
+{
+    Q_D(const QCanOpenSdoClient);
+    return d->m_device;
+}
+
+/*!
+    Returns the time in milliseconds the client waits for each response of a
+    node. The default is 1000 milliseconds.
+*/
+int QCanOpenSdoClient::timeout() const
+{
+    Q_D(const QCanOpenSdoClient);
+    return d->m_timeout;
+}
+
+/*!
+    Sets the time the client waits for each response of a node to \a timeout
+    milliseconds. Transfers without a response in time are aborted.
+*/
+void QCanOpenSdoClient::setTimeout(int timeout)
+{
+    Q_D(QCanOpenSdoClient);
+    d->m_timeout = qMax(1, timeout);
+    d->m_timeoutTimer.setInterval(qMax(10, d->m_timeout / 4));
+}
+
+/*!
+    Returns the number of segments per block the client offers for block
+    uploads. The default is 127, the maximum allowed.
+*/
+int QCanOpenSdoClient::blockSize() const
+{
+    Q_D(const QCanOpenSdoClient);
+    return d->m_blockSize;
+}
+
+/*!
+    Sets the number of segments per block offered for block uploads to
+    \a segments, between 1 and 127. For block downloads, the node decides
+    about the block size.
+*/
+void QCanOpenSdoClient::setBlockSize(int segments)
+{
+    Q_D(QCanOpenSdoClient);
+    d->m_blockSize = qBound(1, segments, int(MaximumBlockSize));
+}
+
+/*!
+    Starts reading the entry \a index, \a subIndex from the object dictionary
+    of the node with \a nodeId, using \a mode. Returns the reply reporting
+    the result, or \c nullptr if \a nodeId is not between 1 and 127 or the
+    device is not connected.
+
+    The reply is a child of the client; delete it with deleteLater() once it
+    has finished.
+*/
+QCanOpenSdoReply *QCanOpenSdoClient::upload(int nodeId, quint16 index, quint8 subIndex,
+                                            TransferMode mode)
+{
+    Q_D(QCanOpenSdoClient);
+    if (nodeId < 1 || nodeId > 127 || !d->m_device
+            || d->m_device->state() != QCanBusDevice::ConnectedState) {
+        return nullptr;
+    }
+
+    auto session = new QCanOpenSdoClientPrivate::Session;
+    session->reply = new QCanOpenSdoReply(QCanOpenSdoReply::Upload, nodeId, index, subIndex, this);
+    session->direction = QCanOpenSdoReply::Upload;
+    session->mode = mode;
+    session->nodeId = nodeId;
+    session->index = index;
+    session->subIndex = subIndex;
+    QCanOpenSdoReply *reply = session->reply;
+    d->enqueue(session);
+    return reply;
+}
+
+/*!
+    Starts writing \a data to the entry \a index, \a subIndex of the object
+    dictionary of the node with \a nodeId, using \a mode. Returns the reply
+    reporting the result, or \c nullptr if \a nodeId is not between 1 and 127
+    or the device is not connected.
+
+    Empty \a data is always written with \l SegmentedTransfer.
+
+    The reply is a child of the client; delete it with deleteLater() once it
+    has finished.
+*/
+QCanOpenSdoReply *QCanOpenSdoClient::download(int nodeId, quint16 index, quint8 subIndex,
+                                              const QByteArray &data, TransferMode mode)
+{
+    Q_D(QCanOpenSdoClient);
+    if (nodeId < 1 || nodeId > 127 || !d->m_device
+            || d->m_device->state() != QCanBusDevice::ConnectedState) {
+        return nullptr;
+    }
+
+    auto session = new QCanOpenSdoClientPrivate::Session;
+    session->reply = new QCanOpenSdoReply(QCanOpenSdoReply::Download, nodeId, index, subIndex,
+                                          this);
+    session->direction = QCanOpenSdoReply::Download;
+    session->mode = data.isEmpty() ? SegmentedTransfer : mode;
+    session->nodeId = nodeId;
+    session->index = index;
+    session->subIndex = subIndex;
+    session->data = data;
+    QCanOpenSdoReply *reply = session->reply;
+    d->enqueue(session);
+    return reply;
+}
+
+/*!
+    \fn void QCanOpenSdoClient::unhandledFramesReceived(const QVector<QCanBusFrame> &frames)
+
+    This signal is emitted with all received \a frames that are not a
+    response to a running transfer.
+*/
+
+void QCanOpenSdoClientPrivate::enqueue(Session *session)
+{
+    if (m_active.contains(session->nodeId)) {
+        m_waiting[session->nodeId].enqueue(session);
+        return;
+    }
+    start(session);
+}
+
+void QCanOpenSdoClientPrivate::start(Session *session)
+{
+    m_active.insert(session->nodeId, session);
+    if (!m_timeoutTimer.isActive())
+        m_timeoutTimer.start();
+
+    char value[4];
+    if (session->direction == QCanOpenSdoReply::Download) {
+        const int size = session->data.size();
+        qToLittleEndian<quint32>(quint32(size), reinterpret_cast<uchar *>(value));
+        if (session->mode == QCanOpenSdoClient::BlockTransfer) {
+            // client CRC support, size indicated
+            session->state = BlockDownloadInitiate;
+            sendCommand(session, BlockDownloadRequest | 0x04 | 0x02, value, 4);
+        } else if (size > 0 && size <= 4) {
+            // expedited, size indicated
+            session->state = DownloadInitiate;
+            sendCommand(session, InitiateDownloadRequest | ((4 - size) << 2) | 0x02 | 0x01,
+                        session->data.constData(), size);
+        } else {
+            session->state = DownloadInitiate;
+            sendCommand(session, InitiateDownloadRequest | 0x01, value, 4);
+        }
+    } else if (session->mode == QCanOpenSdoClient::BlockTransfer) {
+        // client CRC support; block size and no protocol switch
+        session->state = BlockUploadInitiate;
+        value[0] = char(m_blockSize);
+        value[1] = 0;
+        sendCommand(session, BlockUploadRequest | 0x04, value, 2);
+    } else {
+        session->state = UploadInitiate;
+        sendCommand(session, InitiateUploadRequest);
+    }
+}
+
+void QCanOpenSdoClientPrivate::touch(Session *session)
+{
+    session->deadline = m_clock.elapsed() + m_timeout;
+}
+
+void QCanOpenSdoClientPrivate::send(Session *session, const QCanBusFrame &frame)
+{
+    touch(session);
+    m_outgoing.append(frame);
+    m_outgoingNodes.append(session->nodeId);
+
+    if (!m_flushScheduled) {
+        Q_Q(QCanOpenSdoClient);
+        m_flushScheduled = true;
+        QMetaObject::invokeMethod(q, "_q_flush", Qt::QueuedConnection);
+    }
+}
+
+/*
+    Sends a frame with a command byte followed by the multiplexer (index and
+    sub-index) and up to four bytes of data.
+*/
+void QCanOpenSdoClientPrivate::sendCommand(Session *session, quint8 command, const char *data,
+                                           int size)
+{
+    QByteArray payload(8, 0);
+    uchar *bytes = reinterpret_cast<uchar *>(payload.data());
+    bytes[0] = command;
+    qToLittleEndian<quint16>(session->index, bytes + 1);
+    bytes[3] = session->subIndex;
+    if (size)
+        memcpy(bytes + 4, data, size_t(qMin(size, 4)));
+    send(session, QCanBusFrame(SdoRequestBase + session->nodeId, payload));
+}
+
+/*
+    Sends a frame with a command byte followed by up to seven bytes of data.
+*/
+void QCanOpenSdoClientPrivate::sendSegment(Session *session, quint8 command, const char *data,
+                                           int size)
+{
+    QByteArray payload(8, 0);
+    payload[0] = char(command);
+    if (size)
+        memcpy(payload.data() + 1, data, size_t(qMin(size, int(SegmentSize))));
+    send(session, QCanBusFrame(SdoRequestBase + session->nodeId, payload));
+}
+
+void QCanOpenSdoClientPrivate::sendDownloadSegment(Session *session)
+{
+    const int size = qMin(int(SegmentSize), session->data.size() - session->offset);
+    const bool last = session->offset + size == session->data.size();
+    session->segmentSize = size;
+    session->state = DownloadSegment;
+    sendSegment(session, DownloadSegmentRequest | (session->toggle ? 0x10 : 0)
+                | ((SegmentSize - size) << 1) | (last ? 0x01 : 0),
+                session->data.constData() + session->offset, size);
+}
+
+/*
+    Sends the next block, starting at the first byte not yet confirmed by
+    the node. This also repeats segments the node did not receive.
+*/
+void QCanOpenSdoClientPrivate::sendBlock(Session *session)
+{
+    int position = session->offset;
+    int sequence = 0;
+    while (sequence < session->blockSize && position < session->data.size()) {
+        const int size = qMin(int(SegmentSize), session->data.size() - position);
+        const bool last = position + size == session->data.size();
+        ++sequence;
+        sendSegment(session, (last ? 0x80 : 0) | sequence,
+                    session->data.constData() + position, size);
+        position += size;
+    }
+    session->sequence = sequence;
+    session->state = BlockDownloadAck;
+}
+
+void QCanOpenSdoClientPrivate::process(Session *session, const QCanBusFrame &frame)
+{
+    QByteArray payload = frame.payload();
+    if (payload.size() < 8)
+        payload.append(QByteArray(8 - payload.size(), 0));
+    const uchar *bytes = reinterpret_cast<const uchar *>(payload.constData());
+    const quint8 command = bytes[0];
+
+    // In a block upload, any other command byte is a sequence number.
+    if (command == AbortTransfer) {
+        const quint32 code = qFromLittleEndian<quint32>(bytes + 4);
+        finish(session, QCanOpenSdoReply::AbortError,
+               QCanOpenSdoClient::tr("Transfer aborted by node, abort code 0x%1")
+               .arg(code, 8, 16, QLatin1Char('0')), code);
+        return;
+    }
+
+    touch(session);
+
+    const bool multiplexerMatches = qFromLittleEndian<quint16>(bytes + 1) == session->index
+            && bytes[3] == session->subIndex;
+    bool valid = false;
+
+    switch (session->state) {
+    case DownloadInitiate:
+        valid = (command & CommandMask) == InitiateDownloadResponse && multiplexerMatches;
+        if (!valid)
+            break;
+        if (session->data.size() > 0 && session->data.size() <= 4) {
+            finish(session);
+            return;
+        }
+        session->offset = 0;
+        session->toggle = false;
+        sendDownloadSegment(session);
+        return;
+
+    case DownloadSegment:
+        valid = (command & CommandMask) == DownloadSegmentResponse;
+        if (!valid)
+            break;
+        if (bool(command & 0x10) != session->toggle) {
+            abort(session, ToggleBitNotAlternated, QCanOpenSdoReply::ProtocolError,
+                  QCanOpenSdoClient::tr("Toggle bit not alternated"));
+            return;
+        }
+        session->offset += session->segmentSize;
+        session->toggle = !session->toggle;
+        if (session->offset == session->data.size())
+            finish(session);
+        else
+            sendDownloadSegment(session);
+        return;
+
+    case UploadInitiate:
+        valid = (command & CommandMask) == InitiateUploadResponse && multiplexerMatches;
+        if (!valid)
+            break;
+        if (command & 0x02) { // expedited
+            const int size = (command & 0x01) ? 4 - ((command >> 2) & 0x03) : 4;
+            session->data = QByteArray(reinterpret_cast<const char *>(bytes + 4), size);
+            finish(session);
+            return;
+        }
+        if (command & 0x01)
+            session->size = qFromLittleEndian<quint32>(bytes + 4);
+        session->toggle = false;
+        session->state = UploadSegment;
+        sendCommand(session, UploadSegmentRequest);
+        return;
+
+    case UploadSegment: {
+        valid = (command & CommandMask) == UploadSegmentResponse;
+        if (!valid)
+            break;
+        if (bool(command & 0x10) != session->toggle) {
+            abort(session, ToggleBitNotAlternated, QCanOpenSdoReply::ProtocolError,
+                  QCanOpenSdoClient::tr("Toggle bit not alternated"));
+            return;
+        }
+        const int size = SegmentSize - ((command >> 1) & 0x07);
+        session->data.append(reinterpret_cast<const char *>(bytes + 1), size);
+        session->toggle = !session->toggle;
+        if (!(command & 0x01)) {
+            sendSegment(session, UploadSegmentRequest | (session->toggle ? 0x10 : 0), nullptr, 0);
+            return;
+        }
+        if (session->size >= 0 && session->size != session->data.size()) {
+            finish(session, QCanOpenSdoReply::ProtocolError,
+                   QCanOpenSdoClient::tr("Uploaded %1 bytes, but the node indicated %2 bytes")
+                   .arg(session->data.size()).arg(session->size));
+            return;
+        }
+        finish(session);
+        return;
+    }
+
+    case BlockDownloadInitiate:
+        valid = (command & 0xE3) == BlockDownloadResponse && multiplexerMatches;
+        if (!valid)
+            break;
+        session->crc = command & 0x04;
+        session->blockSize = bytes[4];
+        if (session->blockSize < 1 || session->blockSize > MaximumBlockSize) {
+            abort(session, InvalidBlockSize, QCanOpenSdoReply::ProtocolError,
+                  QCanOpenSdoClient::tr("Invalid block size %1").arg(session->blockSize));
+            return;
+        }
+        session->offset = 0;
+        sendBlock(session);
+        return;
+
+    case BlockDownloadAck: {
+        valid = command == (BlockDownloadResponse | 0x02);
+        if (!valid)
+            break;
+        const int acknowledged = bytes[1];
+        if (acknowledged > session->sequence) {
+            abort(session, InvalidSequenceNumber, QCanOpenSdoReply::ProtocolError,
+                  QCanOpenSdoClient::tr("Invalid sequence number %1").arg(acknowledged));
+            return;
+        }
+        session->offset = qMin(session->data.size(),
+                               session->offset + acknowledged * SegmentSize);
+        session->blockSize = bytes[2];
+        if (session->blockSize < 1 || session->blockSize > MaximumBlockSize) {
+            abort(session, InvalidBlockSize, QCanOpenSdoReply::ProtocolError,
+                  QCanOpenSdoClient::tr("Invalid block size %1").arg(session->blockSize));
+            return;
+        }
+        if (session->offset < session->data.size()) {
+            sendBlock(session);
+            return;
+        }
+
+        // number of bytes in the last segment that do not contain data
+        const int unused = (SegmentSize - session->data.size() % SegmentSize) % SegmentSize;
+        char crc[2];
+        qToLittleEndian<quint16>(session->crc ? crc16(session->data) : 0,
+                                 reinterpret_cast<uchar *>(crc));
+        session->state = BlockDownloadEnd;
+        sendSegment(session, BlockDownloadRequest | (unused << 2) | 0x01, crc, 2);
+        return;
+    }
+
+    case BlockDownloadEnd:
+        valid = command == (BlockDownloadResponse | 0x01);
+        if (valid)
+            finish(session);
+        break;
+
+    case BlockUploadInitiate:
+        valid = (command & 0xE1) == BlockUploadResponse && multiplexerMatches;
+        if (!valid)
+            break;
+        session->crc = command & 0x04;
+        if (command & 0x02)
+            session->size = qFromLittleEndian<quint32>(bytes + 4);
+        session->blockSize = m_blockSize;
+        session->sequence = 0;
+        session->state = BlockUploadReceiving;
+        sendSegment(session, BlockUploadRequest | 0x03, nullptr, 0);
+        return;
+
+    case BlockUploadReceiving: {
+        valid = true;
+        const int sequence = command & 0x7F;
+        const bool last = command & 0x80;
+        if (sequence == session->sequence + 1) {
+            session->sequence = sequence;
+            session->data.append(reinterpret_cast<const char *>(bytes + 1), SegmentSize);
+            session->lastSegment = last;
+        }
+        // Confirm at the end of each block. Segments after a lost one are
+        // dropped and sent again by the node in the next block.
+        if (sequence < session->blockSize && !last)
+            return;
+        char confirmation[2] = { char(session->sequence), char(session->blockSize) };
+        sendSegment(session, BlockUploadRequest | 0x02, confirmation, 2);
+        session->sequence = 0;
+        if (session->lastSegment)
+            session->state = BlockUploadEnd;
+        return;
+    }
+
+    case BlockUploadEnd: {
+        valid = (command & 0xE3) == (BlockUploadResponse | 0x01);
+        if (!valid)
+            break;
+        session->data.chop((command >> 2) & 0x07);
+        if (session->crc && qFromLittleEndian<quint16>(bytes + 1) != crc16(session->data)) {
+            abort(session, CrcErrorAbort, QCanOpenSdoReply::CrcError,
+                  QCanOpenSdoClient::tr("CRC mismatch in block upload"));
+            return;
+        }
+        if (session->size >= 0 && session->size != session->data.size()) {
+            abort(session, InvalidCommandSpecifier, QCanOpenSdoReply::ProtocolError,
+                  QCanOpenSdoClient::tr("Uploaded %1 bytes, but the node indicated %2 bytes")
+                  .arg(session->data.size()).arg(session->size));
+            return;
+        }
+        sendSegment(session, BlockUploadRequest | 0x01, nullptr, 0);
+        finish(session);
+        return;
+    }
+    }
+
+    if (!valid) {
+        abort(session, InvalidCommandSpecifier, QCanOpenSdoReply::ProtocolError,
+              QCanOpenSdoClient::tr("Unexpected response 0x%1 from node %2")
+              .arg(command, 2, 16, QLatin1Char('0')).arg(session->nodeId));
+    }
+}
+
+/*
+    Aborts the transfer on the bus and finishes the session with \a error.
+*/
+void QCanOpenSdoClientPrivate::abort(Session *session, quint32 abortCode,
+                                     QCanOpenSdoReply::Error error, const QString &errorText)
+{
+    char code[4];
+    qToLittleEndian<quint32>(abortCode, reinterpret_cast<uchar *>(code));
+    sendCommand(session, AbortTransfer, code, 4);
+    finish(session, error, errorText, abortCode);
+}
+
+void QCanOpenSdoClientPrivate::finish(Session *session, QCanOpenSdoReply::Error error,
+                                      const QString &errorText, quint32 abortCode)
+{
+    const int nodeId = session->nodeId;
+    m_active.remove(nodeId);
+
+    if (QCanOpenSdoReply *reply = session->reply) {
+        QCanOpenSdoReplyPrivate *d = reply->d_func();
+        d->m_finished = true;
+        d->m_error = error;
+        d->m_errorText = errorText;
+        d->m_abortCode = abortCode;
+        if (error == QCanOpenSdoReply::NoError && session->direction == QCanOpenSdoReply::Upload)
+            d->m_data = session->data;
+        if (error != QCanOpenSdoReply::NoError)
+            emit reply->errorOccurred(error);
+        emit reply->finished();
+    }
+    delete session;
+
+    QHash<int, QQueue<Session *> >::iterator waiting = m_waiting.find(nodeId);
+    if (waiting != m_waiting.end()) {
+        Session *next = waiting->dequeue();
+        if (waiting->isEmpty())
+            m_waiting.erase(waiting);
+        start(next);
+    }
+
+    if (m_active.isEmpty())
+        m_timeoutTimer.stop();
+}
+
+void QCanOpenSdoClientPrivate::_q_framesReceived()
+{
+    Q_Q(QCanOpenSdoClient);
+    if (!m_device)
+        return;
+
+    m_device->readAllFrames(&m_received);
+
+    QVector<QCanBusFrame> unhandled;
+    for (const QCanBusFrame &frame : m_received) {
+        const int nodeId = int(frame.frameId()) - SdoResponseBase;
+        Session *session = nullptr;
+        if (frame.frameType() == QCanBusFrame::DataFrame && !frame.hasExtendedFrameFormat()
+                && nodeId >= 1 && nodeId <= 127) {
+            session = m_active.value(nodeId);
+        }
+        if (session)
+            process(session, frame);
+        else
+            unhandled.append(frame);
+    }
+
+    // write the responses to all nodes in one go
+    _q_flush();
+
+    if (!unhandled.isEmpty())
+        emit q->unhandledFramesReceived(unhandled);
+}
+
+void QCanOpenSdoClientPrivate::_q_flush()
+{
+    m_flushScheduled = false;
+    if (m_outgoing.isEmpty())
+        return;
+
+    // swap first: failing transfers may start the next one and send again
+    QVector<QCanBusFrame> frames;
+    QVector<int> nodes;
+    frames.swap(m_outgoing);
+    nodes.swap(m_outgoingNodes);
+
+    int failedNode = 0;
+    for (int i = 0; i < frames.size(); ++i) {
+        if (nodes.at(i) == failedNode)
+            continue;
+        if (m_device && m_device->writeFrame(frames.at(i)))
+            continue;
+        failedNode = nodes.at(i);
+        if (Session *session = m_active.value(failedNode)) {
+            finish(session, QCanOpenSdoReply::WriteError, m_device
+                   ? m_device->errorString() : QCanOpenSdoClient::tr("No device"));
+        }
+    }
+
+    // keep the allocations for the next round
+    if (m_outgoing.isEmpty()) {
+        frames.resize(0);
+        nodes.resize(0);
+        m_outgoing.swap(frames);
+        m_outgoingNodes.swap(nodes);
+    }
+}
+
+void QCanOpenSdoClientPrivate::_q_checkTimeouts()
+{
+    const qint64 now = m_clock.elapsed();
+    const QHash<int, Session *> &active = m_active;
+    QVector<Session *> expired;
+    for (Session *session : active) {
+        if (session->deadline <= now)
+            expired.append(session);
+    }
+    for (Session *session : expired) {
+        abort(session, SdoProtocolTimedOut, QCanOpenSdoReply::TimeoutError,
+              QCanOpenSdoClient::tr("No response from node %1").arg(session->nodeId));
+    }
+    _q_flush();
+}
+
+void QCanOpenSdoClientPrivate::_q_stateChanged(QCanBusDevice::CanBusDeviceState state)
+{
+    if (state != QCanBusDevice::UnconnectedState)
+        return;
+
+    m_outgoing.clear();
+    m_outgoingNodes.clear();
+    const QHash<int, QQueue<Session *> > &waiting = m_waiting;
+    for (const QQueue<Session *> &queue : waiting) {
+        for (Session *session : queue)
+            m_active.insertMulti(session->nodeId, session);
+    }
+    m_waiting.clear();
+
+    const QList<Session *> sessions = m_active.values();
+    for (Session *session : sessions) {
+        finish(session, QCanOpenSdoReply::ConnectionError,
+               QCanOpenSdoClient::tr("Device disconnected"));
+    }
+    m_active.clear();
+}
+
+/*
+    CRC-16-CCITT with polynomial 0x1021 and initial value 0, as used by the
+    SDO block transfer.
+*/
+quint16 QCanOpenSdoClientPrivate::crc16(const QByteArray &data)
+{
+    struct Table {
+        Table()
+        {
+            for (int i = 0; i < 256; ++i) {
+                quint16 crc = quint16(i << 8);
+                for (int bit = 0; bit < 8; ++bit)
+                    crc = (crc & 0x8000) ? quint16((crc << 1) ^ 0x1021) : quint16(crc << 1);
+                values[i] = crc;
+            }
+        }
+        quint16 values[256];
+    };
+    static const Table table;
+
+    quint16 crc = 0;
+    for (const char byte : data)
+        crc = quint16((crc << 8) ^ table.values[((crc >> 8) ^ quint8(byte)) & 0xFF]);
+    return crc;
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qcanopensdoclient.cpp"
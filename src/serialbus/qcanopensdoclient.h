@@ -0,0 +1,89 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCANOPENSDOCLIENT_H
+#define QCANOPENSDOCLIENT_H
+
+#include <QtCore/qobject.h>
+#include <QtSerialBus/qcanbusdevice.h>
+#include <QtSerialBus/qcanopensdoreply.h>
+
+QT_BEGIN_NAMESPACE
+
+class QCanOpenSdoClientPrivate;
+
+class Q_SERIALBUS_EXPORT QCanOpenSdoClient : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QCanOpenSdoClient)
+
+public:
+    enum TransferMode {
+        SegmentedTransfer,
+        BlockTransfer
+    };
+    Q_ENUM(TransferMode)
+
+    explicit QCanOpenSdoClient(QCanBusDevice *device, QObject *parent = nullptr);
+    ~QCanOpenSdoClient();
+
+    QCanBusDevice *device() const;
+
+    int timeout() const;
+    void setTimeout(int timeout);
+
+    int blockSize() const;
+    void setBlockSize(int segments);
+
+    QCanOpenSdoReply *upload(int nodeId, quint16 index, quint8 subIndex,
+                             TransferMode mode = SegmentedTransfer);
+    QCanOpenSdoReply *download(int nodeId, quint16 index, quint8 subIndex,
+                               const QByteArray &data, TransferMode mode = SegmentedTransfer);
+
+Q_SIGNALS:
+    void unhandledFramesReceived(const QVector<QCanBusFrame> &frames);
+
+private:
+    Q_PRIVATE_SLOT(d_func(), void _q_framesReceived())
+    Q_PRIVATE_SLOT(d_func(), void _q_flush())
+    Q_PRIVATE_SLOT(d_func(), void _q_checkTimeouts())
+    Q_PRIVATE_SLOT(d_func(), void _q_stateChanged(QCanBusDevice::CanBusDeviceState))
+};
+Q_DECLARE_TYPEINFO(QCanOpenSdoClient::TransferMode, Q_PRIMITIVE_TYPE);
+
+QT_END_NAMESPACE
+
+#endif // QCANOPENSDOCLIENT_H
@@ -0,0 +1,147 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCANOPENSDOCLIENT_P_H
+#define QCANOPENSDOCLIENT_P_H
+
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qpointer.h>
+#include <QtCore/qqueue.h>
+#include <QtCore/qtimer.h>
+#include <QtSerialBus/qcanopensdoclient.h>
+
+#include <private/qobject_p.h>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+class Q_AUTOTEST_EXPORT QCanOpenSdoClientPrivate : public QObjectPrivate
+{
+    Q_DECLARE_PUBLIC(QCanOpenSdoClient)
+
+public:
+    enum State {
+        DownloadInitiate,
+        DownloadSegment,
+        UploadInitiate,
+        UploadSegment,
+        BlockDownloadInitiate,
+        BlockDownloadAck,
+        BlockDownloadEnd,
+        BlockUploadInitiate,
+        BlockUploadReceiving,
+        BlockUploadEnd
+    };
+
+    // One transfer with one node. Only one transfer per node is active at a
+    // time, since a node serves its default SDO channel strictly in turn.
+    struct Session {
+        QPointer<QCanOpenSdoReply> reply;
+        QCanOpenSdoReply::Direction direction = QCanOpenSdoReply::Upload;
+        QCanOpenSdoClient::TransferMode mode = QCanOpenSdoClient::SegmentedTransfer;
+        int nodeId = 0;
+        quint16 index = 0;
+        quint8 subIndex = 0;
+        State state = UploadInitiate;
+        qint64 deadline = 0;
+
+        QByteArray data;        // data to download, or data uploaded so far
+        int offset = 0;         // download: bytes confirmed by the node
+        int segmentSize = 0;    // segmented download: bytes in the unconfirmed segment
+        bool toggle = false;
+        qint64 size = -1;       // upload: size indicated by the node
+
+        // block transfer
+        int blockSize = 0;      // segments per block, as agreed with the node
+        int sequence = 0;       // last segment sent, or received in order
+        bool crc = false;       // both sides support the CRC
+        bool lastSegment = false;
+    };
+
+    void enqueue(Session *session);
+    void start(Session *session);
+    void process(Session *session, const QCanBusFrame &frame);
+    void finish(Session *session, QCanOpenSdoReply::Error error = QCanOpenSdoReply::NoError,
+                const QString &errorText = QString(), quint32 abortCode = 0);
+    void abort(Session *session, quint32 abortCode, QCanOpenSdoReply::Error error,
+               const QString &errorText);
+
+    void send(Session *session, const QCanBusFrame &frame);
+    void sendCommand(Session *session, quint8 command, const char *data = nullptr, int size = 0);
+    void sendSegment(Session *session, quint8 command, const char *data, int size);
+    void sendDownloadSegment(Session *session);
+    void sendBlock(Session *session);
+    void touch(Session *session);
+
+    void _q_framesReceived();
+    void _q_flush();
+    void _q_checkTimeouts();
+    void _q_stateChanged(QCanBusDevice::CanBusDeviceState state);
+
+    static quint16 crc16(const QByteArray &data);
+
+    QPointer<QCanBusDevice> m_device;
+    int m_timeout = 1000;
+    int m_blockSize = 127;
+
+    QHash<int, Session *> m_active;
+    QHash<int, QQueue<Session *> > m_waiting;
+
+    // Frames are collected and written together, once per received batch or
+    // once per event loop iteration for newly started transfers.
+    QVector<QCanBusFrame> m_outgoing;
+    QVector<int> m_outgoingNodes;
+    bool m_flushScheduled = false;
+
+    QVector<QCanBusFrame> m_received;
+    QElapsedTimer m_clock;
+    QTimer m_timeoutTimer;
+};
+
+QT_END_NAMESPACE
+
+#endif // QCANOPENSDOCLIENT_P_H
@@ -0,0 +1,200 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qcanopensdoreply.h"
+#include "qcanopensdoreply_p.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QCanOpenSdoReply
+    \inmodule QtSerialBus
+    \since 5.7
+
+    \brief The QCanOpenSdoReply class contains the state and result of a
+    CANopen SDO transfer started with \l QCanOpenSdoClient.
+
+    A reply is finished once \l finished() was emitted. For an upload,
+    \l data() then holds the value read from the object dictionary of the
+    node. If the transfer failed, \l error() and \l errorString() describe
+    the reason. If either side aborted the transfer, \l abortCode() returns
+    the SDO abort code.
+
+    \note Do not delete the reply in a slot connected to \l finished(). Use
+    deleteLater().
+*/
+
+/*!
+    \enum QCanOpenSdoReply::Direction
+
+    This enum describes the direction of the transfer.
+
+    \value Upload       The value is read from the node.
+    \value Download     The value is written to the node.
+*/
+
+/*!
+    \enum QCanOpenSdoReply::Error
+
+    This enum describes the possible errors of a transfer.
+
+    \value NoError          No error occurred.
+    \value AbortError       The transfer was aborted by the node. See \l abortCode().
+    \value TimeoutError     The node did not respond in time.
+    \value ProtocolError    The node responded with an unexpected or malformed frame.
+    \value CrcError         The CRC of a block transfer did not match the data.
+    \value WriteError       A frame could not be written to the CAN bus device.
+    \value ConnectionError  The CAN bus device was disconnected during the transfer.
+*/
+
+/*!
+    \internal
+*/
+QCanOpenSdoReply::QCanOpenSdoReply(Direction direction, int nodeId, quint16 index,
+                                   quint8 subIndex, QObject *parent)
+    : QObject(*new QCanOpenSdoReplyPrivate, parent)
+{
+    Q_D(QCanOpenSdoReply);
+    d->m_direction = direction;
+    d->m_nodeId = nodeId;
+    d->m_index = index;
+    d->m_subIndex = subIndex;
+}
+
+/*!
+    Returns the direction of the transfer.
+*/
+QCanOpenSdoReply::Direction QCanOpenSdoReply::direction() const
+{
+    Q_D(const QCanOpenSdoReply);
+    return d->m_direction;
+}
+
+/*!
+    Returns the id of the node the transfer is made with.
+*/
+int QCanOpenSdoReply::nodeId() const
+{
+    Q_D(const QCanOpenSdoReply);
+    return d->m_nodeId;
+}
+
+/*!
+    Returns the object dictionary index of the transfer.
+*/
+quint16 QCanOpenSdoReply::index() const
+{
+    Q_D(const QCanOpenSdoReply);
+    return d->m_index;
+}
+
+/*!
+    Returns the object dictionary sub-index of the transfer.
+*/
+quint8 QCanOpenSdoReply::subIndex() const
+{
+    Q_D(const QCanOpenSdoReply);
+    return d->m_subIndex;
+}
+
+/*!
+    Returns \c true when the transfer has finished or failed.
+*/
+bool QCanOpenSdoReply::isFinished() const
+{
+    Q_D(const QCanOpenSdoReply);
+    return d->m_finished;
+}
+
+/*!
+    Returns the data uploaded from the node. For downloads, and as long as
+    the reply has not finished successfully, the returned byte array is
+    empty.
+*/
+QByteArray QCanOpenSdoReply::data() const
+{
+    Q_D(const QCanOpenSdoReply);
+    return d->m_data;
+}
+
+/*!
+    Returns the error of the transfer.
+
+    \sa errorString(), errorOccurred()
+*/
+QCanOpenSdoReply::Error QCanOpenSdoReply::error() const
+{
+    Q_D(const QCanOpenSdoReply);
+    return d->m_error;
+}
+
+/*!
+    Returns the textual representation of the error of the transfer.
+
+    \sa error()
+*/
+QString QCanOpenSdoReply::errorString() const
+{
+    Q_D(const QCanOpenSdoReply);
+    return d->m_errorText;
+}
+
+/*!
+    Returns the SDO abort code sent by either side when the transfer was
+    aborted; otherwise returns \c 0.
+*/
+quint32 QCanOpenSdoReply::abortCode() const
+{
+    Q_D(const QCanOpenSdoReply);
+    return d->m_abortCode;
+}
+
+/*!
+    \fn void QCanOpenSdoReply::finished()
+
+    This signal is emitted when the transfer has finished or failed.
+
+    \sa isFinished(), error()
+*/
+
+/*!
+    \fn void QCanOpenSdoReply::errorOccurred(QCanOpenSdoReply::Error error)
+
+    This signal is emitted when the transfer failed with \a error. It is
+    emitted right before \l finished().
+*/
+
+QT_END_NAMESPACE
@@ -0,0 +1,98 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCANOPENSDOREPLY_H
+#define QCANOPENSDOREPLY_H
+
+#include <QtCore/qobject.h>
+#include <QtSerialBus/qserialbusglobal.h>
+
+QT_BEGIN_NAMESPACE
+
+class QCanOpenSdoReplyPrivate;
+
+class Q_SERIALBUS_EXPORT QCanOpenSdoReply : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QCanOpenSdoReply)
+
+public:
+    enum Direction {
+        Upload,
+        Download
+    };
+    Q_ENUM(Direction)
+
+    enum Error {
+        NoError,
+        AbortError,
+        TimeoutError,
+        ProtocolError,
+        CrcError,
+        WriteError,
+        ConnectionError
+    };
+    Q_ENUM(Error)
+
+    Direction direction() const;
+    int nodeId() const;
+    quint16 index() const;
+    quint8 subIndex() const;
+
+    bool isFinished() const;
+    QByteArray data() const;
+
+    Error error() const;
+    QString errorString() const;
+    quint32 abortCode() const;
+
+Q_SIGNALS:
+    void finished();
+    void errorOccurred(QCanOpenSdoReply::Error error);
+
+private:
+    QCanOpenSdoReply(Direction direction, int nodeId, quint16 index, quint8 subIndex,
+                     QObject *parent);
+
+    friend class QCanOpenSdoClient;
+    friend class QCanOpenSdoClientPrivate;
+};
+Q_DECLARE_TYPEINFO(QCanOpenSdoReply::Direction, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(QCanOpenSdoReply::Error, Q_PRIMITIVE_TYPE);
+
+QT_END_NAMESPACE
+
+#endif // QCANOPENSDOREPLY_H
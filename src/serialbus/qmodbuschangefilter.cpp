@@ -0,0 +1,382 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qmodbuschangefilter.h"
+#include "qmodbuschangefilter_p.h"
+#include "qmodbusreply.h"
+
+#include <QtCore/qnumeric.h>
+
+#include <algorithm>
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QModbusChangeFilter
+    \inmodule QtSerialBus
+    \since 5.7
+
+    \brief The QModbusChangeFilter class reduces the results of repeated
+    Modbus read requests to the values that changed.
+
+    Applications that poll the same ranges at a fixed rate mostly read
+    values that did not change since the previous poll. The filter remembers
+    the result of each range, identified by the server address, the register
+    type, the start address and the number of values, and passes on only the
+    addresses whose value differs. The cost of the downstream processing then
+    depends on how much the data changes, not on the poll rate.
+
+    Results are passed to \l filter() directly, or read replies are handed to
+    \l watch(), which emits \l valuesChanged() once the reply has finished
+    with at least one changed value. The first result of a range reports all
+    of its values.
+
+    For register ranges, a deadband can be set on a value that is decoded
+    from one or two registers with \l setDeadband(). Such a value is reported
+    only when it differs from the value last reported by more than the
+    deadband, and then always with all of its registers, so the receiver can
+    decode it. Because the comparison is against the last reported value, a
+    slow drift is reported as soon as it adds up to more than the deadband.
+
+    \code
+    QModbusChangeFilter filter;
+    filter.setDeadband(1, QModbusDataUnit::InputRegisters, 10,
+                       QModbusChangeFilter::Float32, 0.5);
+    connect(&filter, &QModbusChangeFilter::valuesChanged, this, &Monitor::publish);
+
+    connect(&pollTimer, &QTimer::timeout, [&]() {
+        filter.watch(client->sendReadRequest(temperatures, 1));
+    });
+    \endcode
+*/
+
+/*!
+    \enum QModbusChangeFilter::ValueType
+
+    This enum describes how the registers covered by a deadband are decoded.
+
+    \value UInt16   Unsigned 16-bit integer in one register.
+    \value Int16    Signed 16-bit integer in one register.
+    \value UInt32   Unsigned 32-bit integer in two registers.
+    \value Int32    Signed 32-bit integer in two registers.
+    \value Float32  IEEE 754 single precision value in two registers.
+*/
+
+/*!
+    \enum QModbusChangeFilter::WordOrder
+
+    This enum describes the order of the registers of a 32-bit value.
+
+    \value HighWordFirst    The register at the lower address holds the most
+                            significant 16 bits, as recommended by the Modbus
+                            specification.
+    \value LowWordFirst     The register at the lower address holds the least
+                            significant 16 bits.
+*/
+
+/*!
+    \class QModbusChangeFilter::Change
+    \inmodule QtSerialBus
+
+    \brief The Change class describes one changed value.
+
+    \c address holds the address of the coil, discrete input or register and
+    \c value its new value. For coils and discrete inputs, the value is \c 0
+    or \c 1.
+*/
+
+/*!
+    \fn void QModbusChangeFilter::valuesChanged(int serverAddress, QModbusDataUnit::RegisterType table, const QVector<QModbusChangeFilter::Change> &changes)
+
+    This signal is emitted when a reply passed to \l watch() has finished
+    with values of \a table of the server at \a serverAddress that differ
+    from the previous result of the same range. The \a changes are sorted by
+    address.
+*/
+
+/*!
+    Constructs a filter with the specified \a parent.
+*/
+QModbusChangeFilter::QModbusChangeFilter(QObject *parent)
+    : QObject(*new QModbusChangeFilterPrivate, parent)
+{
+}
+
+/*!
+    Destroys the filter.
+*/
+QModbusChangeFilter::~QModbusChangeFilter()
+{
+}
+
+/*!
+    Sets a \a deadband for the value of \a type that starts at \a address in
+    \a table of the server at \a serverAddress. 32-bit values cover the
+    registers at \a address and \a address + 1 in the given word \a order.
+    A previously set deadband at the same address is replaced.
+
+    The value is reported only if it differs from the last reported value by
+    more than \a deadband. With a deadband of \c 0, a change of the raw
+    registers that does not change the decoded value is not reported.
+
+    Deadbands apply only to ranges that cover all registers of the value and
+    must not overlap. Returns \c false if \a table is not a register table,
+    \a deadband is negative or the value does not fit into the address
+    space; otherwise returns \c true.
+*/
+bool QModbusChangeFilter::setDeadband(int serverAddress, QModbusDataUnit::RegisterType table,
+                                      int address, ValueType type, double deadband,
+                                      WordOrder order)
+{
+    Q_D(QModbusChangeFilter);
+
+    if (table != QModbusDataUnit::InputRegisters && table != QModbusDataUnit::HoldingRegisters)
+        return false;
+    const int width = (type == UInt16 || type == Int16) ? 1 : 2;
+    if (address < 0 || address + width > 0x10000 || !(deadband >= 0.))
+        return false;
+
+    QVector<QModbusChangeFilterPrivate::Deadband> &deadbands
+            = d->m_deadbands[QModbusChangeFilterPrivate::tableKey(serverAddress, table)];
+    const QModbusChangeFilterPrivate::Deadband entry = { address, width, type, order, deadband };
+    auto it = std::lower_bound(deadbands.begin(), deadbands.end(), address,
+                               [](const QModbusChangeFilterPrivate::Deadband &entry, int a) {
+        return entry.address < a;
+    });
+    if (it != deadbands.end() && it->address == address)
+        *it = entry;
+    else
+        deadbands.insert(it, entry);
+    return true;
+}
+
+/*!
+    Removes the deadband of the value at \a address in \a table of the server
+    at \a serverAddress. Afterwards, every change of its registers is
+    reported.
+*/
+void QModbusChangeFilter::removeDeadband(int serverAddress, QModbusDataUnit::RegisterType table,
+                                         int address)
+{
+    Q_D(QModbusChangeFilter);
+
+    const quint32 key = QModbusChangeFilterPrivate::tableKey(serverAddress, table);
+    auto found = d->m_deadbands.find(key);
+    if (found == d->m_deadbands.end())
+        return;
+
+    QVector<QModbusChangeFilterPrivate::Deadband> &deadbands = *found;
+    for (int i = 0; i < deadbands.size(); ++i) {
+        if (deadbands.at(i).address == address) {
+            deadbands.remove(i);
+            break;
+        }
+    }
+    if (deadbands.isEmpty())
+        d->m_deadbands.erase(found);
+}
+
+/*!
+    Compares \a unit, read from the server at \a serverAddress, with the
+    previous result of the same range and returns the changed values, sorted
+    by address. The previous result is updated with the returned values.
+
+    If the range was not seen before, all values are returned. An invalid
+    \a unit returns an empty list. Unlike \l watch(), this function does not
+    emit \l valuesChanged().
+*/
+QVector<QModbusChangeFilter::Change> QModbusChangeFilter::filter(int serverAddress,
+                                                                 const QModbusDataUnit &unit)
+{
+    Q_D(QModbusChangeFilter);
+
+    QVector<Change> changes;
+    if (!unit.isValid())
+        return changes;
+
+    const QVector<quint16> values = unit.values();
+    const int count = qMin(int(unit.valueCount()), values.size());
+    const int start = unit.startAddress();
+    const quint16 *current = values.constData();
+
+    const quint64 key = QModbusChangeFilterPrivate::rangeKey(serverAddress, unit.registerType(),
+                                                             start, count);
+    auto previous = d->m_ranges.find(key);
+    if (previous == d->m_ranges.end()) {
+        d->m_ranges.insert(key, values.mid(0, count));
+        changes.reserve(count);
+        for (int i = 0; i < count; ++i)
+            changes.append({ start + i, current[i] });
+        return changes;
+    }
+
+    // the common case of a poll, nothing changed at all
+    quint16 *stored = previous->data();
+    if (std::memcmp(stored, current, size_t(count) * sizeof(quint16)) == 0)
+        return changes;
+
+    const QVector<QModbusChangeFilterPrivate::Deadband> deadbands = d->m_deadbands.value(
+                QModbusChangeFilterPrivate::tableKey(serverAddress, unit.registerType()));
+    auto band = std::lower_bound(deadbands.constBegin(), deadbands.constEnd(), start,
+                                 [](const QModbusChangeFilterPrivate::Deadband &entry, int a) {
+        return entry.address < a;
+    });
+
+    for (int i = 0; i < count;) {
+        const int address = start + i;
+        while (band != deadbands.constEnd() && band->address < address)
+            ++band;
+
+        if (band != deadbands.constEnd() && band->address == address && i + band->width <= count) {
+            const int width = band->width;
+            if (std::memcmp(stored + i, current + i, size_t(width) * sizeof(quint16)) != 0
+                    && QModbusChangeFilterPrivate::exceeds(*band, stored + i, current + i)) {
+                for (int j = i; j < i + width; ++j) {
+                    changes.append({ start + j, current[j] });
+                    stored[j] = current[j];
+                }
+            }
+            i += width;
+            continue;
+        }
+
+        if (stored[i] != current[i]) {
+            changes.append({ address, current[i] });
+            stored[i] = current[i];
+        }
+        ++i;
+    }
+    return changes;
+}
+
+/*!
+    Filters the result of the read \a reply once it has finished and emits
+    \l valuesChanged() if any value changed. If the reply has already
+    finished, it is filtered immediately. Replies that finished with an error
+    are ignored.
+
+    Only replies of read requests must be passed, as the result of a write
+    request does not reflect the current values of the server.
+*/
+void QModbusChangeFilter::watch(QModbusReply *reply)
+{
+    if (!reply)
+        return;
+
+    auto process = [this, reply]() {
+        if (reply->error() != QModbusDevice::NoError || reply->type() != QModbusReply::Common)
+            return;
+        const QModbusDataUnit unit = reply->result();
+        const QVector<Change> changes = filter(reply->serverAddress(), unit);
+        if (!changes.isEmpty())
+            emit valuesChanged(reply->serverAddress(), unit.registerType(), changes);
+    };
+
+    if (reply->isFinished())
+        process();
+    else
+        connect(reply, &QModbusReply::finished, this, process);
+}
+
+/*!
+    Forgets the previous results of all ranges, so the next result of each
+    range is reported completely. Deadbands are kept.
+*/
+void QModbusChangeFilter::reset()
+{
+    Q_D(QModbusChangeFilter);
+    d->m_ranges.clear();
+}
+
+/*!
+    \overload
+
+    Forgets the previous results of all ranges of the server at
+    \a serverAddress, for example after it was restarted.
+*/
+void QModbusChangeFilter::reset(int serverAddress)
+{
+    Q_D(QModbusChangeFilter);
+
+    const quint64 server = quint64(serverAddress & 0xffff);
+    for (auto it = d->m_ranges.begin(); it != d->m_ranges.end();) {
+        if ((it.key() >> 48) == server)
+            it = d->m_ranges.erase(it);
+        else
+            ++it;
+    }
+}
+
+double QModbusChangeFilterPrivate::decode(const Deadband &deadband, const quint16 *values)
+{
+    quint32 raw = values[0];
+    if (deadband.width == 2) {
+        raw = (deadband.order == QModbusChangeFilter::HighWordFirst)
+                ? (quint32(values[0]) << 16) | values[1]
+                : (quint32(values[1]) << 16) | values[0];
+    }
+
+    switch (deadband.type) {
+    case QModbusChangeFilter::UInt16:
+    case QModbusChangeFilter::UInt32:
+        return raw;
+    case QModbusChangeFilter::Int16:
+        return qint16(raw);
+    case QModbusChangeFilter::Int32:
+        return qint32(raw);
+    case QModbusChangeFilter::Float32: {
+        float value;
+        std::memcpy(&value, &raw, sizeof(value));
+        return value;
+    }
+    }
+    return raw;
+}
+
+bool QModbusChangeFilterPrivate::exceeds(const Deadband &deadband, const quint16 *previous,
+                                         const quint16 *current)
+{
+    const double before = decode(deadband, previous);
+    const double after = decode(deadband, current);
+    if (qIsNaN(before) || qIsNaN(after))
+        return qIsNaN(before) != qIsNaN(after);
+    return qAbs(after - before) > deadband.deadband;
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qmodbuschangefilter.cpp"
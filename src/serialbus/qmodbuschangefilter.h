@@ -0,0 +1,103 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QMODBUSCHANGEFILTER_H
+#define QMODBUSCHANGEFILTER_H
+
+#include <QtCore/qobject.h>
+#include <QtCore/qvector.h>
+#include <QtSerialBus/qmodbusdataunit.h>
+#include <QtSerialBus/qserialbusglobal.h>
+
+QT_BEGIN_NAMESPACE
+
+class QModbusChangeFilterPrivate;
+class QModbusReply;
+
+class Q_SERIALBUS_EXPORT QModbusChangeFilter : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QModbusChangeFilter)
+
+public:
+    enum ValueType {
+        UInt16,
+        Int16,
+        UInt32,
+        Int32,
+        Float32
+    };
+    Q_ENUM(ValueType)
+
+    enum WordOrder {
+        HighWordFirst,
+        LowWordFirst
+    };
+    Q_ENUM(WordOrder)
+
+    struct Change
+    {
+        int address;
+        quint16 value;
+    };
+
+    explicit QModbusChangeFilter(QObject *parent = nullptr);
+    ~QModbusChangeFilter();
+
+    bool setDeadband(int serverAddress, QModbusDataUnit::RegisterType table, int address,
+                     ValueType type, double deadband, WordOrder order = HighWordFirst);
+    void removeDeadband(int serverAddress, QModbusDataUnit::RegisterType table, int address);
+
+    QVector<Change> filter(int serverAddress, const QModbusDataUnit &unit);
+    void watch(QModbusReply *reply);
+
+    void reset();
+    void reset(int serverAddress);
+
+Q_SIGNALS:
+    void valuesChanged(int serverAddress, QModbusDataUnit::RegisterType table,
+                       const QVector<QModbusChangeFilter::Change> &changes);
+};
+Q_DECLARE_TYPEINFO(QModbusChangeFilter::ValueType, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(QModbusChangeFilter::WordOrder, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(QModbusChangeFilter::Change, Q_PRIMITIVE_TYPE);
+
+QT_END_NAMESPACE
+
+Q_DECLARE_METATYPE(QModbusChangeFilter::Change)
+Q_DECLARE_METATYPE(QVector<QModbusChangeFilter::Change>)
+
+#endif // QMODBUSCHANGEFILTER_H
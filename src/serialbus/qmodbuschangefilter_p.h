@@ -0,0 +1,96 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QMODBUSCHANGEFILTER_P_H
+#define QMODBUSCHANGEFILTER_P_H
+
+#include <QtCore/qhash.h>
+#include <QtSerialBus/qmodbuschangefilter.h>
+
+#include <private/qobject_p.h>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+class QModbusChangeFilterPrivate : public QObjectPrivate
+{
+    Q_DECLARE_PUBLIC(QModbusChangeFilter)
+
+public:
+    struct Deadband
+    {
+        int address;
+        int width;
+        QModbusChangeFilter::ValueType type;
+        QModbusChangeFilter::WordOrder order;
+        double deadband;
+    };
+
+    static quint32 tableKey(int serverAddress, QModbusDataUnit::RegisterType table) {
+        return (quint32(serverAddress & 0xffff) << 8) | quint32(table);
+    }
+
+    static quint64 rangeKey(int serverAddress, QModbusDataUnit::RegisterType table,
+                            int startAddress, int count) {
+        return (quint64(tableKey(serverAddress, table)) << 40)
+                | (quint64(startAddress & 0xffff) << 24) | quint64(count & 0xffffff);
+    }
+
+    static double decode(const Deadband &deadband, const quint16 *values);
+    static bool exceeds(const Deadband &deadband, const quint16 *previous,
+                        const quint16 *current);
+
+    // Last delivered values of every range seen, so a value drifting within
+    // its deadband is always compared with what the receiver has.
+    QHash<quint64, QVector<quint16>> m_ranges;
+
+    // Deadbands of each server and table, sorted by address.
+    QHash<quint32, QVector<Deadband>> m_deadbands;
+};
+
+QT_END_NAMESPACE
+
+#endif // QMODBUSCHANGEFILTER_P_H
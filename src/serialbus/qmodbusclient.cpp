@@ -82,6 +82,7 @@ QModbusClient::QModbusClient(QObject *parent)
 */
 QModbusClient::~QModbusClient()
 {
+    d_func()->abortSubmissions();
 }
 
 /*!
@@ -141,6 +142,98 @@ QModbusReply *QModbusClient::sendRawRequest(const QModbusRequest &request, int s
     return d_func()->sendRequest(request, serverAddress, nullptr);
 }
 
+/*!
+    \typedef QModbusClient::ReplyHandler
+    \since 5.7
+
+    Synonym for \c{std::function<void(QModbusReply *)>}, the type of the completion
+    callback passed to the \c submit functions.
+*/
+
+/*!
+    \since 5.7
+
+    Submits a request to read the contents of the data pointed by \a read from
+    the server with the address \a serverAddress.
+
+    Unlike sendReadRequest(), this function is thread-safe and may be called
+    from any thread. The request is appended to a lock-free queue that is
+    drained in batches by the thread the client lives in; submitting costs a
+    few atomic operations and at most one event post per batch.
+
+    Once the request is finished, \a handler is invoked with the
+    corresponding QModbusReply in the thread of \a context. If \a context is
+    destroyed before that happens, \a handler is not called. If \a context
+    is \c nullptr, \a handler is called in the client's thread. If the
+    request cannot be sent, \a handler receives a reply carrying the error.
+
+    The reply is a child of the client and should be released with
+    QObject::deleteLater() once \a handler is done with it. If \a handler is
+    empty, the reply is deleted automatically when it is finished.
+
+    Requests still waiting in the queue when the client is destroyed are not
+    sent; \a handler then receives a reply without parent carrying a
+    \l {QModbusDevice::}{ReplyAbortedError}.
+
+    \sa sendReadRequest()
+*/
+void QModbusClient::submitReadRequest(const QModbusDataUnit &read, int serverAddress,
+                                      QObject *context, const ReplyHandler &handler)
+{
+    Q_D(QModbusClient);
+    d->submit(d->createReadRequest(read), serverAddress, &read, context, handler);
+}
+
+/*!
+    \since 5.7
+
+    Submits a request to modify the contents of the data pointed by \a write
+    on the server with the address \a serverAddress. This function is
+    thread-safe; \a context and \a handler behave as described for
+    submitReadRequest().
+
+    \sa sendWriteRequest()
+*/
+void QModbusClient::submitWriteRequest(const QModbusDataUnit &write, int serverAddress,
+                                       QObject *context, const ReplyHandler &handler)
+{
+    Q_D(QModbusClient);
+    d->submit(d->createWriteRequest(write), serverAddress, &write, context, handler);
+}
+
+/*!
+    \since 5.7
+
+    Submits a request to read the contents of the data pointed by \a read and
+    to modify the contents of the data pointed by \a write on the server with
+    the address \a serverAddress. This function is thread-safe; \a context
+    and \a handler behave as described for submitReadRequest().
+
+    \sa sendReadWriteRequest()
+*/
+void QModbusClient::submitReadWriteRequest(const QModbusDataUnit &read,
+                                           const QModbusDataUnit &write, int serverAddress,
+                                           QObject *context, const ReplyHandler &handler)
+{
+    Q_D(QModbusClient);
+    d->submit(d->createRWRequest(read, write), serverAddress, &read, context, handler);
+}
+
+/*!
+    \since 5.7
+
+    Submits the raw Modbus \a request to the server with the address
+    \a serverAddress. This function is thread-safe; \a context and \a handler
+    behave as described for submitReadRequest().
+
+    \sa sendRawRequest()
+*/
+void QModbusClient::submitRawRequest(const QModbusRequest &request, int serverAddress,
+                                     QObject *context, const ReplyHandler &handler)
+{
+    d_func()->submit(request, serverAddress, nullptr, context, handler);
+}
+
 /*!
     \property QModbusClient::timeout
     \brief the timeout value used by this client
@@ -263,6 +356,103 @@ QModbusReply *QModbusClientPrivate::sendRequest(const QModbusRequest &request, i
     return enqueueRequest(request, serverAddress, QModbusDataUnit(), QModbusReply::Raw);
 }
 
+void QModbusClientPrivate::submit(const QModbusRequest &request, int serverAddress,
+                                  const QModbusDataUnit *unit, QObject *context,
+                                  const QModbusClient::ReplyHandler &handler)
+{
+    // Runs in the caller's thread, so only the queue may be touched here.
+    Submission submission;
+    submission.request = request;
+    submission.serverAddress = serverAddress;
+    if (unit) {
+        submission.unit = *unit;
+        submission.hasUnit = true;
+    }
+    submission.hasContext = (context != nullptr);
+    submission.context = context;
+    submission.handler = handler;
+
+    if (m_submissions.enqueue(std::move(submission)))
+        QMetaObject::invokeMethod(q_func(), "_q_processSubmissions", Qt::QueuedConnection);
+}
+
+void QModbusClientPrivate::_q_processSubmissions()
+{
+    Q_Q(QModbusClient);
+
+    // Bound the batch, so that a busy producer cannot starve the event loop.
+    enum { MaximumBatchSize = 64 };
+
+    m_submissions.beginDrain();
+    const int processed = m_submissions.drain([this, q](Submission submission) {
+        QModbusReply *reply = sendRequest(submission.request, submission.serverAddress,
+            submission.hasUnit ? &submission.unit : nullptr);
+
+        const bool failed = !reply;
+        if (failed) {
+            reply = new QModbusReply(submission.hasUnit ? QModbusReply::Common
+                : QModbusReply::Raw, submission.serverAddress, q);
+        }
+
+        if (!submission.handler || (submission.hasContext && !submission.context)) {
+            QObject::connect(reply, &QModbusReply::finished, reply, &QObject::deleteLater);
+        } else {
+            const QModbusClient::ReplyHandler handler = submission.handler;
+            QObject::connect(reply, &QModbusReply::finished,
+                submission.hasContext ? submission.context.data() : q,
+                [handler, reply]() { handler(reply); });
+        }
+
+        if (failed)
+            reply->setError(q->error(), q->errorString());
+    }, MaximumBatchSize);
+
+    if (processed == MaximumBatchSize && m_submissions.claimWakeUp())
+        QMetaObject::invokeMethod(q, "_q_processSubmissions", Qt::QueuedConnection);
+}
+
+void QModbusClientPrivate::abortSubmissions()
+{
+    // Called from the client's destructor. Producers must not submit anymore, but
+    // whatever is still queued has a caller waiting for its handler to run.
+    Submission submission;
+    while (m_submissions.dequeue(&submission)) {
+        QModbusReply *reply = new QModbusReply(submission.hasUnit ? QModbusReply::Common
+            : QModbusReply::Raw, submission.serverAddress);
+
+        if (!submission.handler || (submission.hasContext && !submission.context)) {
+            delete reply;
+            continue;
+        }
+
+        const QModbusClient::ReplyHandler handler = submission.handler;
+        QObject::connect(reply, &QModbusReply::finished,
+            submission.hasContext ? submission.context.data() : reply,
+            [handler, reply]() { handler(reply); });
+        reply->setError(QModbusDevice::ReplyAbortedError,
+                        QModbusClient::tr("Reply aborted due to destruction of the client."));
+    }
+}
+
+void QModbusClientPrivate::setTransport(QModbusTransport *transport)
+{
+    Q_Q(QModbusClient);
+
+    if (m_transport)
+        QObject::disconnect(m_transport.data(), nullptr, q, nullptr);
+
+    m_transport = transport;
+    if (!transport)
+        return;
+
+    QObject::connect(transport, &QModbusTransport::readyRead, q, [this]() {
+        processReceivedData();
+    });
+    QObject::connect(transport, &QModbusTransport::bytesWritten, q, [this](qint64 bytes) {
+        processBytesWritten(bytes);
+    });
+}
+
 QModbusRequest QModbusClientPrivate::createReadRequest(const QModbusDataUnit &data) const
 {
     if (!data.isValid())
@@ -590,4 +780,6 @@ bool QModbusClientPrivate::processReadWriteMultipleRegistersResponse(const QModb
     return collateBytes(resp, QModbusDataUnit::HoldingRegisters, data);
 }
 
+#include "moc_qmodbusclient.cpp"
+
 QT_END_NAMESPACE
@@ -43,6 +43,8 @@
 #include <QtSerialBus/qmodbuspdu.h>
 #include <QtSerialBus/qmodbusreply.h>
 
+#include <functional>
+
 QT_BEGIN_NAMESPACE
 
 class QModbusClientPrivate;
@@ -63,6 +65,16 @@ public:
                                        int serverAddress);
     QModbusReply *sendRawRequest(const QModbusRequest &request, int serverAddress);
 
+    typedef std::function<void(QModbusReply *)> ReplyHandler;
+    void submitReadRequest(const QModbusDataUnit &read, int serverAddress,
+                           QObject *context, const ReplyHandler &handler);
+    void submitWriteRequest(const QModbusDataUnit &write, int serverAddress,
+                            QObject *context, const ReplyHandler &handler);
+    void submitReadWriteRequest(const QModbusDataUnit &read, const QModbusDataUnit &write,
+                                int serverAddress, QObject *context, const ReplyHandler &handler);
+    void submitRawRequest(const QModbusRequest &request, int serverAddress,
+                          QObject *context, const ReplyHandler &handler);
+
     int timeout() const;
     void setTimeout(int newTimeout);
 
@@ -77,6 +89,9 @@ protected:
 
     virtual bool processResponse(const QModbusResponse &response, QModbusDataUnit *data);
     virtual bool processPrivateResponse(const QModbusResponse &response, QModbusDataUnit *data);
+
+private:
+    Q_PRIVATE_SLOT(d_func(), void _q_processSubmissions())
 };
 
 QT_END_NAMESPACE
@@ -42,6 +42,9 @@
 #include <QtSerialBus/qmodbuspdu.h>
 
 #include <private/qmodbusdevice_p.h>
+#include <private/qmodbustransport_p.h>
+#include <private/qmpscqueue_p.h>
+#include <private/qserialbustrace_p.h>
 
 //
 //  W A R N I N G
@@ -96,12 +99,34 @@ public:
                                          QModbusReply::ReplyType) {
         return nullptr;
     }
-    // TODO: Review once we have a transport layer in place.
-    virtual bool isOpen() const { return false; }
+    virtual bool isOpen() const { return m_transport && m_transport->isOpen(); }
+
+    // The transport only moves bytes, framing the ADUs stays with the subclass.
+    void setTransport(QModbusTransport *transport);
+    virtual void processReceivedData() {}
+    virtual void processBytesWritten(qint64 bytes) { Q_UNUSED(bytes) }
+
+    QPointer<QModbusTransport> m_transport;
 
     int m_numberOfRetries = 3;
     int m_responseTimeoutDuration = 1000;
 
+    struct Submission {
+        QModbusRequest request;
+        int serverAddress = 0;
+        QModbusDataUnit unit;
+        bool hasUnit = false;
+        bool hasContext = false;
+        QPointer<QObject> context;
+        QModbusClient::ReplyHandler handler;
+    };
+    void submit(const QModbusRequest &request, int serverAddress, const QModbusDataUnit *unit,
+                QObject *context, const QModbusClient::ReplyHandler &handler);
+    void _q_processSubmissions();
+    void abortSubmissions();
+
+    QMpscQueue<Submission> m_submissions;
+
     struct QueueElement {
         QueueElement() = default;
         QueueElement(QModbusReply *r, const QModbusRequest &req, const QModbusDataUnit &u, int num,
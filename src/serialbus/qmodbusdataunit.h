@@ -111,5 +111,6 @@ Q_DECLARE_TYPEINFO(QModbusDataUnit::RegisterType, Q_PRIMITIVE_TYPE);
 QT_END_NAMESPACE
 
 Q_DECLARE_METATYPE(QModbusDataUnit::RegisterType)
+Q_DECLARE_METATYPE(QModbusDataUnit)
 
 #endif // QMODBUSDATAUNIT_H
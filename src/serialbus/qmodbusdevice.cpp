@@ -276,6 +276,7 @@ void QModbusDevice::setState(QModbusDevice::State newState)
         return;
 
     d->state = newState;
+    d->recordEvent(QSerialBusFlightRecorderPrivate::StateChange, quint32(newState), 0);
     emit stateChanged(newState);
 }
 
@@ -302,6 +303,11 @@ void QModbusDevice::setError(const QString &errorText, QModbusDevice::Error erro
 
     d->error = error;
     d->errorString = errorText;
+    if (QSerialBusFlightRecorderPrivate *recorder = d->m_flightRecorder.loadAcquire()) {
+        const QByteArray text = errorText.toUtf8();
+        recorder->record(d->m_flightRecorderInterface, QSerialBusFlightRecorderPrivate::Error, 0,
+                         quint32(error), 0, text.constData(), text.size());
+    }
     emit errorOccurred(error);
 }
 
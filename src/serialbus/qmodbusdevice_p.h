@@ -42,6 +42,7 @@
 #include <QtSerialPort/qserialport.h>
 
 #include <private/qobject_p.h>
+#include <private/qserialbusflightrecorder_p.h>
 
 //
 //  W A R N I N G
@@ -75,6 +76,25 @@ public:
     QString m_networkAddress = QStringLiteral("127.0.0.1");
 
     QHash<int, QVariant> m_userConnectionParams;
+
+    void recordEvent(QSerialBusFlightRecorderPrivate::EventType type, quint32 id, quint32 value)
+    {
+        if (QSerialBusFlightRecorderPrivate *recorder = m_flightRecorder.loadAcquire())
+            recorder->record(m_flightRecorderInterface, type, 0, id, value);
+    }
+
+    void recordAdu(const QByteArray &adu, bool transmitted)
+    {
+        if (QSerialBusFlightRecorderPrivate *recorder = m_flightRecorder.loadAcquire()) {
+            recorder->record(m_flightRecorderInterface, QSerialBusFlightRecorderPrivate::ModbusAdu,
+                             transmitted ? QSerialBusFlightRecorderPrivate::Transmitted : 0, 0, 0,
+                             adu.constData(), adu.size());
+        }
+    }
+
+    // set by QSerialBusFlightRecorder::attach()
+    QAtomicPointer<QSerialBusFlightRecorderPrivate> m_flightRecorder;
+    quint16 m_flightRecorderInterface = 0;
 };
 
 QT_END_NAMESPACE
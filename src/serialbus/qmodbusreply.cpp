@@ -53,8 +53,37 @@ public:
     QString m_errorText;
     QModbusResponse m_response;
     QModbusReply::ReplyType m_type;
+
+    QModbusReply::FinishedHook m_finishedHook = nullptr;
+    void *m_finishedHookData = nullptr;
+    bool m_finishedHookQueued = false;
+
+    void queueFinishedHook();
+    void _q_callFinishedHook();
 };
 
+void QModbusReplyPrivate::queueFinishedHook()
+{
+    Q_Q(QModbusReply);
+
+    // resume from the event loop of the reply's thread, not from deep inside
+    // the client that finished the reply
+    if (m_finishedHook && !m_finishedHookQueued) {
+        m_finishedHookQueued = true;
+        QMetaObject::invokeMethod(q, "_q_callFinishedHook", Qt::QueuedConnection);
+    }
+}
+
+void QModbusReplyPrivate::_q_callFinishedHook()
+{
+    m_finishedHookQueued = false;
+    // reset first, the hook may well set itself again
+    if (QModbusReply::FinishedHook hook = m_finishedHook) {
+        m_finishedHook = nullptr;
+        hook(m_finishedHookData);
+    }
+}
+
 /*!
     \class QModbusReply
     \inmodule QtSerialBus
@@ -112,8 +141,74 @@ void QModbusReply::setFinished(bool isFinished)
 {
     Q_D(QModbusReply);
     d->m_finished = isFinished;
-    if (isFinished)
-        emit finished();
+    if (!isFinished)
+        return;
+
+    // queued before finished() is emitted, so a deleteLater() from a
+    // connected slot cannot drop it
+    d->queueFinishedHook();
+    emit finished();
+    d->queueFinishedHook();
+}
+
+/*!
+    \typedef QModbusReply::FinishedHook
+    \since 5.7
+
+    Function called by the reply once it has finished, with the \c data
+    pointer passed to setFinishedHook().
+*/
+
+/*!
+    \since 5.7
+
+    Sets \a hook to be called with \a data once the reply has finished. The
+    hook is called only once and then reset. Passing \c nullptr removes a
+    previously set hook.
+
+    The hook is not called from within setFinished(), which usually runs deep
+    inside the client, but by a queued invocation in the thread the reply
+    lives in, after the \l finished() signal was emitted. Unlike a connection
+    to \l finished(), the hook does not go through signal dispatch. It is
+    meant for adaptors that resume a waiting operation, such as the
+    awaitables in \c qserialbuscoroutine.h. The hook must not delete the
+    reply; use deleteLater() instead.
+
+    Only one hook can be set at a time. An adaptor that waits together with
+    others has to read the current hook with finishedHook() and
+    finishedHookData() first and call it from its own hook.
+
+    \sa isFinished()
+*/
+void QModbusReply::setFinishedHook(FinishedHook hook, void *data)
+{
+    Q_D(QModbusReply);
+    d->m_finishedHook = hook;
+    d->m_finishedHookData = data;
+}
+
+/*!
+    \since 5.7
+
+    Returns the hook set by setFinishedHook(), or \c nullptr if there is none.
+
+    \sa finishedHookData()
+*/
+QModbusReply::FinishedHook QModbusReply::finishedHook() const
+{
+    Q_D(const QModbusReply);
+    return d->m_finishedHook;
+}
+
+/*!
+    \since 5.7
+
+    Returns the data pointer set together with finishedHook().
+*/
+void *QModbusReply::finishedHookData() const
+{
+    Q_D(const QModbusReply);
+    return d->m_finishedHookData;
 }
 
 /*!
@@ -76,9 +76,17 @@ public:
     void setFinished(bool isFinished);
     void setError(QModbusDevice::Error error, const QString &errorText);
 
+    typedef void (*FinishedHook)(void *data);
+    void setFinishedHook(FinishedHook hook, void *data);
+    FinishedHook finishedHook() const;
+    void *finishedHookData() const;
+
 Q_SIGNALS:
     void finished();
     void errorOccurred(QModbusDevice::Error error);
+
+private:
+    Q_PRIVATE_SLOT(d_func(), void _q_callFinishedHook())
 };
 Q_DECLARE_TYPEINFO(QModbusReply::ReplyType, Q_PRIMITIVE_TYPE);
 
@@ -45,9 +45,7 @@
 #include <QtSerialBus/qmodbusrtuserialmaster.h>
 #include <QtSerialPort/qserialport.h>
 
-#include <private/qmodbusadu_p.h>
 #include <private/qmodbusclient_p.h>
-#include <private/qmodbus_symbols_p.h>
 
 //
 //  W A R N I N G
@@ -87,78 +85,6 @@ public:
         QObject::connect(&m_responseTimer, &QTimer::timeout, q, [this]() { processQueue(); });
 
         m_serialPort = new QSerialPort(q);
-        QObject::connect(m_serialPort, &QSerialPort::readyRead, q, [this]() {
-            responseBuffer += m_serialPort->read(m_serialPort->bytesAvailable());
-            qCDebug(QT_MODBUS_LOW) << "(RTU client) Response buffer:" << responseBuffer.toHex();
-
-            if (responseBuffer.size() < 2) {
-                qCDebug(QT_MODBUS) << "(RTU client) Modbus ADU not complete";
-                return;
-            }
-
-            const QModbusSerialAdu tmpAdu(QModbusSerialAdu::Rtu, responseBuffer);
-            int pduSizeWithoutFcode = QModbusResponse::calculateDataSize(tmpAdu.pdu());
-            if (pduSizeWithoutFcode < 0) {
-                // wait for more data
-                qCDebug(QT_MODBUS) << "(RTU client) Cannot calculate PDU size for function code:"
-                                   << tmpAdu.pdu().functionCode() << ", delaying pending frame";
-                return;
-            }
-
-            // server address byte + function code byte + PDU size + 2 bytes CRC
-            int aduSize = 2 + pduSizeWithoutFcode + 2;
-            if (tmpAdu.rawSize() < aduSize) {
-                qCDebug(QT_MODBUS) << "(RTU client) Incomplete ADU received, ignoring";
-                return;
-            }
-
-            // Special case for Diagnostics:ReturnQueryData. The response has no
-            // length indicator and is just a simple echo of what we have send.
-            if (tmpAdu.pdu().functionCode() == QModbusPdu::Diagnostics) {
-                const QModbusResponse response = tmpAdu.pdu();
-                if (canMatchRequestAndResponse(response, tmpAdu.serverAddress())) {
-                    quint16 subCode = 0xffff;
-                    response.decodeData(&subCode);
-                    if (subCode == Diagnostics::ReturnQueryData) {
-                        if (response.data() != m_current.requestPdu.data())
-                            return; // echo does not match request yet
-                        aduSize = 2 + response.dataSize() + 2;
-                        if (tmpAdu.rawSize() < aduSize)
-                            return; // echo matches, probably checksum missing
-                    }
-                }
-            }
-
-            const QModbusSerialAdu adu(QModbusSerialAdu::Rtu, responseBuffer.left(aduSize));
-            responseBuffer.remove(0, aduSize);
-
-            qCDebug(QT_MODBUS)<< "(RTU client) Received ADU:" << adu.rawData().toHex();
-            if (QT_MODBUS().isDebugEnabled() && !responseBuffer.isEmpty())
-                qCDebug(QT_MODBUS_LOW) << "(RTU client) Pending buffer:" << responseBuffer.toHex();
-
-            // check CRC
-            if (!adu.matchingChecksum()) {
-                qCWarning(QT_MODBUS) << "(RTU client) Discarding response with wrong CRC, received:"
-                                     << adu.checksum<quint16>() << ", calculated CRC:"
-                                     << QModbusSerialAdu::calculateCRC(adu.data(), adu.size());
-                return;
-            }
-
-            const QModbusResponse response = adu.pdu();
-            if (!canMatchRequestAndResponse(response, adu.serverAddress())) {
-                qCWarning(QT_MODBUS) << "(RTU client) Cannot match response with open request, "
-                    "ignoring";
-                return;
-            }
-
-            m_sendTimer.stop();
-            m_responseTimer.stop();
-            processQueueElement(response, m_current);
-
-            m_state = Schedule; // reschedule, even if empty
-            m_serialPort->clear(QSerialPort::AllDirections);
-            QTimer::singleShot(m_timeoutThreeDotFiveMs, [this]() { processQueue(); });
-        });
 
         using TypeId = void (QSerialPort::*)(QSerialPort::SerialPortError);
         QObject::connect(m_serialPort, static_cast<TypeId>(&QSerialPort::error),
@@ -210,10 +136,6 @@ public:
             }
         });
 
-        QObject::connect(m_serialPort, &QSerialPort::bytesWritten, q, [this](qint64 bytes) {
-            m_current.bytesWritten += bytes;
-        });
-
         QObject::connect(m_serialPort, &QSerialPort::aboutToClose, q, [this]() {
             Q_Q(QModbusRtuSerialMaster);
             Q_UNUSED(q); // To avoid unused variable warning in release mode
@@ -222,6 +144,70 @@ public:
             m_sendTimer.stop();
             m_responseTimer.stop();
         });
+
+        setTransport(new QModbusIoDeviceTransport(m_serialPort, q));
+    }
+
+    void processReceivedData() override
+    {
+        QModbusReceiveBuffer *buffer = m_transport->receiveBuffer();
+        qCDebug(QT_MODBUS_LOW) << "(RTU client) Response buffer:"
+                               << QByteArray::fromRawData(buffer->data(), buffer->size()).toHex();
+
+        QModbusFrame frame;
+        int aduSize = 0;
+        const QModbusFramer::Result result = m_framer.decode(buffer->data(), buffer->size(),
+                                                             &frame, &aduSize);
+        if (result == QModbusFramer::Incomplete) {
+            qCDebug(QT_MODBUS) << "(RTU client) Modbus ADU not complete";
+            return;
+        }
+
+        const QByteArray adu = QByteArray::fromRawData(buffer->data(), aduSize);
+        recordAdu(adu, false);
+        qCDebug(QT_MODBUS)<< "(RTU client) Received ADU:" << adu.toHex();
+
+        if (result == QModbusFramer::ChecksumError) {
+            qCWarning(QT_MODBUS) << "(RTU client) Discarding response with wrong CRC:"
+                                 << adu.toHex();
+        } else if (result == QModbusFramer::Invalid) {
+            qCWarning(QT_MODBUS) << "(RTU client) Discarding invalid response:" << adu.toHex();
+        }
+        buffer->consume(aduSize);
+
+        if (QT_MODBUS().isDebugEnabled() && !buffer->isEmpty()) {
+            qCDebug(QT_MODBUS_LOW) << "(RTU client) Pending buffer:"
+                << QByteArray::fromRawData(buffer->data(), buffer->size()).toHex();
+        }
+
+        if (result != QModbusFramer::Complete)
+            return;
+
+        const QModbusResponse response = frame.response();
+        if (!canMatchRequestAndResponse(response, frame.serverAddress)) {
+            qCWarning(QT_MODBUS) << "(RTU client) Cannot match response with open request, "
+                "ignoring";
+            return;
+        }
+
+        m_sendTimer.stop();
+        m_responseTimer.stop();
+        Q_SERIALBUS_TRACE(ModbusResponseReceived, frame.serverAddress, response.functionCode(), 0);
+        processQueueElement(response, m_current);
+
+        scheduleNextRequest(); // reschedule, even if empty
+    }
+
+    void processBytesWritten(qint64 bytes) override
+    {
+        m_current.bytesWritten += bytes;
+    }
+
+    void clearSerialPort()
+    {
+        // Only a serial port knows about bytes still held by the driver.
+        if (m_serialPort && m_serialPort->isOpen())
+            m_serialPort->clear(QSerialPort::AllDirections);
     }
 
     void setupEnvironment() {
@@ -248,13 +234,13 @@ public:
             m_timeoutThreeDotFiveMs = 2;
         }
 
-        responseBuffer.clear();
+        m_transport->receiveBuffer()->clear();
         m_state = QModbusRtuSerialMasterPrivate::Idle;
     }
 
     void scheduleNextRequest() {
         m_state = Schedule;
-        m_serialPort->clear(QSerialPort::AllDirections);
+        clearSerialPort();
         QTimer::singleShot(m_timeoutThreeDotFiveMs, [this]() { processQueue(); });
     }
 
@@ -265,7 +251,7 @@ public:
 
         auto reply = new QModbusReply(type, serverAddress, q);
         QueueElement element(reply, request, unit, m_numberOfRetries + 1);
-        element.adu = QModbusSerialAdu::create(QModbusSerialAdu::Rtu, serverAddress, request);
+        element.adu = m_framer.encode(serverAddress, 0, request);
         m_queue.enqueue(element);
 
         if (m_state == Idle)
@@ -279,11 +265,14 @@ public:
         Q_ASSERT_X(!m_responseTimer.isActive(), "processQueue", "response timer active");
 
         auto writeAdu = [this]() {
-            responseBuffer.clear();
+            m_transport->receiveBuffer()->clear();
             m_current.bytesWritten = 0;
             m_current.numberOfRetries--;
-            m_serialPort->write(m_current.adu);
+            m_transport->write(m_current.adu);
             m_sendTimer.start(m_timeoutThreeDotFiveMs);
+            Q_SERIALBUS_TRACE(ModbusRequestSent, quint8(m_current.adu.at(0)),
+                              m_current.requestPdu.functionCode(), 0);
+            recordAdu(m_current.adu, true);
 
             qCDebug(QT_MODBUS) << "(RTU client) Sent Serial PDU:" << m_current.requestPdu;
             qCDebug(QT_MODBUS_LOW).noquote() << "(RTU client) Sent Serial ADU: 0x" + m_current.adu
@@ -314,13 +303,24 @@ public:
                 qCDebug(QT_MODBUS) << "(RTU client) Send failed:" << m_current.requestPdu;
 
                 if (m_current.numberOfRetries <= 0) {
+                    Q_SERIALBUS_TRACE(ModbusTimeout, m_current.reply->serverAddress(),
+                                      m_current.requestPdu.functionCode(), 0);
+                    recordEvent(QSerialBusFlightRecorderPrivate::ModbusTimeout,
+                                m_current.reply->serverAddress(),
+                                m_current.requestPdu.functionCode());
                     if (m_current.reply) {
                         m_current.reply->setError(QModbusDevice::TimeoutError,
                             QModbusClient::tr("Request timeout."));
                     }
                     scheduleNextRequest();
                 } else {
-                    m_serialPort->clear(QSerialPort::AllDirections);
+                    Q_SERIALBUS_TRACE(ModbusRetry, m_current.reply->serverAddress(),
+                                      m_current.requestPdu.functionCode(),
+                                      m_current.numberOfRetries);
+                    recordEvent(QSerialBusFlightRecorderPrivate::ModbusRetry,
+                                m_current.reply->serverAddress(),
+                                m_current.requestPdu.functionCode());
+                    clearSerialPort();
                     QTimer::singleShot(m_timeoutThreeDotFiveMs, [writeAdu]() { writeAdu(); });
                 }
             } else {
@@ -336,14 +336,22 @@ public:
             if (m_current.reply.isNull()) {
                 scheduleNextRequest();
             } else if (m_current.numberOfRetries <= 0) {
+                Q_SERIALBUS_TRACE(ModbusTimeout, m_current.reply->serverAddress(),
+                                  m_current.requestPdu.functionCode(), 0);
+                recordEvent(QSerialBusFlightRecorderPrivate::ModbusTimeout,
+                            m_current.reply->serverAddress(), m_current.requestPdu.functionCode());
                 if (m_current.reply) {
                     m_current.reply->setError(QModbusDevice::TimeoutError,
                         QModbusClient::tr("Response timeout."));
                 }
                 scheduleNextRequest();
             } else {
+                Q_SERIALBUS_TRACE(ModbusRetry, m_current.reply->serverAddress(),
+                                  m_current.requestPdu.functionCode(), m_current.numberOfRetries);
+                recordEvent(QSerialBusFlightRecorderPrivate::ModbusRetry,
+                            m_current.reply->serverAddress(), m_current.requestPdu.functionCode());
                 m_state = Send;
-                m_serialPort->clear(QSerialPort::AllDirections);
+                clearSerialPort();
                 QTimer::singleShot(m_timeoutThreeDotFiveMs, [this, writeAdu]() { writeAdu(); });
             }
             break;
@@ -366,18 +374,11 @@ public:
         return true;
     }
 
-    bool isOpen() const override
-    {
-        if (m_serialPort)
-            return m_serialPort->isOpen();
-        return false;
-    }
-
     QTimer m_sendTimer;
     QTimer m_responseTimer;
 
     QueueElement m_current;
-    QByteArray responseBuffer;
+    QModbusRtuFramer m_framer { QModbusFramer::ClientRole };
 
     QQueue<QueueElement> m_queue;
     QSerialPort *m_serialPort = nullptr;
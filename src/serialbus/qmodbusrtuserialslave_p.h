@@ -43,8 +43,8 @@
 #include <QtSerialBus/qmodbusrtuserialslave.h>
 #include <QtSerialPort/qserialport.h>
 
-#include <private/qmodbusadu_p.h>
 #include <private/qmodbusserver_p.h>
+#include <private/qmodbustransport_p.h>
 
 //
 //  W A R N I N G
@@ -72,195 +72,28 @@ public:
         Q_Q(QModbusRtuSerialSlave);
 
         m_serialPort = new QSerialPort(q);
-        QObject::connect(m_serialPort, &QSerialPort::readyRead, [this]() {
-            const int size = m_serialPort->size();
-            m_requestBuffer += m_serialPort->read(size);
-
-            const QModbusSerialAdu adu(QModbusSerialAdu::Rtu, m_requestBuffer);
-            qCDebug(QT_MODBUS_LOW) << "(RTU server) Received ADU:" << adu.rawData().toHex();
-
-            // Index                         -> description
-            // Server address                -> 1 byte
-            // FunctionCode                  -> 1 byte
-            // FunctionCode specific content -> 0-252 bytes
-            // CRC                           -> 2 bytes
-            Q_Q(QModbusRtuSerialSlave);
-            QModbusCommEvent event = QModbusCommEvent::ReceiveEvent;
-            if (q->value(QModbusServer::ListenOnlyMode).toBool())
-                event |= QModbusCommEvent::ReceiveFlag::CurrentlyInListenOnlyMode;
-
-            // We expect at least the server address, function code and CRC.
-            if (adu.rawSize() < 4) { // TODO: LRC should be 3 bytes.
-                qCWarning(QT_MODBUS) << "(RTU server) Incomplete ADU received, ignoring";
-
-                // The quantity of CRC errors encountered by the remote device since its last
-                // restart, clear counters operation, or powerup. In case of a message
-                // length < 4 bytes, the receiving device is not able to calculate the CRC.
-                incrementCounter(QModbusServerPrivate::Counter::BusCommunicationError);
-                storeModbusCommEvent(event | QModbusCommEvent::ReceiveFlag::CommunicationError);
-                return;
-            }
-
-            // Server address is set to 0, this is a broadcast.
-            m_processesBroadcast = (adu.serverAddress() == 0);
-            if (q->processesBroadcast())
-                event |= QModbusCommEvent::ReceiveFlag::BroadcastReceived;
-
-            const int pduSizeWithoutFcode = QModbusRequest::calculateDataSize(adu.pdu());
-
-            // server address byte + function code byte + PDU size + 2 bytes CRC
-            if ((pduSizeWithoutFcode < 0) || ((2 + pduSizeWithoutFcode + 2) != adu.rawSize())) {
-                qCWarning(QT_MODBUS) << "(RTU server) ADU does not match expected size, ignoring";
-                // The quantity of messages addressed to the remote device that it could not
-                // handle due to a character overrun condition, since its last restart, clear
-                // counters operation, or powerup. A character overrun is caused by data
-                // characters arriving at the port faster than they can be stored, or by the loss
-                // of a character due to a hardware malfunction.
-                incrementCounter(QModbusServerPrivate::Counter::BusCharacterOverrun);
-                storeModbusCommEvent(event | QModbusCommEvent::ReceiveFlag::CharacterOverrun);
-                return;
-            }
-
-            // We received the full message, including checksum. We do not expect more bytes to
-            // arrive, so clear the buffer. All new bytes are considered part of the next message.
-            m_requestBuffer.resize(0);
-
-            if (!adu.matchingChecksum()) {
-                qCWarning(QT_MODBUS) << "(RTU server) Discarding request with wrong CRC, received:"
-                                     << adu.checksum<quint16>() << ", calculated CRC:"
-                                     << QModbusSerialAdu::calculateCRC(adu.data(), adu.size());
-                // The quantity of CRC errors encountered by the remote device since its last
-                // restart, clear counters operation, or powerup.
-                incrementCounter(QModbusServerPrivate::Counter::BusCommunicationError);
-                storeModbusCommEvent(event | QModbusCommEvent::ReceiveFlag::CommunicationError);
-                return;
-            }
-
-            // The quantity of messages that the remote device has detected on the communications
-            // system since its last restart, clear counters operation, or powerup.
-            incrementCounter(QModbusServerPrivate::Counter::BusMessage);
-
-            // If we do not process a Broadcast ...
-            if (!q->processesBroadcast()) {
-                // check if the server address matches ...
-                if (q->serverAddress() != adu.serverAddress()) {
-                    // no, not our address! Ignore!
-                    qCDebug(QT_MODBUS) << "(RTU server) Wrong server address, expected"
-                        << q->serverAddress() << "got" << adu.serverAddress();
+        m_transport = new QModbusIoDeviceTransport(m_serialPort, q);
+        QObject::connect(m_transport, &QModbusTransport::readyRead, q, [this]() {
+            QModbusReceiveBuffer *buffer = m_transport->receiveBuffer();
+            while (!buffer->isEmpty()) {
+                QModbusFrame frame;
+                int aduSize = 0;
+                const QModbusFramer::Result result = m_framer.decode(buffer->data(),
+                                                                     buffer->size(), &frame,
+                                                                     &aduSize);
+                if (result == QModbusFramer::Incomplete) {
+                    qCDebug(QT_MODBUS_LOW) << "(RTU server) Incomplete ADU received, waiting for "
+                        "more data";
                     return;
                 }
-            } // else { Broadcast -> Server address will never match, deliberately ignore }
-
-            storeModbusCommEvent(event); // store the final event before processing
-
-            const QModbusRequest req = adu.pdu();
-            qCDebug(QT_MODBUS) << "(RTU server) Request PDU:" << req;
-            QModbusResponse response; // If the device ...
-            if (q->value(QModbusServer::DeviceBusy).value<quint16>() == 0xffff) {
-                // is busy, update the quantity of messages addressed to the remote device for
-                // which it returned a Server Device Busy exception response, since its last
-                // restart, clear counters operation, or powerup.
-                incrementCounter(QModbusServerPrivate::Counter::ServerBusy);
-                response = QModbusExceptionResponse(req.functionCode(),
-                    QModbusExceptionResponse::ServerDeviceBusy);
-            } else {
-                // is not busy, update the quantity of messages addressed to the remote device,
-                // or broadcast, that the remote device has processed since its last restart,
-                // clear counters operation, or powerup.
-                incrementCounter(QModbusServerPrivate::Counter::ServerMessage);
-                response = q->processRequest(req);
-            }
-            qCDebug(QT_MODBUS) << "(RTU server) Response PDU:" << response;
-
-            event = QModbusCommEvent::SentEvent; // reset event after processing
-            if (q->value(QModbusServer::ListenOnlyMode).toBool())
-                event |= QModbusCommEvent::SendFlag::CurrentlyInListenOnlyMode;
-
-            if ((!response.isValid())
-                || q->processesBroadcast()
-                || q->value(QModbusServer::ListenOnlyMode).toBool()) {
-                // The quantity of messages addressed to the remote device for which it has
-                // returned no response (neither a normal response nor an exception response),
-                // since its last restart, clear counters operation, or powerup.
-                incrementCounter(QModbusServerPrivate::Counter::ServerNoResponse);
-                storeModbusCommEvent(event);
-                return;
-            }
 
-            const QByteArray result = QModbusSerialAdu::create(QModbusSerialAdu::Rtu,
-                                                               q->serverAddress(), response);
+                const QByteArray adu = QByteArray::fromRawData(buffer->data(), aduSize);
+                qCDebug(QT_MODBUS_LOW) << "(RTU server) Received ADU:" << adu.toHex();
+                recordAdu(adu, false);
+                buffer->consume(aduSize);
 
-            qCDebug(QT_MODBUS_LOW) << "(RTU server) Response ADU:" << result.toHex();
-
-            if (!m_serialPort->isOpen()) {
-                qCDebug(QT_MODBUS) << "(RTU server) Requesting serial port has closed.";
-                q->setError(QModbusRtuSerialSlave::tr("Requesting serial port is closed"),
-                            QModbusDevice::WriteError);
-                incrementCounter(QModbusServerPrivate::Counter::ServerNoResponse);
-                storeModbusCommEvent(event);
-                return;
+                processFrame(frame, result);
             }
-
-            int writtenBytes = m_serialPort->write(result);
-            if ((writtenBytes == -1) || (writtenBytes < result.size())) {
-                qCDebug(QT_MODBUS) << "(RTU server) Cannot write requested response to serial port.";
-                q->setError(QModbusRtuSerialSlave::tr("Could not write response to client"),
-                            QModbusDevice::WriteError);
-                incrementCounter(QModbusServerPrivate::Counter::ServerNoResponse);
-                storeModbusCommEvent(event);
-                m_serialPort->clear(QSerialPort::Output);
-                return;
-            }
-
-            if (response.isException()) {
-                switch (response.exceptionCode()) {
-                case QModbusExceptionResponse::IllegalFunction:
-                case QModbusExceptionResponse::IllegalDataAddress:
-                case QModbusExceptionResponse::IllegalDataValue:
-                    event |= QModbusCommEvent::SendFlag::ReadExceptionSent;
-                    break;
-
-                case QModbusExceptionResponse::ServerDeviceFailure:
-                    event |= QModbusCommEvent::SendFlag::ServerAbortExceptionSent;
-                    break;
-
-                case QModbusExceptionResponse::ServerDeviceBusy:
-                    // The quantity of messages addressed to the remote device for which it
-                    // returned a server device busy exception response, since its last restart,
-                    // clear counters operation, or powerup.
-                    incrementCounter(QModbusServerPrivate::Counter::ServerBusy);
-                    event |= QModbusCommEvent::SendFlag::ServerBusyExceptionSent;
-                    break;
-
-                case  QModbusExceptionResponse::NegativeAcknowledge:
-                    // The quantity of messages addressed to the remote device for which it
-                    // returned a negative acknowledge (NAK) exception response, since its last
-                    // restart, clear counters operation, or powerup.
-                    incrementCounter(QModbusServerPrivate::Counter::ServerNAK);
-                    event |= QModbusCommEvent::SendFlag::ServerProgramNAKExceptionSent;
-                    break;
-
-                default:
-                    break;
-                }
-                // The quantity of Modbus exception responses returned by the remote device since
-                // its last restart, clear counters operation, or powerup.
-                incrementCounter(QModbusServerPrivate::Counter::BusExceptionError);
-            } else {
-                switch (quint16(req.functionCode())) {
-                case 0x0a: // Poll 484 (not in the official Modbus specification) *1
-                case 0x0e: // Poll Controller (not in the official Modbus specification) *1
-                case QModbusRequest::GetCommEventCounter: // fall through and bail out
-                    break;
-                default:
-                    // The device's event counter is incremented once for each successful message
-                    // completion. Do not increment for exception responses, poll commands, or fetch
-                    // event counter commands.            *1 but mentioned here ^^^
-                    incrementCounter(QModbusServerPrivate::Counter::CommEvent);
-                    break;
-                }
-            }
-            storeModbusCommEvent(event); // store the final event after processing
         });
 
         using TypeId = void (QSerialPort::*)(QSerialPort::SerialPortError);
@@ -321,6 +154,175 @@ public:
         });
     }
 
+    void processFrame(const QModbusFrame &frame, QModbusFramer::Result result)
+    {
+        // Index                         -> description
+        // Server address                -> 1 byte
+        // FunctionCode                  -> 1 byte
+        // FunctionCode specific content -> 0-252 bytes
+        // CRC                           -> 2 bytes
+        Q_Q(QModbusRtuSerialSlave);
+        QModbusCommEvent event = QModbusCommEvent::ReceiveEvent;
+        if (q->value(QModbusServer::ListenOnlyMode).toBool())
+            event |= QModbusCommEvent::ReceiveFlag::CurrentlyInListenOnlyMode;
+
+        // Server address is set to 0, this is a broadcast.
+        m_processesBroadcast = (frame.serverAddress == 0);
+        if (q->processesBroadcast())
+            event |= QModbusCommEvent::ReceiveFlag::BroadcastReceived;
+
+        if (result == QModbusFramer::Invalid) {
+            qCWarning(QT_MODBUS) << "(RTU server) ADU does not match expected size, ignoring";
+            // The quantity of messages addressed to the remote device that it could not
+            // handle due to a character overrun condition, since its last restart, clear
+            // counters operation, or powerup. A character overrun is caused by data
+            // characters arriving at the port faster than they can be stored, or by the loss
+            // of a character due to a hardware malfunction.
+            incrementCounter(QModbusServerPrivate::Counter::BusCharacterOverrun);
+            storeModbusCommEvent(event | QModbusCommEvent::ReceiveFlag::CharacterOverrun);
+            return;
+        }
+
+        if (result == QModbusFramer::ChecksumError) {
+            qCWarning(QT_MODBUS) << "(RTU server) Discarding request with wrong CRC";
+            // The quantity of CRC errors encountered by the remote device since its last
+            // restart, clear counters operation, or powerup.
+            incrementCounter(QModbusServerPrivate::Counter::BusCommunicationError);
+            storeModbusCommEvent(event | QModbusCommEvent::ReceiveFlag::CommunicationError);
+            return;
+        }
+
+        // The quantity of messages that the remote device has detected on the communications
+        // system since its last restart, clear counters operation, or powerup.
+        incrementCounter(QModbusServerPrivate::Counter::BusMessage);
+
+        // If we do not process a Broadcast ...
+        if (!q->processesBroadcast()) {
+            // check if the server address matches ...
+            if (q->serverAddress() != frame.serverAddress) {
+                // no, not our address! Ignore!
+                qCDebug(QT_MODBUS) << "(RTU server) Wrong server address, expected"
+                    << q->serverAddress() << "got" << frame.serverAddress;
+                return;
+            }
+        } // else { Broadcast -> Server address will never match, deliberately ignore }
+
+        storeModbusCommEvent(event); // store the final event before processing
+
+        const QModbusRequest req = frame.request();
+        qCDebug(QT_MODBUS) << "(RTU server) Request PDU:" << req;
+        QModbusResponse response; // If the device ...
+        if (q->value(QModbusServer::DeviceBusy).value<quint16>() == 0xffff) {
+            // is busy, update the quantity of messages addressed to the remote device for
+            // which it returned a Server Device Busy exception response, since its last
+            // restart, clear counters operation, or powerup.
+            incrementCounter(QModbusServerPrivate::Counter::ServerBusy);
+            response = QModbusExceptionResponse(req.functionCode(),
+                QModbusExceptionResponse::ServerDeviceBusy);
+        } else {
+            // is not busy, update the quantity of messages addressed to the remote device,
+            // or broadcast, that the remote device has processed since its last restart,
+            // clear counters operation, or powerup.
+            incrementCounter(QModbusServerPrivate::Counter::ServerMessage);
+            Q_SERIALBUS_TRACE(ModbusServerRequestStarted, frame.serverAddress,
+                              req.functionCode(), 0);
+            response = q->processRequest(req);
+            Q_SERIALBUS_TRACE(ModbusServerRequestFinished, frame.serverAddress,
+                              req.functionCode(), response.exceptionCode());
+        }
+        qCDebug(QT_MODBUS) << "(RTU server) Response PDU:" << response;
+
+        event = QModbusCommEvent::SentEvent; // reset event after processing
+        if (q->value(QModbusServer::ListenOnlyMode).toBool())
+            event |= QModbusCommEvent::SendFlag::CurrentlyInListenOnlyMode;
+
+        if ((!response.isValid())
+            || q->processesBroadcast()
+            || q->value(QModbusServer::ListenOnlyMode).toBool()) {
+            // The quantity of messages addressed to the remote device for which it has
+            // returned no response (neither a normal response nor an exception response),
+            // since its last restart, clear counters operation, or powerup.
+            incrementCounter(QModbusServerPrivate::Counter::ServerNoResponse);
+            storeModbusCommEvent(event);
+            return;
+        }
+
+        const QByteArray result = m_framer.encode(q->serverAddress(), 0, response);
+
+        qCDebug(QT_MODBUS_LOW) << "(RTU server) Response ADU:" << result.toHex();
+
+        if (!m_transport->isOpen()) {
+            qCDebug(QT_MODBUS) << "(RTU server) Requesting serial port has closed.";
+            q->setError(QModbusRtuSerialSlave::tr("Requesting serial port is closed"),
+                        QModbusDevice::WriteError);
+            incrementCounter(QModbusServerPrivate::Counter::ServerNoResponse);
+            storeModbusCommEvent(event);
+            return;
+        }
+
+        recordAdu(result, true);
+        const qint64 writtenBytes = m_transport->write(result);
+        if ((writtenBytes == -1) || (writtenBytes < result.size())) {
+            qCDebug(QT_MODBUS) << "(RTU server) Cannot write requested response to serial port.";
+            q->setError(QModbusRtuSerialSlave::tr("Could not write response to client"),
+                        QModbusDevice::WriteError);
+            incrementCounter(QModbusServerPrivate::Counter::ServerNoResponse);
+            storeModbusCommEvent(event);
+            m_serialPort->clear(QSerialPort::Output);
+            return;
+        }
+
+        if (response.isException()) {
+            switch (response.exceptionCode()) {
+            case QModbusExceptionResponse::IllegalFunction:
+            case QModbusExceptionResponse::IllegalDataAddress:
+            case QModbusExceptionResponse::IllegalDataValue:
+                event |= QModbusCommEvent::SendFlag::ReadExceptionSent;
+                break;
+
+            case QModbusExceptionResponse::ServerDeviceFailure:
+                event |= QModbusCommEvent::SendFlag::ServerAbortExceptionSent;
+                break;
+
+            case QModbusExceptionResponse::ServerDeviceBusy:
+                // The quantity of messages addressed to the remote device for which it
+                // returned a server device busy exception response, since its last restart,
+                // clear counters operation, or powerup.
+                incrementCounter(QModbusServerPrivate::Counter::ServerBusy);
+                event |= QModbusCommEvent::SendFlag::ServerBusyExceptionSent;
+                break;
+
+            case  QModbusExceptionResponse::NegativeAcknowledge:
+                // The quantity of messages addressed to the remote device for which it
+                // returned a negative acknowledge (NAK) exception response, since its last
+                // restart, clear counters operation, or powerup.
+                incrementCounter(QModbusServerPrivate::Counter::ServerNAK);
+                event |= QModbusCommEvent::SendFlag::ServerProgramNAKExceptionSent;
+                break;
+
+            default:
+                break;
+            }
+            // The quantity of Modbus exception responses returned by the remote device since
+            // its last restart, clear counters operation, or powerup.
+            incrementCounter(QModbusServerPrivate::Counter::BusExceptionError);
+        } else {
+            switch (quint16(req.functionCode())) {
+            case 0x0a: // Poll 484 (not in the official Modbus specification) *1
+            case 0x0e: // Poll Controller (not in the official Modbus specification) *1
+            case QModbusRequest::GetCommEventCounter: // fall through and bail out
+                break;
+            default:
+                // The device's event counter is incremented once for each successful message
+                // completion. Do not increment for exception responses, poll commands, or fetch
+                // event counter commands.            *1 but mentioned here ^^^
+                incrementCounter(QModbusServerPrivate::Counter::CommEvent);
+                break;
+            }
+        }
+        storeModbusCommEvent(event); // store the final event after processing
+    }
+
     void setupEnvironment() {
         if (m_serialPort) {
             m_serialPort->setPortName(m_comPort);
@@ -330,12 +332,13 @@ public:
             m_serialPort->setStopBits(m_stopBits);
         }
 
-        m_requestBuffer.clear();
+        m_transport->receiveBuffer()->clear();
     }
 
-    QByteArray m_requestBuffer;;
     bool m_processesBroadcast = false;
     QSerialPort *m_serialPort = nullptr;
+    QModbusTransport *m_transport = nullptr;
+    QModbusRtuFramer m_framer { QModbusFramer::ServerRole };
 };
 
 QT_END_NAMESPACE
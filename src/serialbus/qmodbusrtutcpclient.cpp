@@ -0,0 +1,95 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qmodbusrtutcpclient.h"
+#include "qmodbusrtutcpclient_p.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QModbusRtuTcpClient
+    \inmodule QtSerialBus
+    \since 5.7
+
+    \brief The QModbusRtuTcpClient class is the interface class for a Modbus
+    client that exchanges RTU framed messages over TCP.
+
+    Serial device servers often forward the raw frames of a Modbus RTU line
+    over a TCP connection instead of translating them to Modbus TCP.
+    QModbusRtuTcpClient talks to such device servers directly: requests are
+    sent as RTU ADUs with server address and CRC, and responses are separated
+    by their length as derived from the function code, not by the silent
+    interval used on a serial line. After a frame with a wrong CRC, the
+    client skips one byte at a time until a valid frame starts.
+
+    As RTU frames carry no transaction identifier, responses are matched by
+    server address and function code. Requests to different server addresses
+    are pipelined, while requests to the same server address are sent one
+    after the other.
+
+    The network address and port are set with the same connection parameters
+    as for QModbusTcpClient.
+
+    \sa QModbusRtuTcpServer
+*/
+
+/*!
+    Constructs a QModbusRtuTcpClient with the specified \a parent.
+*/
+QModbusRtuTcpClient::QModbusRtuTcpClient(QObject *parent)
+    : QModbusTcpClient(*new QModbusRtuTcpClientPrivate, parent)
+{
+}
+
+/*!
+    Destroys the QModbusRtuTcpClient instance.
+*/
+QModbusRtuTcpClient::~QModbusRtuTcpClient()
+{
+}
+
+/*!
+    \internal
+*/
+QModbusRtuTcpClient::QModbusRtuTcpClient(QModbusRtuTcpClientPrivate &dd, QObject *parent)
+    : QModbusTcpClient(dd, parent)
+{
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qmodbusrtutcpclient.cpp"
@@ -0,0 +1,274 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QMODBUSRTUTCPCLIENT_P_H
+#define QMODBUSRTUTCPCLIENT_P_H
+
+#include <QtCore/qqueue.h>
+#include <QtSerialBus/qmodbusrtutcpclient.h>
+
+#include <private/qmodbustcpclient_p.h>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+class QModbusRtuTcpClientPrivate : public QModbusTcpClientPrivate
+{
+    Q_DECLARE_PUBLIC(QModbusRtuTcpClient)
+
+public:
+    /*
+        RTU frames carry no transaction id, a response can only be matched by
+        its server address and function code. Therefore at most one request per
+        server address is in flight, kept in m_transactionStore under the server
+        address. Requests to other servers behind the same device server are
+        sent right away, further requests to a busy server wait in m_queue.
+        A request whose reply got deleted stays in flight until its response or
+        timeout, so that a late response cannot be taken for the next request.
+    */
+    QModbusReply *enqueueRequest(const QModbusRequest &request, int serverAddress,
+                                 const QModbusDataUnit &unit,
+                                 QModbusReply::ReplyType type) override
+    {
+        Q_Q(QModbusRtuTcpClient);
+
+        const bool busy = isBusy(serverAddress);
+        const QByteArray adu = m_rtuFramer.encode(serverAddress, 0, request);
+        if (!busy && !writeAdu(adu, serverAddress, request))
+            return nullptr;
+
+        auto reply = new QModbusReply(type, serverAddress, q);
+        QueueElement element(reply, request, unit, m_numberOfRetries, m_responseTimeoutDuration);
+        element.adu = adu;
+
+        q->connect(q, &QModbusClient::timeoutChanged, element.timer.data(), &QTimer::setInterval);
+        QObject::connect(element.timer.data(), &QTimer::timeout, q, [this, serverAddress]() {
+            processTimeout(serverAddress);
+        });
+
+        if (busy) {
+            qCDebug(QT_MODBUS) << "(RTU TCP client) Server" << serverAddress << "busy, queue"
+                               << request;
+            m_queue.enqueue(element);
+        } else {
+            m_transactionStore.insert(serverAddress, element);
+            element.timer->start();
+        }
+        return reply;
+    }
+
+    bool isBusy(int serverAddress) const
+    {
+        if (m_transactionStore.contains(serverAddress))
+            return true;
+        foreach (const QueueElement &element, m_queue) {
+            if (!element.reply.isNull() && element.reply->serverAddress() == serverAddress)
+                return true;
+        }
+        return false;
+    }
+
+    bool writeAdu(const QByteArray &adu, int serverAddress, const QModbusRequest &request)
+    {
+        const qint64 writtenBytes = m_transport->write(adu);
+        if (writtenBytes == -1 || writtenBytes < adu.size()) {
+            Q_Q(QModbusRtuTcpClient);
+            qCDebug(QT_MODBUS) << "(RTU TCP client) Cannot write request to socket.";
+            q->setError(QModbusClient::tr("Could not write request to socket."),
+                        QModbusDevice::WriteError);
+            return false;
+        }
+        Q_SERIALBUS_TRACE(ModbusRequestSent, serverAddress, request.functionCode(), 0);
+        recordAdu(adu, true);
+        qCDebug(QT_MODBUS_LOW) << "(RTU TCP client) Sent RTU ADU:" << adu.toHex();
+        qCDebug(QT_MODBUS) << "(RTU TCP client) Sent RTU PDU:" << request << "to server"
+                           << serverAddress;
+        return true;
+    }
+
+    void sendNext(int serverAddress)
+    {
+        // a finished or failed reply might have been used to send the next request already
+        if (m_transactionStore.contains(serverAddress))
+            return;
+
+        for (auto it = m_queue.begin(); it != m_queue.end();) {
+            if (it->reply.isNull()) {
+                it = m_queue.erase(it);
+                continue;
+            }
+            if (it->reply->serverAddress() != serverAddress) {
+                ++it;
+                continue;
+            }
+
+            const QueueElement element = *it;
+            it = m_queue.erase(it);
+            if (writeAdu(element.adu, serverAddress, element.requestPdu)) {
+                m_transactionStore.insert(serverAddress, element);
+                element.timer->start();
+                return;
+            }
+            element.reply->setError(QModbusDevice::WriteError,
+                                    QModbusClient::tr("Could not write request to socket."));
+        }
+    }
+
+    void processTimeout(int serverAddress)
+    {
+        if (!m_transactionStore.contains(serverAddress))
+            return;
+
+        QueueElement elem = m_transactionStore.take(serverAddress);
+        if (!elem.reply.isNull()) {
+            if (elem.numberOfRetries > 0) {
+                elem.numberOfRetries--;
+                Q_SERIALBUS_TRACE(ModbusRetry, serverAddress, elem.requestPdu.functionCode(),
+                                  elem.numberOfRetries);
+                recordEvent(QSerialBusFlightRecorderPrivate::ModbusRetry, serverAddress,
+                            elem.requestPdu.functionCode());
+                if (writeAdu(elem.adu, serverAddress, elem.requestPdu)) {
+                    qCDebug(QT_MODBUS) << "(RTU TCP client) Resend request to server"
+                                       << serverAddress;
+                    m_transactionStore.insert(serverAddress, elem);
+                    elem.timer->start();
+                    return;
+                }
+                elem.reply->setError(QModbusDevice::WriteError,
+                                     QModbusClient::tr("Could not write request to socket."));
+            } else {
+                qCDebug(QT_MODBUS) << "(RTU TCP client) Timeout of request to server"
+                                   << serverAddress;
+                Q_SERIALBUS_TRACE(ModbusTimeout, serverAddress, elem.requestPdu.functionCode(),
+                                  0);
+                recordEvent(QSerialBusFlightRecorderPrivate::ModbusTimeout, serverAddress,
+                            elem.requestPdu.functionCode());
+                elem.reply->setError(QModbusDevice::TimeoutError,
+                                     QModbusClient::tr("Request timeout."));
+            }
+        }
+        sendNext(serverAddress);
+    }
+
+    void processReceivedData() override
+    {
+        QModbusReceiveBuffer *buffer = m_transport->receiveBuffer();
+        qCDebug(QT_MODBUS_LOW) << "(RTU TCP client) Response buffer:"
+                               << QByteArray::fromRawData(buffer->data(), buffer->size()).toHex();
+
+        bool resynchronizing = false;
+        while (!buffer->isEmpty()) {
+            QModbusFrame frame;
+            int aduSize = 0;
+            const QModbusFramer::Result result = m_rtuFramer.decode(buffer->data(),
+                                                                    buffer->size(), &frame,
+                                                                    &aduSize);
+            if (result == QModbusFramer::Incomplete) {
+                qCDebug(QT_MODBUS_LOW) << "(RTU TCP client) Modbus ADU not complete";
+                return;
+            }
+
+            recordAdu(QByteArray::fromRawData(buffer->data(), aduSize), false);
+            buffer->consume(aduSize);
+
+            if (result != QModbusFramer::Complete) {
+                // the framer skips a single byte, warn once per lost frame boundary
+                if (!resynchronizing)
+                    qCWarning(QT_MODBUS) << "(RTU TCP client) Discarding invalid response.";
+                resynchronizing = true;
+                continue;
+            }
+            resynchronizing = false;
+
+            const QModbusResponse response = frame.response();
+            qCDebug(QT_MODBUS) << "(RTU TCP client) Received PDU:" << response.functionCode()
+                               << response.data().toHex() << "from server"
+                               << frame.serverAddress;
+
+            if (!m_transactionStore.contains(frame.serverAddress)) {
+                qCDebug(QT_MODBUS) << "(RTU TCP client) No pending request for response from "
+                    "given server address, ignoring response message.";
+                continue;
+            }
+
+            const QueueElement element = m_transactionStore.value(frame.serverAddress);
+            if (element.requestPdu.functionCode() != response.functionCode()) {
+                qCWarning(QT_MODBUS) << "(RTU TCP client) Cannot match response with open "
+                    "request, ignoring";
+                continue;
+            }
+
+            m_transactionStore.remove(frame.serverAddress);
+            element.timer->stop();
+            Q_SERIALBUS_TRACE(ModbusResponseReceived, frame.serverAddress,
+                              response.functionCode(), 0);
+            if (!element.reply.isNull())
+                processQueueElement(response, element);
+            sendNext(frame.serverAddress);
+        }
+    }
+
+    void cleanupTransactionStore() override
+    {
+        QModbusTcpClientPrivate::cleanupTransactionStore();
+        while (!m_queue.isEmpty()) {
+            const QueueElement elem = m_queue.dequeue();
+            if (elem.reply.isNull())
+                continue;
+            elem.reply->setError(QModbusDevice::ReplyAbortedError,
+                                 QModbusClient::tr("Reply aborted due to connection closure."));
+        }
+    }
+
+    QModbusRtuFramer m_rtuFramer { QModbusFramer::ClientRole,
+                                   QModbusRtuFramer::SkipByte };
+    QQueue<QueueElement> m_queue;
+};
+
+QT_END_NAMESPACE
+
+#endif // QMODBUSRTUTCPCLIENT_P_H
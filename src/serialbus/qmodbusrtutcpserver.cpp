@@ -0,0 +1,130 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qmodbusrtutcpserver.h"
+#include "qmodbusrtutcpserver_p.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QModbusRtuTcpServer
+    \inmodule QtSerialBus
+    \since 5.7
+
+    \brief The QModbusRtuTcpServer class represents a Modbus server that
+    exchanges RTU framed messages with its clients over TCP.
+
+    Serial device servers often forward the raw frames of a Modbus RTU
+    line over a TCP connection instead of translating them to Modbus TCP.
+    QModbusRtuTcpServer accepts such connections: every request is an RTU
+    ADU with server address and CRC, and is answered the same way. Frames
+    are separated by their length as derived from the function code, not by
+    the silent interval used on a serial line. After a frame with a wrong
+    CRC, the server skips one byte at a time until a valid frame starts.
+
+    As on a serial line, a request to server address \c 0 is a broadcast.
+    It is processed, but never answered. Since processesBroadcast() refers
+    to the request currently processed, requests are always processed one
+    after the other in the server's thread, even if a thread pool is set.
+
+    The network address and port are set with the same connection parameters
+    as for QModbusTcpServer.
+
+    \sa QModbusRtuTcpClient
+*/
+
+/*!
+    Constructs a QModbusRtuTcpServer with the specified \a parent. The
+    \l serverAddress preset is \c 1.
+*/
+QModbusRtuTcpServer::QModbusRtuTcpServer(QObject *parent)
+    : QModbusTcpServer(*new QModbusRtuTcpServerPrivate, parent)
+{
+}
+
+/*!
+    Destroys the QModbusRtuTcpServer instance.
+*/
+QModbusRtuTcpServer::~QModbusRtuTcpServer()
+{
+}
+
+/*!
+    \internal
+*/
+QModbusRtuTcpServer::QModbusRtuTcpServer(QModbusRtuTcpServerPrivate &dd, QObject *parent)
+    : QModbusTcpServer(dd, parent)
+{
+}
+
+/*!
+    \reimp
+*/
+bool QModbusRtuTcpServer::processesBroadcast() const
+{
+    return d_func()->m_processesBroadcast;
+}
+
+/*!
+    \reimp
+
+    Processes the Modbus client request specified by \a request and returns a
+    Modbus response.
+
+    Unlike QModbusTcpServer, the serial line only function codes are
+    processed, as the requests originate from a serial line. The Modbus
+    function \l QModbusRequest::EncapsulatedInterfaceTransport with MEI Type
+    13 (0x0D) CANopen General Reference is filtered out, as for
+    QModbusRtuSerialSlave, and answered with a Modbus exception response with
+    the exception code QModbusExceptionResponse::IllegalFunction.
+*/
+QModbusResponse QModbusRtuTcpServer::processRequest(const QModbusPdu &request)
+{
+    if (request.functionCode() == QModbusRequest::EncapsulatedInterfaceTransport) {
+        quint8 meiType;
+        request.decodeData(&meiType);
+        if (meiType == EncapsulatedInterfaceTransport::CanOpenGeneralReference) {
+            return QModbusExceptionResponse(request.functionCode(),
+                QModbusExceptionResponse::IllegalFunction);
+        }
+    }
+    return QModbusServer::processRequest(request);
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qmodbusrtutcpserver.cpp"
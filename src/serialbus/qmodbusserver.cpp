@@ -44,6 +44,7 @@
 
 #include <algorithm>
 #include <bitset>
+#include <cstring>
 
 QT_BEGIN_NAMESPACE
 
@@ -88,6 +89,19 @@ Q_DECLARE_LOGGING_CATEGORY(QT_MODBUS)
     components use the correct types when accessing and setting values.
 */
 
+/*!
+    \enum QModbusServer::DataNotification
+    \since 5.7
+
+    This enum describes how a bulk update with setData() reports changed registers.
+
+    \value NoNotification      No signal is emitted.
+    \value RangeNotification   The \l dataWritten() signal is emitted once for every range
+                               that changed, after all ranges have been written.
+    \value BatchNotification   The \l dataBatchWritten() signal is emitted once with all
+                               ranges that changed.
+*/
+
 /*!
     Constructs a Modbus server with the specified \a parent.
 */
@@ -451,6 +465,128 @@ bool QModbusServer::setData(const QModbusDataUnit &newData)
     return writeData(newData);
 }
 
+/*
+    Returns \c true if the \a count registers starting at \a address lie
+    within the map entry \a current. The values of a map entry are indexed by
+    register address, so they must reach up to the end of the range as well.
+*/
+static bool isInMapRange(const QModbusDataUnit &current, int address, int count)
+{
+    // check range start is within internal map range
+    const int internalRangeEndAddress = current.startAddress() + current.valueCount() - 1;
+    if (address < current.startAddress() || address > internalRangeEndAddress)
+        return false;
+
+    // check range end is within internal map range
+    const int rangeEndAddress = address + count - 1;
+    if (rangeEndAddress < current.startAddress() || rangeEndAddress > internalRangeEndAddress)
+        return false;
+
+    return rangeEndAddress < current.values().size();
+}
+
+/*!
+    \since 5.7
+
+    Writes all register ranges in \a units to the Modbus server map as one
+    update. Returns \c true on success, or \c false if any of the ranges lies
+    outside of the map range or its registerType() does not exist. All ranges
+    are validated before the first one is written, so a failing call leaves the
+    map untouched.
+
+    Requests from Modbus clients are processed in between calls, so they see
+    either none or all of the new values. Ranges whose registers already hold
+    the given values are skipped. How the changed ranges are reported depends
+    on \a notification; by default, \l dataWritten() is emitted for each of
+    them, like for the other overloads of setData().
+
+    This is considerably cheaper than calling setData() for every range when
+    many disjoint ranges are updated at once, for example once per acquisition
+    cycle.
+
+    \note This function writes to the register map set with setMap() and does
+    not call writeData().
+
+    \sa data(), dataBatchWritten()
+*/
+bool QModbusServer::setData(const QVector<QModbusDataUnit> &units,
+                            DataNotification notification)
+{
+    Q_D(QModbusServer);
+    QWriteLocker locker(&d->m_dataLock);
+
+    for (const QModbusDataUnit &unit : units) {
+        const auto it = d->m_modbusDataUnitMap.constFind(unit.registerType());
+        if (it == d->m_modbusDataUnitMap.constEnd() || !it->isValid())
+            return false;
+
+        const int count = int(unit.valueCount());
+        if (count == 0)
+            continue;
+        if (unit.values().size() < count || !isInMapRange(*it, unit.startAddress(), count))
+            return false;
+    }
+
+    QVector<bool> changed(units.size(), false);
+    bool anyChanged = false;
+    for (auto it = d->m_modbusDataUnitMap.begin(); it != d->m_modbusDataUnitMap.end(); ++it) {
+        QModbusDataUnit &current = it.value();
+        const uint valueCount = current.valueCount();
+        QVector<quint16> store;
+        quint16 *base = nullptr;
+
+        for (int i = 0; i < units.size(); ++i) {
+            const QModbusDataUnit &unit = units.at(i);
+            if (unit.registerType() != it.key() || unit.valueCount() == 0)
+                continue;
+
+            if (!base) {
+                // take the values out of the map, so they are detached at most once
+                store = current.values();
+                current.setValues(QVector<quint16>());
+                base = store.data();
+            }
+
+            const QVector<quint16> values = unit.values();
+            quint16 *target = base + unit.startAddress();
+            const size_t size = size_t(unit.valueCount()) * sizeof(quint16);
+            if (std::memcmp(target, values.constData(), size) == 0)
+                continue;
+
+            std::memcpy(target, values.constData(), size);
+            changed[i] = true;
+            anyChanged = true;
+        }
+
+        if (base) {
+            current.setValues(store);
+            current.setValueCount(valueCount);
+        }
+    }
+
+    locker.unlock();
+
+    if (!anyChanged || notification == NoNotification)
+        return true;
+
+    if (notification == RangeNotification) {
+        for (int i = 0; i < units.size(); ++i) {
+            if (changed.at(i))
+                emit dataWritten(units.at(i).registerType(), units.at(i).startAddress(),
+                                 units.at(i).valueCount());
+        }
+        return true;
+    }
+
+    QVector<QModbusDataUnit> written;
+    for (int i = 0; i < units.size(); ++i) {
+        if (changed.at(i))
+            written.append(units.at(i));
+    }
+    emit dataBatchWritten(written);
+    return true;
+}
+
 /*!
     Writes \a newData to the Modbus server map. Returns \c true on success,
     or \c false if the \a newData range is outside of the map range or the
@@ -466,31 +602,24 @@ bool QModbusServer::setData(const QModbusDataUnit &newData)
 bool QModbusServer::writeData(const QModbusDataUnit &newData)
 {
     Q_D(QModbusServer);
+    QWriteLocker locker(&d->m_dataLock);
     if (!d->m_modbusDataUnitMap.contains(newData.registerType()))
         return false;
 
     QModbusDataUnit &current = d->m_modbusDataUnitMap[newData.registerType()];
-    if (!current.isValid())
-        return false;
-
-    // check range start is within internal map range
-    int internalRangeEndAddress = current.startAddress() + current.valueCount() - 1;
-    if (newData.startAddress() < current.startAddress()
-        || newData.startAddress() > internalRangeEndAddress) {
+    if (!current.isValid()
+        || !isInMapRange(current, newData.startAddress(), int(newData.valueCount()))) {
         return false;
     }
 
-    // check range end is within internal map range
-    int rangeEndAddress = newData.startAddress() + newData.valueCount() - 1;
-    if (rangeEndAddress < current.startAddress() || rangeEndAddress > internalRangeEndAddress)
-        return false;
-
+    const int rangeEndAddress = newData.startAddress() + newData.valueCount() - 1;
     bool changeRequired = false;
     for (int i = newData.startAddress(); i <= rangeEndAddress; i++) {
         quint16 newValue = newData.value(i - newData.startAddress());
         changeRequired |= (current.value(i) != newValue);
         current.setValue(i, newValue);
     }
+    locker.unlock();
 
     if (changeRequired)
         emit dataWritten(newData.registerType(), newData.startAddress(), newData.valueCount());
@@ -511,6 +640,7 @@ bool QModbusServer::writeData(const QModbusDataUnit &newData)
 bool QModbusServer::readData(QModbusDataUnit *newData) const
 {
     Q_D(const QModbusServer);
+    QReadLocker locker(&d->m_dataLock);
 
     if ((!newData) || (!d->m_modbusDataUnitMap.contains(newData->registerType())))
         return false;
@@ -525,16 +655,7 @@ bool QModbusServer::readData(QModbusDataUnit *newData) const
         return true;
     }
 
-    // check range start is within internal map range
-    int internalRangeEndAddress = current.startAddress() + current.valueCount() - 1;
-    if (newData->startAddress() < current.startAddress()
-        || newData->startAddress() > internalRangeEndAddress) {
-        return false;
-    }
-
-    // check range end is within internal map range
-    const int rangeEndAddress = newData->startAddress() + newData->valueCount() - 1;
-    if (rangeEndAddress < current.startAddress() || rangeEndAddress > internalRangeEndAddress)
+    if (!isInMapRange(current, newData->startAddress(), int(newData->valueCount())))
         return false;
 
     newData->setValues(current.values().mid(newData->startAddress(), newData->valueCount()));
@@ -556,6 +677,17 @@ bool QModbusServer::readData(QModbusDataUnit *newData) const
     due to no change in value.
 */
 
+/*!
+    \fn void QModbusServer::dataBatchWritten(const QVector<QModbusDataUnit> &units)
+    \since 5.7
+
+    This signal is emitted once by a bulk setData() call using
+    \l BatchNotification. \a units holds the ranges that were written and
+    changed, in the order they were passed to setData().
+
+    \sa dataWritten()
+*/
+
 /*!
     Processes a Modbus client \a request and returns a Modbus response.
     This function returns a \l QModbusResponse or \l QModbusExceptionResponse depending
@@ -610,6 +742,7 @@ QModbusResponse QModbusServer::processPrivateRequest(const QModbusPdu &request)
 
 bool QModbusServerPrivate::setMap(const QModbusDataUnitMap &map)
 {
+    QWriteLocker locker(&m_dataLock);
     m_modbusDataUnitMap = map;
     return true;
 }
@@ -67,6 +67,13 @@ public:
     };
     Q_ENUM(Option)
 
+    enum DataNotification {
+        NoNotification,
+        RangeNotification,
+        BatchNotification
+    };
+    Q_ENUM(DataNotification)
+
     explicit QModbusServer(QObject *parent = nullptr);
     ~QModbusServer();
 
@@ -85,8 +92,12 @@ public:
     bool setData(QModbusDataUnit::RegisterType table, quint16 address, quint16 data);
     bool data(QModbusDataUnit::RegisterType table, quint16 address, quint16 *data) const;
 
+    bool setData(const QVector<QModbusDataUnit> &units,
+                 DataNotification notification = RangeNotification);
+
 Q_SIGNALS:
     void dataWritten(QModbusDataUnit::RegisterType table, int address, int size);
+    void dataBatchWritten(const QVector<QModbusDataUnit> &units);
 
 protected:
     QModbusServer(QModbusServerPrivate &dd, QObject *parent = nullptr);
@@ -99,6 +110,7 @@ protected:
 };
 
 Q_DECLARE_TYPEINFO(QModbusServer::Option, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(QModbusServer::DataNotification, Q_PRIMITIVE_TYPE);
 
 QT_END_NAMESPACE
 
@@ -37,12 +37,14 @@
 #ifndef QMODBUSERVER_P_H
 #define QMODBUSERVER_P_H
 
+#include <QtCore/qreadwritelock.h>
 #include <QtSerialBus/qmodbusdataunit.h>
 #include <QtSerialBus/qmodbusserver.h>
 
 #include <private/qmodbuscommevent_p.h>
 #include <private/qmodbusdevice_p.h>
 #include <private/qmodbus_symbols_p.h>
+#include <private/qserialbustrace_p.h>
 
 #include <array>
 #include <deque>
@@ -118,6 +120,8 @@ public:
     std::array<quint16, 20> m_counters;
     QHash<int, QVariant> m_serverOptions;
     QModbusDataUnitMap m_modbusDataUnitMap;
+    // guards m_modbusDataUnitMap, requests may be processed on worker threads
+    mutable QReadWriteLock m_dataLock;
     std::deque<quint8> m_commEventLog;
 };
 
@@ -75,7 +75,7 @@ public:
             qCDebug(QT_MODBUS) << "(TCP client) Connected to" << m_socket->peerAddress()
                                << "on port" << m_socket->peerPort();
             Q_Q(QModbusTcpClient);
-            responseBuffer.clear();
+            m_transport->receiveBuffer()->clear();
             q->setState(QModbusDevice::ConnectedState);
         });
 
@@ -100,55 +100,58 @@ public:
                         QModbusDevice::ConnectionError);
         });
 
-        QObject::connect(m_socket, &QIODevice::readyRead, [this](){
-            responseBuffer += m_socket->read(m_socket->bytesAvailable());
-            qCDebug(QT_MODBUS_LOW) << "(TCP client) Response buffer:" << responseBuffer.toHex();
-
-            while (!responseBuffer.isEmpty()) {
-                // can we read enough for Modbus ADU header?
-                if (responseBuffer.size() < mbpaHeaderSize) {
-                    qCDebug(QT_MODBUS_LOW) << "(TCP client) Modbus ADU not complete";
-                    return;
-                }
-
-                quint8 serverAddress;
-                quint16 transactionId, bytesPdu, protocolId;
-                QDataStream input(responseBuffer);
-                input >> transactionId >> protocolId >> bytesPdu >> serverAddress;
+        setTransport(new QModbusIoDeviceTransport(m_socket, q));
+    }
 
-                // stop the timer as soon as we know enough about the transaction
-                const bool knownTransaction = m_transactionStore.contains(transactionId);
-                if (knownTransaction && m_transactionStore[transactionId].timer)
-                    m_transactionStore[transactionId].timer->stop();
+    void processReceivedData() override
+    {
+        QModbusReceiveBuffer *buffer = m_transport->receiveBuffer();
+        qCDebug(QT_MODBUS_LOW) << "(TCP client) Response buffer:"
+                               << QByteArray::fromRawData(buffer->data(), buffer->size()).toHex();
+
+        while (!buffer->isEmpty()) {
+            QModbusFrame frame;
+            int aduSize = 0;
+            const QModbusFramer::Result result = m_framer.decode(buffer->data(), buffer->size(),
+                                                                 &frame, &aduSize);
+
+            // stop the timer as soon as we know enough about the transaction
+            const bool knownTransaction = m_transactionStore.contains(frame.transactionId);
+            if (knownTransaction && result != QModbusFramer::Invalid
+                && buffer->size() >= QModbusTcpFramer::HeaderSize) {
+                if (m_transactionStore[frame.transactionId].timer)
+                    m_transactionStore[frame.transactionId].timer->stop();
+            }
 
-                qCDebug(QT_MODBUS) << "(TCP client) tid:" << hex << transactionId << "size:"
-                    << bytesPdu << "server address:" << serverAddress;
+            if (result == QModbusFramer::Incomplete) {
+                qCDebug(QT_MODBUS_LOW) << "(TCP client) Modbus ADU not complete";
+                return;
+            }
 
-                // The length field is the byte count of the following fields, including the Unit
-                // Identifier and the PDU, so we remove on byte.
-                bytesPdu--;
+            qCDebug(QT_MODBUS) << "(TCP client) tid:" << hex << frame.transactionId << "size:"
+                << aduSize << "server address:" << frame.serverAddress;
 
-                int tcpAduSize = mbpaHeaderSize + bytesPdu;
-                if (responseBuffer.size() < tcpAduSize) {
-                    qCDebug(QT_MODBUS) << "(TCP client) PDU too short. Waiting for more data";
-                    return;
-                }
+            recordAdu(QByteArray::fromRawData(buffer->data(), aduSize), false);
+            buffer->consume(aduSize);
 
-                QModbusResponse responsePdu;
-                input >> responsePdu;
-                qCDebug(QT_MODBUS) << "(TCP client) Received PDU:" << responsePdu.functionCode()
-                                   << responsePdu.data().toHex();
-
-                responseBuffer.remove(0, tcpAduSize);
+            if (result != QModbusFramer::Complete) {
+                qCWarning(QT_MODBUS) << "(TCP client) Discarding invalid ADU.";
+                continue;
+            }
 
-                if (!knownTransaction) {
-                    qCDebug(QT_MODBUS) << "(TCP client) No pending request for response with "
-                        "given transaction ID, ignoring response message.";
-                } else {
-                    processQueueElement(responsePdu, m_transactionStore[transactionId]);
-                }
+            const QModbusResponse responsePdu = frame.response();
+            qCDebug(QT_MODBUS) << "(TCP client) Received PDU:" << responsePdu.functionCode()
+                               << responsePdu.data().toHex();
+
+            if (!knownTransaction) {
+                qCDebug(QT_MODBUS) << "(TCP client) No pending request for response with "
+                    "given transaction ID, ignoring response message.";
+            } else {
+                Q_SERIALBUS_TRACE(ModbusResponseReceived, frame.serverAddress,
+                                  responsePdu.functionCode(), frame.transactionId);
+                processQueueElement(responsePdu, m_transactionStore[frame.transactionId]);
             }
-        });
+        }
     }
 
     QModbusReply *enqueueRequest(const QModbusRequest &request, int serverAddress,
@@ -156,11 +159,9 @@ public:
                                  QModbusReply::ReplyType type) override
     {
         auto writeToSocket = [this](quint16 tId, const QModbusRequest &request, int address) {
-            QByteArray buffer;
-            QDataStream output(&buffer, QIODevice::WriteOnly);
-            output << tId << quint16(0) << quint16(request.size() + 1) << quint8(address) << request;
+            const QByteArray buffer = m_framer.encode(address, tId, request);
 
-            int writtenBytes = m_socket->write(buffer);
+            const qint64 writtenBytes = m_transport->write(buffer);
             if (writtenBytes == -1 || writtenBytes < buffer.size()) {
                 Q_Q(QModbusTcpClient);
                 qCDebug(QT_MODBUS) << "(TCP client) Cannot write request to socket.";
@@ -168,6 +169,8 @@ public:
                             QModbusDevice::WriteError);
                 return false;
             }
+            Q_SERIALBUS_TRACE(ModbusRequestSent, address, request.functionCode(), tId);
+            recordAdu(buffer, true);
             qCDebug(QT_MODBUS_LOW) << "(TCP client) Sent TCP ADU:" << buffer.toHex();
             qCDebug(QT_MODBUS) << "(TCP client) Sent TCP PDU:" << request << "with tId:" << hex
                 << tId;
@@ -204,6 +207,10 @@ public:
 
                 if (elem.numberOfRetries > 0) {
                     elem.numberOfRetries--;
+                    Q_SERIALBUS_TRACE(ModbusRetry, elem.reply->serverAddress(),
+                                      elem.requestPdu.functionCode(), elem.numberOfRetries);
+                    recordEvent(QSerialBusFlightRecorderPrivate::ModbusRetry,
+                                elem.reply->serverAddress(), elem.requestPdu.functionCode());
                     if (!writeToSocket(tId, elem.requestPdu, elem.reply->serverAddress()))
                         return;
                     m_transactionStore.insert(tId, elem);
@@ -211,6 +218,10 @@ public:
                     qCDebug(QT_MODBUS) << "(TCP client) Resend request with tId:" << hex << tId;
                 } else {
                     qCDebug(QT_MODBUS) << "(TCP client) Timeout of request with tId:" << hex << tId;
+                    Q_SERIALBUS_TRACE(ModbusTimeout, elem.reply->serverAddress(),
+                                      elem.requestPdu.functionCode(), tId);
+                    recordEvent(QSerialBusFlightRecorderPrivate::ModbusTimeout,
+                                elem.reply->serverAddress(), elem.requestPdu.functionCode());
                     elem.reply->setError(QModbusDevice::TimeoutError,
                         QModbusClient::tr("Request timeout."));
                 }
@@ -225,15 +236,7 @@ public:
         return reply;
     }
 
-    // TODO: Review once we have a transport layer in place.
-    bool isOpen() const override
-    {
-        if (m_socket)
-            return m_socket->isOpen();
-        return false;
-    }
-
-    void cleanupTransactionStore()
+    virtual void cleanupTransactionStore()
     {
         if (m_transactionStore.isEmpty())
             return;
@@ -255,9 +258,8 @@ public:
     inline int transactionId() const { return m_transactionId; }
 
     QTcpSocket *m_socket = nullptr;
-    QByteArray responseBuffer;
+    QModbusTcpFramer m_framer { QModbusFramer::ClientRole };
     QHash<quint16, QueueElement> m_transactionStore;
-    int mbpaHeaderSize = 7;
 
 private:   // Private to avoid using the wrong id inside the timer lambda,
     quint16 m_transactionId = 0; // capturing 'this' will not copy the id.
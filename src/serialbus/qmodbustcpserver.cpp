@@ -55,6 +55,30 @@ QT_BEGIN_NAMESPACE
 
     Modbus TCP networks can have multiple servers. Servers are read/written by
     a client device represented by \l QModbusTcpClient.
+
+    By default, the requests of all connections are processed one after the
+    other in the server's thread. When a thread pool is set with
+    setThreadPool(), requests that access the registers are processed
+    concurrently on the pool's threads instead, including requests that a
+    client pipelines on one connection. Responses are written in the order
+    given by responseOrder().
+*/
+
+/*!
+    \enum QModbusTcpServer::ResponseOrder
+    \since 5.7
+
+    This enum describes the order in which responses to the requests of one
+    connection are written when requests are processed concurrently.
+
+    \value RequestOrder     Responses are written in the order the requests were
+                            received, as done by a server processing one request
+                            at a time. This is the default.
+    \value CompletionOrder  Responses are written as soon as their request has
+                            been processed. Clients match them by the MBAP
+                            transaction identifier.
+
+    \sa setResponseOrder(), setThreadPool()
 */
 
 /*!
@@ -75,6 +99,7 @@ QModbusTcpServer::QModbusTcpServer(QObject *parent)
 QModbusTcpServer::~QModbusTcpServer()
 {
     close();
+    d_func()->waitForPooledRequests();
 }
 
 /*!
@@ -87,6 +112,87 @@ QModbusTcpServer::QModbusTcpServer(QModbusTcpServerPrivate &dd, QObject *parent)
     d->setupTcpServer();
 }
 
+/*!
+    \since 5.7
+
+    Returns the thread pool used to process requests, or \c nullptr if the
+    requests are processed in the server's thread.
+
+    \sa setThreadPool()
+*/
+QThreadPool *QModbusTcpServer::threadPool() const
+{
+    return d_func()->m_threadPool;
+}
+
+/*!
+    \since 5.7
+
+    Sets the thread pool used to process requests to \a pool. The pool is not
+    owned by the server. Passing \c nullptr processes all requests in the
+    server's thread again, which is the default.
+
+    With a thread pool, requests that read or write coils, discrete inputs
+    or registers are processed on the pool's threads, up to 16 of every
+    connection at the same time. The server keeps reading further requests
+    from a connection while earlier ones are still being processed. All
+    other requests are processed in the server's thread, so server options
+    set with setValue(), the diagnostic counters and the event log are never
+    accessed concurrently.
+
+    For the pooled requests, processRequest(), readData() and writeData()
+    are called from the pool's threads. The default register store of
+    QModbusServer is safe to use that way; sub-classes that reimplement one
+    of these functions must make it thread-safe before setting a thread
+    pool. Requests that access the store more than once, such as
+    \l QModbusRequest::MaskWriteRegister, are not interleaved with any other
+    pooled request.
+
+    close() and disconnectDevice() wait for the requests still being
+    processed. A sub-class that reimplements one of the functions above
+    must disconnect the server in its own destructor.
+
+    The dataWritten() signal is emitted from the thread processing the
+    request.
+
+    \note QModbusRtuTcpServer always processes requests in its own thread.
+
+    \sa threadPool(), setResponseOrder()
+*/
+void QModbusTcpServer::setThreadPool(QThreadPool *pool)
+{
+    Q_D(QModbusTcpServer);
+    if (pool)
+        qRegisterMetaType<QModbusDataUnit::RegisterType>();
+    d->m_threadPool = pool;
+}
+
+/*!
+    \since 5.7
+
+    Returns the order in which responses are written.
+
+    \sa setResponseOrder()
+*/
+QModbusTcpServer::ResponseOrder QModbusTcpServer::responseOrder() const
+{
+    return d_func()->m_responseOrder;
+}
+
+/*!
+    \since 5.7
+
+    Sets the order in which the responses to the requests of a connection
+    are written to \a order. The order only matters when a thread pool is
+    set, since otherwise requests are processed one after the other.
+
+    \sa responseOrder(), setThreadPool()
+*/
+void QModbusTcpServer::setResponseOrder(ResponseOrder order)
+{
+    d_func()->m_responseOrder = order;
+}
+
 /*!
     \reimp
 */
@@ -134,6 +240,11 @@ void QModbusTcpServer::close()
     foreach (auto socket, d->connections)
         socket->disconnectFromHost();
 
+    // Nothing may call processRequest() once the server is closed, so that a
+    // sub-class can safely tear down its state after disconnecting.
+    d->waitForPooledRequests();
+    d->m_connections.clear();
+
     setState(QModbusDevice::UnconnectedState);
 }
 
@@ -171,4 +282,6 @@ QModbusResponse QModbusTcpServer::processRequest(const QModbusPdu &request)
     return QModbusServer::processRequest(request);
 }
 
+#include "moc_qmodbustcpserver.cpp"
+
 QT_END_NAMESPACE
@@ -43,6 +43,7 @@
 QT_BEGIN_NAMESPACE
 
 class QModbusTcpServerPrivate;
+class QThreadPool;
 
 class Q_SERIALBUS_EXPORT QModbusTcpServer : public QModbusServer
 {
@@ -50,9 +51,21 @@ class Q_SERIALBUS_EXPORT QModbusTcpServer : public QModbusServer
     Q_DECLARE_PRIVATE(QModbusTcpServer)
 
 public:
+    enum ResponseOrder {
+        RequestOrder,
+        CompletionOrder
+    };
+    Q_ENUM(ResponseOrder)
+
     explicit QModbusTcpServer(QObject *parent = nullptr);
     ~QModbusTcpServer();
 
+    QThreadPool *threadPool() const;
+    void setThreadPool(QThreadPool *pool);
+
+    ResponseOrder responseOrder() const;
+    void setResponseOrder(ResponseOrder order);
+
 protected:
     QModbusTcpServer(QModbusTcpServerPrivate &dd, QObject *parent = nullptr);
 
@@ -60,6 +73,9 @@ protected:
     void close() override;
 
     QModbusResponse processRequest(const QModbusPdu &request) override;
+
+private:
+    Q_PRIVATE_SLOT(d_func(), void _q_requestsProcessed())
 };
 
 QT_END_NAMESPACE
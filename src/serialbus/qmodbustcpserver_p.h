@@ -37,16 +37,28 @@
 #ifndef QMODBUSTCPSERVER_P_H
 #define QMODBUSTCPSERVER_P_H
 
-#include <QtCore/qdatastream.h>
+#include <QtCore/qatomic.h>
 #include <QtCore/qdebug.h>
+#include <QtCore/qhash.h>
 #include <QtCore/qloggingcategory.h>
+#include <QtCore/qmap.h>
+#include <QtCore/qmutex.h>
 #include <QtCore/qobject.h>
+#include <QtCore/qpointer.h>
+#include <QtCore/qreadwritelock.h>
+#include <QtCore/qrunnable.h>
+#include <QtCore/qscopedpointer.h>
+#include <QtCore/qsharedpointer.h>
+#include <QtCore/qthreadpool.h>
+#include <QtCore/qwaitcondition.h>
 #include <QtNetwork/qhostaddress.h>
 #include <QtNetwork/qtcpserver.h>
 #include <QtNetwork/qtcpsocket.h>
 #include <QtSerialBus/qmodbustcpserver.h>
 
 #include <private/qmodbusserver_p.h>
+#include <private/qmodbustransport_p.h>
+#include <private/qmpscqueue_p.h>
 
 //
 //  W A R N I N G
@@ -76,7 +88,7 @@ public:
     QModbusResponse forwardProcessRequest(const QModbusRequest &r)
     {
         Q_Q(QModbusTcpServer);
-        if (q->value(QModbusServer::DeviceBusy).value<quint16>() == 0xffff) {
+        if (isDeviceBusy()) {
             // If the device is busy, send an exception response without processing.
             incrementCounter(QModbusServerPrivate::Counter::ServerBusy);
             return QModbusExceptionResponse(r.functionCode(),
@@ -111,6 +123,295 @@ public:
         return false;
     }
 
+    /*
+        A request that was handed to the thread pool. The response is written
+        by the worker thread and collected in the server's thread.
+    */
+    struct ProcessedRequest
+    {
+        quint64 connection = 0;
+        quint64 sequence = 0;
+        quint8 unitId = 0;
+        quint16 transactionId = 0;
+        QModbusRequest request;
+        QModbusResponse response;
+    };
+
+    struct Connection
+    {
+        QModbusTransport *transport = nullptr;
+        quint64 nextSequence = 0;
+        quint64 nextResponse = 0;
+        int pending = 0;
+        QMap<quint64, QByteArray> reorderBuffer;
+        QModbusFrame frame; // decoded into again and again, keeps its storage
+    };
+
+    class Task : public QRunnable
+    {
+    public:
+        Task(QModbusTcpServerPrivate *d, ProcessedRequest &&request)
+            : m_d(d)
+            , m_request(std::move(request))
+        {}
+
+        void run() override
+        {
+            if (!m_d->m_shuttingDown.load())
+                m_request.response = m_d->processPooledRequest(m_request);
+            m_d->finishPooledRequest(std::move(m_request));
+        }
+
+    private:
+        QModbusTcpServerPrivate *m_d;
+        ProcessedRequest m_request;
+    };
+
+    // Upper limit of requests per connection handed to the pool at once.
+    enum { MaximumPendingRequests = 16 };
+
+    bool isDeviceBusy() const
+    {
+        Q_Q(const QModbusTcpServer);
+        return q->value(QModbusServer::DeviceBusy).value<quint16>() == 0xffff;
+    }
+
+    /*
+        Requests that access nothing but the register store, which is guarded
+        by QModbusServer. Server options, counters and the event log are only
+        touched by the other requests, which stay in the server's thread.
+    */
+    static bool isPooledRequest(QModbusPdu::FunctionCode code)
+    {
+        switch (code) {
+        case QModbusRequest::ReadCoils:
+        case QModbusRequest::ReadDiscreteInputs:
+        case QModbusRequest::ReadHoldingRegisters:
+        case QModbusRequest::ReadInputRegisters:
+        case QModbusRequest::WriteSingleCoil:
+        case QModbusRequest::WriteSingleRegister:
+        case QModbusRequest::WriteMultipleCoils:
+        case QModbusRequest::WriteMultipleRegisters:
+        case QModbusRequest::MaskWriteRegister:
+        case QModbusRequest::ReadWriteMultipleRegisters:
+        case QModbusRequest::ReadFifoQueue:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Requests that access the register store more than once.
+    static bool isExclusiveRequest(QModbusPdu::FunctionCode code)
+    {
+        return code == QModbusRequest::MaskWriteRegister
+            || code == QModbusRequest::ReadWriteMultipleRegisters
+            || code == QModbusRequest::ReadFifoQueue;
+    }
+
+    // Called from worker threads.
+    QModbusResponse processPooledRequest(const ProcessedRequest &request)
+    {
+        Q_Q(QModbusTcpServer);
+        const QModbusPdu::FunctionCode code = request.request.functionCode();
+
+        // Every single access is guarded by QModbusServer, but a read-modify-write
+        // must not interleave with any other request processed in the pool.
+        if (isExclusiveRequest(code))
+            m_requestLock.lockForWrite();
+        else
+            m_requestLock.lockForRead();
+
+        Q_SERIALBUS_TRACE(ModbusServerRequestStarted, request.unitId, code, 0);
+        const QModbusResponse response = q->processRequest(request.request);
+        Q_SERIALBUS_TRACE(ModbusServerRequestFinished, request.unitId, code,
+                          response.exceptionCode());
+
+        m_requestLock.unlock();
+        return response;
+    }
+
+    // Called from worker threads.
+    void finishPooledRequest(ProcessedRequest &&request)
+    {
+        if (m_processedRequests.enqueue(std::move(request)))
+            QMetaObject::invokeMethod(q_func(), "_q_requestsProcessed", Qt::QueuedConnection);
+
+        // last, the server may be destroyed as soon as the count drops to zero
+        QMutexLocker locker(&m_poolMutex);
+        if (--m_pooledRequests == 0)
+            m_poolIdle.wakeAll();
+    }
+
+    // Requests that have not been started yet are dropped unprocessed.
+    void waitForPooledRequests()
+    {
+        m_shuttingDown.store(1);
+        QMutexLocker locker(&m_poolMutex);
+        while (m_pooledRequests > 0)
+            m_poolIdle.wait(&m_poolMutex);
+        m_shuttingDown.store(0);
+    }
+
+    bool usesThreadPool() const
+    {
+        // processesBroadcast() describes the current request, so broadcasts need serial processing
+        return m_threadPool && !m_broadcastSupported;
+    }
+
+    void _q_requestsProcessed()
+    {
+        Q_Q(QModbusTcpServer);
+
+        // Bound the batch, so that busy connections cannot starve the event loop.
+        enum { MaximumBatchSize = 64 };
+
+        QVector<quint64> resume;
+        m_processedRequests.beginDrain();
+        const int processed = m_processedRequests.drain([this, &resume](ProcessedRequest request) {
+            const QSharedPointer<Connection> connection = m_connections.value(request.connection);
+            if (!connection)
+                return; // the connection was closed in the meantime
+
+            qCDebug(QT_MODBUS) << "(TCP server) Response PDU:" << request.response;
+            --connection->pending;
+            deliverResponse(*connection, request.sequence, m_framer->encode(request.unitId,
+                request.transactionId, request.response));
+            if (!resume.contains(request.connection))
+                resume.append(request.connection);
+        }, MaximumBatchSize);
+
+        // continue with requests that were held back by the pending limit
+        foreach (quint64 id, resume)
+            processReceivedData(id);
+
+        if (processed == MaximumBatchSize && m_processedRequests.claimWakeUp())
+            QMetaObject::invokeMethod(q, "_q_requestsProcessed", Qt::QueuedConnection);
+    }
+
+    /*
+        Writes the response with the given sequence number, or keeps it back
+        until all earlier responses of the connection have been written. An
+        empty ADU marks a request that is not answered.
+    */
+    void deliverResponse(Connection &connection, quint64 sequence, const QByteArray &adu)
+    {
+        if (m_responseOrder == QModbusTcpServer::CompletionOrder && !adu.isEmpty()) {
+            writeResponse(connection.transport, adu);
+            connection.reorderBuffer.insert(sequence, QByteArray());
+        } else {
+            connection.reorderBuffer.insert(sequence, adu);
+        }
+
+        while (!connection.reorderBuffer.isEmpty()
+            && connection.reorderBuffer.firstKey() == connection.nextResponse) {
+            const QByteArray next = connection.reorderBuffer.take(connection.nextResponse++);
+            if (!next.isEmpty())
+                writeResponse(connection.transport, next);
+        }
+    }
+
+    bool writeResponse(QModbusTransport *transport, const QByteArray &adu)
+    {
+        if (!transport->isOpen()) {
+            qCDebug(QT_MODBUS) << "(TCP server) Requesting socket has closed.";
+            forwardError(QModbusTcpServer::tr("Requesting socket is closed"),
+                         QModbusDevice::WriteError);
+            return false;
+        }
+
+        recordAdu(adu, true);
+        const qint64 writtenBytes = transport->write(adu);
+        if (writtenBytes == -1 || writtenBytes < adu.size()) {
+            qCDebug(QT_MODBUS) << "(TCP server) Cannot write requested response to socket.";
+            forwardError(QModbusTcpServer::tr("Could not write response to client"),
+                         QModbusDevice::WriteError);
+            return false;
+        }
+        return true;
+    }
+
+    void processReceivedData(quint64 id)
+    {
+        // Keep the connection alive, processing may end up closing it.
+        const QSharedPointer<Connection> keepAlive = m_connections.value(id);
+        if (!keepAlive)
+            return;
+
+        Connection &connection = *keepAlive;
+        QModbusTransport *transport = connection.transport;
+        QModbusReceiveBuffer *buffer = transport->receiveBuffer();
+        while (!buffer->isEmpty()) {
+            // Requests still processed in the pool hold back any further
+            // request, so that the response order is kept.
+            if (connection.pending >= (usesThreadPool() ? int(MaximumPendingRequests) : 1))
+                return;
+
+            qCDebug(QT_MODBUS_LOW).noquote() << "(TCP server) Read buffer: 0x"
+                + QByteArray::fromRawData(buffer->data(), buffer->size()).toHex();
+
+            QModbusFrame &frame = connection.frame;
+            int aduSize = 0;
+            const QModbusFramer::Result result = m_framer->decode(buffer->data(), buffer->size(),
+                                                                  &frame, &aduSize);
+            if (result == QModbusFramer::Incomplete) {
+                qCDebug(QT_MODBUS) << "(TCP server) ADU too short. Waiting for more data.";
+                return;
+            }
+
+            qCDebug(QT_MODBUS_LOW) << "(TCP server) Request MBPA:" << "Transaction Id:"
+                << hex << frame.transactionId << "ADU bytes:" << aduSize << "Unit Id:"
+                << frame.serverAddress;
+
+            recordAdu(QByteArray::fromRawData(buffer->data(), aduSize), false);
+            buffer->consume(aduSize);
+
+            if (result != QModbusFramer::Complete) {
+                qCWarning(QT_MODBUS) << "(TCP server) Discarding invalid ADU.";
+                continue;
+            }
+
+            const quint8 unitId = quint8(frame.serverAddress);
+            // Only serial line framing knows broadcasts, MBAP unit id 0 is a regular address.
+            m_processesBroadcast = m_broadcastSupported && unitId == 0;
+            if (!m_processesBroadcast && !matchingServerAddress(unitId))
+                continue;
+
+            const QModbusRequest request = frame.request();
+            qCDebug(QT_MODBUS) << "(TCP server) Request PDU:" << request;
+
+            const quint64 sequence = connection.nextSequence++;
+            if (usesThreadPool() && isPooledRequest(request.functionCode()) && !isDeviceBusy()) {
+                ProcessedRequest pooled;
+                pooled.connection = id;
+                pooled.sequence = sequence;
+                pooled.unitId = unitId;
+                pooled.transactionId = frame.transactionId;
+                pooled.request = request;
+
+                ++connection.pending;
+                {
+                    QMutexLocker locker(&m_poolMutex);
+                    ++m_pooledRequests;
+                }
+                m_threadPool->start(new Task(this, std::move(pooled)));
+                continue;
+            }
+
+            Q_SERIALBUS_TRACE(ModbusServerRequestStarted, unitId, request.functionCode(), 0);
+            const QModbusResponse response = forwardProcessRequest(request);
+            Q_SERIALBUS_TRACE(ModbusServerRequestFinished, unitId, request.functionCode(),
+                              response.exceptionCode());
+            qCDebug(QT_MODBUS) << "(TCP server) Response PDU:" << response;
+
+            // a broadcast is never answered
+            deliverResponse(connection, sequence, m_processesBroadcast ? QByteArray()
+                : m_framer->encode(unitId, frame.transactionId, response));
+            if (!transport->isOpen())
+                return;
+        }
+    }
+
     void setupTcpServer()
     {
         Q_Q(QModbusTcpServer);
@@ -125,81 +426,25 @@ public:
 
             connections.append(socket);
 
-            auto buffer = new QByteArray();
-
-            QObject::connect(socket, &QObject::destroyed, [buffer]() {
-                // cleanup buffer
-                delete buffer;
-            });
-            QObject::connect(socket, &QTcpSocket::disconnected, [socket, this]() {
+            // owned by the socket, so it goes away with the connection
+            auto transport = new QModbusIoDeviceTransport(socket, socket);
+            // Received bytes are read straight into this buffer and decoded in place.
+            // Allocate it up front for a full pipeline of requests, so it is not grown
+            // while the connection is in use.
+            transport->receiveBuffer()->reserve((MaximumPendingRequests + 1)
+                                                * QModbusTcpFramer::MaximumAduSize);
+            const quint64 id = m_nextConnectionId++;
+            QSharedPointer<Connection> connection = QSharedPointer<Connection>::create();
+            connection->transport = transport;
+            m_connections.insert(id, connection);
+
+            QObject::connect(socket, &QTcpSocket::disconnected, [socket, id, this]() {
                 connections.removeAll(socket);
+                m_connections.remove(id);
                 socket->deleteLater();
             });
-            QObject::connect(socket, &QTcpSocket::readyRead, [buffer, socket, this]() {
-                if (!socket)
-                    return;
-
-                buffer->append(socket->readAll());
-                while (!buffer->isEmpty()) {
-                    qCDebug(QT_MODBUS_LOW).noquote() << "(TCP server) Read buffer: 0x"
-                        + buffer->toHex();
-
-                    if (buffer->size() < mbpaHeaderSize) {
-                        qCDebug(QT_MODBUS) << "(TCP server) ADU too short. Waiting for more data.";
-                        return;
-                    }
-
-                    quint8 unitId;
-                    quint16 transactionId, bytesPdu, protocolId;
-                    QDataStream input(*buffer);
-                    input >> transactionId >> protocolId >> bytesPdu >> unitId;
-
-                    qCDebug(QT_MODBUS_LOW) << "(TCP server) Request MBPA:" << "Transaction Id:"
-                        << hex << transactionId << "Protocol Id:" << protocolId << "PDU bytes:"
-                        << bytesPdu << "Unit Id:" << unitId;
-
-                    // The length field is the byte count of the following fields, including the Unit
-                    // Identifier and the PDU, so we remove on byte.
-                    bytesPdu--;
-
-                    if (buffer->size() < mbpaHeaderSize + bytesPdu) {
-                        qCDebug(QT_MODBUS) << "(TCP server) PDU too short. Waiting for more data";
-                        return;
-                    }
-
-                    QModbusRequest request;
-                    input >> request;
-
-                    buffer->remove(0, mbpaHeaderSize + bytesPdu);
-
-                    if (!matchingServerAddress(unitId))
-                        continue;
-
-                    qCDebug(QT_MODBUS) << "(TCP server) Request PDU:" << request;
-                    const QModbusResponse response = forwardProcessRequest(request);
-                    qCDebug(QT_MODBUS) << "(TCP server) Response PDU:" << response;
-
-                    QByteArray result;
-                    QDataStream output(&result, QIODevice::WriteOnly);
-                    // The length field is the byte count of the following fields, including the Unit
-                    // Identifier and PDU fields, so we add one byte to the response size.
-                    output << transactionId << protocolId << quint16(response.size() + 1)
-                           << unitId << response;
-
-                    if (!socket->isOpen()) {
-                        qCDebug(QT_MODBUS) << "(TCP server) Requesting socket has closed.";
-                        forwardError(QModbusTcpServer::tr("Requesting socket is closed"),
-                                     QModbusDevice::WriteError);
-                        return;
-                    }
-
-                    int writtenBytes = socket->write(result);
-                    if (writtenBytes == -1 || writtenBytes < result.size()) {
-                        qCDebug(QT_MODBUS) << "(TCP server) Cannot write requested response to socket.";
-                        forwardError(QModbusTcpServer::tr("Could not write response to client"),
-                                     QModbusDevice::WriteError);
-                    }
-                }
+            QObject::connect(transport, &QModbusTransport::readyRead, [id, this]() {
+                processReceivedData(id);
             });
         });
         QObject::connect(m_tcpServer, &QTcpServer::acceptError,
@@ -213,9 +458,21 @@ public:
 
     QTcpServer *m_tcpServer;
     QVector<QTcpSocket *> connections;
-
-    static const qint8 mbpaHeaderSize = 7;
-    static const qint16 maxBytesModbusADU = 260;
+    QScopedPointer<QModbusFramer> m_framer { new QModbusTcpFramer(QModbusFramer::ServerRole) };
+    bool m_broadcastSupported = false;
+    bool m_processesBroadcast = false;
+
+    QHash<quint64, QSharedPointer<Connection>> m_connections;
+    quint64 m_nextConnectionId = 0;
+
+    QPointer<QThreadPool> m_threadPool;
+    QModbusTcpServer::ResponseOrder m_responseOrder = QModbusTcpServer::RequestOrder;
+    QMpscQueue<ProcessedRequest> m_processedRequests;
+    QMutex m_poolMutex;
+    QWaitCondition m_poolIdle;
+    int m_pooledRequests = 0;
+    QAtomicInt m_shuttingDown;
+    QReadWriteLock m_requestLock;
 };
 
 QT_END_NAMESPACE
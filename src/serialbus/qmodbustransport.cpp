@@ -0,0 +1,502 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qmodbustransport_p.h"
+#include "qmodbusadu_p.h"
+#include "qmodbus_symbols_p.h"
+
+#include <QtCore/qtimer.h>
+
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \internal
+    \class QModbusReceiveBuffer
+
+    Holds the bytes received by a QModbusTransport until a framer has consumed
+    them. Transports write directly into the free space at the end of the
+    buffer (see reserve() and commit()), framers decode in place from data()
+    and consume() drops the bytes of a decoded ADU without moving the rest.
+    Pending bytes are only moved to the front when the buffer runs out of space.
+*/
+
+/*!
+    \internal
+
+    Returns a pointer to at least \a size bytes of writable space behind the
+    pending bytes. Call commit() with the number of bytes actually written.
+*/
+char *QModbusReceiveBuffer::reserve(int size)
+{
+    if (m_data.size() - m_end < size) {
+        if (m_begin > 0) {
+            const int pending = m_end - m_begin;
+            ::memmove(m_data.data(), m_data.constData() + m_begin, pending);
+            m_begin = 0;
+            m_end = pending;
+        }
+        if (m_data.size() - m_end < size)
+            m_data.resize(qMax(qMax(m_end + size, 2 * m_data.size()), 256));
+    }
+    return m_data.data() + m_end;
+}
+
+void QModbusReceiveBuffer::append(const char *data, int size)
+{
+    ::memcpy(reserve(size), data, size);
+    commit(size);
+}
+
+void QModbusReceiveBuffer::consume(int size)
+{
+    Q_ASSERT(size <= m_end - m_begin);
+    m_begin += size;
+    if (m_begin == m_end)
+        clear();
+}
+
+/*!
+    \internal
+    \class QModbusFrame
+
+    A decoded ADU. The PDU data is copied out of the receive buffer, so the
+    frame stays valid once the ADU has been consumed.
+*/
+
+/*!
+    \internal
+
+    Sets the PDU data of the frame to the \a size bytes at \a pduData.
+
+    The storage of the previous data is reused, so a frame that is decoded
+    into over and over does not allocate. A request or response created from
+    the frame shares the data with it; as long as such a copy is alive, the
+    next call detaches and the copy keeps its data.
+*/
+void QModbusFrame::setData(const char *pduData, int size)
+{
+    // 253 bytes PDU minus the function code, the capacity survives resizing
+    data.reserve(252);
+    data.resize(size);
+    ::memcpy(data.data(), pduData, size_t(size));
+}
+
+/*!
+    \internal
+    \class QModbusFramer
+
+    Separates the Modbus application data units of one framing flavor from a
+    byte stream and builds them for sending. A framer has no state besides its
+    configuration, so a single instance can serve any number of connections.
+
+    decode() inspects the first \c size bytes of \c data. It returns
+    \l Incomplete if more bytes are needed. Otherwise \c aduSize is set to the
+    number of bytes the caller must consume, and \c frame is filled in if the
+    result is \l Complete. For \l Invalid and \l ChecksumError results the
+    frame boundary is lost; depending on the framer, the caller is asked to
+    consume all pending bytes or just enough to retry at the next candidate.
+*/
+
+static quint8 rawFunctionCode(const QModbusPdu &pdu)
+{
+    if (pdu.isException())
+        return quint8(pdu.functionCode() | QModbusPdu::ExceptionByte);
+    return quint8(pdu.functionCode());
+}
+
+/*!
+    \internal
+
+    Returns the size of the PDU data part that follows \a functionCode, based
+    on the \a size bytes of \a data received so far. Returns
+    \c InvalidFunctionCode for an unknown function code and \c NeedMoreData
+    if the size cannot be calculated yet.
+*/
+int QModbusFramer::pduDataSize(quint8 functionCode, const char *data, int size) const
+{
+    // The maximum PDU data size is 252 bytes, never look any further.
+    const QByteArray view = QByteArray::fromRawData(data, qMin(size, 252));
+
+    int dataSize;
+    if (m_role == ClientRole) {
+        const QModbusResponse response(QModbusPdu::FunctionCode(functionCode), view);
+        if (QModbusResponse::minimumDataSize(response) < 0)
+            return InvalidFunctionCode;
+        dataSize = QModbusResponse::calculateDataSize(response);
+    } else {
+        const QModbusRequest request(QModbusPdu::FunctionCode(functionCode), view);
+        if (QModbusRequest::minimumDataSize(request) < 0)
+            return InvalidFunctionCode;
+        dataSize = QModbusRequest::calculateDataSize(request);
+    }
+    return dataSize < 0 ? int(NeedMoreData) : dataSize;
+}
+
+static bool matchingCrc(const char *data, int size)
+{
+    const quint16 crc = quint16(quint8(data[size - 2]) << 8 | quint8(data[size - 1]));
+    return QModbusSerialAdu::calculateCRC(data, size - 2) == crc;
+}
+
+static bool isReturnQueryData(quint8 functionCode, const char *data, int size)
+{
+    return functionCode == QModbusPdu::Diagnostics && size >= 2
+        && quint16(quint8(data[0]) << 8 | quint8(data[1])) == Diagnostics::ReturnQueryData;
+}
+
+/*!
+    \internal
+    \class QModbusRtuFramer
+
+    Frames RTU ADUs: server address, PDU and CRC. The frame length is derived
+    from the function code and, where present, the byte count of the PDU.
+
+    The framer has no notion of the silent interval between frames. On a
+    serial line, the bytes pending after a frame with a wrong checksum or an
+    unknown function code belong to the same broken frame, so \c DiscardPending
+    asks to consume all of them. Over a byte stream like TCP, further frames
+    may already be pending; \c SkipByte asks to consume a single byte, and the
+    next call looks for a frame starting at the following one.
+*/
+
+QByteArray QModbusRtuFramer::encode(int serverAddress, quint16 transactionId,
+                                    const QModbusPdu &pdu) const
+{
+    Q_UNUSED(transactionId)
+    return QModbusSerialAdu::create(QModbusSerialAdu::Rtu, serverAddress, pdu);
+}
+
+QModbusFramer::Result QModbusRtuFramer::decode(const char *data, int size, QModbusFrame *frame,
+                                               int *aduSize) const
+{
+    Q_ASSERT(frame && aduSize);
+
+    *aduSize = 0;
+    if (size < 2)
+        return Incomplete;
+
+    frame->serverAddress = quint8(data[0]);
+    const quint8 functionCode = quint8(data[1]);
+
+    const int discarded = (m_resynchronization == SkipByte) ? 1 : size;
+
+    const int dataSize = pduDataSize(functionCode, data + 2, size - 2);
+    if (dataSize == InvalidFunctionCode) {
+        *aduSize = discarded;
+        return Invalid;
+    }
+
+    int frameSize = -1;
+    if (dataSize >= 0 && isReturnQueryData(functionCode, data + 2, size - 2)) {
+        // The echoed data has no length indicator, the first matching CRC ends the frame.
+        const int maximum = qMin(size, int(MaximumAduSize));
+        for (int candidate = 2 + dataSize + 2; candidate <= maximum; ++candidate) {
+            if (matchingCrc(data, candidate)) {
+                frameSize = candidate;
+                break;
+            }
+        }
+    } else if (dataSize >= 0 && size >= 2 + dataSize + 2) {
+        // server address byte + function code byte + PDU size + 2 bytes CRC
+        frameSize = 2 + dataSize + 2;
+    }
+
+    if (frameSize < 0) {
+        if (size < MaximumAduSize)
+            return Incomplete;
+        *aduSize = discarded;
+        return Invalid;
+    }
+
+    if (!matchingCrc(data, frameSize)) {
+        *aduSize = discarded;
+        return ChecksumError;
+    }
+
+    *aduSize = frameSize;
+    frame->functionCode = functionCode;
+    frame->setData(data + 2, frameSize - MinimumAduSize);
+    return Complete;
+}
+
+/*!
+    \internal
+    \class QModbusTcpFramer
+
+    Frames TCP ADUs: the MBAP header followed by the PDU. On \l Incomplete the
+    transaction id and unit identifier of \c frame are already filled in as soon
+    as the header has been received. ADUs with a protocol id other than 0 are
+    not Modbus and reported as \l Invalid.
+*/
+
+QByteArray QModbusTcpFramer::encode(int serverAddress, quint16 transactionId,
+                                    const QModbusPdu &pdu) const
+{
+    const QByteArray data = pdu.data();
+    // The length field is the byte count of the following fields, including the Unit
+    // Identifier and the PDU.
+    const quint16 length = quint16(data.size() + 2);
+
+    QByteArray adu(HeaderSize + 1 + data.size(), Qt::Uninitialized);
+    char *out = adu.data();
+    out[0] = char(transactionId >> 8);
+    out[1] = char(transactionId);
+    out[2] = 0; // protocol id
+    out[3] = 0;
+    out[4] = char(length >> 8);
+    out[5] = char(length);
+    out[6] = char(serverAddress);
+    out[7] = char(rawFunctionCode(pdu));
+    if (!data.isEmpty())
+        ::memcpy(out + HeaderSize + 1, data.constData(), data.size());
+    return adu;
+}
+
+QModbusFramer::Result QModbusTcpFramer::decode(const char *data, int size, QModbusFrame *frame,
+                                               int *aduSize) const
+{
+    Q_ASSERT(frame && aduSize);
+
+    *aduSize = 0;
+    if (size < HeaderSize)
+        return Incomplete;
+
+    const uchar *header = reinterpret_cast<const uchar *>(data);
+    frame->transactionId = quint16(header[0] << 8 | header[1]);
+    const quint16 protocolId = quint16(header[2] << 8 | header[3]);
+    const quint16 length = quint16(header[4] << 8 | header[5]);
+    frame->serverAddress = header[6];
+
+    if (length < 2 || length > MaximumAduSize - HeaderSize + 1) {
+        // A bogus length field leaves no way to find the next frame in the stream.
+        *aduSize = size;
+        return Invalid;
+    }
+
+    const int frameSize = HeaderSize - 1 + length;
+    if (size < frameSize)
+        return Incomplete;
+
+    *aduSize = frameSize;
+    if (protocolId != 0)
+        return Invalid;
+
+    frame->functionCode = header[HeaderSize];
+    frame->setData(data + HeaderSize + 1, frameSize - HeaderSize - 1);
+    return Complete;
+}
+
+static bool isHexDigit(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+/*!
+    \internal
+    \class QModbusAsciiFramer
+
+    Frames ASCII ADUs: a colon, the hex encoded server address, PDU and LRC,
+    followed by a carriage return and the delimiter character.
+*/
+
+QByteArray QModbusAsciiFramer::encode(int serverAddress, quint16 transactionId,
+                                      const QModbusPdu &pdu) const
+{
+    Q_UNUSED(transactionId)
+    return QModbusSerialAdu::create(QModbusSerialAdu::Ascii, serverAddress, pdu, m_delimiter);
+}
+
+QModbusFramer::Result QModbusAsciiFramer::decode(const char *data, int size, QModbusFrame *frame,
+                                                 int *aduSize) const
+{
+    Q_ASSERT(frame && aduSize);
+
+    *aduSize = 0;
+    if (size == 0)
+        return Incomplete;
+
+    if (data[0] != ':') {
+        // skip everything up to the next start character
+        const char *start = static_cast<const char *>(::memchr(data, ':', size));
+        *aduSize = start ? int(start - data) : size;
+        return Invalid;
+    }
+
+    const char *end = static_cast<const char *>(::memchr(data, m_delimiter,
+                                                         qMin(size, int(MaximumAduSize))));
+    if (!end) {
+        if (size < MaximumAduSize)
+            return Incomplete;
+        *aduSize = size;
+        return Invalid;
+    }
+
+    const int frameSize = int(end - data) + 1;
+    *aduSize = frameSize;
+
+    // colon + hex characters + carriage return + delimiter, the hex part holds at least
+    // the server address, the function code and the LRC
+    const int hexSize = frameSize - 3;
+    if (hexSize < 6 || (hexSize % 2) != 0 || data[frameSize - 2] != '\r')
+        return Invalid;
+
+    for (int i = 1; i <= hexSize; ++i) {
+        if (!isHexDigit(data[i]))
+            return Invalid; // fromHex() would silently skip it
+    }
+
+    const QByteArray raw = QByteArray::fromHex(QByteArray::fromRawData(data + 1, hexSize));
+
+    frame->serverAddress = quint8(raw.at(0));
+    if (QModbusSerialAdu::calculateLRC(raw.constData(), raw.size() - 1)
+            != quint8(raw.at(raw.size() - 1))) {
+        return ChecksumError;
+    }
+
+    frame->functionCode = quint8(raw.at(1));
+    frame->setData(raw.constData() + 2, raw.size() - 3);
+    return Complete;
+}
+
+/*!
+    \internal
+    \class QModbusTransport
+
+    Moves bytes between a Modbus device and its medium, independent of the
+    framing. Received bytes are appended to receiveBuffer() and announced with
+    readyRead(). Consumers decode straight from the buffer and consume what
+    they have processed, so the bytes are never copied into intermediate
+    containers. write() hands a complete ADU to the medium and returns the
+    number of bytes accepted or \c -1 on error.
+*/
+
+/*!
+    \internal
+    \class QModbusIoDeviceTransport
+
+    Transports over any QIODevice, such as QTcpSocket or QSerialPort. The
+    device stays under control of the caller, which opens and closes it.
+*/
+
+QModbusIoDeviceTransport::QModbusIoDeviceTransport(QIODevice *device, QObject *parent)
+    : QModbusTransport(parent)
+    , m_device(device)
+{
+    Q_ASSERT(device);
+    connect(device, &QIODevice::readyRead, this, &QModbusIoDeviceTransport::readFromDevice);
+    connect(device, &QIODevice::bytesWritten, this, &QModbusTransport::bytesWritten);
+}
+
+bool QModbusIoDeviceTransport::isOpen() const
+{
+    return m_device && m_device->isOpen();
+}
+
+qint64 QModbusIoDeviceTransport::write(const QByteArray &adu)
+{
+    if (!m_device)
+        return -1;
+    return m_device->write(adu);
+}
+
+void QModbusIoDeviceTransport::readFromDevice()
+{
+    const qint64 available = m_device->bytesAvailable();
+    if (available <= 0)
+        return;
+
+    const qint64 read = m_device->read(m_receiveBuffer.reserve(int(available)), available);
+    if (read <= 0)
+        return;
+
+    m_receiveBuffer.commit(int(read));
+    emit readyRead();
+}
+
+/*!
+    \internal
+    \class QModbusMemoryTransport
+
+    Transports between two instances connected with connectPair(), without any
+    I/O. Written bytes are appended to the receive buffer of the peer right
+    away; the peer is notified from the event loop, as with a socket. Multiple
+    writes before the peer gets to run cause a single readyRead(). The
+    bytesWritten() signal is emitted before write() returns.
+*/
+
+void QModbusMemoryTransport::connectPair(QModbusMemoryTransport *first,
+                                         QModbusMemoryTransport *second)
+{
+    Q_ASSERT(first && second && first != second);
+
+    first->disconnectPeer();
+    second->disconnectPeer();
+    first->m_peer = second;
+    second->m_peer = first;
+}
+
+void QModbusMemoryTransport::disconnectPeer()
+{
+    if (m_peer)
+        m_peer->m_peer = nullptr;
+    m_peer = nullptr;
+}
+
+qint64 QModbusMemoryTransport::write(const QByteArray &adu)
+{
+    if (!m_peer)
+        return -1;
+
+    QModbusMemoryTransport *peer = m_peer.data();
+    peer->m_receiveBuffer.append(adu.constData(), adu.size());
+    if (!peer->m_notificationPending) {
+        peer->m_notificationPending = true;
+        QTimer::singleShot(0, peer, [peer]() {
+            peer->m_notificationPending = false;
+            emit peer->readyRead();
+        });
+    }
+
+    emit bytesWritten(adu.size());
+    return adu.size();
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qmodbustransport_p.cpp"
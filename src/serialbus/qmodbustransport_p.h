@@ -0,0 +1,242 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QMODBUSTRANSPORT_P_H
+#define QMODBUSTRANSPORT_P_H
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qiodevice.h>
+#include <QtCore/qobject.h>
+#include <QtCore/qpointer.h>
+#include <QtSerialBus/qmodbuspdu.h>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+class Q_AUTOTEST_EXPORT QModbusReceiveBuffer
+{
+public:
+    const char *data() const { return m_data.constData() + m_begin; }
+    int size() const { return m_end - m_begin; }
+    bool isEmpty() const { return m_begin == m_end; }
+
+    char *reserve(int size);
+    void commit(int size) { m_end += size; }
+    void append(const char *data, int size);
+    void consume(int size);
+    void clear() { m_begin = m_end = 0; }
+
+private:
+    QByteArray m_data;
+    int m_begin = 0;
+    int m_end = 0;
+};
+
+struct QModbusFrame
+{
+    int serverAddress = -1;
+    quint16 transactionId = 0;
+    quint8 functionCode = 0;
+    QByteArray data;
+
+    void setData(const char *pduData, int size);
+
+    QModbusRequest request() const {
+        return QModbusRequest(QModbusPdu::FunctionCode(functionCode), data);
+    }
+    QModbusResponse response() const {
+        return QModbusResponse(QModbusPdu::FunctionCode(functionCode), data);
+    }
+};
+
+class Q_AUTOTEST_EXPORT QModbusFramer
+{
+public:
+    enum Role {
+        ClientRole, // decodes responses
+        ServerRole  // decodes requests
+    };
+
+    enum Result {
+        Complete,
+        Incomplete,
+        Invalid,
+        ChecksumError
+    };
+
+    explicit QModbusFramer(Role role) : m_role(role) {}
+    virtual ~QModbusFramer() = default;
+
+    Role role() const { return m_role; }
+
+    virtual QByteArray encode(int serverAddress, quint16 transactionId,
+                              const QModbusPdu &pdu) const = 0;
+    virtual Result decode(const char *data, int size, QModbusFrame *frame,
+                          int *aduSize) const = 0;
+
+protected:
+    enum { InvalidFunctionCode = -2, NeedMoreData = -1 };
+    int pduDataSize(quint8 functionCode, const char *data, int size) const;
+
+private:
+    Role m_role;
+};
+
+class Q_AUTOTEST_EXPORT QModbusRtuFramer : public QModbusFramer
+{
+public:
+    enum { MinimumAduSize = 4, MaximumAduSize = 256 };
+
+    enum Resynchronization {
+        DiscardPending, // serial line, the next frame starts after the silent interval
+        SkipByte        // byte stream, the next frame may start at any of the pending bytes
+    };
+
+    explicit QModbusRtuFramer(Role role, Resynchronization resync = DiscardPending)
+        : QModbusFramer(role), m_resynchronization(resync) {}
+
+    Resynchronization resynchronization() const { return m_resynchronization; }
+
+    QByteArray encode(int serverAddress, quint16 transactionId,
+                      const QModbusPdu &pdu) const override;
+    Result decode(const char *data, int size, QModbusFrame *frame, int *aduSize) const override;
+
+private:
+    Resynchronization m_resynchronization;
+};
+
+class Q_AUTOTEST_EXPORT QModbusTcpFramer : public QModbusFramer
+{
+public:
+    enum { HeaderSize = 7, MaximumAduSize = 260 };
+
+    explicit QModbusTcpFramer(Role role) : QModbusFramer(role) {}
+
+    QByteArray encode(int serverAddress, quint16 transactionId,
+                      const QModbusPdu &pdu) const override;
+    Result decode(const char *data, int size, QModbusFrame *frame, int *aduSize) const override;
+};
+
+class Q_AUTOTEST_EXPORT QModbusAsciiFramer : public QModbusFramer
+{
+public:
+    enum { MaximumAduSize = 513 };
+
+    explicit QModbusAsciiFramer(Role role, char delimiter = '\n')
+        : QModbusFramer(role), m_delimiter(delimiter) {}
+
+    char delimiter() const { return m_delimiter; }
+    void setDelimiter(char delimiter) { m_delimiter = delimiter; }
+
+    QByteArray encode(int serverAddress, quint16 transactionId,
+                      const QModbusPdu &pdu) const override;
+    Result decode(const char *data, int size, QModbusFrame *frame, int *aduSize) const override;
+
+private:
+    char m_delimiter;
+};
+
+class Q_AUTOTEST_EXPORT QModbusTransport : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit QModbusTransport(QObject *parent = nullptr) : QObject(parent) {}
+
+    virtual bool isOpen() const = 0;
+    virtual qint64 write(const QByteArray &adu) = 0;
+
+    QModbusReceiveBuffer *receiveBuffer() { return &m_receiveBuffer; }
+
+Q_SIGNALS:
+    void readyRead();
+    void bytesWritten(qint64 bytes);
+
+protected:
+    QModbusReceiveBuffer m_receiveBuffer;
+};
+
+class Q_AUTOTEST_EXPORT QModbusIoDeviceTransport : public QModbusTransport
+{
+    Q_OBJECT
+
+public:
+    explicit QModbusIoDeviceTransport(QIODevice *device, QObject *parent = nullptr);
+
+    QIODevice *device() const { return m_device; }
+
+    bool isOpen() const override;
+    qint64 write(const QByteArray &adu) override;
+
+private:
+    void readFromDevice();
+
+    QPointer<QIODevice> m_device;
+};
+
+class Q_AUTOTEST_EXPORT QModbusMemoryTransport : public QModbusTransport
+{
+    Q_OBJECT
+
+public:
+    explicit QModbusMemoryTransport(QObject *parent = nullptr) : QModbusTransport(parent) {}
+
+    static void connectPair(QModbusMemoryTransport *first, QModbusMemoryTransport *second);
+    void disconnectPeer();
+    QModbusMemoryTransport *peer() const { return m_peer; }
+
+    bool isOpen() const override { return !m_peer.isNull(); }
+    qint64 write(const QByteArray &adu) override;
+
+private:
+    QPointer<QModbusMemoryTransport> m_peer;
+    bool m_notificationPending = false;
+};
+
+QT_END_NAMESPACE
+
+#endif // QMODBUSTRANSPORT_P_H
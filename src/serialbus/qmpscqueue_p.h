@@ -0,0 +1,178 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QMPSCQUEUE_P_H
+#define QMPSCQUEUE_P_H
+
+#include <QtCore/qatomic.h>
+#include <QtCore/qglobal.h>
+
+#include <utility>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+/*
+    Unbounded multi-producer single-consumer queue (D. Vyukov's intrusive
+    MPSC node queue). enqueue() may be called from any thread and costs one
+    allocation plus two atomic exchanges; it never blocks. dequeue() and
+    beginDrain() must only be called from the single consumer thread.
+
+    Elements enqueued by the same producer are dequeued in the order they
+    were enqueued.
+
+    To avoid one wake-up per element, the queue tracks whether the consumer
+    has already been scheduled: enqueue() returns true only for the element
+    that turned the queue from idle to pending. The consumer calls
+    beginDrain() before dequeuing, which marks it idle again; if it stops
+    early (e.g. after a batch limit) it calls claimWakeUp() and reschedules
+    itself if that returns true.
+
+    The destructor discards whatever is still queued; owners whose elements
+    carry completion callbacks have to drain the queue themselves first.
+*/
+template <typename T>
+class QMpscQueue
+{
+    Q_DISABLE_COPY(QMpscQueue)
+
+    struct Node
+    {
+        QAtomicPointer<Node> next;
+        T value;
+    };
+
+public:
+    QMpscQueue()
+        : m_head(&m_stub)
+        , m_tail(&m_stub)
+        , m_idle(1)
+    {}
+
+    ~QMpscQueue()
+    {
+        T value;
+        while (dequeue(&value)) {}
+    }
+
+    bool enqueue(const T &value)
+    {
+        Node *node = new Node;
+        node->value = value;
+        push(node);
+        return claimWakeUp();
+    }
+
+    bool enqueue(T &&value)
+    {
+        Node *node = new Node;
+        node->value = std::move(value);
+        push(node);
+        return claimWakeUp();
+    }
+
+    bool claimWakeUp() { return m_idle.testAndSetOrdered(1, 0); }
+    void beginDrain() { m_idle.fetchAndStoreOrdered(1); }
+
+    bool dequeue(T *value)
+    {
+        Node *tail = m_tail;
+        Node *next = tail->next.loadAcquire();
+        if (tail == &m_stub) {
+            if (!next)
+                return false;
+            m_tail = next;
+            tail = next;
+            next = next->next.loadAcquire();
+        }
+
+        if (!next) {
+            // A producer swapped the head but did not link its node yet. It will
+            // claim the wake-up once it is done, so it is fine to bail out here.
+            if (tail != m_head.loadAcquire())
+                return false;
+
+            push(&m_stub);
+            next = tail->next.loadAcquire();
+            if (!next)
+                return false;
+        }
+
+        m_tail = next;
+        *value = std::move(tail->value);
+        delete tail;
+        return true;
+    }
+
+    template <typename Function>
+    int drain(Function function, int maximum)
+    {
+        int count = 0;
+        T value;
+        while (count < maximum && dequeue(&value)) {
+            function(std::move(value));
+            ++count;
+        }
+        return count;
+    }
+
+private:
+    void push(Node *node)
+    {
+        node->next.store(nullptr);
+        Node *previous = m_head.fetchAndStoreOrdered(node);
+        previous->next.storeRelease(node);
+    }
+
+    QAtomicPointer<Node> m_head;
+    Node *m_tail;
+    Node m_stub;
+    QAtomicInt m_idle;
+};
+
+QT_END_NAMESPACE
+
+#endif // QMPSCQUEUE_P_H
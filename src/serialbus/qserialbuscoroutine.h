@@ -0,0 +1,243 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSERIALBUSCOROUTINE_H
+#define QSERIALBUSCOROUTINE_H
+
+#include <QtSerialBus/qcanbusdevice.h>
+#include <QtSerialBus/qmodbusclient.h>
+#include <QtSerialBus/qmodbusreply.h>
+
+// The library itself is built as C++11. Everything below is header only and
+// available to applications compiled with C++20 coroutine support.
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#  if __has_include(<coroutine>)
+#    define QT_SERIALBUS_COROUTINES
+#  endif
+#endif
+
+#ifdef QT_SERIALBUS_COROUTINES
+
+#include <coroutine>
+#include <exception>
+
+QT_BEGIN_NAMESPACE
+
+class QSerialBusTask
+{
+public:
+    struct promise_type
+    {
+        QSerialBusTask get_return_object() noexcept { return QSerialBusTask(); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+struct QModbusResult
+{
+    QModbusDevice::Error error = QModbusDevice::NoError;
+    QString errorString;
+    QModbusDataUnit unit;
+    QModbusResponse rawResult;
+
+    bool isValid() const { return error == QModbusDevice::NoError; }
+};
+
+class QModbusReplyAwaiter
+{
+public:
+    QModbusReplyAwaiter(QModbusClient *client, QModbusReply *reply) noexcept
+        : m_client(client), m_reply(reply)
+    {}
+
+    bool await_ready() const noexcept { return !m_reply || m_reply->isFinished(); }
+
+    void await_suspend(std::coroutine_handle<> handle) noexcept
+    {
+        // chain up with anyone already waiting for the same reply
+        m_handle = handle;
+        m_previousHook = m_reply->finishedHook();
+        m_previousHookData = m_reply->finishedHookData();
+        m_reply->setFinishedHook(&QModbusReplyAwaiter::resume, this);
+    }
+
+    QModbusResult await_resume()
+    {
+        QModbusResult result;
+        if (!m_reply) {
+            result.error = m_client->error();
+            if (result.error == QModbusDevice::NoError)
+                result.error = QModbusDevice::UnknownError;
+            result.errorString = m_client->errorString();
+            return result;
+        }
+
+        result.error = m_reply->error();
+        result.errorString = m_reply->errorString();
+        result.unit = m_reply->result();
+        result.rawResult = m_reply->rawResult();
+        m_reply->deleteLater();
+        return result;
+    }
+
+private:
+    static void resume(void *data)
+    {
+        // the awaiter lives in the coroutine frame, which may be gone after resume()
+        const QModbusReplyAwaiter *awaiter = static_cast<QModbusReplyAwaiter *>(data);
+        const QModbusReply::FinishedHook previousHook = awaiter->m_previousHook;
+        void *previousHookData = awaiter->m_previousHookData;
+        const std::coroutine_handle<> handle = awaiter->m_handle;
+
+        // resume in the order the coroutines started waiting
+        if (previousHook)
+            previousHook(previousHookData);
+        handle.resume();
+    }
+
+    QModbusClient *m_client;
+    QModbusReply *m_reply;
+    std::coroutine_handle<> m_handle;
+    QModbusReply::FinishedHook m_previousHook = nullptr;
+    void *m_previousHookData = nullptr;
+};
+
+class QModbusAwaitableClient
+{
+public:
+    explicit QModbusAwaitableClient(QModbusClient *client) noexcept : m_client(client) {}
+
+    QModbusClient *client() const noexcept { return m_client; }
+
+    QModbusReplyAwaiter read(const QModbusDataUnit &read, int serverAddress)
+    {
+        return QModbusReplyAwaiter(m_client, m_client->sendReadRequest(read, serverAddress));
+    }
+    QModbusReplyAwaiter write(const QModbusDataUnit &write, int serverAddress)
+    {
+        return QModbusReplyAwaiter(m_client, m_client->sendWriteRequest(write, serverAddress));
+    }
+    QModbusReplyAwaiter readWrite(const QModbusDataUnit &read, const QModbusDataUnit &write,
+                                  int serverAddress)
+    {
+        return QModbusReplyAwaiter(m_client,
+                                   m_client->sendReadWriteRequest(read, write, serverAddress));
+    }
+    QModbusReplyAwaiter raw(const QModbusRequest &request, int serverAddress)
+    {
+        return QModbusReplyAwaiter(m_client, m_client->sendRawRequest(request, serverAddress));
+    }
+
+private:
+    QModbusClient *m_client;
+};
+
+class QCanBusAwaitableDevice
+{
+public:
+    explicit QCanBusAwaitableDevice(QCanBusDevice *device) noexcept : m_device(device) {}
+
+    QCanBusDevice *device() const noexcept { return m_device; }
+
+    class FramesAwaiter
+    {
+    public:
+        explicit FramesAwaiter(QCanBusAwaitableDevice *owner) noexcept : m_owner(owner) {}
+
+        bool await_ready()
+        {
+            m_ready = m_owner->takeFrames()
+                    || m_owner->m_device->state() != QCanBusDevice::ConnectedState;
+            return m_ready;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) noexcept
+        {
+            // chain up with other coroutines waiting on the same device
+            QCanBusDevice *device = m_owner->m_device;
+            m_handle = handle;
+            m_previousHook = device->receiveHook();
+            m_previousHookData = device->receiveHookData();
+            device->setReceiveHook(&FramesAwaiter::resume, this);
+        }
+
+        // Frames are handed to the coroutine resumed first, the others get an
+        // empty batch. The batch stays valid until the next co_await on m_owner.
+        const QVector<QCanBusFrame> &await_resume()
+        {
+            if (!m_ready)
+                m_owner->takeFrames();
+            return m_owner->m_frames;
+        }
+
+    private:
+        static void resume(void *data)
+        {
+            // the awaiter lives in the coroutine frame, which may be gone after resume()
+            const FramesAwaiter *awaiter = static_cast<FramesAwaiter *>(data);
+            const QCanBusDevice::ReceiveHook previousHook = awaiter->m_previousHook;
+            void *previousHookData = awaiter->m_previousHookData;
+            const std::coroutine_handle<> handle = awaiter->m_handle;
+
+            if (previousHook)
+                previousHook(previousHookData);
+            handle.resume();
+        }
+
+        QCanBusAwaitableDevice *m_owner;
+        bool m_ready = false;
+        std::coroutine_handle<> m_handle;
+        QCanBusDevice::ReceiveHook m_previousHook = nullptr;
+        void *m_previousHookData = nullptr;
+    };
+
+    FramesAwaiter frames() noexcept { return FramesAwaiter(this); }
+
+private:
+    bool takeFrames() { return m_device->readAllFrames(&m_frames) > 0; }
+
+    QCanBusDevice *m_device;
+    QVector<QCanBusFrame> m_frames;
+};
+
+QT_END_NAMESPACE
+
+#endif // QT_SERIALBUS_COROUTINES
+
+#endif // QSERIALBUSCOROUTINE_H
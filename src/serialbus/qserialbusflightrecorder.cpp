@@ -0,0 +1,674 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qserialbusflightrecorder.h"
+#include "qserialbusflightrecorder_p.h"
+#include "qcanbusdevice.h"
+#include "qcanbusdevice_p.h"
+#include "qcanbusframe.h"
+#include "qmodbusdevice.h"
+#include "qmodbusdevice_p.h"
+#include "qmodbustcpclient.h"
+#include "qmodbustcpserver.h"
+#include "qserialbustrace_p.h"
+
+#include <QtCore/qdatetime.h>
+#include <QtCore/qendian.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qsavefile.h>
+
+#include <atomic>
+#include <chrono>
+
+QT_BEGIN_NAMESPACE
+
+// pcapng link types
+enum : quint16 {
+    LinkTypeCanSocketCan = 227,
+    LinkTypeModbusRtu = 147,    // LINKTYPE_USER0
+    LinkTypeModbusTcp = 148     // LINKTYPE_USER1
+};
+
+/*!
+    \class QSerialBusFlightRecorder
+    \inmodule QtSerialBus
+    \since 5.7
+
+    \brief The QSerialBusFlightRecorder class keeps the most recent protocol
+    events of CAN bus and Modbus devices in memory.
+
+    When a field device misbehaves, the evidence is usually gone by the time
+    debug logging is enabled. A flight recorder attached to the devices of an
+    application records compact binary events into a fixed-size ring and is
+    cheap enough to be left enabled permanently:
+
+    \list
+        \li CAN frames received and written,
+        \li Modbus ADUs sent and received by clients and servers,
+        \li Modbus retries and timeouts,
+        \li errors and state changes of the attached devices.
+    \endlist
+
+    Recording an event takes one atomic increment, a clock read and a copy of
+    at most 96 bytes of payload; longer payloads are truncated. The ring does
+    not use locks, so devices in different threads can record into the same
+    recorder. Once the ring is full, the oldest events are overwritten.
+
+    The ring can be written to a file at any time with \l dump(), which is a
+    slot and can be connected to any signal, or automatically whenever an
+    attached device reports an error, see \l setDumpsOnError().
+
+    \code
+    auto recorder = new QSerialBusFlightRecorder(16384, this);
+    recorder->attach(canDevice);
+    recorder->attach(modbusClient);
+    recorder->setDumpFileName(QStringLiteral("/var/log/fieldbus.pcapng"));
+    recorder->setDumpFormat(QSerialBusFlightRecorder::PcapNgFormat);
+    recorder->setDumpsOnError(true);
+    \endcode
+
+    A device can be attached to one recorder at a time. Attach and detach
+    devices in the thread the recorder lives in, and destroy the recorder
+    only after the attached devices stopped recording, for example because
+    they were disconnected.
+*/
+
+/*!
+    \enum QSerialBusFlightRecorder::Format
+
+    This enum describes the formats the recorded events can be written in.
+
+    \value BinaryFormat     The events as recorded, see \l {Binary Format}.
+    \value PcapNgFormat     The pcapng format read by Wireshark. Each device
+                            is an interface. CAN frames use the link type
+                            \c LINKTYPE_CAN_SOCKETCAN, Modbus RTU ADUs
+                            \c LINKTYPE_USER0 and Modbus TCP ADUs
+                            \c LINKTYPE_USER1, for which Wireshark can be
+                            configured to use the \c mbrtu and \c mbtcp
+                            dissectors. Other events are written as packets
+                            without data and a comment.
+
+    \section2 Binary Format
+
+    The file begins with the eight bytes \c QSBFLREC, followed by the
+    format version (currently 1), the size of an event (120) and the number
+    of interfaces, each as 32-bit unsigned integer. For each interface
+    follow its link type and the length of its name as 16-bit integers, and
+    the name in UTF-8. The offset to add to the event timestamps to get
+    nanoseconds since the Unix epoch follows as 64-bit integer, then the
+    events, oldest first. Each event consists of:
+
+    \list
+        \li a 64-bit timestamp in nanoseconds of the monotonic clock,
+        \li the 16-bit index of the interface,
+        \li the 8-bit event type: 1 for a CAN frame, 2 for a Modbus ADU,
+            3 for a Modbus retry, 4 for a Modbus timeout, 5 for an error and
+            6 for a state change,
+        \li 8 bits of flags: \c 0x01 if the data was transmitted, \c 0x02 if
+            it was truncated,
+        \li a 32-bit id: the frame id, the server address, the error or the
+            new state,
+        \li a 32-bit value: the frame flags as for the \l {Tracing Qt Serial
+            Bus}{tracepoints} or the Modbus function code,
+        \li the 16-bit length of the data before truncation, 16 reserved
+            bits and 96 bytes of data.
+    \endlist
+
+    All values are in the byte order of the host that wrote the file.
+*/
+
+/*!
+    Constructs a recorder keeping the last \a capacity events, with the
+    specified \a parent. The capacity is rounded up to a power of two of at
+    least 16. Each event takes 128 bytes of memory.
+*/
+QSerialBusFlightRecorder::QSerialBusFlightRecorder(int capacity, QObject *parent)
+    : QObject(*new QSerialBusFlightRecorderPrivate, parent)
+{
+    Q_D(QSerialBusFlightRecorder);
+    quint64 size = 16;
+    while (size < quint64(qMax(capacity, 16)))
+        size <<= 1;
+    d->m_capacity = size;
+    d->m_slots.reset(new QSerialBusFlightRecorderPrivate::Slot[size]);
+    clear();
+}
+
+/*!
+    Destroys the recorder and detaches it from all devices.
+*/
+QSerialBusFlightRecorder::~QSerialBusFlightRecorder()
+{
+    Q_D(QSerialBusFlightRecorder);
+    for (int i = 0; i < d->m_interfaces.size(); ++i)
+        d->removeInterface(i);
+}
+
+/*!
+    Returns the number of events the recorder keeps.
+*/
+int QSerialBusFlightRecorder::capacity() const
+{
+    Q_D(const QSerialBusFlightRecorder);
+    return int(d->m_capacity);
+}
+
+/*!
+    Returns the number of events recorded since the recorder was created or
+    cleared, including the ones already overwritten.
+*/
+quint64 QSerialBusFlightRecorder::eventCount() const
+{
+    Q_D(const QSerialBusFlightRecorder);
+    return d->m_head.load();
+}
+
+/*!
+    Discards all recorded events. Devices stay attached.
+*/
+void QSerialBusFlightRecorder::clear()
+{
+    Q_D(QSerialBusFlightRecorder);
+    // Sequence 0 never belongs to a completely written event.
+    for (quint64 i = 0; i < d->m_capacity; ++i)
+        d->m_slots[i].sequence.store(0);
+    d->m_head.store(0);
+}
+
+/*!
+    Starts recording the frames, errors and state changes of the CAN bus
+    \a device. The device is detached from any other recorder.
+
+    Frames written are recorded by the plugins shipped with Qt Serial Bus;
+    other plugins may only record received frames.
+*/
+void QSerialBusFlightRecorder::attach(QCanBusDevice *device)
+{
+    Q_D(QSerialBusFlightRecorder);
+    if (!device)
+        return;
+
+    detach(device);
+    const int index = d->addInterface(device, LinkTypeCanSocketCan);
+    d->m_interfaces[index].errorConnection = connect(device, &QCanBusDevice::errorOccurred,
+                                                     this, [d]() { d->onDeviceError(); });
+
+    QCanBusDevicePrivate *dd = static_cast<QCanBusDevicePrivate *>(QObjectPrivate::get(device));
+    dd->flightRecorderInterface = quint16(index);
+    dd->flightRecorder.storeRelease(d);
+}
+
+/*!
+    Starts recording the ADUs, retries, timeouts, errors and state changes of
+    the Modbus \a device. The device is detached from any other recorder.
+*/
+void QSerialBusFlightRecorder::attach(QModbusDevice *device)
+{
+    Q_D(QSerialBusFlightRecorder);
+    if (!device)
+        return;
+
+    detach(device);
+    const bool tcp = qobject_cast<QModbusTcpClient *>(device)
+            || qobject_cast<QModbusTcpServer *>(device);
+    const int index = d->addInterface(device, tcp ? LinkTypeModbusTcp : LinkTypeModbusRtu);
+    d->m_interfaces[index].errorConnection = connect(device, &QModbusDevice::errorOccurred,
+                                                     this, [d]() { d->onDeviceError(); });
+
+    QModbusDevicePrivate *dd = static_cast<QModbusDevicePrivate *>(QObjectPrivate::get(device));
+    dd->m_flightRecorderInterface = quint16(index);
+    dd->m_flightRecorder.storeRelease(d);
+}
+
+/*!
+    Stops recording the events of \a device. Events already recorded are
+    kept.
+*/
+void QSerialBusFlightRecorder::detach(QObject *device)
+{
+    Q_D(QSerialBusFlightRecorder);
+    if (!device)
+        return;
+
+    // a device attached to another recorder is detached from that one
+    if (QCanBusDevice *canDevice = qobject_cast<QCanBusDevice *>(device)) {
+        QCanBusDevicePrivate *dd = static_cast<QCanBusDevicePrivate *>(QObjectPrivate::get(canDevice));
+        if (QSerialBusFlightRecorderPrivate *other = dd->flightRecorder.load()) {
+            if (other != d) {
+                other->q_func()->detach(device);
+                return;
+            }
+        }
+    } else if (QModbusDevice *modbusDevice = qobject_cast<QModbusDevice *>(device)) {
+        QModbusDevicePrivate *dd = static_cast<QModbusDevicePrivate *>(QObjectPrivate::get(modbusDevice));
+        if (QSerialBusFlightRecorderPrivate *other = dd->m_flightRecorder.load()) {
+            if (other != d) {
+                other->q_func()->detach(device);
+                return;
+            }
+        }
+    }
+
+    for (int i = 0; i < d->m_interfaces.size(); ++i) {
+        if (d->m_interfaces.at(i).device == device)
+            d->removeInterface(i);
+    }
+}
+
+/*!
+    Returns the name of the file written by \l dump().
+*/
+QString QSerialBusFlightRecorder::dumpFileName() const
+{
+    Q_D(const QSerialBusFlightRecorder);
+    return d->m_dumpFileName;
+}
+
+/*!
+    Sets the name of the file written by \l dump() to \a fileName. Every dump
+    replaces the file.
+*/
+void QSerialBusFlightRecorder::setDumpFileName(const QString &fileName)
+{
+    Q_D(QSerialBusFlightRecorder);
+    d->m_dumpFileName = fileName;
+}
+
+/*!
+    Returns the format of the file written by \l dump(). The default is
+    \l BinaryFormat.
+*/
+QSerialBusFlightRecorder::Format QSerialBusFlightRecorder::dumpFormat() const
+{
+    Q_D(const QSerialBusFlightRecorder);
+    return d->m_dumpFormat;
+}
+
+/*!
+    Sets the \a format of the file written by \l dump().
+*/
+void QSerialBusFlightRecorder::setDumpFormat(Format format)
+{
+    Q_D(QSerialBusFlightRecorder);
+    d->m_dumpFormat = format;
+}
+
+/*!
+    Returns \c true if the recorder dumps its events whenever an attached
+    device emits \c errorOccurred(). The default is \c false.
+*/
+bool QSerialBusFlightRecorder::dumpsOnError() const
+{
+    Q_D(const QSerialBusFlightRecorder);
+    return d->m_dumpsOnError;
+}
+
+/*!
+    Sets whether the recorder dumps its events whenever an attached device
+    emits \c errorOccurred() to \a enable. The error itself is part of the
+    dump.
+*/
+void QSerialBusFlightRecorder::setDumpsOnError(bool enable)
+{
+    Q_D(QSerialBusFlightRecorder);
+    d->m_dumpsOnError = enable;
+}
+
+/*!
+    Writes the recorded events to \a device in \a format. Returns \c true on
+    success. Recording continues while the events are written; events
+    overwritten in the meantime are left out.
+*/
+bool QSerialBusFlightRecorder::dump(QIODevice *device, Format format) const
+{
+    Q_D(const QSerialBusFlightRecorder);
+    if (!device || !device->isWritable())
+        return false;
+
+    const QVector<QSerialBusFlightRecorderPrivate::Event> events = d->snapshot();
+    if (format == PcapNgFormat)
+        return d->writePcapNg(device, events);
+    return d->writeBinary(device, events);
+}
+
+/*!
+    Writes the recorded events to \l dumpFileName() in \l dumpFormat().
+    Returns \c true and emits \l dumped() on success.
+*/
+bool QSerialBusFlightRecorder::dump()
+{
+    Q_D(QSerialBusFlightRecorder);
+    if (d->m_dumpFileName.isEmpty())
+        return false;
+
+    QSaveFile file(d->m_dumpFileName);
+    if (!file.open(QIODevice::WriteOnly) || !dump(&file, d->m_dumpFormat) || !file.commit())
+        return false;
+
+    emit dumped(d->m_dumpFileName);
+    return true;
+}
+
+/*!
+    \fn void QSerialBusFlightRecorder::dumped(const QString &fileName)
+
+    This signal is emitted after \l dump() wrote the events to \a fileName.
+*/
+
+static quint64 monotonicTime()
+{
+    using namespace std::chrono;
+    return quint64(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+void QSerialBusFlightRecorderPrivate::record(quint16 interface, EventType type, quint8 flags,
+                                             quint32 id, quint32 value, const char *data,
+                                             int length)
+{
+    const quint64 position = m_head.fetchAndAddRelaxed(1);
+    Slot &slot = m_slots[position & (m_capacity - 1)];
+
+    slot.sequence.store(2 * position + 1);
+    // A release store only orders what comes before it. The fence keeps the
+    // event writes below from becoming visible ahead of the odd sequence,
+    // otherwise snapshot() could accept a half-written event.
+    std::atomic_thread_fence(std::memory_order_release);
+    Event &event = slot.event;
+    event.timestamp = monotonicTime();
+    event.interface = interface;
+    event.type = type;
+    event.id = id;
+    event.value = value;
+    event.length = quint16(qMin(length, 0xffff));
+    event.reserved = 0;
+    const int stored = qMin(length, int(DataSize));
+    event.flags = flags | (stored < length ? Truncated : 0);
+    if (stored > 0)
+        memcpy(event.data, data, size_t(stored));
+    slot.sequence.storeRelease(2 * position + 2);
+}
+
+void QSerialBusFlightRecorderPrivate::recordFrame(quint16 interface, const QCanBusFrame &frame,
+                                                  bool transmitted)
+{
+    const QByteArray payload = frame.payload();
+    record(interface, CanFrame, transmitted ? Transmitted : 0, frame.frameId(),
+           QSerialBusTrace::frameFlags(frame), payload.constData(), payload.size());
+}
+
+QVector<QSerialBusFlightRecorderPrivate::Event> QSerialBusFlightRecorderPrivate::snapshot() const
+{
+    const quint64 head = m_head.loadAcquire();
+    const quint64 first = head > m_capacity ? head - m_capacity : 0;
+
+    QVector<Event> events;
+    events.reserve(int(head - first));
+    for (quint64 position = first; position < head; ++position) {
+        const Slot &slot = m_slots[position & (m_capacity - 1)];
+        const quint64 expected = 2 * position + 2;
+        if (slot.sequence.loadAcquire() != expected)
+            continue; // still being written, or already overwritten
+        Event event;
+        memcpy(&event, &slot.event, sizeof(Event));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load() != expected)
+            continue;
+        events.append(event);
+    }
+    return events;
+}
+
+int QSerialBusFlightRecorderPrivate::addInterface(QObject *device, quint16 linkType)
+{
+    Interface interface;
+    interface.device = device;
+    interface.linkType = linkType;
+    interface.name = device->objectName().isEmpty()
+            ? QString::fromLatin1(device->metaObject()->className()) : device->objectName();
+
+    // keep indexes of recorded events valid, reuse only slots of the same device
+    for (int i = 0; i < m_interfaces.size(); ++i) {
+        if (m_interfaces.at(i).device.isNull() && m_interfaces.at(i).name == interface.name
+                && m_interfaces.at(i).linkType == linkType) {
+            m_interfaces[i] = interface;
+            return i;
+        }
+    }
+    m_interfaces.append(interface);
+    return m_interfaces.size() - 1;
+}
+
+void QSerialBusFlightRecorderPrivate::removeInterface(int index)
+{
+    Interface &interface = m_interfaces[index];
+    QObject::disconnect(interface.errorConnection);
+    if (QCanBusDevice *canDevice = qobject_cast<QCanBusDevice *>(interface.device)) {
+        static_cast<QCanBusDevicePrivate *>(QObjectPrivate::get(canDevice))
+                ->flightRecorder.storeRelease(nullptr);
+    } else if (QModbusDevice *modbusDevice = qobject_cast<QModbusDevice *>(interface.device)) {
+        static_cast<QModbusDevicePrivate *>(QObjectPrivate::get(modbusDevice))
+                ->m_flightRecorder.storeRelease(nullptr);
+    }
+    // the entry stays, it still names the interface of recorded events
+    interface.device.clear();
+}
+
+void QSerialBusFlightRecorderPrivate::onDeviceError()
+{
+    Q_Q(QSerialBusFlightRecorder);
+    if (m_dumpsOnError)
+        q->dump();
+}
+
+static quint64 wallClockOffset()
+{
+    return quint64(QDateTime::currentMSecsSinceEpoch()) * 1000000 - monotonicTime();
+}
+
+bool QSerialBusFlightRecorderPrivate::writeBinary(QIODevice *device,
+                                                  const QVector<Event> &events) const
+{
+    QByteArray header("QSBFLREC");
+    const quint32 values[] = { 1, quint32(sizeof(Event)), quint32(m_interfaces.size()) };
+    header.append(reinterpret_cast<const char *>(values), sizeof(values));
+    for (const Interface &interface : m_interfaces) {
+        const QByteArray name = interface.name.toUtf8();
+        const quint16 description[] = { interface.linkType, quint16(name.size()) };
+        header.append(reinterpret_cast<const char *>(description), sizeof(description));
+        header.append(name);
+    }
+    const quint64 offset = wallClockOffset();
+    header.append(reinterpret_cast<const char *>(&offset), sizeof(offset));
+
+    if (device->write(header) != header.size())
+        return false;
+    const qint64 size = qint64(events.size()) * qint64(sizeof(Event));
+    return device->write(reinterpret_cast<const char *>(events.constData()), size) == size;
+}
+
+namespace {
+
+// Builds pcapng blocks in the byte order of the host, as the format allows.
+class PcapNgBlock
+{
+public:
+    explicit PcapNgBlock(quint32 type)
+    {
+        append32(type);
+        append32(0); // total length, set by finish()
+    }
+
+    void append16(quint16 value) { m_data.append(reinterpret_cast<const char *>(&value), 2); }
+    void append32(quint32 value) { m_data.append(reinterpret_cast<const char *>(&value), 4); }
+    void append64(quint64 value) { m_data.append(reinterpret_cast<const char *>(&value), 8); }
+
+    void appendPadded(const QByteArray &data)
+    {
+        m_data.append(data);
+        m_data.append(QByteArray((4 - data.size() % 4) % 4, 0));
+    }
+
+    void appendOption(quint16 code, const QByteArray &value)
+    {
+        append16(code);
+        append16(quint16(value.size()));
+        appendPadded(value);
+    }
+
+    QByteArray finish()
+    {
+        append16(0); // opt_endofopt
+        append16(0);
+        const quint32 length = quint32(m_data.size() + 4);
+        append32(length);
+        memcpy(m_data.data() + 4, &length, 4);
+        return m_data;
+    }
+
+private:
+    QByteArray m_data;
+};
+
+} // namespace
+
+// LINKTYPE_CAN_SOCKETCAN header: id with flags in network byte order,
+// payload length, CAN FD flags and two reserved bytes
+static QByteArray socketCanPacket(const QSerialBusFlightRecorderPrivate::Event &event)
+{
+    quint32 id = event.id & ((event.value & 0x100) ? 0x1fffffff : 0x7ff);
+    const quint8 frameType = quint8(event.value & 0xff);
+    if (event.value & 0x100)
+        id |= 0x80000000;
+    if (frameType == QCanBusFrame::RemoteRequestFrame)
+        id |= 0x40000000;
+    else if (frameType == QCanBusFrame::ErrorFrame)
+        id = 0x20000000 | (event.id & 0x1fffffff);
+
+    const int stored = qMin(int(event.length), int(QSerialBusFlightRecorderPrivate::DataSize));
+    QByteArray packet(8, 0);
+    qToBigEndian<quint32>(id, reinterpret_cast<uchar *>(packet.data()));
+    packet[4] = char(stored);
+    packet[5] = char((event.value & 0x200) ? 0x04 : 0); // CANFD_FDF
+    packet.append(event.data, stored);
+    return packet;
+}
+
+static QByteArray eventComment(const QSerialBusFlightRecorderPrivate::Event &event)
+{
+    const int stored = qMin(int(event.length), int(QSerialBusFlightRecorderPrivate::DataSize));
+    switch (event.type) {
+    case QSerialBusFlightRecorderPrivate::CanFrame:
+        return "CAN XL frame, priority " + QByteArray::number(event.id, 16) + ", "
+                + QByteArray::number(event.length) + " bytes: "
+                + QByteArray(event.data, stored).toHex();
+    case QSerialBusFlightRecorderPrivate::ModbusRetry:
+        return "Modbus retry, server " + QByteArray::number(event.id) + ", function code "
+                + QByteArray::number(event.value);
+    case QSerialBusFlightRecorderPrivate::ModbusTimeout:
+        return "Modbus timeout, server " + QByteArray::number(event.id) + ", function code "
+                + QByteArray::number(event.value);
+    case QSerialBusFlightRecorderPrivate::Error:
+        return "Error " + QByteArray::number(event.id) + ": " + QByteArray(event.data, stored);
+    case QSerialBusFlightRecorderPrivate::StateChange:
+        return "State changed to " + QByteArray::number(event.id);
+    default:
+        return QByteArray();
+    }
+}
+
+bool QSerialBusFlightRecorderPrivate::writePcapNg(QIODevice *device,
+                                                  const QVector<Event> &events) const
+{
+    QByteArray output;
+
+    PcapNgBlock section(0x0a0d0d0a);
+    section.append32(0x1a2b3c4d);
+    section.append16(1);
+    section.append16(0);
+    section.append64(~quint64(0)); // section length not specified
+    output.append(section.finish());
+
+    for (const Interface &interface : m_interfaces) {
+        PcapNgBlock description(0x00000001);
+        description.append16(interface.linkType);
+        description.append16(0);
+        description.append32(0); // no snapshot length limit
+        description.appendOption(2, interface.name.toUtf8());   // if_name
+        description.appendOption(9, QByteArray(1, 9));          // if_tsresol: nanoseconds
+        output.append(description.finish());
+    }
+
+    const quint64 offset = wallClockOffset();
+    for (const Event &event : events) {
+        QByteArray packet;
+        QByteArray comment;
+        const bool canXl = event.type == CanFrame && (event.value & 0x400);
+        if (event.type == CanFrame && !canXl) {
+            packet = socketCanPacket(event);
+        } else if (event.type == ModbusAdu) {
+            packet = QByteArray(event.data, qMin(int(event.length), int(DataSize)));
+        } else {
+            comment = eventComment(event);
+        }
+
+        const quint64 timestamp = event.timestamp + offset;
+        PcapNgBlock block(0x00000006);
+        block.append32(event.interface);
+        block.append32(quint32(timestamp >> 32));
+        block.append32(quint32(timestamp));
+        block.append32(quint32(packet.size()));
+        block.append32(quint32(packet.size() + (event.flags & Truncated
+                                                ? event.length - DataSize : 0)));
+        block.appendPadded(packet);
+        if (!comment.isEmpty())
+            block.appendOption(1, comment);                     // opt_comment
+        quint32 direction = (event.flags & Transmitted) ? 2 : 1;
+        block.appendOption(2, QByteArray(reinterpret_cast<const char *>(&direction), 4));
+        output.append(block.finish());
+    }
+
+    return device->write(output) == output.size();
+}
+
+void qt_serialbus_record_frame(QCanBusDevice *device, const QCanBusFrame &frame,
+                               bool transmitted)
+{
+    QCanBusDevicePrivate *d = static_cast<QCanBusDevicePrivate *>(QObjectPrivate::get(device));
+    if (QSerialBusFlightRecorderPrivate *recorder = d->flightRecorder.loadAcquire())
+        recorder->recordFrame(d->flightRecorderInterface, frame, transmitted);
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,145 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSERIALBUSFLIGHTRECORDER_P_H
+#define QSERIALBUSFLIGHTRECORDER_P_H
+
+#include <QtCore/qatomic.h>
+#include <QtCore/qpointer.h>
+#include <QtCore/qscopedpointer.h>
+#include <QtCore/qvector.h>
+#include <QtSerialBus/qserialbusflightrecorder.h>
+
+#include <private/qobject_p.h>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+class QCanBusFrame;
+
+class QSerialBusFlightRecorderPrivate : public QObjectPrivate
+{
+    Q_DECLARE_PUBLIC(QSerialBusFlightRecorder)
+
+public:
+    // The values are part of the binary dump format, never renumber them.
+    enum EventType : quint8 {
+        CanFrame = 1,       // id: frame id, value: frame flags, data: payload
+        ModbusAdu = 2,      // data: ADU as sent or received
+        ModbusRetry = 3,    // id: server address, value: function code
+        ModbusTimeout = 4,  // id: server address, value: function code
+        Error = 5,          // id: error, data: error string as UTF-8
+        StateChange = 6     // id: new state
+    };
+
+    enum EventFlag : quint8 {
+        Transmitted = 0x01,
+        Truncated = 0x02
+    };
+
+    enum { DataSize = 96 };
+
+    struct Event
+    {
+        quint64 timestamp;  // nanoseconds of the monotonic clock
+        quint16 interface;
+        quint8 type;
+        quint8 flags;
+        quint32 id;
+        quint32 value;
+        quint16 length;     // length of the data before truncation
+        quint16 reserved;
+        char data[DataSize];
+    };
+    Q_STATIC_ASSERT(sizeof(Event) == 120);
+
+    // A writer marks the slot odd while it fills it and even afterwards,
+    // derived from its position in the ring. Readers retry nothing: they
+    // drop a slot whose sequence changed while it was copied.
+    struct Slot
+    {
+        QAtomicInteger<quint64> sequence;
+        Event event;
+    };
+
+    struct Interface
+    {
+        QPointer<QObject> device;
+        quint16 linkType;
+        QString name;
+        QMetaObject::Connection errorConnection;
+    };
+
+    void record(quint16 interface, EventType type, quint8 flags, quint32 id, quint32 value,
+                const char *data = nullptr, int length = 0);
+    void recordFrame(quint16 interface, const QCanBusFrame &frame, bool transmitted);
+    QVector<Event> snapshot() const;
+
+    int addInterface(QObject *device, quint16 linkType);
+    void removeInterface(int index);
+    void onDeviceError();
+
+    bool writeBinary(QIODevice *device, const QVector<Event> &events) const;
+    bool writePcapNg(QIODevice *device, const QVector<Event> &events) const;
+
+    QScopedArrayPointer<Slot> m_slots;
+    quint64 m_capacity = 0;
+    QAtomicInteger<quint64> m_head;
+
+    QVector<Interface> m_interfaces;
+    QString m_dumpFileName;
+    QSerialBusFlightRecorder::Format m_dumpFormat = QSerialBusFlightRecorder::BinaryFormat;
+    bool m_dumpsOnError = false;
+};
+
+// Records a frame written by a CAN bus plugin if a recorder is attached to
+// the device. Received frames are recorded by QCanBusDevice itself.
+Q_SERIALBUS_EXPORT void qt_serialbus_record_frame(QCanBusDevice *device,
+                                                  const QCanBusFrame &frame, bool transmitted);
+
+QT_END_NAMESPACE
+
+#endif // QSERIALBUSFLIGHTRECORDER_P_H
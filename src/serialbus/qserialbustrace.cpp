@@ -0,0 +1,143 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qserialbustrace_p.h"
+#include "qcanbusframe.h"
+
+#include <QtCore/qfile.h>
+#include <QtCore/qmutex.h>
+
+#include <chrono>
+#include <stdio.h>
+
+QT_BEGIN_NAMESPACE
+
+/*
+    Static tracepoints on the CAN and Modbus hot paths.
+
+    Every tracepoint is a USDT probe of the provider "qtserialbus" when the
+    module is built with <sys/sdt.h> available, usable from perf, bpftrace,
+    SystemTap and LTTng (as userspace probes). Independent of that, the
+    built-in sink writes binary records to a file, started either with the
+    environment variable QT_SERIALBUS_TRACE_FILE or with start().
+
+    The file begins with the magic "QSBTRACE", followed by the format
+    version and the size of a record as quint32. All values, including the
+    records that follow, are in the byte order of the host; a reader
+    detects it from the version.
+*/
+
+namespace QSerialBusTrace {
+
+QBasicAtomicInt enabled = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+enum { FormatVersion = 1 };
+
+static QBasicMutex sinkGuard;
+static FILE *sinkFile = nullptr;
+
+static quint64 timestamp()
+{
+    using namespace std::chrono;
+    return quint64(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+void record(Event event, quint32 argument0, quint32 argument1, quint32 argument2)
+{
+    const Record record = { timestamp(), event, { argument0, argument1, argument2 } };
+
+    QMutexLocker locker(&sinkGuard);
+    if (sinkFile)
+        fwrite(&record, sizeof(record), 1, sinkFile);
+}
+
+/*
+    Returns the frame type in the lower 8 bits, followed by flags for the
+    extended frame format, CAN FD (a classic frame with more than 8 bytes of
+    payload) and CAN XL.
+*/
+quint32 frameFlags(const QCanBusFrame &frame)
+{
+    const bool canXl = frame.hasCanXlFormat();
+    return quint32(frame.frameType())
+            | (frame.hasExtendedFrameFormat() ? 0x100 : 0)
+            | (!canXl && frame.payload().size() > 8 ? 0x200 : 0)
+            | (canXl ? 0x400 : 0);
+}
+
+bool start(const QString &fileName)
+{
+    QMutexLocker locker(&sinkGuard);
+    if (sinkFile)
+        return false;
+
+    FILE *file = fopen(QFile::encodeName(fileName).constData(), "wb");
+    if (!file)
+        return false;
+
+    const quint32 header[] = { FormatVersion, quint32(sizeof(Record)) };
+    if (fwrite("QSBTRACE", 8, 1, file) != 1 || fwrite(header, sizeof(header), 1, file) != 1) {
+        fclose(file);
+        return false;
+    }
+
+    sinkFile = file;
+    enabled.store(1);
+    return true;
+}
+
+void stop()
+{
+    QMutexLocker locker(&sinkGuard);
+    enabled.store(0);
+    if (sinkFile) {
+        fclose(sinkFile);
+        sinkFile = nullptr;
+    }
+}
+
+static void startFromEnvironment()
+{
+    const QByteArray fileName = qgetenv("QT_SERIALBUS_TRACE_FILE");
+    if (!fileName.isEmpty())
+        start(QFile::decodeName(fileName));
+}
+Q_CONSTRUCTOR_FUNCTION(startFromEnvironment)
+Q_DESTRUCTOR_FUNCTION(stop)
+
+} // namespace QSerialBusTrace
+
+QT_END_NAMESPACE
@@ -0,0 +1,175 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSERIALBUSTRACE_P_H
+#define QSERIALBUSTRACE_P_H
+
+#include <QtCore/qatomic.h>
+#include <QtCore/qstring.h>
+#include <QtSerialBus/qserialbusglobal.h>
+
+#if defined(QT_SERIALBUS_TRACE_USDT)
+#  define _SDT_HAS_SEMAPHORES 1
+#  include <sys/sdt.h>
+#endif
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+class QCanBusFrame;
+
+namespace QSerialBusTrace {
+
+// The values are part of the binary trace format, never renumber them.
+enum Event : quint32 {
+    CanFrameReceived = 1,       // frame id, frame flags, payload size
+    CanFrameWritten = 2,        // frame id, frame flags, payload size
+    CanFramesEnqueued = 3,      // frames added, frames now queued, queue
+    CanFramesDequeued = 4,      // frames taken, frames still queued, queue
+    CanFrameFiltered = 5,       // frame id, frame flags, payload size
+    ModbusRequestSent = 6,      // server address, function code, transaction id
+    ModbusResponseReceived = 7, // server address, function code, transaction id
+    ModbusRetry = 8,            // server address, function code, retries left
+    ModbusTimeout = 9,          // server address, function code, transaction id
+    ModbusServerRequestStarted = 10,    // server address, function code, 0
+    ModbusServerRequestFinished = 11    // server address, function code, exception code
+};
+
+enum Queue : quint32 {
+    ReceiveQueue = 0,
+    TransmitQueue = 1
+};
+
+struct Record
+{
+    quint64 timestamp;  // nanoseconds of the monotonic clock
+    quint32 event;
+    quint32 arguments[3];
+};
+Q_STATIC_ASSERT(sizeof(Record) == 24);
+
+Q_SERIALBUS_EXPORT extern QBasicAtomicInt enabled;
+
+inline bool isEnabled()
+{
+    return Q_UNLIKELY(enabled.load());
+}
+
+Q_SERIALBUS_EXPORT void record(Event event, quint32 argument0, quint32 argument1,
+                               quint32 argument2);
+Q_SERIALBUS_EXPORT quint32 frameFlags(const QCanBusFrame &frame);
+
+Q_SERIALBUS_EXPORT bool start(const QString &fileName);
+Q_SERIALBUS_EXPORT void stop();
+
+} // namespace QSerialBusTrace
+
+QT_END_NAMESPACE
+
+/*
+    Every USDT probe has a semaphore, which tracers such as bpftrace and
+    SystemTap raise while they are attached to it. The probe and the
+    evaluation of its arguments are skipped as long as it is zero. Each
+    translation unit gets its own copy, referenced by the probes of that unit
+    only; the names must not be mangled, hence the global namespace.
+*/
+#if defined(QT_SERIALBUS_TRACE_USDT)
+#  define Q_SERIALBUS_TRACE_SEMAPHORE(event) qtserialbus_##event##_semaphore
+#  define Q_SERIALBUS_TRACE_DEFINE_SEMAPHORE(event) \
+    static volatile unsigned short Q_SERIALBUS_TRACE_SEMAPHORE(event) \
+        __attribute__((unused, section(".probes"))) = 0
+
+Q_SERIALBUS_TRACE_DEFINE_SEMAPHORE(CanFrameReceived);
+Q_SERIALBUS_TRACE_DEFINE_SEMAPHORE(CanFrameWritten);
+Q_SERIALBUS_TRACE_DEFINE_SEMAPHORE(CanFramesEnqueued);
+Q_SERIALBUS_TRACE_DEFINE_SEMAPHORE(CanFramesDequeued);
+Q_SERIALBUS_TRACE_DEFINE_SEMAPHORE(CanFrameFiltered);
+Q_SERIALBUS_TRACE_DEFINE_SEMAPHORE(ModbusRequestSent);
+Q_SERIALBUS_TRACE_DEFINE_SEMAPHORE(ModbusResponseReceived);
+Q_SERIALBUS_TRACE_DEFINE_SEMAPHORE(ModbusRetry);
+Q_SERIALBUS_TRACE_DEFINE_SEMAPHORE(ModbusTimeout);
+Q_SERIALBUS_TRACE_DEFINE_SEMAPHORE(ModbusServerRequestStarted);
+Q_SERIALBUS_TRACE_DEFINE_SEMAPHORE(ModbusServerRequestFinished);
+
+#  define Q_SERIALBUS_TRACE_PROBE_ENABLED(event) Q_UNLIKELY(Q_SERIALBUS_TRACE_SEMAPHORE(event))
+#  define Q_SERIALBUS_TRACE_PROBE(event, a0, a1, a2) \
+    do { \
+        if (Q_SERIALBUS_TRACE_PROBE_ENABLED(event)) \
+            DTRACE_PROBE3(qtserialbus, event, quint32(a0), quint32(a1), quint32(a2)); \
+    } while (false)
+#else
+#  define Q_SERIALBUS_TRACE_PROBE_ENABLED(event) false
+#  define Q_SERIALBUS_TRACE_PROBE(event, a0, a1, a2) do { } while (false)
+#endif
+
+QT_BEGIN_NAMESPACE
+
+/*
+    Emits the tracepoint \a event with three integer arguments. While neither
+    a tracer is attached to the USDT probe nor the built-in sink is started,
+    this costs a load and a branch for each of them, and the arguments are
+    not evaluated. Once enabled, arguments are evaluated for each consumer,
+    so keep them cheap.
+*/
+#define Q_SERIALBUS_TRACE(event, a0, a1, a2) \
+    do { \
+        Q_SERIALBUS_TRACE_PROBE(event, a0, a1, a2); \
+        if (QSerialBusTrace::isEnabled()) \
+            QSerialBusTrace::record(QSerialBusTrace::event, quint32(a0), quint32(a1), \
+                                    quint32(a2)); \
+    } while (false)
+
+#define Q_SERIALBUS_TRACE_FRAME(event, frame) \
+    Q_SERIALBUS_TRACE(event, (frame).frameId(), QSerialBusTrace::frameFlags(frame), \
+                      (frame).payload().size())
+
+// True if the tracepoint \a event is consumed at all, to skip loops around it.
+#define Q_SERIALBUS_TRACE_ENABLED(event) \
+    (QSerialBusTrace::isEnabled() || Q_SERIALBUS_TRACE_PROBE_ENABLED(event))
+
+QT_END_NAMESPACE
+
+#endif // QSERIALBUSTRACE_P_H
@@ -8,52 +8,84 @@ QMAKE_DOCS = $$PWD/doc/qtserialbus.qdocconf
 
 PUBLIC_HEADERS += \
     qcanbusdevice.h \
+    qcanbuse2echecker.h \
     qcanbusfactory.h \
     qcanbusframe.h \
     qcanbus.h \
+    qcanopensdoclient.h \
+    qcanopensdoreply.h \
     qserialbusglobal.h \
     qmodbusserver.h \
     qmodbusdevice.h \
     qmodbusdataunit.h \
     qmodbusclient.h \
+    qmodbuschangefilter.h \
     qmodbusreply.h \
     qmodbusrtuserialmaster.h \
     qmodbustcpclient.h \
     qmodbustcpserver.h \
     qmodbusrtuserialslave.h \
-    qmodbuspdu.h
+    qmodbusrtutcpclient.h \
+    qmodbusrtutcpserver.h \
+    qmodbuspdu.h \
+    qserialbuscoroutine.h \
+    qserialbusflightrecorder.h
 
 PRIVATE_HEADERS += \
     qcanbusdevice_p.h \
+    qcanbuse2echecker_p.h \
+    qcanbustimestampnormalizer_p.h \
+    qcanopensdoclient_p.h \
+    qcanopensdoreply_p.h \
     qmodbusserver_p.h \
     qmodbusclient_p.h \
+    qmodbuschangefilter_p.h \
     qmodbusdevice_p.h \
     qmodbusrtuserialmaster_p.h \
     qmodbustcpclient_p.h \
     qmodbustcpserver_p.h \
     qmodbusrtuserialslave_p.h \
+    qmodbusrtutcpclient_p.h \
+    qmodbusrtutcpserver_p.h \
     qmodbus_symbols_p.h \
     qmodbuscommevent_p.h \
-    qmodbusadu_p.h
+    qmodbusadu_p.h \
+    qmodbustransport_p.h \
+    qmpscqueue_p.h \
+    qserialbustrace_p.h \
+    qserialbusflightrecorder_p.h
 
 SOURCES += \
     qcanbusdevice.cpp \
+    qcanbuse2echecker.cpp \
     qcanbus.cpp \
     qcanbusfactory.cpp \
     qcanbusframe.cpp \
+    qcanbustimestampnormalizer.cpp \
+    qcanopensdoclient.cpp \
+    qcanopensdoreply.cpp \
     qmodbusserver.cpp \
     qmodbusdevice.cpp \
     qmodbusdataunit.cpp \
     qmodbusclient.cpp \
+    qmodbuschangefilter.cpp \
     qmodbusreply.cpp \
     qmodbusrtuserialmaster.cpp \
     qmodbustcpclient.cpp \
     qmodbustcpserver.cpp \
     qmodbusrtuserialslave.cpp \
-    qmodbuspdu.cpp
+    qmodbusrtutcpclient.cpp \
+    qmodbusrtutcpserver.cpp \
+    qmodbuspdu.cpp \
+    qmodbustransport.cpp \
+    qserialbustrace.cpp \
+    qserialbusflightrecorder.cpp
 
 HEADERS += $$PUBLIC_HEADERS $$PRIVATE_HEADERS
 
+# USDT probes for perf, bpftrace, SystemTap and LTTng
+config_sdt: DEFINES += QT_SERIALBUS_TRACE_USDT
+
 MODULE_PLUGIN_TYPES = \
     canbus
 load(qt_module)
@@ -0,0 +1,323 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the QtSerialBus module.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "bridgetask.h"
+
+#include <chrono>
+#include <limits>
+
+// Frames are dropped instead of queued once the target has this many frames pending.
+static const qint64 MAXIMUMBACKLOG = 1024;
+// Distinct frame ids whose verdict is cached before the cache is flushed.
+static const int MAXIMUMCACHEDVERDICTS = 65536;
+// Receive timestamps further away from the wall clock are not used for latency.
+static const qint64 MAXIMUMCLOCKOFFSETUS = 10 * 1000 * 1000;
+
+static qint64 wallClockUs()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+static bool parseIdAndMask(const QString &field, quint32 &id, quint32 &mask)
+{
+    bool ok = true;
+    const int slash = field.indexOf(QLatin1Char('/'));
+    id = field.left(slash).toUInt(&ok, 16);
+    if (!ok || id > 0x1FFFFFFF)
+        return false;
+
+    mask = 0x1FFFFFFF;
+    if (slash >= 0) {
+        mask = field.mid(slash + 1).toUInt(&ok, 16);
+        if (!ok || mask > 0x1FFFFFFF)
+            return false;
+    }
+    return true;
+}
+
+BridgeTask::BridgeTask(QTextStream &output, QObject *parent)
+    : QObject(parent),
+      output(output)
+{
+    reportTimer.setInterval(1000);
+    connect(&reportTimer, &QTimer::timeout, this, &BridgeTask::report);
+}
+
+/*
+    Parses a rule of the form [ab:|ba:]<kind>:<id>[/<mask>][...], see
+    CanBusUtil::printUsage(). Rules without a direction apply to both.
+*/
+bool BridgeTask::addRule(const QString &rule)
+{
+    QString text = rule;
+    bool useDirection[2] = { true, true };
+    if (text.startsWith(QLatin1String("ab:"))) {
+        useDirection[1] = false;
+        text = text.mid(3);
+    } else if (text.startsWith(QLatin1String("ba:"))) {
+        useDirection[0] = false;
+        text = text.mid(3);
+    }
+
+    const int colon = text.indexOf(QLatin1Char(':'));
+    if (colon < 0)
+        return false;
+    const QString kind = text.left(colon);
+    QString arguments = text.mid(colon + 1);
+
+    Rule compiled;
+    compiled.newId = 0;
+    compiled.byteIndex = 0;
+    compiled.byteValue = 0;
+
+    bool ok = true;
+    if (kind == QLatin1String("pass") || kind == QLatin1String("drop")) {
+        compiled.action = (kind == QLatin1String("pass")) ? Rule::Pass : Rule::Drop;
+    } else if (kind == QLatin1String("id")) {
+        const int equals = arguments.indexOf(QLatin1Char('='));
+        if (equals < 0)
+            return false;
+        compiled.action = Rule::RewriteId;
+        compiled.newId = arguments.mid(equals + 1).toUInt(&ok, 16);
+        if (!ok || compiled.newId > 0x1FFFFFFF)
+            return false;
+        arguments = arguments.left(equals);
+    } else if (kind == QLatin1String("byte")) {
+        const int at = arguments.indexOf(QLatin1Char('@'));
+        const int equals = arguments.indexOf(QLatin1Char('='));
+        if (at < 0 || equals < at)
+            return false;
+        compiled.action = Rule::RewriteByte;
+        compiled.byteIndex = arguments.mid(at + 1, equals - at - 1).toInt(&ok);
+        if (!ok || compiled.byteIndex < 0 || compiled.byteIndex >= 2048)
+            return false;
+        const uint value = arguments.mid(equals + 1).toUInt(&ok, 16);
+        if (!ok || value > 0xFF)
+            return false;
+        compiled.byteValue = quint8(value);
+        arguments = arguments.left(at);
+    } else {
+        return false;
+    }
+
+    if (!parseIdAndMask(arguments, compiled.id, compiled.mask))
+        return false;
+
+    for (int i = 0; i < 2; ++i) {
+        if (!useDirection[i])
+            continue;
+        directions[i].rules.append(compiled);
+        if (compiled.action == Rule::Pass)
+            directions[i].hasPassRules = true;
+    }
+    return true;
+}
+
+void BridgeTask::start(QCanBusDevice *a, QCanBusDevice *b)
+{
+    directions[0].name = QStringLiteral("a->b");
+    directions[0].from = a;
+    directions[0].to = b;
+    directions[1].name = QStringLiteral("b->a");
+    directions[1].from = b;
+    directions[1].to = a;
+
+    connect(a, &QCanBusDevice::framesReceived, this, [this]() { forward(directions[0]); });
+    connect(b, &QCanBusDevice::framesReceived, this, [this]() { forward(directions[1]); });
+
+    intervalClock.start();
+    totalClock.start();
+    reportTimer.start();
+}
+
+/*
+    The rules only depend on the frame id, so they are evaluated once per id.
+    Every further frame with the same id costs a single hash lookup.
+*/
+const BridgeTask::Verdict &BridgeTask::verdict(Direction &direction, const QCanBusFrame &frame)
+{
+    const quint32 key = frame.frameId() | (frame.hasExtendedFrameFormat() ? 0x80000000 : 0);
+    QHash<quint32, Verdict>::const_iterator it = direction.verdicts.constFind(key);
+    if (it != direction.verdicts.constEnd())
+        return it.value();
+
+    if (direction.verdicts.size() >= MAXIMUMCACHEDVERDICTS)
+        direction.verdicts.clear();
+
+    Verdict result;
+    const quint32 frameId = frame.frameId();
+    result.forward = !direction.hasPassRules;
+    result.id = frameId;
+
+    foreach (const Rule &rule, direction.rules) {
+        if (!rule.matches(frameId))
+            continue;
+        switch (rule.action) {
+        case Rule::Pass:
+            result.forward = true;
+            break;
+        case Rule::Drop:
+            result.forward = false;
+            break;
+        case Rule::RewriteId:
+            result.id = (result.id & ~rule.mask) | (rule.newId & rule.mask);
+            break;
+        case Rule::RewriteByte:
+            result.bytes.append(qMakePair(rule.byteIndex, rule.byteValue));
+            break;
+        }
+        // a matching drop rule always wins over pass rules
+        if (rule.action == Rule::Drop)
+            break;
+    }
+
+    return *direction.verdicts.insert(key, result);
+}
+
+void BridgeTask::forward(Direction &direction)
+{
+    const QVector<QCanBusFrame> frames = direction.from->readAllFrames();
+    if (frames.isEmpty())
+        return;
+
+    Statistics batch;
+    batch.received = frames.size();
+
+    const bool targetConnected = direction.to->state() == QCanBusDevice::ConnectedState;
+    const qint64 receivedAt = wallClockUs();
+    qint64 oldestStamp = std::numeric_limits<qint64>::max();
+    qint64 stampSum = 0;
+
+    for (const QCanBusFrame &frame : frames) {
+        // error frames describe the local bus and are never forwarded
+        if (frame.frameType() == QCanBusFrame::ErrorFrame) {
+            ++batch.filtered;
+            continue;
+        }
+
+        const Verdict &result = verdict(direction, frame);
+        if (!result.forward) {
+            ++batch.filtered;
+            continue;
+        }
+
+        if (!targetConnected || direction.to->framesToWrite() >= MAXIMUMBACKLOG) {
+            ++batch.dropped;
+            continue;
+        }
+
+        QCanBusFrame out = frame;
+        if (result.id != frame.frameId())
+            out.setFrameId(result.id);
+        if (!result.bytes.isEmpty()) {
+            QByteArray payload = out.payload();
+            for (const QPair<int, quint8> &byte : result.bytes) {
+                if (byte.first < payload.size())
+                    payload[byte.first] = char(byte.second);
+            }
+            out.setPayload(payload);
+        }
+
+        if (!direction.to->writeFrame(out)) {
+            ++batch.dropped;
+            continue;
+        }
+        ++batch.forwarded;
+
+        // Only backends with wall clock receive timestamps allow a latency measurement.
+        const QCanBusFrame::TimeStamp stamp = frame.timeStamp();
+        const qint64 stampUs = stamp.seconds() * 1000000 + stamp.microSeconds();
+        if (stampUs > 0 && qAbs(receivedAt - stampUs) < MAXIMUMCLOCKOFFSETUS) {
+            stampSum += stampUs;
+            oldestStamp = qMin(oldestStamp, stampUs);
+            ++batch.latencyCount;
+        }
+    }
+
+    // The whole batch is written before the clock is sampled, so the
+    // measured latency includes the time spent on the frames before.
+    if (batch.latencyCount) {
+        const qint64 writtenAt = wallClockUs();
+        batch.latencySum = batch.latencyCount * writtenAt - stampSum;
+        batch.latencyMax = writtenAt - oldestStamp;
+    }
+
+    Statistics *targets[] = { &direction.total, &direction.interval };
+    for (Statistics *target : targets) {
+        target->received += batch.received;
+        target->forwarded += batch.forwarded;
+        target->filtered += batch.filtered;
+        target->dropped += batch.dropped;
+        target->latencySum += batch.latencySum;
+        target->latencyCount += batch.latencyCount;
+        target->latencyMax = qMax(target->latencyMax, batch.latencyMax);
+    }
+}
+
+void BridgeTask::printStatistics(const Direction &direction, const Statistics &statistics,
+                                 qint64 elapsedMs)
+{
+    const double seconds = qMax<qint64>(elapsedMs, 1) / 1000.;
+    output << direction.name << ": rx "
+           << qRound64(statistics.received / seconds) << "/s, fwd "
+           << qRound64(statistics.forwarded / seconds) << "/s, filtered "
+           << statistics.filtered << ", dropped " << statistics.dropped;
+    if (statistics.latencyCount) {
+        output << ", latency avg " << statistics.latencySum / statistics.latencyCount
+               << " us max " << statistics.latencyMax << " us";
+    }
+    output << endl;
+}
+
+void BridgeTask::report()
+{
+    const qint64 elapsed = intervalClock.restart();
+    for (Direction &direction : directions) {
+        printStatistics(direction, direction.interval, elapsed);
+        direction.interval = Statistics();
+    }
+}
+
+void BridgeTask::printTotals()
+{
+    if (!totalClock.isValid())
+        return;
+
+    output << "Total:" << endl;
+    for (const Direction &direction : directions)
+        printStatistics(direction, direction.total, totalClock.elapsed());
+}
@@ -0,0 +1,113 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the QtSerialBus module.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef BRIDGETASK_H
+#define BRIDGETASK_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QTextStream>
+#include <QTimer>
+#include <QVector>
+#include <QtSerialBus>
+
+class BridgeTask : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BridgeTask(QTextStream &output, QObject *parent = nullptr);
+
+    bool addRule(const QString &rule);
+    void start(QCanBusDevice *a, QCanBusDevice *b);
+    void printTotals();
+
+private:
+    struct Rule {
+        enum Action { Pass, Drop, RewriteId, RewriteByte };
+
+        Action action;
+        quint32 id;
+        quint32 mask;
+        quint32 newId;
+        int byteIndex;
+        quint8 byteValue;
+
+        bool matches(quint32 frameId) const { return (frameId & mask) == (id & mask); }
+    };
+
+    // Result of all rules for one frame id, computed once and cached.
+    struct Verdict {
+        bool forward = true;
+        quint32 id = 0;
+        QVector<QPair<int, quint8>> bytes;
+    };
+
+    struct Statistics {
+        qint64 received = 0;
+        qint64 forwarded = 0;
+        qint64 filtered = 0;
+        qint64 dropped = 0;
+        qint64 latencySum = 0;
+        qint64 latencyCount = 0;
+        qint64 latencyMax = 0;
+    };
+
+    struct Direction {
+        QString name;
+        QCanBusDevice *from = nullptr;
+        QCanBusDevice *to = nullptr;
+        QVector<Rule> rules;
+        bool hasPassRules = false;
+        QHash<quint32, Verdict> verdicts;
+        Statistics total;
+        Statistics interval;
+    };
+
+    void forward(Direction &direction);
+    const Verdict &verdict(Direction &direction, const QCanBusFrame &frame);
+    void report();
+    void printStatistics(const Direction &direction, const Statistics &statistics,
+                         qint64 elapsedMs);
+
+    QTextStream &output;
+    Direction directions[2];
+    QTimer reportTimer;
+    QElapsedTimer intervalClock;
+    QElapsedTimer totalClock;
+};
+
+#endif // BRIDGETASK_H
@@ -36,15 +36,17 @@
 
 #include "canbusutil.h"
 
-static const qint8 MAXNORMALPAYLOADSIZE = 8;
-static const qint8 MAXEXTENDEDPAYLOADSIZE = 64;
+static const qint32 MAXNORMALPAYLOADSIZE = 8;
+static const qint32 MAXEXTENDEDPAYLOADSIZE = 64;
+static const qint32 MAXXLPAYLOADSIZE = 2048;
 
 CanBusUtil::CanBusUtil(QTextStream &output, QCoreApplication &app, QObject *parent)
   : QObject(parent),
     canBus(QCanBus::instance()),
     output(output),
     app(app),
-    readTask(new ReadTask(output, this))
+    readTask(new ReadTask(output, this)),
+    bridgeTask(new BridgeTask(output, this))
 {
 }
 
@@ -61,7 +63,20 @@ bool CanBusUtil::start(int argc, char *argv[])
     if (!connectCanDevice())
         return false;
 
-    if (listening) {
+    if (bridging) {
+        foreach (const QString &rule, bridgeRules) {
+            if (!bridgeTask->addRule(rule)) {
+                output << "Invalid bridge rule: " << rule << endl;
+                printUsage();
+                return false;
+            }
+        }
+        bridgeDevice.reset(createCanDevice(bridgePluginName, bridgeDeviceName));
+        if (!bridgeDevice)
+            return false;
+        bridgeTask->start(canDevice.data(), bridgeDevice.data());
+        connect(&app, &QCoreApplication::aboutToQuit, bridgeTask, &BridgeTask::printTotals);
+    } else if (listening) {
         connect(canDevice.data(), &QCanBusDevice::framesReceived, readTask, &ReadTask::checkMessages);
     } else {
         if (!sendData())
@@ -75,7 +90,9 @@ bool CanBusUtil::start(int argc, char *argv[])
 void CanBusUtil::printUsage()
 {
     output << "Usage: canbusutil [options] <plugin> <device> [data]" << endl
+           << "       canbusutil -b <plugin> <device> <plugin> <device> [rule...]" << endl
            << "-l             start listening CAN data on device" << endl
+           << "-b             bridge frames between two devices a and b in both directions" << endl
            << "--list-plugins lists all available plugins" << endl
            << "<plugin>       plugin name to use. See --list-plugins." << endl
            << "<device>       device to use" << endl
@@ -83,8 +100,17 @@ void CanBusUtil::printUsage()
            << "                   <id>#{payload}   (CAN 2.0 data frames)," << endl
            << "                   <id>#Rxx         (CAN 2.0 RTR frames with xx bytes data length)," << endl
            << "                   <id>##{payload}  (CAN FD data frames)," << endl
-           << "               where {payload} has 0..8 (0..64 CAN FD) ASCII hex-value pairs," << endl
-           << "               e.g. 1#1a2b3c" << endl;
+           << "                   <id>###{payload} (CAN XL data frames, <id> is the priority)," << endl
+           << "               where {payload} has 0..8 (0..64 CAN FD, 1..2048 CAN XL)" << endl
+           << "               ASCII hex-value pairs," << endl
+           << "               e.g. 1#1a2b3c" << endl
+           << "[rule]         Bridge rule, applied to both directions unless prefixed" << endl
+           << "               with ab: or ba:. All numbers are hex. Format:" << endl
+           << "                   pass:<id>[/<mask>]        (forward only matching frames)," << endl
+           << "                   drop:<id>[/<mask>]        (never forward matching frames)," << endl
+           << "                   id:<id>[/<mask>]=<newid>  (replace the masked id bits)," << endl
+           << "                   byte:<id>[/<mask>]@<n>=<xx> (set payload byte n, decimal)," << endl
+           << "               e.g. ab:pass:100/700 ab:id:123=323 ba:drop:7ff" << endl;
 }
 
 void CanBusUtil::printPlugins()
@@ -101,7 +127,8 @@ void CanBusUtil::printDataUsage()
            << "    <id>#{payload}   (CAN 2.0 data frames)," << endl
            << "    <id>#Rxx         (CAN 2.0 RTR frames with xx bytes data length)," << endl
            << "    <id>##{payload}  (CAN FD data frames)," << endl
-           << "{payload} has 0..8 (0..64 CAN FD) ASCII hex-value pairs" << endl;
+           << "    <id>###{payload} (CAN XL data frames, <id> is the priority)," << endl
+           << "{payload} has 0..8 (0..64 CAN FD, 1..2048 CAN XL) ASCII hex-value pairs" << endl;
 }
 
 
@@ -114,6 +141,22 @@ bool CanBusUtil::parseArgs(int argc, char *argv[])
         return false;
     }
 
+    bridging = arg1 == QStringLiteral("-b");
+    if (bridging) {
+        if (argc < 6) {
+            printUsage();
+            return false;
+        }
+        listening = false;
+        pluginName = QString(argv[2]);
+        deviceName = QString(argv[3]);
+        bridgePluginName = QString(argv[4]);
+        bridgeDeviceName = QString(argv[5]);
+        for (int i = 6; i < argc; ++i)
+            bridgeRules.append(QString(argv[i]));
+        return true;
+    }
+
     if (argc != 4) {
         printUsage();
         return false;
@@ -147,9 +190,10 @@ bool CanBusUtil::parseDataField(qint32 &id, QString &payload)
 }
 
 bool CanBusUtil::parsePayloadField(QString payload, bool &rtrFrame,
-                                   bool &fdFrame, QByteArray &bytes)
+                                   bool &fdFrame, bool &xlFrame, QByteArray &bytes)
 {
     fdFrame = false;
+    xlFrame = false;
     rtrFrame = false;
 
      if (payload.size() == 0)
@@ -178,6 +222,9 @@ bool CanBusUtil::parsePayloadField(QString payload, bool &rtrFrame,
         }
 
         return validPayloadLength;
+    } else if (payload.startsWith(QLatin1String("##"))) {
+        xlFrame = true;
+        payload = payload.mid(2);
     } else if (payload[0] == '#') {
         fdFrame = true;
         payload = payload.mid(1);
@@ -203,8 +250,9 @@ bool CanBusUtil::parsePayloadField(QString payload, bool &rtrFrame,
             quint8 byte = (high << 4) | (low);
             bytes.append(byte);
         }
-        qint8 size = bytes.size();
-        qint8 maxsize = fdFrame ? MAXEXTENDEDPAYLOADSIZE : MAXNORMALPAYLOADSIZE;
+        qint32 size = bytes.size();
+        qint32 maxsize = xlFrame ? MAXXLPAYLOADSIZE
+                                 : (fdFrame ? MAXEXTENDEDPAYLOADSIZE : MAXNORMALPAYLOADSIZE);
         if (size > maxsize) {
             output << "Warning! payload size too great. Size: " << size << ", max allowed size in frame: " << maxsize << endl
                    << "Clipping payload to fit frame..." << endl;
@@ -221,31 +269,29 @@ bool CanBusUtil::parsePayloadField(QString payload, bool &rtrFrame,
 
 bool CanBusUtil::connectCanDevice()
 {
-    bool foundPlugin = false;
-    QList<QByteArray> plugins = canBus->plugins();
-    for (int i = 0; i < plugins.size(); i++)
-    {
-        if (plugins.at(i) == pluginName) {
-            canDevice.reset(canBus->createDevice(plugins.at(i), deviceName));
-            if (!canDevice) {
-                output << "Unable to create QCanBusDevice with device name: " << deviceName << endl;
-                return false;
-            }
-            connect(canDevice.data(), &QCanBusDevice::errorOccurred, readTask, &ReadTask::receiveError);
-            if (!canDevice->connectDevice()) {
-                output << "Unable to connect QCanBusDevice with device name: " << deviceName << endl;
-                return false;
-            }
-            foundPlugin = true;
-        }
-    }
+    canDevice.reset(createCanDevice(pluginName, deviceName));
+    return !canDevice.isNull();
+}
 
-    if (!foundPlugin) {
+QCanBusDevice *CanBusUtil::createCanDevice(const QString &plugin, const QString &device)
+{
+    if (!canBus->plugins().contains(plugin.toLatin1())) {
         output << "Could not find suitable plugin." << endl;
         printPlugins();
-        return false;
+        return nullptr;
     }
-    return true;
+
+    QScopedPointer<QCanBusDevice> canBusDevice(canBus->createDevice(plugin.toLatin1(), device));
+    if (!canBusDevice) {
+        output << "Unable to create QCanBusDevice with device name: " << device << endl;
+        return nullptr;
+    }
+    connect(canBusDevice.data(), &QCanBusDevice::errorOccurred, readTask, &ReadTask::receiveError);
+    if (!canBusDevice->connectDevice()) {
+        output << "Unable to connect QCanBusDevice with device name: " << device << endl;
+        return nullptr;
+    }
+    return canBusDevice.take();
 }
 
 bool CanBusUtil::sendData()
@@ -254,15 +300,21 @@ bool CanBusUtil::sendData()
     QString payload;
     bool rtrFrame;
     bool fdFrame;
+    bool xlFrame;
     QByteArray bytes;
     QCanBusFrame frame;
 
     if (parseDataField(id, payload) == false)
         return false;
 
-    if (parsePayloadField(payload, rtrFrame, fdFrame, bytes) == false)
+    if (parsePayloadField(payload, rtrFrame, fdFrame, xlFrame, bytes) == false)
         return false;
 
+    if (xlFrame && (id < 0 || id > 0x7FF)) { // 11 bit priority
+        id = 0x7FF;
+        output << "Warning! Priority does not fit into 11 bits, setting it to: " << id << endl;
+    }
+
     if (id < 0 || id > 0x1FFFFFFF) { // 29 bits
         id = 0x1FFFFFFF;
         output << "Warning! Id does not fit into Extended Frame Format, setting id to: " << id << endl;
@@ -273,9 +325,12 @@ bool CanBusUtil::sendData()
 
     frame.setPayload(bytes);
     frame.setFrameId(id);
+    frame.setCanXlFormat(xlFrame);
 
     if (fdFrame)
         canDevice->setConfigurationParameter(QCanBusDevice::CanFdKey, true);
+    if (xlFrame)
+        canDevice->setConfigurationParameter(QCanBusDevice::CanXlKey, true);
 
     return canDevice->writeFrame(frame);
 }
@@ -42,6 +42,7 @@
 #include <QCoreApplication>
 #include <QScopedPointer>
 
+#include "bridgetask.h"
 #include "readtask.h"
 
 class CanBusUtil : public QObject
@@ -58,8 +59,10 @@ private:
     void printDataUsage();
     bool parseArgs(int argc, char *argv[]);
     bool parseDataField(qint32 &id, QString &payload);
-    bool parsePayloadField(QString payload, bool &rtrFrame, bool &fdFrame, QByteArray &bytes);
+    bool parsePayloadField(QString payload, bool &rtrFrame, bool &fdFrame, bool &xlFrame,
+                           QByteArray &bytes);
     bool connectCanDevice();
+    QCanBusDevice *createCanDevice(const QString &plugin, const QString &device);
     bool startListeningOnCanDevice();
     bool sendData();
 
@@ -68,11 +71,17 @@ private:
     QTextStream &output;
     QCoreApplication &app;
     bool listening;
+    bool bridging;
     QString pluginName;
     QString deviceName;
+    QString bridgePluginName;
+    QString bridgeDeviceName;
+    QStringList bridgeRules;
     QString data;
     QScopedPointer<QCanBusDevice> canDevice;
+    QScopedPointer<QCanBusDevice> bridgeDevice;
     ReadTask *readTask;
+    BridgeTask *bridgeTask;
 };
 
 #endif // CANBUSUTIL_H
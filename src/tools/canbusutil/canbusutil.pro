@@ -2,11 +2,13 @@ QT = core serialbus
 
 SOURCES += main.cpp \
     readtask.cpp \
+    bridgetask.cpp \
     canbusutil.cpp \
     sigtermhandler.cpp
 
 HEADERS += \
     readtask.h \
+    bridgetask.h \
     canbusutil.h \
     sigtermhandler.h
 
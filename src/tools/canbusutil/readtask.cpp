@@ -52,11 +52,24 @@ void ReadTask::checkMessages() {
     const QCanBusFrame frame = canDevice->readFrame();
 
     const qint32 id = frame.frameId();
-    const qint8 dataLength = frame.payload().size();
+    const qint32 dataLength = frame.payload().size();
 
     QString view;
     if (frame.frameType() == QCanBusFrame::ErrorFrame) {
         view = canDevice->interpretErrorFrame(frame);
+    } else if (frame.hasCanXlFormat()) {
+        view += QString::asprintf("Prio:    %03X SDT: %02X AF: %08X%s",
+                                  static_cast<uint>(id), frame.serviceDataUnitType(),
+                                  frame.acceptanceField(),
+                                  frame.hasSimpleExtendedContent() ? " SEC" : "");
+        view += QLatin1String(" bytes: ");
+        view += QString::number(dataLength, 10);
+        view += QLatin1String(" data:");
+        const QByteArray array = frame.payload();
+        for (int i = 0; i < array.size(); i++) {
+            view += QLatin1String(" 0x");
+            view += QString::number(quint8(array[i]), 16);
+        }
     } else {
         const char *format =
                 frame.hasExtendedFrameFormat() ? "Id: %08X" : "Id:      %03X";
@@ -78,6 +91,8 @@ void ReadTask::checkMessages() {
         output << "RTR: " << view << endl;
     } else if (frame.frameType() == QCanBusFrame::ErrorFrame) {
         output << "ERR: " << view << endl;
+    } else if (frame.hasCanXlFormat()) {
+        output << "XL: " << view << endl;
     } else {
         output << view << endl;
     }
@@ -3,14 +3,26 @@ SUBDIRS += cmake \
            qcanbusframe \
            qcanbus \
            qcanbusdevice \
+           qcanbuse2echecker \
+           qcanbustimestampnormalizer \
+           qcanopensdoclient \
            qmodbusdataunit \
            qmodbusreply \
            qmodbusdevice \
            qmodbuspdu \
            qmodbusclient \
+           qmodbuschangefilter \
            qmodbusserver \
            qmodbuscommevent \
-           qmodbusadu
+           qmodbusadu \
+           qmodbustransport \
+           qmodbusrtutcp \
+           qmodbustcpserver \
+           qserialbustrace \
+           qserialbusflightrecorder \
+           qserialbuscoroutine
+
+unix: SUBDIRS += slcanbackend
 
 qcanbus.depends += plugins
 qcanbusdevice.depends += plugins
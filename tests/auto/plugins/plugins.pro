@@ -1,2 +1,4 @@
 TEMPLATE = subdirs
 SUBDIRS += genericcanbus
+
+linux: SUBDIRS += socketcanfilter
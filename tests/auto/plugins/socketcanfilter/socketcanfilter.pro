@@ -0,0 +1,13 @@
+QT = core testlib
+TARGET = tst_socketcanfilter
+CONFIG += testcase c++11
+CONFIG -= app_bundle
+
+# the filter compiler is built into the test, so it does not depend on the installed plugin
+SOCKETCAN_DIR = $$PWD/../../../../src/plugins/canbus/socketcan
+INCLUDEPATH += $$SOCKETCAN_DIR
+
+HEADERS += $$SOCKETCAN_DIR/socketcanfilter.h
+
+SOURCES += tst_socketcanfilter.cpp \
+    $$SOCKETCAN_DIR/socketcanfilter.cpp
@@ -0,0 +1,313 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "socketcanfilter.h"
+
+#include <QtTest/QtTest>
+
+#include <linux/can/raw.h>
+
+#include <random>
+
+#ifndef CAN_RAW_FILTER_MAX
+#define CAN_RAW_FILTER_MAX 512
+#endif
+
+static const canid_t BaseFormatMask = CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_SFF_MASK;
+static const canid_t ExtendedFormatMask = CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_EFF_MASK;
+
+// all extended ids used by the tests are in one aligned block, so merged
+// entries cannot cover any id outside of it
+static const canid_t ExtendedBlock = 0x18da0000U;
+static const canid_t ExtendedBlockSize = 0x1000U;
+
+static can_filter baseFilter(canid_t id)
+{
+    return { id, BaseFormatMask };
+}
+
+static can_filter extendedFilter(canid_t id)
+{
+    return { id | CAN_EFF_FLAG, ExtendedFormatMask };
+}
+
+// what the original filter list selects, without any compilation
+static bool naiveMatch(const QVector<can_filter> &filters, canid_t canId)
+{
+    for (const can_filter &filter : filters) {
+        if ((canId & filter.can_mask) == (filter.can_id & filter.can_mask))
+            return true;
+    }
+    return false;
+}
+
+// evaluation of a CAN_RAW_FILTER list as done by the kernel
+static bool kernelMatch(const QVector<can_filter> &filters, bool joined, canid_t canId)
+{
+    for (const can_filter &filter : filters) {
+        const canid_t id = filter.can_id & ~CAN_INV_FILTER;
+        bool match = (canId & filter.can_mask) == (id & filter.can_mask);
+        if (filter.can_id & CAN_INV_FILTER)
+            match = !match;
+
+        if (joined && !match)
+            return false;
+        if (!joined && match)
+            return true;
+    }
+    return joined && !filters.isEmpty();
+}
+
+class tst_SocketCanFilter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit tst_SocketCanFilter();
+
+private slots:
+    void mergeAdjacentIds();
+    void keepMaskedEntries();
+    void falsePositiveBudget_data();
+    void falsePositiveBudget();
+    void invertedList();
+    void invertedListWithoutJoin();
+    void entryLimit();
+    void randomLists_data();
+    void randomLists();
+
+private:
+    void verify(const QVector<can_filter> &filters, const SocketCanFilter &filter);
+
+    QVector<canid_t> frameIds;
+};
+
+tst_SocketCanFilter::tst_SocketCanFilter()
+{
+    // data and remote request frames with every base format id and
+    // every extended format id of the test block
+    for (canid_t id = 0; id <= CAN_SFF_MASK; ++id) {
+        frameIds.append(id);
+        frameIds.append(id | CAN_RTR_FLAG);
+    }
+    for (canid_t id = ExtendedBlock; id < ExtendedBlock + ExtendedBlockSize; ++id) {
+        frameIds.append(id | CAN_EFF_FLAG);
+        frameIds.append(id | CAN_EFF_FLAG | CAN_RTR_FLAG);
+    }
+}
+
+/*
+    Checks the compiled list against the original one for all test frames:
+    the kernel must let every selected frame pass, the additional frames
+    must be exactly the reported false positives, and the userspace check
+    must remove them again.
+*/
+void tst_SocketCanFilter::verify(const QVector<can_filter> &filters,
+                                 const SocketCanFilter &filter)
+{
+    const QVector<can_filter> kernelFilters = filter.kernelFilters();
+    QVERIFY(kernelFilters.size() <= CAN_RAW_FILTER_MAX);
+    QVERIFY(kernelFilters.size() <= qMax(1, filters.size()));
+    if (filter.joinFilters())
+        QCOMPARE(filter.falsePositives(), quint64(0));
+
+    quint64 falsePositives = 0;
+    for (canid_t canId : qAsConst(frameIds)) {
+        const bool selected = naiveMatch(filters, canId);
+        const bool passed = kernelMatch(kernelFilters, filter.joinFilters(), canId);
+        if (selected && !passed)
+            QFAIL(qPrintable(QString::fromLatin1("frame 0x%1 rejected").arg(canId, 0, 16)));
+        if (!selected && passed)
+            ++falsePositives;
+
+        if (passed && filter.falsePositives() > 0)
+            QCOMPARE(filter.matches(canId), selected);
+    }
+    QCOMPARE(falsePositives, filter.falsePositives());
+}
+
+void tst_SocketCanFilter::mergeAdjacentIds()
+{
+    QVector<can_filter> filters;
+    for (canid_t id = 0x100; id < 0x110; ++id)
+        filters.append(baseFilter(id));
+    for (canid_t id = ExtendedBlock + 0x40; id < ExtendedBlock + 0x80; ++id)
+        filters.append(extendedFilter(id));
+    // duplicates do not need entries of their own
+    filters.append(baseFilter(0x105));
+
+    const SocketCanFilter filter(filters, 0);
+    QCOMPARE(filter.kernelFilters().size(), 2);
+    QCOMPARE(filter.falsePositives(), quint64(0));
+    QVERIFY(!filter.joinFilters());
+    verify(filters, filter);
+}
+
+void tst_SocketCanFilter::keepMaskedEntries()
+{
+    QVector<can_filter> filters;
+    filters.append({ 0x700, CAN_EFF_FLAG | 0x700 });
+    filters.append({ 0x200, CAN_SFF_MASK });
+    filters.append(baseFilter(0x300));
+    filters.append(baseFilter(0x301));
+
+    const SocketCanFilter filter(filters, 0);
+    QCOMPARE(filter.kernelFilters().size(), 3);
+    QCOMPARE(filter.kernelFilters().at(0).can_id, canid_t(0x700));
+    QCOMPARE(filter.kernelFilters().at(0).can_mask, canid_t(CAN_EFF_FLAG | 0x700));
+    QCOMPARE(filter.kernelFilters().at(1).can_id, canid_t(0x200));
+    QCOMPARE(filter.kernelFilters().at(1).can_mask, canid_t(CAN_SFF_MASK));
+    verify(filters, filter);
+}
+
+void tst_SocketCanFilter::falsePositiveBudget_data()
+{
+    QTest::addColumn<quint64>("budget");
+    QTest::addColumn<int>("entries");
+    QTest::addColumn<quint64>("falsePositives");
+
+    QTest::newRow("none") << quint64(0) << 4 << quint64(0);
+    QTest::newRow("too small") << quint64(3) << 4 << quint64(0);
+    QTest::newRow("exact") << quint64(4) << 1 << quint64(4);
+    QTest::newRow("large") << quint64(1000) << 1 << quint64(4);
+}
+
+void tst_SocketCanFilter::falsePositiveBudget()
+{
+    QFETCH(quint64, budget);
+    QFETCH(int, entries);
+    QFETCH(quint64, falsePositives);
+
+    // every second id, so any merge lets additional ids pass
+    QVector<can_filter> filters;
+    for (canid_t id = 0x100; id < 0x108; id += 2)
+        filters.append(baseFilter(id));
+
+    const SocketCanFilter filter(filters, budget);
+    QCOMPARE(filter.kernelFilters().size(), entries);
+    QCOMPARE(filter.falsePositives(), falsePositives);
+    verify(filters, filter);
+}
+
+void tst_SocketCanFilter::invertedList()
+{
+    QVector<can_filter> filters;
+    for (canid_t id = 0; id <= CAN_SFF_MASK; ++id) {
+        if (id != 0x123 && id != 0x456 && id != 0x7ff)
+            filters.append(baseFilter(id));
+    }
+
+    const SocketCanFilter filter(filters, 0);
+    QVERIFY(filter.joinFilters());
+    // one entry for frame format and type, one per excluded id
+    QCOMPARE(filter.kernelFilters().size(), 4);
+    QCOMPARE(filter.kernelFilters().at(0).can_id, canid_t(0));
+    QCOMPARE(filter.kernelFilters().at(0).can_mask, canid_t(CAN_EFF_FLAG | CAN_RTR_FLAG));
+    for (int i = 1; i < filter.kernelFilters().size(); ++i)
+        QVERIFY(filter.kernelFilters().at(i).can_id & CAN_INV_FILTER);
+    verify(filters, filter);
+}
+
+void tst_SocketCanFilter::invertedListWithoutJoin()
+{
+    QVector<can_filter> filters;
+    for (canid_t id = 0; id <= CAN_SFF_MASK; ++id) {
+        if (id != 0x123 && id != 0x456 && id != 0x7ff)
+            filters.append(baseFilter(id));
+    }
+
+    const SocketCanFilter filter(filters, 0, false);
+    QVERIFY(!filter.joinFilters());
+    for (const can_filter &entry : filter.kernelFilters())
+        QVERIFY(!(entry.can_id & CAN_INV_FILTER));
+    verify(filters, filter);
+}
+
+void tst_SocketCanFilter::entryLimit()
+{
+    // every second extended id, more than the kernel accepts without merging
+    QVector<can_filter> filters;
+    for (canid_t id = ExtendedBlock; id < ExtendedBlock + 2 * 600; id += 2)
+        filters.append(extendedFilter(id));
+
+    const SocketCanFilter filter(filters, 0);
+    QVERIFY(filter.kernelFilters().size() <= CAN_RAW_FILTER_MAX);
+    QVERIFY(filter.falsePositives() > 0);
+    verify(filters, filter);
+}
+
+void tst_SocketCanFilter::randomLists_data()
+{
+    QTest::addColumn<uint>("seed");
+    QTest::addColumn<int>("baseIds");
+    QTest::addColumn<int>("extendedIds");
+    QTest::addColumn<quint64>("budget");
+
+    QTest::newRow("few, no budget") << 1u << 20 << 20 << quint64(0);
+    QTest::newRow("few, budget") << 2u << 20 << 20 << quint64(64);
+    QTest::newRow("many base ids") << 3u << 1500 << 0 << quint64(16);
+    QTest::newRow("most base ids") << 4u << 4000 << 0 << quint64(0);
+    QTest::newRow("mixed, budget") << 5u << 300 << 300 << quint64(256);
+    QTest::newRow("mixed, over limit") << 6u << 400 << 800 << quint64(0);
+}
+
+void tst_SocketCanFilter::randomLists()
+{
+    QFETCH(uint, seed);
+    QFETCH(int, baseIds);
+    QFETCH(int, extendedIds);
+    QFETCH(quint64, budget);
+
+    std::mt19937 generator(seed);
+    QVector<can_filter> filters;
+    for (int i = 0; i < baseIds; ++i)
+        filters.append(baseFilter(generator() & CAN_SFF_MASK));
+    for (int i = 0; i < extendedIds; ++i)
+        filters.append(extendedFilter(ExtendedBlock + generator() % ExtendedBlockSize));
+
+    const SocketCanFilter filter(filters, budget);
+    // merges beyond the budget are only done to stay within the kernel limit
+    if (filters.size() <= CAN_RAW_FILTER_MAX)
+        QVERIFY(filter.falsePositives() <= budget);
+    verify(filters, filter);
+
+    const SocketCanFilter withoutJoin(filters, budget, false);
+    QVERIFY(!withoutJoin.joinFilters());
+    verify(filters, withoutJoin);
+}
+
+QTEST_MAIN(tst_SocketCanFilter)
+
+#include "tst_socketcanfilter.moc"
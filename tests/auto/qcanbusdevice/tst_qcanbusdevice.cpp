@@ -77,25 +77,38 @@ public:
         setState(QCanBusDevice::UnconnectedState);
     }
 
-    bool writeFrame(const QCanBusFrame &/*data*/)
+    bool writeFrame(const QCanBusFrame &data)
     {
         if (state() != QCanBusDevice::ConnectedState)
             return false;
 
+        writtenFrames.append(data);
         emit written();
         return true;
     }
 
+    void receive(const QVector<QCanBusFrame> &frames)
+    {
+        enqueueReceivedFrames(frames);
+    }
+
     void emulateError(const QString &text, QCanBusDevice::CanBusError e)
     {
         setError(text, e);
     }
 
+    void emulateBusStatistics(const QCanBusDevice::BusStatistics &statistics)
+    {
+        setBusStatistics(statistics);
+    }
+
     QString interpretErrorFrame(const QCanBusFrame &/*errorFrame*/)
     {
         return QString();
     }
 
+    QVector<QCanBusFrame> writtenFrames;
+
 signals:
     void written();
 
@@ -104,6 +117,51 @@ private:
     bool firstOpen;
 };
 
+class SubmitThread : public QThread
+{
+public:
+    SubmitThread(QCanBusDevice *device, quint32 id, int count)
+        : m_device(device), m_id(id), m_count(count)
+    {}
+
+protected:
+    void run() override
+    {
+        // the payload carries the sequence number of the frame
+        for (int i = 0; i < m_count; ++i) {
+            QByteArray payload;
+            QDataStream(&payload, QIODevice::WriteOnly) << qint32(i);
+            m_device->submitFrame(QCanBusFrame(m_id, payload));
+        }
+    }
+
+private:
+    QCanBusDevice *m_device;
+    quint32 m_id;
+    int m_count;
+};
+
+class WaitThread : public QThread
+{
+public:
+    explicit WaitThread(QCanBusDevice *device)
+        : m_device(device)
+    {}
+
+    bool waited = false;
+    QVector<QCanBusFrame> frames;
+
+protected:
+    void run() override
+    {
+        waited = m_device->waitForFramesReceived(5000);
+        frames = m_device->readAllFrames();
+    }
+
+private:
+    QCanBusDevice *m_device;
+};
+
 class tst_QCanBusDevice : public QObject
 {
     Q_OBJECT
@@ -116,6 +174,11 @@ private slots:
     void write();
     void read();
     void error();
+    void submitFrame();
+    void waitForFramesReceived();
+    void receiveHook();
+    void busStatistics();
+    void timeStampNormalization();
     void cleanupTestCase();
     void tst_filtering();
 
@@ -127,6 +190,7 @@ tst_QCanBusDevice::tst_QCanBusDevice()
 {
     qRegisterMetaType<QCanBusDevice::CanBusDeviceState>();
     qRegisterMetaType<QCanBusDevice::CanBusError>();
+    qRegisterMetaType<QCanBusDevice::CanBusStatus>();
 }
 
 void tst_QCanBusDevice::initTestCase()
@@ -290,6 +354,223 @@ void tst_QCanBusDevice::error()
     QCOMPARE(spy.count(), 5);
 }
 
+void tst_QCanBusDevice::submitFrame()
+{
+    tst_Backend backend;
+    QVERIFY(!backend.connectDevice());
+    QVERIFY(backend.connectDevice());
+    QTRY_COMPARE(backend.state(), QCanBusDevice::ConnectedState);
+
+    QVERIFY(!backend.submitFrame(QCanBusFrame(QCanBusFrame::InvalidFrame)));
+
+    const int producers = 4;
+    const int count = 1000;
+    QVector<SubmitThread *> threads;
+    for (int i = 0; i < producers; ++i)
+        threads.append(new SubmitThread(&backend, 0x100 + i, count));
+    for (SubmitThread *thread : threads)
+        thread->start();
+    for (SubmitThread *thread : threads)
+        QVERIFY(thread->wait(5000));
+    qDeleteAll(threads);
+
+    QVERIFY(backend.framesToWrite() > 0);
+    QTRY_COMPARE(backend.writtenFrames.size(), producers * count);
+    QCOMPARE(backend.framesToWrite(), qint64(0));
+
+    // frames of a single producer must be written in submission order
+    QVector<qint32> next(producers, 0);
+    for (const QCanBusFrame &frame : backend.writtenFrames) {
+        const int producer = frame.frameId() - 0x100;
+        QVERIFY(producer >= 0 && producer < producers);
+        qint32 sequence;
+        QDataStream(frame.payload()) >> sequence;
+        QCOMPARE(sequence, next[producer]++);
+    }
+}
+
+void tst_QCanBusDevice::waitForFramesReceived()
+{
+    tst_Backend backend;
+    QVERIFY(!backend.waitForFramesReceived(0)); // not connected
+    QVERIFY(!backend.connectDevice());
+    QVERIFY(backend.connectDevice());
+    QTRY_COMPARE(backend.state(), QCanBusDevice::ConnectedState);
+
+    // frames queued by the constructor are returned in one go
+    QVERIFY(backend.waitForFramesReceived(0));
+    QCOMPARE(backend.readAllFrames().size(), 5);
+    QCOMPARE(backend.framesAvailable(), qint64(0));
+
+    // same thread: a local event loop delivers the frames
+    QVERIFY(!backend.waitForFramesReceived(10));
+    const QVector<QCanBusFrame> frames(3, QCanBusFrame(0x42, QByteArray("data")));
+    QTimer::singleShot(10, &backend, [&backend, &frames]() { backend.receive(frames); });
+    QVERIFY(backend.waitForFramesReceived(5000));
+    QCOMPARE(backend.readAllFrames().size(), 3);
+
+    // other thread: blocks on the queue without an event loop
+    WaitThread waiter(&backend);
+    waiter.start();
+    QTest::qWait(20);
+    backend.receive(frames);
+    QVERIFY(waiter.wait(5000));
+    QVERIFY(waiter.waited);
+    QCOMPARE(waiter.frames.size(), 3);
+
+    // other thread: a disconnect ends the wait
+    WaitThread interrupted(&backend);
+    interrupted.start();
+    QTest::qWait(20);
+    backend.disconnectDevice();
+    QVERIFY(interrupted.wait(5000));
+    QVERIFY(!interrupted.waited);
+}
+
+static void countHookCall(void *data)
+{
+    ++*static_cast<int *>(data);
+}
+
+void tst_QCanBusDevice::receiveHook()
+{
+    tst_Backend backend;
+    QVector<QCanBusFrame> frames(16, QCanBusFrame(0x123, QByteArray(8, 0)));
+    QCOMPARE(backend.readAllFrames(&frames), 0); // not connected
+    QVERIFY(frames.isEmpty());
+
+    QVERIFY(!backend.connectDevice());
+    QVERIFY(backend.connectDevice());
+    QTRY_COMPARE(backend.state(), QCanBusDevice::ConnectedState);
+
+    int calls = 0;
+    backend.setReceiveHook(&countHookCall, &calls);
+    backend.receive({ QCanBusFrame(0x1, QByteArray()), QCanBusFrame(0x2, QByteArray()) });
+    QCOMPARE(calls, 1);
+
+    // the hook is called only once
+    backend.receive({ QCanBusFrame(0x3, QByteArray()) });
+    QCOMPARE(calls, 1);
+
+    frames.reserve(64);
+    const int capacity = frames.capacity();
+    QCOMPARE(backend.readAllFrames(&frames), 3);
+    QCOMPARE(frames.at(2).frameId(), 0x3u);
+    QCOMPARE(backend.framesAvailable(), qint64(0));
+
+    // the previous storage is reused for the next batch
+    backend.receive({ QCanBusFrame(0x4, QByteArray()) });
+    QVector<QCanBusFrame> next;
+    QCOMPARE(backend.readAllFrames(&next), 1);
+    QCOMPARE(next.capacity(), capacity);
+
+    // state changes call the hook as well
+    backend.setReceiveHook(&countHookCall, &calls);
+    backend.disconnectDevice();
+    QTRY_COMPARE(calls, 2);
+}
+
+void tst_QCanBusDevice::busStatistics()
+{
+    tst_Backend backend;
+    QCOMPARE(backend.busStatus(), QCanBusDevice::UnknownStatus);
+    QCOMPARE(backend.busStatistics().transmitErrorCounter, -1);
+    QCOMPARE(backend.busStatistics().receiveErrorCounter, -1);
+
+    QVERIFY(!backend.connectDevice());
+    QVERIFY(backend.connectDevice());
+    QTRY_COMPARE(backend.state(), QCanBusDevice::ConnectedState);
+
+    QSignalSpy spy(&backend, &QCanBusDevice::busStatusChanged);
+
+    QCanBusDevice::BusStatistics statistics;
+    statistics.status = QCanBusDevice::GoodStatus;
+    statistics.transmitErrorCounter = 0;
+    statistics.receiveErrorCounter = 3;
+    backend.emulateBusStatistics(statistics);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).value<QCanBusDevice::CanBusStatus>(), QCanBusDevice::GoodStatus);
+
+    // only a change of the controller state is signaled
+    statistics.receiveErrorCounter = 90;
+    statistics.receiveDropped = 12;
+    backend.emulateBusStatistics(statistics);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(backend.busStatistics().receiveErrorCounter, 90);
+    QCOMPARE(backend.busStatistics().receiveDropped, quint64(12));
+
+    statistics.status = QCanBusDevice::ErrorStatus;
+    statistics.transmitErrorCounter = 128;
+    backend.emulateBusStatistics(statistics);
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(backend.busStatus(), QCanBusDevice::ErrorStatus);
+
+    // the snapshot is reset when the device is disconnected
+    backend.disconnectDevice();
+    QTRY_COMPARE(backend.state(), QCanBusDevice::UnconnectedState);
+    QCOMPARE(spy.count(), 3);
+    QCOMPARE(backend.busStatus(), QCanBusDevice::UnknownStatus);
+    QCOMPARE(backend.busStatistics().receiveDropped, quint64(0));
+}
+
+void tst_QCanBusDevice::timeStampNormalization()
+{
+    tst_Backend backend;
+    while (backend.framesAvailable())
+        backend.readFrame();
+
+    backend.setConfigurationParameter(QCanBusDevice::TimeStampNormalizationKey, true);
+    QCOMPARE(backend.configurationParameter(QCanBusDevice::TimeStampNormalizationKey).toBool(), true);
+
+    // nothing is known about the backend clock yet
+    QCOMPARE(backend.toNormalizedTimeStamp(QCanBusFrame::TimeStamp(22, 500)).seconds(), qint64(0));
+
+    // the backend clock starts at 22 s
+    QCanBusFrame first(0x10, QByteArray("a"));
+    first.setTimeStamp(QCanBusFrame::TimeStamp(22, 500));
+    QCanBusFrame second(0x11, QByteArray("b"));
+    second.setTimeStamp(QCanBusFrame::TimeStamp(22, 700));
+    const QCanBusFrame unstamped(0x12, QByteArray("c"));
+
+    const auto toMicroseconds = [](const QCanBusFrame::TimeStamp &stamp) {
+        return stamp.seconds() * 1000000 + stamp.microSeconds();
+    };
+    QElapsedTimer timer;
+    timer.start();
+    backend.receive(QVector<QCanBusFrame>() << first << second << unstamped);
+    QCOMPARE(backend.framesAvailable(), qint64(3));
+
+    // the frames keep the timestamps of the backend
+    const QCanBusFrame readFirst = backend.readFrame();
+    const QCanBusFrame readSecond = backend.readFrame();
+    const QCanBusFrame readUnstamped = backend.readFrame();
+    QVERIFY(!readFirst.hasNormalizedTimeStamp());
+    QCOMPARE(readFirst.timeStamp().seconds(), qint64(22));
+    QCOMPARE(readFirst.timeStamp().microSeconds(), qint64(500));
+    QCOMPARE(toMicroseconds(readUnstamped.timeStamp()), qint64(0));
+
+    // the newest stamped frame was received just now
+    const qint64 mappedFirst = toMicroseconds(backend.toNormalizedTimeStamp(readFirst.timeStamp()));
+    const qint64 mappedSecond = toMicroseconds(backend.toNormalizedTimeStamp(readSecond.timeStamp()));
+    QCOMPARE(mappedSecond - mappedFirst, qint64(200));
+    QVERIFY(mappedSecond > 0);
+    // a timestamp ahead of the reception is clamped to the current time
+    const qint64 now = toMicroseconds(backend.toNormalizedTimeStamp(QCanBusFrame::TimeStamp(30, 0)));
+    QVERIFY(now >= mappedSecond);
+    QVERIFY(now - mappedSecond <= timer.nsecsElapsed() / 1000);
+    QCOMPARE(toMicroseconds(backend.toNormalizedTimeStamp(readUnstamped.timeStamp())), qint64(0));
+
+    // a normalized timestamp set by the application is kept by the frame
+    QCanBusFrame merged = readFirst;
+    merged.setNormalizedTimeStamp(backend.toNormalizedTimeStamp(readFirst.timeStamp()));
+    QVERIFY(merged.hasNormalizedTimeStamp());
+    QCOMPARE(toMicroseconds(merged.timeStamp()), mappedFirst);
+
+    // disabled again, nothing is mapped anymore
+    backend.setConfigurationParameter(QCanBusDevice::TimeStampNormalizationKey, false);
+    QCOMPARE(toMicroseconds(backend.toNormalizedTimeStamp(readFirst.timeStamp())), qint64(0));
+}
+
 void tst_QCanBusDevice::cleanupTestCase()
 {
     device->disconnectDevice();
@@ -0,0 +1,8 @@
+QT = core testlib serialbus
+TARGET = tst_qcanbuse2echecker
+CONFIG += testcase c++11
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../shared
+HEADERS += ../shared/canbustestbackend.h
+SOURCES += tst_qcanbuse2echecker.cpp
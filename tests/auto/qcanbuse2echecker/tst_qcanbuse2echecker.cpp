@@ -0,0 +1,298 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "canbustestbackend.h"
+
+#include <QtSerialBus/qcanbusdevice.h>
+#include <QtSerialBus/qcanbuse2echecker.h>
+#include <QtSerialBus/qcanbusframe.h>
+
+#include <QtTest/QtTest>
+
+// Bitwise reference of the MSB-first CRCs, independent of the lookup tables.
+static quint16 referenceCrc(const QByteArray &data, int width, quint16 polynomial,
+                            quint16 init, quint16 xorOut)
+{
+    const quint16 topBit = quint16(1 << (width - 1));
+    const quint16 mask = quint16((1 << width) - 1);
+    quint16 crc = init;
+    for (char byte : data) {
+        crc ^= quint16(uchar(byte) << (width - 8));
+        for (int bit = 0; bit < 8; ++bit)
+            crc = quint16(((crc & topBit) ? (crc << 1) ^ polynomial : crc << 1) & mask);
+    }
+    return quint16(crc ^ xorOut);
+}
+
+// Builds a protected frame as the sender would, CRC at offset 0 and counter at offset 2.
+static QCanBusFrame protectedFrame(quint32 frameId, QCanBusE2EChecker::CrcType type,
+                                   quint16 dataId, int counter, const QByteArray &signal)
+{
+    const int crcSize = (type == QCanBusE2EChecker::Crc16CcittFalse) ? 2 : 1;
+    QByteArray payload(crcSize, 0);
+    payload.append(char(counter));
+    payload.append(signal);
+
+    const QByteArray id = QByteArray(1, char(dataId & 0xff)) + char(dataId >> 8);
+    const QByteArray covered = payload.mid(crcSize);
+    quint16 crc = 0;
+    switch (type) {
+    case QCanBusE2EChecker::Crc8SaeJ1850:
+        crc = referenceCrc(id + covered, 8, 0x1d, 0xff, 0xff);
+        break;
+    case QCanBusE2EChecker::Crc8H2F:
+        crc = referenceCrc(id + covered, 8, 0x2f, 0xff, 0xff);
+        break;
+    case QCanBusE2EChecker::Crc16CcittFalse:
+        crc = referenceCrc(covered + id, 16, 0x1021, 0xffff, 0);
+        payload[1] = char(crc >> 8);
+        break;
+    }
+    payload[0] = char(crc & 0xff);
+    return QCanBusFrame(frameId, payload);
+}
+
+static QCanBusE2EChecker::Protection protection(QCanBusE2EChecker::CrcType type, quint16 dataId)
+{
+    QCanBusE2EChecker::Protection protection;
+    protection.crcType = type;
+    protection.dataId = dataId;
+    protection.crcOffset = 0;
+    protection.counterOffset = (type == QCanBusE2EChecker::Crc16CcittFalse) ? 2 : 1;
+    return protection;
+}
+
+class tst_QCanBusE2EChecker : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void crc_data();
+    void crc();
+    void counter();
+    void wrongLength();
+    void dropFailedFrames();
+    void attach();
+};
+
+void tst_QCanBusE2EChecker::crc_data()
+{
+    QTest::addColumn<QCanBusE2EChecker::CrcType>("type");
+
+    QTest::newRow("SAE J1850") << QCanBusE2EChecker::Crc8SaeJ1850;
+    QTest::newRow("H2F") << QCanBusE2EChecker::Crc8H2F;
+    QTest::newRow("CCITT-FALSE") << QCanBusE2EChecker::Crc16CcittFalse;
+}
+
+void tst_QCanBusE2EChecker::crc()
+{
+    QFETCH(QCanBusE2EChecker::CrcType, type);
+
+    QCanBusE2EChecker checker;
+    checker.setProtection(0x100, protection(type, 0x1234));
+    QCOMPARE(checker.protectedFrameIds(), QVector<quint32>() << 0x100);
+
+    QVector<QCanBusFrame> frames;
+    for (int i = 0; i < 64; ++i)
+        frames.append(protectedFrame(0x100, type, 0x1234, i, QByteArray(5, char(i * 7))));
+    QCOMPARE(checker.check(&frames), 0);
+    QCOMPARE(frames.size(), 64);
+    QCOMPARE(frames.first().e2eStatus(), QCanBusFrame::E2EInitial);
+    for (int i = 1; i < frames.size(); ++i)
+        QCOMPARE(frames.at(i).e2eStatus(), QCanBusFrame::E2EOk);
+
+    // a flipped bit, or the payload of another data identifier, fails
+    QCanBusFrame corrupted = protectedFrame(0x100, type, 0x1234, 0, QByteArray(5, 0));
+    QByteArray payload = corrupted.payload();
+    payload[4] = char(payload.at(4) ^ 0x10);
+    corrupted.setPayload(payload);
+    frames = QVector<QCanBusFrame>()
+            << corrupted << protectedFrame(0x100, type, 0x1235, 0, QByteArray(5, 0));
+    QCOMPARE(checker.check(&frames), 2);
+    QCOMPARE(frames.at(0).e2eStatus(), QCanBusFrame::E2EWrongCrc);
+    QCOMPARE(frames.at(1).e2eStatus(), QCanBusFrame::E2EWrongCrc);
+
+    const QCanBusE2EChecker::Statistics statistics = checker.statistics(0x100);
+    QCOMPARE(statistics.checkedFrames, quint64(66));
+    QCOMPARE(statistics.wrongCrcFrames, quint64(2));
+
+    // CAN XL payloads are checked behind the acceptance field, up to 2048 bytes
+    QCanBusFrame xl = protectedFrame(0x100, type, 0x1234, 64, QByteArray(2000, '\x5a'));
+    xl.setCanXlFormat(true);
+    xl.setAcceptanceField(0xdeadbeef);
+    QCanBusFrame xlCorrupted = protectedFrame(0x100, type, 0x1234, 65, QByteArray(2000, '\x5a'));
+    xlCorrupted.setCanXlFormat(true);
+    payload = xlCorrupted.payload();
+    payload[1990] = char(payload.at(1990) ^ 0x01);
+    xlCorrupted.setPayload(payload);
+    frames = QVector<QCanBusFrame>() << xl << xlCorrupted;
+    QCOMPARE(checker.check(&frames), 1);
+    QCOMPARE(frames.at(0).e2eStatus(), QCanBusFrame::E2EOk);
+    QCOMPARE(frames.at(1).e2eStatus(), QCanBusFrame::E2EWrongCrc);
+}
+
+void tst_QCanBusE2EChecker::counter()
+{
+    const auto type = QCanBusE2EChecker::Crc8SaeJ1850;
+    QCanBusE2EChecker::Protection config = protection(type, 7);
+    config.maxDeltaCounter = 3;
+
+    QCanBusE2EChecker checker;
+    checker.setProtection(0x20, config);
+
+    // 4 bit counter: wraps from 15 to 0
+    static const int counters[] = { 14, 15, 0, 0, 2, 3, 10, 11 };
+    static const QCanBusFrame::E2EStatus expected[] = {
+        QCanBusFrame::E2EInitial, QCanBusFrame::E2EOk, QCanBusFrame::E2EOk,
+        QCanBusFrame::E2ERepeated, QCanBusFrame::E2EOkSomeLost, QCanBusFrame::E2EOk,
+        QCanBusFrame::E2EWrongSequence, QCanBusFrame::E2EOk
+    };
+
+    QVector<QCanBusFrame> frames;
+    for (int counter : counters)
+        frames.append(protectedFrame(0x20, type, 7, counter, QByteArray("xyz")));
+    // frames of other identifiers pass unchecked
+    frames.append(QCanBusFrame(0x21, QByteArray("abc")));
+
+    QCOMPARE(checker.check(&frames), 2);
+    for (int i = 0; i < 8; ++i)
+        QCOMPARE(frames.at(i).e2eStatus(), expected[i]);
+    QCOMPARE(frames.last().e2eStatus(), QCanBusFrame::E2ENotChecked);
+
+    QCanBusE2EChecker::Statistics statistics = checker.statistics(0x20);
+    QCOMPARE(statistics.checkedFrames, quint64(8));
+    QCOMPARE(statistics.lostFrames, quint64(1));
+    QCOMPARE(statistics.repeatedFrames, quint64(1));
+    QCOMPARE(statistics.wrongSequenceFrames, quint64(1));
+
+    checker.resetStatistics();
+    checker.resetCounters();
+    frames = QVector<QCanBusFrame>() << protectedFrame(0x20, type, 7, 5, QByteArray("xyz"));
+    QCOMPARE(checker.check(&frames), 0);
+    QCOMPARE(frames.first().e2eStatus(), QCanBusFrame::E2EInitial);
+    statistics = checker.statistics(0x20);
+    QCOMPARE(statistics.checkedFrames, quint64(1));
+    QCOMPARE(statistics.repeatedFrames, quint64(0));
+}
+
+void tst_QCanBusE2EChecker::wrongLength()
+{
+    QCanBusE2EChecker checker;
+    checker.setProtection(0x300, protection(QCanBusE2EChecker::Crc16CcittFalse, 1));
+
+    QVector<QCanBusFrame> frames;
+    frames << QCanBusFrame(0x300, QByteArray(2, 0));
+    QCOMPARE(checker.check(&frames), 1);
+    QCOMPARE(frames.first().e2eStatus(), QCanBusFrame::E2EWrongLength);
+    QCOMPARE(checker.statistics(0x300).wrongLengthFrames, quint64(1));
+
+    checker.removeProtection(0x300);
+    QVERIFY(checker.protectedFrameIds().isEmpty());
+    frames = QVector<QCanBusFrame>() << QCanBusFrame(0x300, QByteArray(2, 0));
+    QCOMPARE(checker.check(&frames), 0);
+    QCOMPARE(frames.first().e2eStatus(), QCanBusFrame::E2ENotChecked);
+}
+
+void tst_QCanBusE2EChecker::dropFailedFrames()
+{
+    const auto type = QCanBusE2EChecker::Crc8H2F;
+    QCanBusE2EChecker checker;
+    checker.setProtection(0x10, protection(type, 3));
+    QVERIFY(!checker.dropsFailedFrames());
+    checker.setDropsFailedFrames(true);
+    QVERIFY(checker.dropsFailedFrames());
+
+    QVector<QCanBusFrame> frames;
+    frames << protectedFrame(0x10, type, 3, 1, QByteArray("a"))
+           << QCanBusFrame(0x11, QByteArray("b"))
+           << protectedFrame(0x10, type, 3, 1, QByteArray("a"))    // repeated
+           << protectedFrame(0x10, type, 4, 2, QByteArray("a"))    // wrong data id
+           << protectedFrame(0x10, type, 3, 2, QByteArray("c"));
+    QCOMPARE(checker.check(&frames), 2);
+    QCOMPARE(frames.size(), 3);
+    QCOMPARE(frames.at(0).e2eStatus(), QCanBusFrame::E2EInitial);
+    QCOMPARE(frames.at(1).frameId(), 0x11u);
+    QCOMPARE(frames.at(2).payload().mid(2), QByteArray("c"));
+    QCOMPARE(frames.at(2).e2eStatus(), QCanBusFrame::E2EOk);
+}
+
+void tst_QCanBusE2EChecker::attach()
+{
+    const auto type = QCanBusE2EChecker::Crc8SaeJ1850;
+    CanBusTestBackend device;
+    QVERIFY(device.connectDevice());
+
+    QCanBusE2EChecker checker;
+    checker.setProtection(0x42, protection(type, 0x42));
+    checker.setDropsFailedFrames(true);
+    checker.attach(&device);
+
+    QSignalSpy spy(&device, &QCanBusDevice::framesReceived);
+    QCanBusFrame corrupted = protectedFrame(0x42, type, 0x42, 1, QByteArray("d"));
+    corrupted.setPayload(corrupted.payload() + 'x');
+
+    // a batch without any frame passing the check is not signaled
+    device.receive(QVector<QCanBusFrame>() << corrupted);
+    QCOMPARE(spy.count(), 0);
+    QCOMPARE(device.framesAvailable(), qint64(0));
+
+    device.receive(QVector<QCanBusFrame>()
+                   << protectedFrame(0x42, type, 0x42, 1, QByteArray("d")) << corrupted
+                   << protectedFrame(0x42, type, 0x42, 2, QByteArray("e")));
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(device.framesAvailable(), qint64(2));
+    QCOMPARE(device.readFrame().e2eStatus(), QCanBusFrame::E2EInitial);
+    QCOMPARE(device.readFrame().e2eStatus(), QCanBusFrame::E2EOk);
+    QCOMPARE(checker.statistics(0x42).wrongCrcFrames, quint64(2));
+
+    // attaching to another checker detaches the device from this one
+    QCanBusE2EChecker other;
+    other.attach(&device);
+    device.receive(QVector<QCanBusFrame>() << corrupted);
+    QCOMPARE(device.framesAvailable(), qint64(1));
+    QCOMPARE(device.readFrame().e2eStatus(), QCanBusFrame::E2ENotChecked);
+    QCOMPARE(checker.statistics(0x42).checkedFrames, quint64(4));
+
+    other.detach(&device);
+    checker.attach(&device);
+    checker.detach(&device);
+    device.receive(QVector<QCanBusFrame>() << corrupted);
+    QCOMPARE(device.framesAvailable(), qint64(1));
+}
+
+QTEST_MAIN(tst_QCanBusE2EChecker)
+
+#include "tst_qcanbuse2echecker.moc"
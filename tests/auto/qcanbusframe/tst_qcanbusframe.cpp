@@ -56,6 +56,12 @@ private slots:
     void streaming();
 
     void tst_error();
+
+    void canXl_data();
+    void canXl();
+    void canXlStreaming();
+    void normalizedTimeStamp();
+    void mixedStreamVersions();
 };
 
 tst_QCanBusFrame::tst_QCanBusFrame()
@@ -304,6 +310,186 @@ void tst_QCanBusFrame::tst_error()
     QCOMPARE(frame.error(), QCanBusFrame::NoError);
 }
 
+void tst_QCanBusFrame::canXl_data()
+{
+    QTest::addColumn<QCanBusFrame::FrameType>("frameType");
+    QTest::addColumn<bool>("isValid");
+    QTest::addColumn<QByteArray>("payload");
+    QTest::addColumn<uint>("id");
+
+    QTest::newRow("min payload")
+                 << QCanBusFrame::DataFrame << true << QByteArray(1, 0) << 0x7ffu;
+    QTest::newRow("max payload")
+                 << QCanBusFrame::DataFrame << true << QByteArray(2048, 0) << 0x1u;
+    QTest::newRow("no payload")
+                 << QCanBusFrame::DataFrame << false << QByteArray() << 0x1u;
+    QTest::newRow("too much payload")
+                 << QCanBusFrame::DataFrame << false << QByteArray(2049, 0) << 0x1u;
+    QTest::newRow("priority too long")
+                 << QCanBusFrame::DataFrame << false << QByteArray(8, 0) << 0x800u;
+    QTest::newRow("remote request frame")
+                 << QCanBusFrame::RemoteRequestFrame << false << QByteArray(8, 0) << 0x1u;
+}
+
+void tst_QCanBusFrame::canXl()
+{
+    QFETCH(QCanBusFrame::FrameType, frameType);
+    QFETCH(bool, isValid);
+    QFETCH(QByteArray, payload);
+    QFETCH(uint, id);
+
+    QCanBusFrame frame(frameType);
+    frame.setFrameId(id);
+    frame.setPayload(payload);
+    QVERIFY(!frame.hasCanXlFormat());
+
+    frame.setCanXlFormat(true);
+    QVERIFY(frame.hasCanXlFormat());
+    QCOMPARE(frame.isValid(), isValid);
+    QCOMPARE(frame.payload(), payload);
+
+    frame.setAcceptanceField(0x01020304);
+    QCOMPARE(frame.acceptanceField(), 0x01020304u);
+    QCOMPARE(frame.payload(), payload);
+    frame.setPayload(QByteArray(3, '\x01'));
+    QCOMPARE(frame.acceptanceField(), 0x01020304u);
+    QCOMPARE(frame.payload(), QByteArray(3, '\x01'));
+
+    frame.setCanXlFormat(false);
+    QVERIFY(!frame.hasCanXlFormat());
+    QCOMPARE(frame.payload(), QByteArray(3, '\x01'));
+    QCOMPARE(frame.acceptanceField(), 0u);
+
+}
+
+void tst_QCanBusFrame::canXlStreaming()
+{
+    QCanBusFrame originalFrame(0x123, QByteArray(2048, '\x42'));
+    originalFrame.setCanXlFormat(true);
+    originalFrame.setServiceDataUnitType(0x03);
+    originalFrame.setSimpleExtendedContent(true);
+    originalFrame.setAcceptanceField(0xdeadbeef);
+    originalFrame.setTimeStamp(QCanBusFrame::TimeStamp(1, 2));
+    QVERIFY(originalFrame.isValid());
+
+    QByteArray buffer;
+    QDataStream out(&buffer, QIODevice::WriteOnly);
+    out << originalFrame;
+
+    QDataStream in(buffer);
+    QCanBusFrame restoredFrame;
+    in >> restoredFrame;
+
+    QVERIFY(restoredFrame.isValid());
+    QVERIFY(restoredFrame.hasCanXlFormat());
+    QCOMPARE(restoredFrame.frameId(), originalFrame.frameId());
+    QCOMPARE(restoredFrame.payload(), originalFrame.payload());
+    QCOMPARE(restoredFrame.serviceDataUnitType(), quint8(0x03));
+    QVERIFY(restoredFrame.hasSimpleExtendedContent());
+    QCOMPARE(restoredFrame.acceptanceField(), 0xdeadbeefu);
+    QCOMPARE(restoredFrame.timeStamp().microSeconds(), qint64(2));
+
+    // frames that are not CAN XL keep the original stream layout
+    QByteArray classicBuffer;
+    QDataStream classicOut(&classicBuffer, QIODevice::WriteOnly);
+    classicOut << QCanBusFrame(0x123, QByteArray(8, '\x42'));
+    QCOMPARE(classicBuffer.size(), 4 + 1 + 1 + 1 + (4 + 8) + 8 + 8);
+}
+
+void tst_QCanBusFrame::normalizedTimeStamp()
+{
+    QCanBusFrame frame(0x123, QByteArray(8, '\x42'));
+    frame.setTimeStamp(QCanBusFrame::TimeStamp(22, 23));
+    QVERIFY(!frame.hasNormalizedTimeStamp());
+
+    frame.setNormalizedTimeStamp(QCanBusFrame::TimeStamp(1000, 5));
+    frame.setNormalizedTimeStamp(QCanBusFrame::TimeStamp(1000, 6));
+    QVERIFY(frame.hasNormalizedTimeStamp());
+    QCOMPARE(frame.timeStamp().seconds(), qint64(1000));
+    QCOMPARE(frame.timeStamp().microSeconds(), qint64(6));
+
+    QByteArray buffer;
+    QDataStream out(&buffer, QIODevice::WriteOnly);
+    out << frame;
+
+    QDataStream in(buffer);
+    QCanBusFrame restoredFrame;
+    in >> restoredFrame;
+
+    QVERIFY(restoredFrame.hasNormalizedTimeStamp());
+    QCOMPARE(restoredFrame.payload(), frame.payload());
+    QCOMPARE(restoredFrame.timeStamp().microSeconds(), qint64(6));
+
+    // setting a timestamp drops the normalized one
+    restoredFrame.setTimeStamp(QCanBusFrame::TimeStamp(3, 4));
+    QVERIFY(!restoredFrame.hasNormalizedTimeStamp());
+    QCOMPARE(restoredFrame.timeStamp().seconds(), qint64(3));
+
+    // neither the normalized flag nor the CAN XL fields grow the frame
+    struct Layout
+    {
+        quint32 idAndFormat;
+        quint8 flags;
+        quint8 reserved[3];
+        QByteArray payload;
+        QCanBusFrame::TimeStamp stamp;
+    };
+    QCOMPARE(sizeof(QCanBusFrame), sizeof(Layout));
+}
+
+void tst_QCanBusFrame::mixedStreamVersions()
+{
+    const QCanBusFrame classic(0x100, QByteArray(8, '\x01'));
+
+    QCanBusFrame xl(0x200, QByteArray(100, '\x02'));
+    xl.setCanXlFormat(true);
+    xl.setAcceptanceField(0x12345678);
+    xl.setTimeStamp(QCanBusFrame::TimeStamp(5, 6));
+
+    QCanBusFrame normalized(0x300, QByteArray(64, '\x03'));
+    normalized.setNormalizedTimeStamp(QCanBusFrame::TimeStamp(7, 8));
+
+    QCanBusFrame normalizedXl = xl;
+    normalizedXl.setFrameId(0x400);
+    normalizedXl.setNormalizedTimeStamp(QCanBusFrame::TimeStamp(9, 10));
+
+    QCanBusFrame extended(0x12345, QByteArray(3, '\x05'));
+    extended.setExtendedFrameFormat(true);
+
+    // versions 0, 1, 2, 0, 2, 0, each read with the layout it was written in
+    const QVector<QCanBusFrame> frames = QVector<QCanBusFrame>()
+            << classic << xl << normalized << classic << normalizedXl << extended;
+    QByteArray buffer;
+    QDataStream out(&buffer, QIODevice::WriteOnly);
+    for (const QCanBusFrame &frame : frames)
+        out << frame;
+
+    QDataStream in(buffer);
+    for (const QCanBusFrame &frame : frames) {
+        QCanBusFrame restored;
+        in >> restored;
+        QCOMPARE(in.status(), QDataStream::Ok);
+        QCOMPARE(restored.frameId(), frame.frameId());
+        QCOMPARE(restored.hasExtendedFrameFormat(), frame.hasExtendedFrameFormat());
+        QCOMPARE(restored.hasCanXlFormat(), frame.hasCanXlFormat());
+        QCOMPARE(restored.acceptanceField(), frame.acceptanceField());
+        QCOMPARE(restored.hasNormalizedTimeStamp(), frame.hasNormalizedTimeStamp());
+        QCOMPARE(restored.payload(), frame.payload());
+        QCOMPARE(restored.timeStamp().seconds(), frame.timeStamp().seconds());
+        QCOMPARE(restored.timeStamp().microSeconds(), frame.timeStamp().microSeconds());
+    }
+    QVERIFY(in.atEnd());
+
+    // a reader ignoring the version, as before Qt 5.7, desynchronizes behind a CAN XL frame
+    QDataStream oldIn(buffer);
+    QCanBusFrame restored;
+    oldIn >> restored;
+    oldIn.skipRawData(4 + 1 + 1 + 1 + (4 + 100) + 8 + 8);
+    quint32 frameId = 0;
+    oldIn >> frameId;
+    QVERIFY(frameId != normalized.frameId());
+}
+
 QTEST_MAIN(tst_QCanBusFrame)
 
 #include "tst_qcanbusframe.moc"
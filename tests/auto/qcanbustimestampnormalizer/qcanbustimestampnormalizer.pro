@@ -0,0 +1,6 @@
+QT = core testlib serialbus serialbus-private
+TARGET = tst_qcanbustimestampnormalizer
+CONFIG += testcase c++11
+CONFIG -= app_bundle
+
+SOURCES += tst_qcanbustimestampnormalizer.cpp
@@ -0,0 +1,126 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtSerialBus/private/qcanbustimestampnormalizer_p.h>
+
+#include <QtTest/QtTest>
+
+class tst_QCanBusTimeStampNormalizer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void offset();
+    void drift_data();
+    void drift();
+    void reset();
+};
+
+void tst_QCanBusTimeStampNormalizer::offset()
+{
+    QCanBusTimeStampNormalizer normalizer;
+    QVERIFY(!normalizer.isValid());
+    QCOMPARE(normalizer.toMonotonic(1234), qint64(1234));
+
+    // the device clock runs 5 s behind, frames are read after 100 to 900 us
+    const qint64 offset = 5000000;
+    static const int delays[] = { 400, 100, 900, 250, 600 };
+    for (int i = 0; i < 5; ++i) {
+        const qint64 raw = 1000000 + i * 100;
+        normalizer.addSample(raw, raw + offset + delays[i]);
+    }
+    QVERIFY(normalizer.isValid());
+
+    // all pairs are in one slot, only the shortest delay counts
+    QCOMPARE(normalizer.toMonotonic(1000000), 1000000 + offset + 100);
+    QCOMPARE(normalizer.drift(), 0.);
+}
+
+void tst_QCanBusTimeStampNormalizer::drift_data()
+{
+    QTest::addColumn<double>("drift");
+
+    QTest::newRow("none") << 0.;
+    QTest::newRow("+50 ppm") << 50e-6;
+    QTest::newRow("-200 ppm") << -200e-6;
+}
+
+void tst_QCanBusTimeStampNormalizer::drift()
+{
+    QFETCH(double, drift);
+
+    QCanBusTimeStampNormalizer normalizer;
+    const qint64 offset = -3000000;
+
+    // one pair every 100 ms over 60 s with a delay between 20 and 520 us
+    quint32 seed = 1;
+    qint64 raw = 0;
+    for (int i = 0; i < 600; ++i) {
+        raw += 100000;
+        seed = seed * 1103515245 + 12345;
+        const qint64 delay = 20 + (seed >> 16) % 500;
+        const qint64 monotonic = raw + offset + qint64(drift * raw) + delay;
+        normalizer.addSample(raw, monotonic);
+    }
+
+    QVERIFY(qAbs(normalizer.drift() - drift) < 5e-6);
+
+    // a frame sent now maps close to its true time, but never later
+    raw += 50000;
+    const qint64 exact = raw + offset + qint64(drift * raw);
+    const qint64 mapped = normalizer.toMonotonic(raw);
+    QVERIFY2(qAbs(mapped - exact) <= 600, QByteArray::number(mapped - exact));
+}
+
+void tst_QCanBusTimeStampNormalizer::reset()
+{
+    QCanBusTimeStampNormalizer normalizer;
+    for (int i = 0; i < 10; ++i)
+        normalizer.addSample(i * 300000, 7000000 + i * 300000);
+    QCOMPARE(normalizer.toMonotonic(3000000), qint64(10000000));
+
+    // the device clock was set back; the estimate starts over
+    normalizer.addSample(100000, 10100000 + 20);
+    QCOMPARE(normalizer.toMonotonic(100000), qint64(10100020));
+    QCOMPARE(normalizer.drift(), 0.);
+
+    normalizer.reset();
+    QVERIFY(!normalizer.isValid());
+}
+
+QTEST_MAIN(tst_QCanBusTimeStampNormalizer)
+
+#include "tst_qcanbustimestampnormalizer.moc"
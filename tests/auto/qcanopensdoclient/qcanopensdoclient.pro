@@ -0,0 +1,8 @@
+QT = core testlib serialbus
+TARGET = tst_qcanopensdoclient
+CONFIG += testcase c++11
+
+INCLUDEPATH += ../shared
+HEADERS += sdoserver.h \
+    ../shared/canbustestbackend.h
+SOURCES += tst_qcanopensdoclient.cpp
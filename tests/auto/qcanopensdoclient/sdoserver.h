@@ -0,0 +1,345 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef SDOSERVER_H
+#define SDOSERVER_H
+
+#include "canbustestbackend.h"
+
+#include <QtCore/qendian.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qtimer.h>
+
+/*
+    CAN bus device with a simulated CANopen node behind it. Frames written to
+    the device are handled by the node, its responses are received in one
+    batch when the event loop runs next, like frames read from a real bus.
+
+    The node implements expedited, segmented and block transfers of the
+    default SDO channel with an object dictionary kept in a hash. A response
+    delay simulates the turnaround time of a real bus and node.
+*/
+class SdoServerBackend : public CanBusTestBackend
+{
+public:
+    explicit SdoServerBackend(int nodeId = 5)
+        : m_nodeId(nodeId)
+    {}
+
+    static quint32 key(quint16 index, quint8 subIndex) { return (quint32(index) << 8) | subIndex; }
+
+    QHash<quint32, QByteArray> dictionary;
+    bool silent = false;        // never respond
+    int blockSize = 127;        // block size offered for block downloads
+    int dropSegment = 0;        // drop the block segment with this number once
+    bool corruptCrc = false;    // send a wrong CRC at the end of block uploads
+    int responseDelay = 0;      // milliseconds until responses are received
+    int requests = 0;
+
+    bool writeFrame(const QCanBusFrame &frame) override
+    {
+        if (state() != QCanBusDevice::ConnectedState)
+            return false;
+        if (frame.frameId() == quint32(0x600 + m_nodeId) && !silent) {
+            ++requests;
+            handle(frame.payload());
+        }
+        return true;
+    }
+
+    // the reference implementation, bit by bit
+    static quint16 crc16(const QByteArray &data)
+    {
+        quint16 crc = 0;
+        for (const char byte : data) {
+            crc ^= quint16(quint8(byte) << 8);
+            for (int bit = 0; bit < 8; ++bit)
+                crc = (crc & 0x8000) ? quint16((crc << 1) ^ 0x1021) : quint16(crc << 1);
+        }
+        return crc;
+    }
+
+private:
+    enum State {
+        Idle,
+        Downloading,
+        Uploading,
+        BlockDownloading,
+        BlockDownloadEnding,
+        BlockUploadStarting,
+        BlockUploading
+    };
+
+    void respond(const QByteArray &payload)
+    {
+        if (m_pending.isEmpty()) {
+            QTimer::singleShot(responseDelay, this, [this]() {
+                QVector<QCanBusFrame> frames;
+                frames.swap(m_pending);
+                enqueueReceivedFrames(frames);
+            });
+        }
+        QByteArray padded = payload;
+        padded.resize(8);
+        m_pending.append(QCanBusFrame(0x580 + m_nodeId, padded));
+    }
+
+    QByteArray command(quint8 cmd, const QByteArray &data = QByteArray()) const
+    {
+        QByteArray payload(8, 0);
+        payload[0] = char(cmd);
+        qToLittleEndian<quint16>(m_index, reinterpret_cast<uchar *>(payload.data()) + 1);
+        payload[3] = char(m_subIndex);
+        payload.replace(4, data.size(), data);
+        return payload.left(8);
+    }
+
+    void abort(quint32 code)
+    {
+        QByteArray data(4, 0);
+        qToLittleEndian<quint32>(code, reinterpret_cast<uchar *>(data.data()));
+        respond(command(0x80, data));
+        m_state = Idle;
+    }
+
+    QByteArray segment(quint8 cmd, const char *data, int size) const
+    {
+        QByteArray payload(8, 0);
+        payload[0] = char(cmd);
+        memcpy(payload.data() + 1, data, size_t(size));
+        return payload;
+    }
+
+    void sendBlock()
+    {
+        int position = m_offset;
+        for (int sequence = 1; sequence <= m_blockSize && position < m_data.size(); ++sequence) {
+            const int size = qMin(7, m_data.size() - position);
+            const bool last = position + size == m_data.size();
+            if (sequence == dropSegment) {
+                dropSegment = 0;
+            } else {
+                respond(segment((last ? 0x80 : 0) | sequence, m_data.constData() + position,
+                                size));
+            }
+            position += size;
+        }
+    }
+
+    void handle(const QByteArray &payload)
+    {
+        const uchar *bytes = reinterpret_cast<const uchar *>(payload.constData());
+        const quint8 cmd = bytes[0];
+
+        if (cmd == 0x80) {
+            m_state = Idle;
+            return;
+        }
+
+        if (m_state == BlockDownloading) {
+            const int sequence = cmd & 0x7f;
+            if (sequence == dropSegment) {
+                dropSegment = 0;
+                return;
+            }
+            if (sequence == m_sequence + 1) {
+                m_sequence = sequence;
+                m_data.append(payload.mid(1, 7));
+                m_last = cmd & 0x80;
+            }
+            if (sequence < m_blockSize && !(cmd & 0x80))
+                return;
+            QByteArray ack(8, 0);
+            ack[0] = char(0xa2);
+            ack[1] = char(m_sequence);
+            ack[2] = char(m_blockSize);
+            respond(ack);
+            m_sequence = 0;
+            if (m_last)
+                m_state = BlockDownloadEnding;
+            return;
+        }
+
+        if (m_state == BlockDownloadEnding) {
+            if ((cmd & 0xe3) != 0xc1)
+                return abort(0x05040001);
+            m_data.chop((cmd >> 2) & 0x07);
+            if (qFromLittleEndian<quint16>(bytes + 1) != crc16(m_data))
+                return abort(0x05040004);
+            dictionary.insert(key(m_index, m_subIndex), m_data);
+            respond(segment(0xa1, nullptr, 0));
+            m_state = Idle;
+            return;
+        }
+
+        switch (cmd & 0xe0) {
+        case 0x20: // initiate download
+            m_index = qFromLittleEndian<quint16>(bytes + 1);
+            m_subIndex = bytes[3];
+            if (cmd & 0x02) {
+                const int size = (cmd & 0x01) ? 4 - ((cmd >> 2) & 0x03) : 4;
+                dictionary.insert(key(m_index, m_subIndex), payload.mid(4, size));
+            } else {
+                m_data.clear();
+                m_toggle = false;
+                m_state = Downloading;
+            }
+            respond(command(0x60));
+            break;
+        case 0x00: { // download segment
+            if (m_state != Downloading)
+                return abort(0x05040001);
+            if (bool(cmd & 0x10) != m_toggle)
+                return abort(0x05030000);
+            m_data.append(payload.mid(1, 7 - ((cmd >> 1) & 0x07)));
+            respond(segment(0x20 | (m_toggle ? 0x10 : 0), nullptr, 0));
+            m_toggle = !m_toggle;
+            if (cmd & 0x01) {
+                dictionary.insert(key(m_index, m_subIndex), m_data);
+                m_state = Idle;
+            }
+            break;
+        }
+        case 0x40: { // initiate upload
+            m_index = qFromLittleEndian<quint16>(bytes + 1);
+            m_subIndex = bytes[3];
+            if (!dictionary.contains(key(m_index, m_subIndex)))
+                return abort(0x06020000);
+            m_data = dictionary.value(key(m_index, m_subIndex));
+            if (m_data.size() <= 4) {
+                respond(command(0x43 | ((4 - m_data.size()) << 2), m_data));
+                break;
+            }
+            QByteArray size(4, 0);
+            qToLittleEndian<quint32>(quint32(m_data.size()), reinterpret_cast<uchar *>(size.data()));
+            respond(command(0x41, size));
+            m_offset = 0;
+            m_toggle = false;
+            m_state = Uploading;
+            break;
+        }
+        case 0x60: { // upload segment
+            if (m_state != Uploading)
+                return abort(0x05040001);
+            if (bool(cmd & 0x10) != m_toggle)
+                return abort(0x05030000);
+            const int size = qMin(7, m_data.size() - m_offset);
+            const bool last = m_offset + size == m_data.size();
+            respond(segment((m_toggle ? 0x10 : 0) | ((7 - size) << 1) | (last ? 0x01 : 0),
+                            m_data.constData() + m_offset, size));
+            m_offset += size;
+            m_toggle = !m_toggle;
+            if (last)
+                m_state = Idle;
+            break;
+        }
+        case 0xc0: { // initiate block download
+            if (cmd & 0x01)
+                return abort(0x05040001);
+            m_index = qFromLittleEndian<quint16>(bytes + 1);
+            m_subIndex = bytes[3];
+            m_data.clear();
+            m_blockSize = blockSize;
+            m_sequence = 0;
+            m_last = false;
+            m_state = BlockDownloading;
+            QByteArray size(1, char(m_blockSize));
+            respond(command(0xa4, size));
+            break;
+        }
+        case 0xa0: // block upload
+            switch (cmd & 0x03) {
+            case 0x00: { // initiate
+                m_index = qFromLittleEndian<quint16>(bytes + 1);
+                m_subIndex = bytes[3];
+                if (!dictionary.contains(key(m_index, m_subIndex)))
+                    return abort(0x06020000);
+                m_data = dictionary.value(key(m_index, m_subIndex));
+                m_blockSize = bytes[4];
+                m_offset = 0;
+                QByteArray size(4, 0);
+                qToLittleEndian<quint32>(quint32(m_data.size()),
+                                         reinterpret_cast<uchar *>(size.data()));
+                respond(command(0xc6, size));
+                m_state = BlockUploadStarting;
+                break;
+            }
+            case 0x03: // start
+                if (m_state != BlockUploadStarting)
+                    return abort(0x05040001);
+                m_state = BlockUploading;
+                sendBlock();
+                break;
+            case 0x02: // confirmation
+                if (m_state != BlockUploading)
+                    return abort(0x05040001);
+                m_offset = qMin(m_data.size(), m_offset + bytes[1] * 7);
+                m_blockSize = bytes[2];
+                if (m_offset < m_data.size()) {
+                    sendBlock();
+                } else {
+                    QByteArray crc(2, 0);
+                    qToLittleEndian<quint16>(crc16(m_data) ^ (corruptCrc ? 1 : 0),
+                                             reinterpret_cast<uchar *>(crc.data()));
+                    respond(segment(0xc1 | (((7 - m_data.size() % 7) % 7) << 2),
+                                    crc.constData(), 2));
+                }
+                break;
+            case 0x01: // end
+                m_state = Idle;
+                break;
+            }
+            break;
+        default:
+            abort(0x05040001);
+            break;
+        }
+    }
+
+    int m_nodeId;
+    State m_state = Idle;
+    quint16 m_index = 0;
+    quint8 m_subIndex = 0;
+    QByteArray m_data;
+    int m_offset = 0;
+    bool m_toggle = false;
+    int m_blockSize = 0;
+    int m_sequence = 0;
+    bool m_last = false;
+    QVector<QCanBusFrame> m_pending;
+};
+
+#endif // SDOSERVER_H
@@ -0,0 +1,318 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "sdoserver.h"
+
+#include <QtSerialBus/qcanopensdoclient.h>
+#include <QtSerialBus/qcanopensdoreply.h>
+
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+
+class tst_QCanOpenSdoClient : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void invalidArguments();
+    void download_data();
+    void download();
+    void upload_data();
+    void upload();
+    void blockRetransmission();
+    void queuedTransfers();
+    void abort();
+    void timeout();
+    void crcError();
+    void disconnect();
+    void unhandledFrames();
+
+private:
+    QCanOpenSdoReply *waitForFinished(QCanOpenSdoReply *reply);
+    void addTransfers();
+
+    SdoServerBackend *device = nullptr;
+    QCanOpenSdoClient *client = nullptr;
+};
+
+void tst_QCanOpenSdoClient::initTestCase()
+{
+    qRegisterMetaType<QCanOpenSdoReply::Error>();
+}
+
+void tst_QCanOpenSdoClient::init()
+{
+    device = new SdoServerBackend(5);
+    QVERIFY(device->connectDevice());
+    client = new QCanOpenSdoClient(device);
+}
+
+void tst_QCanOpenSdoClient::cleanup()
+{
+    delete client;
+    delete device;
+}
+
+QCanOpenSdoReply *tst_QCanOpenSdoClient::waitForFinished(QCanOpenSdoReply *reply)
+{
+    if (reply && !reply->isFinished()) {
+        QSignalSpy spy(reply, &QCanOpenSdoReply::finished);
+        spy.wait(5000);
+    }
+    return reply;
+}
+
+void tst_QCanOpenSdoClient::invalidArguments()
+{
+    QVERIFY(!client->upload(0, 0x1000, 0));
+    QVERIFY(!client->upload(128, 0x1000, 0));
+    QVERIFY(!client->download(-1, 0x1000, 0, QByteArray("x")));
+
+    device->disconnectDevice();
+    QVERIFY(!client->upload(5, 0x1000, 0));
+
+    QCanOpenSdoClient noDevice(nullptr);
+    QVERIFY(!noDevice.device());
+    QVERIFY(!noDevice.upload(5, 0x1000, 0));
+
+    QCOMPARE(client->timeout(), 1000);
+    client->setTimeout(250);
+    QCOMPARE(client->timeout(), 250);
+    QCOMPARE(client->blockSize(), 127);
+    client->setBlockSize(0);
+    QCOMPARE(client->blockSize(), 1);
+    client->setBlockSize(1000);
+    QCOMPARE(client->blockSize(), 127);
+}
+
+void tst_QCanOpenSdoClient::addTransfers()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<QCanOpenSdoClient::TransferMode>("mode");
+
+    const int sizes[] = { 1, 4, 5, 7, 8, 14, 100, 889, 890, 4096 };
+    for (int size : sizes) {
+        QTest::newRow(qPrintable(QStringLiteral("segmented %1").arg(size)))
+                << size << QCanOpenSdoClient::SegmentedTransfer;
+        QTest::newRow(qPrintable(QStringLiteral("block %1").arg(size)))
+                << size << QCanOpenSdoClient::BlockTransfer;
+    }
+}
+
+static QByteArray testData(int size)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i)
+        data[i] = char(i * 7 + (i >> 8));
+    return data;
+}
+
+void tst_QCanOpenSdoClient::download_data()
+{
+    addTransfers();
+}
+
+void tst_QCanOpenSdoClient::download()
+{
+    QFETCH(int, size);
+    QFETCH(QCanOpenSdoClient::TransferMode, mode);
+
+    const QByteArray data = testData(size);
+    QCanOpenSdoReply *reply = waitForFinished(client->download(5, 0x2000, 3, data, mode));
+    QVERIFY(reply);
+    QVERIFY(reply->isFinished());
+    QCOMPARE(reply->error(), QCanOpenSdoReply::NoError);
+    QCOMPARE(reply->direction(), QCanOpenSdoReply::Download);
+    QCOMPARE(reply->nodeId(), 5);
+    QCOMPARE(reply->index(), quint16(0x2000));
+    QCOMPARE(reply->subIndex(), quint8(3));
+    QCOMPARE(device->dictionary.value(SdoServerBackend::key(0x2000, 3)), data);
+}
+
+void tst_QCanOpenSdoClient::upload_data()
+{
+    addTransfers();
+}
+
+void tst_QCanOpenSdoClient::upload()
+{
+    QFETCH(int, size);
+    QFETCH(QCanOpenSdoClient::TransferMode, mode);
+
+    const QByteArray data = testData(size);
+    device->dictionary.insert(SdoServerBackend::key(0x2001, 0), data);
+    QCanOpenSdoReply *reply = waitForFinished(client->upload(5, 0x2001, 0, mode));
+    QVERIFY(reply);
+    QVERIFY(reply->isFinished());
+    QCOMPARE(reply->error(), QCanOpenSdoReply::NoError);
+    QCOMPARE(reply->direction(), QCanOpenSdoReply::Upload);
+    QCOMPARE(reply->data(), data);
+}
+
+void tst_QCanOpenSdoClient::blockRetransmission()
+{
+    const QByteArray data = testData(2000);
+
+    device->dropSegment = 3;
+    device->blockSize = 16;
+    QCanOpenSdoReply *reply = waitForFinished(client->download(5, 0x2002, 0, data,
+                                                               QCanOpenSdoClient::BlockTransfer));
+    QVERIFY(reply);
+    QCOMPARE(reply->error(), QCanOpenSdoReply::NoError);
+    QCOMPARE(device->dictionary.value(SdoServerBackend::key(0x2002, 0)), data);
+    QCOMPARE(device->dropSegment, 0);
+
+    device->dropSegment = 10;
+    client->setBlockSize(32);
+    reply = waitForFinished(client->upload(5, 0x2002, 0, QCanOpenSdoClient::BlockTransfer));
+    QVERIFY(reply);
+    QCOMPARE(reply->error(), QCanOpenSdoReply::NoError);
+    QCOMPARE(reply->data(), data);
+    QCOMPARE(device->dropSegment, 0);
+}
+
+void tst_QCanOpenSdoClient::queuedTransfers()
+{
+    QVector<QCanOpenSdoReply *> replies;
+    for (int i = 0; i < 8; ++i) {
+        replies.append(client->download(5, 0x3000, quint8(i), testData(20 + i),
+                                        (i % 2) ? QCanOpenSdoClient::BlockTransfer
+                                                : QCanOpenSdoClient::SegmentedTransfer));
+    }
+    QCanOpenSdoReply *last = client->upload(5, 0x3000, 7);
+    waitForFinished(last);
+
+    for (int i = 0; i < 8; ++i) {
+        QVERIFY(replies.at(i)->isFinished());
+        QCOMPARE(replies.at(i)->error(), QCanOpenSdoReply::NoError);
+        QCOMPARE(device->dictionary.value(SdoServerBackend::key(0x3000, quint8(i))),
+                 testData(20 + i));
+    }
+    QCOMPARE(last->error(), QCanOpenSdoReply::NoError);
+    QCOMPARE(last->data(), testData(27));
+}
+
+void tst_QCanOpenSdoClient::abort()
+{
+    QCanOpenSdoReply *reply = client->upload(5, 0x6000, 1);
+    QVERIFY(reply);
+    QSignalSpy errorSpy(reply, &QCanOpenSdoReply::errorOccurred);
+    waitForFinished(reply);
+    QVERIFY(reply->isFinished());
+    QCOMPARE(reply->error(), QCanOpenSdoReply::AbortError);
+    QCOMPARE(reply->abortCode(), quint32(0x06020000));
+    QVERIFY(!reply->errorString().isEmpty());
+    QCOMPARE(errorSpy.count(), 1);
+    QVERIFY(reply->data().isEmpty());
+}
+
+void tst_QCanOpenSdoClient::timeout()
+{
+    device->silent = true;
+    client->setTimeout(50);
+
+    QCanOpenSdoReply *first = client->upload(5, 0x1000, 0);
+    QCanOpenSdoReply *second = client->upload(5, 0x1000, 0);
+    waitForFinished(second);
+
+    QVERIFY(first->isFinished());
+    QCOMPARE(first->error(), QCanOpenSdoReply::TimeoutError);
+    QCOMPARE(first->abortCode(), quint32(0x05040000));
+    QVERIFY(second->isFinished());
+    QCOMPARE(second->error(), QCanOpenSdoReply::TimeoutError);
+}
+
+void tst_QCanOpenSdoClient::crcError()
+{
+    device->corruptCrc = true;
+    device->dictionary.insert(SdoServerBackend::key(0x2003, 0), testData(100));
+    QCanOpenSdoReply *reply = waitForFinished(client->upload(5, 0x2003, 0,
+                                                             QCanOpenSdoClient::BlockTransfer));
+    QVERIFY(reply);
+    QCOMPARE(reply->error(), QCanOpenSdoReply::CrcError);
+    QCOMPARE(reply->abortCode(), quint32(0x05040004));
+    QVERIFY(reply->data().isEmpty());
+}
+
+void tst_QCanOpenSdoClient::disconnect()
+{
+    device->silent = true;
+    QCanOpenSdoReply *first = client->upload(5, 0x1000, 0);
+    QCanOpenSdoReply *second = client->upload(5, 0x1000, 0);
+    QCanOpenSdoReply *third = client->upload(6, 0x1000, 0);
+
+    device->disconnectDevice();
+    for (QCanOpenSdoReply *reply : { first, second, third }) {
+        QVERIFY(reply->isFinished());
+        QCOMPARE(reply->error(), QCanOpenSdoReply::ConnectionError);
+    }
+}
+
+void tst_QCanOpenSdoClient::unhandledFrames()
+{
+    // QCanBusFrame is not a registered meta type, so QSignalSpy cannot record it
+    int emissions = 0;
+    QVector<QCanBusFrame> unhandled;
+    connect(client, &QCanOpenSdoClient::unhandledFramesReceived,
+            [&](const QVector<QCanBusFrame> &frames) {
+        ++emissions;
+        unhandled = frames;
+    });
+    device->dictionary.insert(SdoServerBackend::key(0x1000, 0), QByteArray("\x91\x01\x0f\x00", 4));
+
+    // an SDO response without a running transfer and an unrelated frame
+    const QVector<QCanBusFrame> frames = {
+        QCanBusFrame(0x585, QByteArray(8, 0)),
+        QCanBusFrame(0x181, QByteArray("\x01\x02", 2))
+    };
+    device->receive(frames);
+    QCOMPARE(emissions, 1);
+    QCOMPARE(unhandled.size(), 2);
+    QCOMPARE(unhandled.at(1).frameId(), quint32(0x181));
+
+    QCanOpenSdoReply *reply = waitForFinished(client->upload(5, 0x1000, 0));
+    QCOMPARE(reply->error(), QCanOpenSdoReply::NoError);
+    QCOMPARE(reply->data(), QByteArray("\x91\x01\x0f\x00", 4));
+    QCOMPARE(emissions, 1);
+}
+
+QTEST_MAIN(tst_QCanOpenSdoClient)
+
+#include "tst_qcanopensdoclient.moc"
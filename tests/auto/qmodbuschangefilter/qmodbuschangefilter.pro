@@ -0,0 +1,5 @@
+QT = core testlib serialbus
+TARGET = tst_qmodbuschangefilter
+CONFIG += testcase c++11
+
+SOURCES += tst_qmodbuschangefilter.cpp
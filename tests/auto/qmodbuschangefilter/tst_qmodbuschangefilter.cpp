@@ -0,0 +1,326 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtSerialBus/qmodbuschangefilter.h>
+#include <QtSerialBus/qmodbusreply.h>
+
+#include <QtTest/QtTest>
+
+#include <cstring>
+
+typedef QModbusChangeFilter::Change Change;
+typedef QVector<Change> Changes;
+
+static Changes changes(std::initializer_list<int> pairs)
+{
+    Changes result;
+    for (auto it = pairs.begin(); it != pairs.end(); it += 2)
+        result.append({ *it, quint16(*(it + 1)) });
+    return result;
+}
+
+static bool operator==(const Change &lhs, const Change &rhs)
+{
+    return lhs.address == rhs.address && lhs.value == rhs.value;
+}
+
+static QModbusDataUnit registers(int start, const QVector<quint16> &values)
+{
+    return QModbusDataUnit(QModbusDataUnit::HoldingRegisters, start, values);
+}
+
+static QVector<quint16> floatRegisters(float value)
+{
+    quint32 raw;
+    std::memcpy(&raw, &value, sizeof(raw));
+    return { quint16(raw >> 16), quint16(raw) };
+}
+
+class tst_QModbusChangeFilter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void firstResult();
+    void onlyChanges();
+    void rangesAndServers();
+    void coils();
+    void deadbands();
+    void deadbandDrift();
+    void deadbandTypes_data();
+    void deadbandTypes();
+    void invalidDeadbands();
+    void reset();
+    void watch();
+};
+
+void tst_QModbusChangeFilter::initTestCase()
+{
+    qRegisterMetaType<QModbusDataUnit::RegisterType>();
+    qRegisterMetaType<QVector<QModbusChangeFilter::Change>>();
+}
+
+void tst_QModbusChangeFilter::firstResult()
+{
+    QModbusChangeFilter filter;
+    QVERIFY(filter.filter(1, QModbusDataUnit()).isEmpty());
+
+    QCOMPARE(filter.filter(1, registers(10, { 1, 2, 3 })), changes({ 10, 1, 11, 2, 12, 3 }));
+    QVERIFY(filter.filter(1, registers(10, { 1, 2, 3 })).isEmpty());
+}
+
+void tst_QModbusChangeFilter::onlyChanges()
+{
+    QModbusChangeFilter filter;
+    filter.filter(1, registers(0, { 1, 2, 3, 4, 5 }));
+
+    QCOMPARE(filter.filter(1, registers(0, { 1, 7, 3, 4, 9 })), changes({ 1, 7, 4, 9 }));
+    QVERIFY(filter.filter(1, registers(0, { 1, 7, 3, 4, 9 })).isEmpty());
+    QCOMPARE(filter.filter(1, registers(0, { 0, 7, 3, 4, 9 })), changes({ 0, 0 }));
+}
+
+void tst_QModbusChangeFilter::rangesAndServers()
+{
+    QModbusChangeFilter filter;
+    filter.filter(1, registers(0, { 1, 2 }));
+
+    // a different range, table or server starts over
+    QCOMPARE(filter.filter(1, registers(0, { 1, 2, 3 })).size(), 3);
+    QCOMPARE(filter.filter(2, registers(0, { 1, 2 })).size(), 2);
+    QCOMPARE(filter.filter(1, QModbusDataUnit(QModbusDataUnit::InputRegisters, 0,
+                                              QVector<quint16>({ 1, 2 }))).size(), 2);
+
+    QVERIFY(filter.filter(1, registers(0, { 1, 2 })).isEmpty());
+    QCOMPARE(filter.filter(1, registers(0, { 1, 5, 3 })), changes({ 1, 5 }));
+}
+
+void tst_QModbusChangeFilter::coils()
+{
+    QModbusChangeFilter filter;
+    QVERIFY(!filter.setDeadband(1, QModbusDataUnit::Coils, 0, QModbusChangeFilter::UInt16, 1.));
+
+    QModbusDataUnit unit(QModbusDataUnit::Coils, 100, QVector<quint16>({ 0, 1, 0, 0 }));
+    QCOMPARE(filter.filter(1, unit).size(), 4);
+    unit.setValue(2, 1);
+    QCOMPARE(filter.filter(1, unit), changes({ 102, 1 }));
+}
+
+void tst_QModbusChangeFilter::deadbands()
+{
+    QModbusChangeFilter filter;
+    QVERIFY(filter.setDeadband(1, QModbusDataUnit::HoldingRegisters, 1,
+                               QModbusChangeFilter::Float32, 0.5));
+
+    QVector<quint16> values = { 7 };
+    values += floatRegisters(20.f);
+    values += 8;
+    QCOMPARE(filter.filter(1, registers(0, values)).size(), 4);
+
+    // both registers of the float change, but not by more than the deadband
+    const QVector<quint16> inside = floatRegisters(20.25f);
+    values[1] = inside.at(0);
+    values[2] = inside.at(1);
+    QVERIFY(filter.filter(1, registers(0, values)).isEmpty());
+
+    // other registers are reported without the float
+    values[3] = 9;
+    QCOMPARE(filter.filter(1, registers(0, values)), changes({ 3, 9 }));
+
+    const QVector<quint16> outside = floatRegisters(21.f);
+    values[1] = outside.at(0);
+    values[2] = outside.at(1);
+    QCOMPARE(filter.filter(1, registers(0, values)),
+             changes({ 1, outside.at(0), 2, outside.at(1) }));
+
+    // the deadband only applies to ranges containing the whole value
+    QCOMPARE(filter.filter(1, registers(2, { 1 })).size(), 1);
+    QCOMPARE(filter.filter(1, registers(2, { 2 })), changes({ 2, 2 }));
+
+    filter.removeDeadband(1, QModbusDataUnit::HoldingRegisters, 1);
+    const QVector<quint16> small = floatRegisters(21.0625f);
+    values[2] = small.at(1);
+    QCOMPARE(filter.filter(1, registers(0, values)), changes({ 2, small.at(1) }));
+}
+
+void tst_QModbusChangeFilter::deadbandDrift()
+{
+    QModbusChangeFilter filter;
+    filter.setDeadband(1, QModbusDataUnit::HoldingRegisters, 0, QModbusChangeFilter::UInt16, 10.);
+
+    QCOMPARE(filter.filter(1, registers(0, { 100 })), changes({ 0, 100 }));
+    QVERIFY(filter.filter(1, registers(0, { 104 })).isEmpty());
+    QVERIFY(filter.filter(1, registers(0, { 108 })).isEmpty());
+    QVERIFY(filter.filter(1, registers(0, { 110 })).isEmpty());
+    // compared with the last reported value, not with the previous poll
+    QCOMPARE(filter.filter(1, registers(0, { 111 })), changes({ 0, 111 }));
+    QVERIFY(filter.filter(1, registers(0, { 101 })).isEmpty());
+    QCOMPARE(filter.filter(1, registers(0, { 100 })), changes({ 0, 100 }));
+}
+
+void tst_QModbusChangeFilter::deadbandTypes_data()
+{
+    QTest::addColumn<int>("type");
+    QTest::addColumn<int>("order");
+    QTest::addColumn<QVector<quint16>>("before");
+    QTest::addColumn<QVector<quint16>>("after");
+    QTest::addColumn<double>("deadband");
+    QTest::addColumn<bool>("reported");
+
+    QTest::newRow("int16 wraps") << int(QModbusChangeFilter::Int16)
+        << int(QModbusChangeFilter::HighWordFirst)
+        << QVector<quint16>({ 0xffff }) << QVector<quint16>({ 0x0001 }) << 5. << false;
+    QTest::newRow("uint16 wraps") << int(QModbusChangeFilter::UInt16)
+        << int(QModbusChangeFilter::HighWordFirst)
+        << QVector<quint16>({ 0xffff }) << QVector<quint16>({ 0x0001 }) << 5. << true;
+    QTest::newRow("uint32 high word first") << int(QModbusChangeFilter::UInt32)
+        << int(QModbusChangeFilter::HighWordFirst)
+        << QVector<quint16>({ 0x0001, 0x0000 }) << QVector<quint16>({ 0x0000, 0xffff }) << 5.
+        << false;
+    QTest::newRow("uint32 low word first") << int(QModbusChangeFilter::UInt32)
+        << int(QModbusChangeFilter::LowWordFirst)
+        << QVector<quint16>({ 0x0000, 0x0001 }) << QVector<quint16>({ 0xffff, 0x0000 }) << 5.
+        << false;
+    QTest::newRow("int32 negative") << int(QModbusChangeFilter::Int32)
+        << int(QModbusChangeFilter::HighWordFirst)
+        << QVector<quint16>({ 0xffff, 0xfff0 }) << QVector<quint16>({ 0x0000, 0x0010 }) << 30.
+        << true;
+    QTest::newRow("float nan") << int(QModbusChangeFilter::Float32)
+        << int(QModbusChangeFilter::HighWordFirst)
+        << floatRegisters(1.f) << QVector<quint16>({ 0x7fc0, 0x0000 }) << 100. << true;
+    QTest::newRow("float zero deadband") << int(QModbusChangeFilter::Float32)
+        << int(QModbusChangeFilter::HighWordFirst)
+        << floatRegisters(0.f) << floatRegisters(-0.f) << 0. << false;
+}
+
+void tst_QModbusChangeFilter::deadbandTypes()
+{
+    QFETCH(int, type);
+    QFETCH(int, order);
+    QFETCH(QVector<quint16>, before);
+    QFETCH(QVector<quint16>, after);
+    QFETCH(double, deadband);
+    QFETCH(bool, reported);
+
+    QModbusChangeFilter filter;
+    QVERIFY(filter.setDeadband(1, QModbusDataUnit::HoldingRegisters, 0,
+                               QModbusChangeFilter::ValueType(type), deadband,
+                               QModbusChangeFilter::WordOrder(order)));
+    filter.filter(1, registers(0, before));
+    QCOMPARE(filter.filter(1, registers(0, after)).isEmpty(), !reported);
+}
+
+void tst_QModbusChangeFilter::invalidDeadbands()
+{
+    QModbusChangeFilter filter;
+    QVERIFY(!filter.setDeadband(1, QModbusDataUnit::DiscreteInputs, 0,
+                                QModbusChangeFilter::UInt16, 1.));
+    QVERIFY(!filter.setDeadband(1, QModbusDataUnit::HoldingRegisters, -1,
+                                QModbusChangeFilter::UInt16, 1.));
+    QVERIFY(!filter.setDeadband(1, QModbusDataUnit::HoldingRegisters, 0xffff,
+                                QModbusChangeFilter::Float32, 1.));
+    QVERIFY(!filter.setDeadband(1, QModbusDataUnit::HoldingRegisters, 0,
+                                QModbusChangeFilter::UInt16, -1.));
+    QVERIFY(filter.setDeadband(1, QModbusDataUnit::InputRegisters, 0xffff,
+                               QModbusChangeFilter::UInt16, 1.));
+
+    // replacing a deadband at the same address
+    QVERIFY(filter.setDeadband(1, QModbusDataUnit::HoldingRegisters, 0,
+                               QModbusChangeFilter::UInt16, 100.));
+    QVERIFY(filter.setDeadband(1, QModbusDataUnit::HoldingRegisters, 0,
+                               QModbusChangeFilter::UInt16, 1.));
+    filter.filter(1, registers(0, { 10 }));
+    QCOMPARE(filter.filter(1, registers(0, { 12 })), changes({ 0, 12 }));
+}
+
+void tst_QModbusChangeFilter::reset()
+{
+    QModbusChangeFilter filter;
+    filter.setDeadband(1, QModbusDataUnit::HoldingRegisters, 0, QModbusChangeFilter::UInt16, 10.);
+    filter.filter(1, registers(0, { 1, 2 }));
+    filter.filter(2, registers(0, { 1, 2 }));
+
+    filter.reset(2);
+    QVERIFY(filter.filter(1, registers(0, { 1, 2 })).isEmpty());
+    QCOMPARE(filter.filter(2, registers(0, { 1, 2 })).size(), 2);
+
+    filter.reset();
+    QCOMPARE(filter.filter(1, registers(0, { 1, 2 })).size(), 2);
+    // deadbands survive a reset
+    QVERIFY(filter.filter(1, registers(0, { 5, 2 })).isEmpty());
+}
+
+void tst_QModbusChangeFilter::watch()
+{
+    QModbusChangeFilter filter;
+    QSignalSpy spy(&filter, &QModbusChangeFilter::valuesChanged);
+
+    QModbusReply first(QModbusReply::Common, 3);
+    filter.watch(&first);
+    QCOMPARE(spy.count(), 0);
+    first.setResult(registers(0, { 1, 2 }));
+    first.setFinished(true);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toInt(), 3);
+    QCOMPARE(spy.at(0).at(1).value<QModbusDataUnit::RegisterType>(),
+             QModbusDataUnit::HoldingRegisters);
+    QCOMPARE(spy.at(0).at(2).value<Changes>().size(), 2);
+
+    // unchanged results are not signaled
+    QModbusReply same(QModbusReply::Common, 3);
+    same.setResult(registers(0, { 1, 2 }));
+    same.setFinished(true);
+    filter.watch(&same);
+    QCOMPARE(spy.count(), 1);
+
+    QModbusReply failed(QModbusReply::Common, 3);
+    filter.watch(&failed);
+    failed.setResult(registers(0, { 4, 4 }));
+    failed.setError(QModbusDevice::TimeoutError, QStringLiteral("timeout"));
+    QCOMPARE(spy.count(), 1);
+
+    QModbusReply changed(QModbusReply::Common, 3);
+    filter.watch(&changed);
+    changed.setResult(registers(0, { 1, 9 }));
+    changed.setFinished(true);
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(1).at(2).value<Changes>(), changes({ 1, 9 }));
+}
+
+QTEST_MAIN(tst_QModbusChangeFilter)
+
+#include "tst_qmodbuschangefilter.moc"
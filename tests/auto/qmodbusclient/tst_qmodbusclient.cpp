@@ -74,6 +74,31 @@ public:
     Q_DECLARE_PRIVATE(TestClient)
 };
 
+class SubmitThread : public QThread
+{
+public:
+    SubmitThread(QModbusClient *client, int id, int count, QObject *context,
+                 const QModbusClient::ReplyHandler &handler)
+        : m_client(client), m_id(id), m_count(count), m_context(context), m_handler(handler)
+    {}
+
+protected:
+    void run() override
+    {
+        for (int i = 0; i < m_count; ++i) {
+            m_client->submitRawRequest(QModbusRequest(QModbusRequest::Diagnostics),
+                                       m_id * 1000 + i, m_context, m_handler);
+        }
+    }
+
+private:
+    QModbusClient *m_client;
+    int m_id;
+    int m_count;
+    QObject *m_context;
+    QModbusClient::ReplyHandler m_handler;
+};
+
 class tst_QModbusClient : public QObject
 {
     Q_OBJECT
@@ -478,6 +503,78 @@ private slots:
         QCOMPARE(client.d_func()->sendRequest(request, 1, &unit), reply);
         QCOMPARE(client.d_func()->sendRequest(request, 1, nullptr), reply);
     }
+
+    void testSubmitFromThreads()
+    {
+        QLoggingCategory::setFilterRules(QStringLiteral("qt.modbus.warning=false"));
+
+        // The client stays disconnected, so every submission ends in a ConnectionError reply.
+        TestClient client;
+        QObject context;
+        QHash<int, QVector<int>> received;
+        int finished = 0;
+        int wrongThread = 0;
+        int wrongError = 0;
+        const QModbusClient::ReplyHandler handler = [&](QModbusReply *reply) {
+            ++finished;
+            if (QThread::currentThread() != context.thread())
+                ++wrongThread;
+            if (reply->error() != QModbusDevice::ConnectionError || !reply->isFinished())
+                ++wrongError;
+            received[reply->serverAddress() / 1000].append(reply->serverAddress() % 1000);
+            reply->deleteLater();
+        };
+
+        const int producers = 4;
+        const int count = 250;
+        QVector<SubmitThread *> threads;
+        for (int i = 0; i < producers; ++i)
+            threads.append(new SubmitThread(&client, i, count, &context, handler));
+        for (SubmitThread *thread : threads)
+            thread->start();
+        for (SubmitThread *thread : threads)
+            QVERIFY(thread->wait(5000));
+        qDeleteAll(threads);
+
+        QTRY_COMPARE(finished, producers * count);
+        QCOMPARE(wrongThread, 0);
+        QCOMPARE(wrongError, 0);
+
+        // submissions of a single producer must complete in submission order
+        for (int i = 0; i < producers; ++i) {
+            QCOMPARE(received.value(i).size(), count);
+            for (int j = 0; j < count; ++j)
+                QCOMPARE(received.value(i).at(j), j);
+        }
+
+        QLoggingCategory::setFilterRules(QString());
+    }
+
+    void testSubmitAbortedOnDestruction()
+    {
+        QObject context;
+        int aborted = 0;
+        int wrongError = 0;
+        const QModbusClient::ReplyHandler handler = [&](QModbusReply *reply) {
+            ++aborted;
+            if (reply->error() != QModbusDevice::ReplyAbortedError || !reply->isFinished())
+                ++wrongError;
+            reply->deleteLater();
+        };
+
+        {
+            TestClient client;
+            // submitted from another thread, destroyed before the queue is drained
+            SubmitThread thread(&client, 0, 10, &context, handler);
+            thread.start();
+            QVERIFY(thread.wait(5000));
+            client.submitRawRequest(QModbusRequest(QModbusRequest::Diagnostics), 1, nullptr,
+                                    handler);
+        }
+
+        QCOMPARE(aborted, 11);
+        QCOMPARE(wrongError, 0);
+    }
 };
 
 QTEST_MAIN(tst_QModbusClient)
@@ -48,6 +48,7 @@ private slots:
     void tst_setError_data();
     void tst_setError();
     void tst_setResult();
+    void tst_finishedHook();
 };
 
 void tst_QModbusReply::initTestCase()
@@ -221,6 +222,36 @@ void tst_QModbusReply::tst_setResult()
     QCOMPARE(tmp.data(), QByteArray::fromHex("0000"));
 }
 
+static void countHookCall(void *data)
+{
+    ++*static_cast<int *>(data);
+}
+
+void tst_QModbusReply::tst_finishedHook()
+{
+    QModbusReply replyTest(QModbusReply::Common, 1);
+    QSignalSpy finishedSpy(&replyTest, SIGNAL(finished()));
+
+    int calls = 0;
+    replyTest.setFinishedHook(&countHookCall, &calls);
+    replyTest.setFinished(false);
+    QCOMPARE(calls, 0);
+
+    replyTest.setError(QModbusDevice::TimeoutError, QStringLiteral("timeout"));
+    QCOMPARE(finishedSpy.count(), 1);
+    QCOMPARE(calls, 1);
+
+    // the hook is called only once
+    replyTest.setFinished(true);
+    QCOMPARE(finishedSpy.count(), 2);
+    QCOMPARE(calls, 1);
+
+    replyTest.setFinishedHook(&countHookCall, &calls);
+    replyTest.setFinishedHook(nullptr, nullptr);
+    replyTest.setFinished(true);
+    QCOMPARE(calls, 1);
+}
+
 QTEST_MAIN(tst_QModbusReply)
 
 #include "tst_qmodbusreply.moc"
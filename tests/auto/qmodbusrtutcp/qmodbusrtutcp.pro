@@ -0,0 +1,7 @@
+QT = core network testlib serialbus serialbus-private
+TARGET = tst_qmodbusrtutcp
+CONFIG += testcase c++11
+
+CONFIG -= app_bundle
+
+SOURCES += tst_qmodbusrtutcp.cpp
@@ -0,0 +1,236 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtNetwork/qtcpserver.h>
+#include <QtNetwork/qtcpsocket.h>
+#include <QtSerialBus/qmodbusrtutcpclient.h>
+#include <QtSerialBus/qmodbusrtutcpserver.h>
+#include <private/qmodbusadu_p.h>
+
+#include <QtTest/QtTest>
+
+static int freePort()
+{
+    QTcpServer probe;
+    if (!probe.listen(QHostAddress::LocalHost))
+        return -1;
+    return probe.serverPort();
+}
+
+class tst_QModbusRtuTcp : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void clientServer();
+    void pipelining();
+    void resynchronization();
+
+private:
+    void setupClient(QModbusRtuTcpClient *client, int port);
+};
+
+void tst_QModbusRtuTcp::initTestCase()
+{
+    qRegisterMetaType<QModbusDevice::State>();
+}
+
+void tst_QModbusRtuTcp::setupClient(QModbusRtuTcpClient *client, int port)
+{
+    client->setConnectionParameter(QModbusDevice::NetworkAddressParameter,
+                                   QStringLiteral("127.0.0.1"));
+    client->setConnectionParameter(QModbusDevice::NetworkPortParameter, port);
+    client->setTimeout(200);
+    client->setNumberOfRetries(0);
+}
+
+void tst_QModbusRtuTcp::clientServer()
+{
+    const int port = freePort();
+    QVERIFY(port > 0);
+
+    QModbusRtuTcpServer server;
+    QCOMPARE(server.serverAddress(), 1);
+    QModbusDataUnitMap map;
+    map.insert(QModbusDataUnit::HoldingRegisters, { QModbusDataUnit::HoldingRegisters, 0, 4 });
+    server.setMap(map);
+    server.setData(QModbusDataUnit::HoldingRegisters, 2, 0x1234);
+    server.setConnectionParameter(QModbusDevice::NetworkAddressParameter,
+                                  QStringLiteral("127.0.0.1"));
+    server.setConnectionParameter(QModbusDevice::NetworkPortParameter, port);
+    QVERIFY(server.connectDevice());
+
+    QModbusRtuTcpClient client;
+    setupClient(&client, port);
+    QVERIFY(client.connectDevice());
+    QTRY_COMPARE(client.state(), QModbusDevice::ConnectedState);
+
+    QModbusReply *reply = client.sendReadRequest(
+        QModbusDataUnit(QModbusDataUnit::HoldingRegisters, 1, 2), 1);
+    QVERIFY(reply);
+    QTRY_VERIFY(reply->isFinished());
+    QCOMPARE(reply->error(), QModbusDevice::NoError);
+    QCOMPARE(reply->result().values(), QVector<quint16>() << 0 << 0x1234);
+    delete reply;
+
+    // no server with that address behind the device server
+    reply = client.sendReadRequest(QModbusDataUnit(QModbusDataUnit::HoldingRegisters, 1, 2), 7);
+    QVERIFY(reply);
+    QTRY_VERIFY(reply->isFinished());
+    QCOMPARE(reply->error(), QModbusDevice::TimeoutError);
+    delete reply;
+
+    // a broadcast is processed, but not answered
+    reply = client.sendWriteRequest(
+        QModbusDataUnit(QModbusDataUnit::HoldingRegisters, 3, QVector<quint16>() << 0xabcd), 0);
+    QVERIFY(reply);
+    QTRY_VERIFY(reply->isFinished());
+    QCOMPARE(reply->error(), QModbusDevice::TimeoutError);
+    quint16 value = 0;
+    QVERIFY(server.data(QModbusDataUnit::HoldingRegisters, 3, &value));
+    QCOMPARE(value, quint16(0xabcd));
+    delete reply;
+}
+
+void tst_QModbusRtuTcp::pipelining()
+{
+    // Plays a device server with two RTU devices behind it that answer in reverse order.
+    QTcpServer gateway;
+    QVERIFY(gateway.listen(QHostAddress::LocalHost));
+
+    QTcpSocket *connection = nullptr;
+    QByteArray received;
+    connect(&gateway, &QTcpServer::newConnection, [&]() {
+        connection = gateway.nextPendingConnection();
+        connect(connection, &QIODevice::readyRead, [&]() { received += connection->readAll(); });
+    });
+
+    QModbusRtuTcpClient client;
+    setupClient(&client, gateway.serverPort());
+    client.setTimeout(5000);
+    QVERIFY(client.connectDevice());
+    QTRY_COMPARE(client.state(), QModbusDevice::ConnectedState);
+    QTRY_VERIFY(connection);
+
+    const QModbusDataUnit unit(QModbusDataUnit::HoldingRegisters, 0, 1);
+    QScopedPointer<QModbusReply> first(client.sendReadRequest(unit, 1));
+    QScopedPointer<QModbusReply> second(client.sendReadRequest(unit, 2));
+    QScopedPointer<QModbusReply> third(client.sendReadRequest(unit, 1));
+    QVERIFY(first && second && third);
+
+    const QModbusRequest request(QModbusRequest::ReadHoldingRegisters, quint16(0), quint16(1));
+    const QByteArray toFirst = QModbusSerialAdu::create(QModbusSerialAdu::Rtu, 1, request);
+    const QByteArray toSecond = QModbusSerialAdu::create(QModbusSerialAdu::Rtu, 2, request);
+
+    // both servers are asked at once, the second request to server 1 has to wait
+    QTRY_COMPARE(received, toFirst + toSecond);
+    QTest::qWait(50);
+    QCOMPARE(received, toFirst + toSecond);
+    received.clear();
+
+    auto answer = [&](int serverAddress, quint16 value) {
+        const QModbusResponse response(QModbusResponse::ReadHoldingRegisters, quint8(2),
+                                       QVector<quint16>() << value);
+        connection->write(QModbusSerialAdu::create(QModbusSerialAdu::Rtu, serverAddress,
+                                                   response));
+    };
+
+    answer(2, 0x2222);
+    QTRY_VERIFY(second->isFinished());
+    QVERIFY(!first->isFinished());
+    QCOMPARE(second->result().values(), QVector<quint16>() << 0x2222);
+
+    answer(1, 0x1111);
+    QTRY_VERIFY(first->isFinished());
+    QCOMPARE(first->error(), QModbusDevice::NoError);
+    QCOMPARE(first->result().values(), QVector<quint16>() << 0x1111);
+
+    QTRY_COMPARE(received, toFirst);
+    QVERIFY(!third->isFinished());
+    answer(1, 0x3333);
+    QTRY_VERIFY(third->isFinished());
+    QCOMPARE(third->error(), QModbusDevice::NoError);
+    QCOMPARE(third->result().values(), QVector<quint16>() << 0x3333);
+}
+
+void tst_QModbusRtuTcp::resynchronization()
+{
+    // Plays a device server that forwards a corrupted response ahead of the correct one.
+    QTcpServer gateway;
+    QVERIFY(gateway.listen(QHostAddress::LocalHost));
+
+    QTcpSocket *connection = nullptr;
+    QByteArray received;
+    connect(&gateway, &QTcpServer::newConnection, [&]() {
+        connection = gateway.nextPendingConnection();
+        connect(connection, &QIODevice::readyRead, [&]() { received += connection->readAll(); });
+    });
+
+    QModbusRtuTcpClient client;
+    setupClient(&client, gateway.serverPort());
+    client.setTimeout(5000);
+    QVERIFY(client.connectDevice());
+    QTRY_COMPARE(client.state(), QModbusDevice::ConnectedState);
+    QTRY_VERIFY(connection);
+
+    QScopedPointer<QModbusReply> reply(client.sendReadRequest(
+        QModbusDataUnit(QModbusDataUnit::HoldingRegisters, 0, 1), 1));
+    QVERIFY(reply);
+    QTRY_VERIFY(!received.isEmpty());
+
+    auto response = [](quint16 value) {
+        return QModbusSerialAdu::create(QModbusSerialAdu::Rtu, 1,
+            QModbusResponse(QModbusResponse::ReadHoldingRegisters, quint8(2),
+                            QVector<quint16>() << value));
+    };
+
+    // None of the bytes inside the corrupted frame starts a frame longer than
+    // the pending data, so the client gets to the correct one without waiting.
+    QByteArray corrupted = response(0x0000);
+    corrupted[corrupted.size() - 1] = corrupted.at(corrupted.size() - 1) ^ 0x01;
+    connection->write(corrupted + response(0x1111));
+
+    QTRY_VERIFY(reply->isFinished());
+    QCOMPARE(reply->error(), QModbusDevice::NoError);
+    QCOMPARE(reply->result().values(), QVector<quint16>() << 0x1111);
+}
+
+QTEST_MAIN(tst_QModbusRtuTcp)
+
+#include "tst_qmodbusrtutcp.moc"
@@ -46,6 +46,7 @@ class TestServer : public QModbusServer
 public:
     TestServer() {
         qRegisterMetaType<QModbusDataUnit::RegisterType>();
+        qRegisterMetaType<QVector<QModbusDataUnit>>();
     }
 
     bool open() override {
@@ -1136,6 +1137,115 @@ private slots:
         QCOMPARE(local.setData(missing), false);
     }
 
+    void testBulkSetData()
+    {
+        QSignalSpy writtenSpy(&server, SIGNAL(dataWritten(QModbusDataUnit::RegisterType,int,int)));
+        QSignalSpy batchSpy(&server, SIGNAL(dataBatchWritten(QVector<QModbusDataUnit>)));
+
+        const QVector<QModbusDataUnit> units = {
+            { QModbusDataUnit::HoldingRegisters, 10, QVector<quint16>() << 1 << 2 << 3 },
+            { QModbusDataUnit::Coils, 0, QVector<quint16>() << 1 << 0 << 1 },
+            { QModbusDataUnit::HoldingRegisters, MAP_RANGE - 2, QVector<quint16>() << 4 << 5 }
+        };
+        QVERIFY(server.setData(units, QModbusServer::BatchNotification));
+        QCOMPARE(writtenSpy.count(), 0);
+        QCOMPARE(batchSpy.count(), 1);
+        const QVector<QModbusDataUnit> changed
+            = batchSpy.at(0).at(0).value<QVector<QModbusDataUnit>>();
+        QCOMPARE(changed.count(), 3);
+        QCOMPARE(changed.at(2).startAddress(), MAP_RANGE - 2);
+
+        QModbusDataUnit holding(QModbusDataUnit::HoldingRegisters, 10, 3);
+        QVERIFY(server.data(&holding));
+        QCOMPARE(holding.values(), QVector<quint16>() << 1 << 2 << 3);
+        quint16 value = 0;
+        QVERIFY(server.data(QModbusDataUnit::HoldingRegisters, MAP_RANGE - 1, &value));
+        QCOMPARE(value, quint16(5));
+        QVERIFY(server.data(QModbusDataUnit::Coils, 2, &value));
+        QCOMPARE(value, quint16(1));
+
+        // unchanged values are not reported
+        QVERIFY(server.setData(units, QModbusServer::BatchNotification));
+        QCOMPARE(batchSpy.count(), 1);
+
+        // one invalid range rejects the whole update
+        const QVector<QModbusDataUnit> invalid = {
+            { QModbusDataUnit::HoldingRegisters, 10, QVector<quint16>() << 7 },
+            { QModbusDataUnit::HoldingRegisters, MAP_RANGE - 1, QVector<quint16>() << 7 << 7 }
+        };
+        QVERIFY(!server.setData(invalid, QModbusServer::BatchNotification));
+        QVERIFY(server.data(QModbusDataUnit::HoldingRegisters, 10, &value));
+        QCOMPARE(value, quint16(1));
+        QCOMPARE(batchSpy.count(), 1);
+
+        const QVector<QModbusDataUnit> update = {
+            { QModbusDataUnit::HoldingRegisters, 10, QVector<quint16>() << 8 },
+            { QModbusDataUnit::HoldingRegisters, 11, QVector<quint16>() << 2 },
+            { QModbusDataUnit::InputRegisters, 20, QVector<quint16>() << 9 << 9 }
+        };
+        QVERIFY(server.setData(update, QModbusServer::RangeNotification));
+        QCOMPARE(batchSpy.count(), 1);
+        QCOMPARE(writtenSpy.count(), 2);
+        QCOMPARE(writtenSpy.at(0).at(0).value<QModbusDataUnit::RegisterType>(),
+                 QModbusDataUnit::HoldingRegisters);
+        QCOMPARE(writtenSpy.at(0).at(1).toInt(), 10);
+        QCOMPARE(writtenSpy.at(1).at(0).value<QModbusDataUnit::RegisterType>(),
+                 QModbusDataUnit::InputRegisters);
+        QCOMPARE(writtenSpy.at(1).at(2).toInt(), 2);
+
+        QVERIFY(server.setData({ { QModbusDataUnit::HoldingRegisters, 10, QVector<quint16>() << 0 } },
+                               QModbusServer::NoNotification));
+        QCOMPARE(batchSpy.count(), 1);
+        QCOMPARE(writtenSpy.count(), 2);
+        QVERIFY(server.data(QModbusDataUnit::HoldingRegisters, 10, &value));
+        QCOMPARE(value, quint16(0));
+
+        // by default, every changed range is reported like a single setData()
+        QVERIFY(server.setData({ { QModbusDataUnit::Coils, 1, QVector<quint16>() << 1 } }));
+        QCOMPARE(batchSpy.count(), 1);
+        QCOMPARE(writtenSpy.count(), 3);
+        QCOMPARE(writtenSpy.at(2).at(1).toInt(), 1);
+
+        QModbusDataUnit missing(QModbusDataUnit::HoldingRegisters);
+        TestServer local;
+        local.setMap({ { QModbusDataUnit::Coils, QModbusDataUnit(QModbusDataUnit::Coils, 0, 4) } });
+        QVERIFY(!local.setData(QVector<QModbusDataUnit>() << missing));
+    }
+
+    void testBulkSetDataMapOffset()
+    {
+        // map values are indexed by register address, the map starts at address 10
+        TestServer local;
+        QModbusDataUnit holding(QModbusDataUnit::HoldingRegisters, 10, QVector<quint16>(20));
+        holding.setValueCount(10);
+        local.setMap({ { QModbusDataUnit::HoldingRegisters, holding } });
+
+        QVERIFY(local.setData({ { QModbusDataUnit::HoldingRegisters, 12,
+                                  QVector<quint16>() << 1 << 2 } }));
+        quint16 value = 0;
+        QVERIFY(local.data(QModbusDataUnit::HoldingRegisters, 12, &value));
+        QCOMPARE(value, quint16(1));
+        QVERIFY(local.data(QModbusDataUnit::HoldingRegisters, 13, &value));
+        QCOMPARE(value, quint16(2));
+
+        // single and bulk updates address the same registers
+        QVERIFY(local.setData(QModbusDataUnit::HoldingRegisters, 19, 3u));
+        QModbusDataUnit range(QModbusDataUnit::HoldingRegisters, 12, 8);
+        QVERIFY(local.data(&range));
+        QCOMPARE(range.values(), QVector<quint16>() << 1 << 2 << 0 << 0 << 0 << 0 << 0 << 3);
+        QVERIFY(local.setData({ { QModbusDataUnit::HoldingRegisters, 19,
+                                  QVector<quint16>() << 4 } }));
+        QVERIFY(local.data(QModbusDataUnit::HoldingRegisters, 19, &value));
+        QCOMPARE(value, quint16(4));
+
+        // outside of the map range
+        QVERIFY(!local.setData({ { QModbusDataUnit::HoldingRegisters, 9,
+                                   QVector<quint16>() << 1 } }));
+        QVERIFY(!local.setData({ { QModbusDataUnit::HoldingRegisters, 19,
+                                   QVector<quint16>() << 1 << 1 } }));
+        QVERIFY(!local.setData(QModbusDataUnit::HoldingRegisters, 20, 1u));
+    }
+
     void testIllegalTcpFunctionCodes()
     {
         class ModbusTcpServer : public QModbusTcpServer
@@ -0,0 +1,5 @@
+QT = core network testlib serialbus
+TARGET = tst_qmodbustcpserver
+CONFIG += testcase c++11
+
+SOURCES += tst_qmodbustcpserver.cpp
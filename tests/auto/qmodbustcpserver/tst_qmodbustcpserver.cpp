@@ -0,0 +1,319 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtCore/qrunnable.h>
+#include <QtCore/qsemaphore.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qthreadpool.h>
+#include <QtNetwork/qtcpserver.h>
+#include <QtNetwork/qtcpsocket.h>
+#include <QtSerialBus/qmodbustcpserver.h>
+
+#include <QtTest/QtTest>
+
+static int freePort()
+{
+    QTcpServer probe;
+    if (!probe.listen(QHostAddress::LocalHost))
+        return -1;
+    return probe.serverPort();
+}
+
+static QByteArray readRequest(quint16 transactionId, quint16 address)
+{
+    QByteArray adu;
+    QDataStream output(&adu, QIODevice::WriteOnly);
+    output << transactionId << quint16(0) << quint16(6) << quint8(1)
+           << quint8(QModbusPdu::ReadHoldingRegisters) << address << quint16(1);
+    return adu;
+}
+
+static QByteArray request(quint16 transactionId, QModbusPdu::FunctionCode code,
+                          const QByteArray &data)
+{
+    QByteArray adu;
+    QDataStream output(&adu, QIODevice::WriteOnly);
+    output << transactionId << quint16(0) << quint16(2 + data.size()) << quint8(1)
+           << quint8(code);
+    output.writeRawData(data.constData(), data.size());
+    return adu;
+}
+
+static quint16 transactionId(const QByteArray &adu)
+{
+    return quint16(quint8(adu.at(0)) << 8 | quint8(adu.at(1)));
+}
+
+// Reading address 0 blocks until the gate is opened, any other read passes.
+class GatedServer : public QModbusTcpServer
+{
+public:
+    ~GatedServer() { disconnectDevice(); }
+
+    mutable QSemaphore gate;
+    mutable QAtomicInt gatedReads;
+    mutable QAtomicInt passedReads;
+    mutable QAtomicInt otherReads;
+
+protected:
+    bool readData(QModbusDataUnit *newData) const override
+    {
+        if (newData->startAddress() == 0) {
+            gatedReads.ref();
+            gate.tryAcquire(1, 5000);
+            passedReads.ref();
+        } else {
+            otherReads.ref();
+        }
+        return QModbusTcpServer::readData(newData);
+    }
+};
+
+// Records the threads processing a register read and a non-standard request.
+class ThreadRecordingServer : public QModbusTcpServer
+{
+public:
+    ~ThreadRecordingServer() { disconnectDevice(); }
+
+    mutable QAtomicPointer<QThread> readThread;
+    QAtomicPointer<QThread> privateRequestThread;
+
+protected:
+    bool readData(QModbusDataUnit *newData) const override
+    {
+        readThread.store(QThread::currentThread());
+        return QModbusTcpServer::readData(newData);
+    }
+
+    QModbusResponse processPrivateRequest(const QModbusPdu &request) override
+    {
+        privateRequestThread.store(QThread::currentThread());
+        return QModbusResponse(request.functionCode(), quint16(0));
+    }
+};
+
+class GateOpener : public QRunnable
+{
+public:
+    explicit GateOpener(QSemaphore *gate) : m_gate(gate) {}
+
+    void run() override
+    {
+        QThread::msleep(100);
+        m_gate->release();
+    }
+
+private:
+    QSemaphore *m_gate;
+};
+
+class tst_QModbusTcpServer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void threadPool();
+    void concurrentProcessing_data();
+    void concurrentProcessing();
+    void serialOnlyInServerThread();
+    void exclusiveReadModifyWrite();
+    void closeWaitsForPool();
+
+private:
+    bool startServer(QModbusTcpServer *server, QThreadPool *pool, int port);
+};
+
+bool tst_QModbusTcpServer::startServer(QModbusTcpServer *server, QThreadPool *pool, int port)
+{
+    server->setServerAddress(1);
+    QModbusDataUnitMap map;
+    map.insert(QModbusDataUnit::HoldingRegisters, { QModbusDataUnit::HoldingRegisters, 0, 2 });
+    server->setMap(map);
+    server->setData(QModbusDataUnit::HoldingRegisters, 0, 0x1111);
+    server->setData(QModbusDataUnit::HoldingRegisters, 1, 0x2222);
+    server->setThreadPool(pool);
+    server->setConnectionParameter(QModbusDevice::NetworkAddressParameter,
+                                   QStringLiteral("127.0.0.1"));
+    server->setConnectionParameter(QModbusDevice::NetworkPortParameter, port);
+    return server->connectDevice();
+}
+
+void tst_QModbusTcpServer::threadPool()
+{
+    QThreadPool pool;
+    QModbusTcpServer server;
+    QCOMPARE(server.threadPool(), static_cast<QThreadPool *>(nullptr));
+    QCOMPARE(server.responseOrder(), QModbusTcpServer::RequestOrder);
+
+    server.setThreadPool(&pool);
+    QCOMPARE(server.threadPool(), &pool);
+    server.setResponseOrder(QModbusTcpServer::CompletionOrder);
+    QCOMPARE(server.responseOrder(), QModbusTcpServer::CompletionOrder);
+
+    server.setThreadPool(nullptr);
+    QCOMPARE(server.threadPool(), static_cast<QThreadPool *>(nullptr));
+}
+
+void tst_QModbusTcpServer::concurrentProcessing_data()
+{
+    QTest::addColumn<QModbusTcpServer::ResponseOrder>("order");
+
+    QTest::newRow("request order") << QModbusTcpServer::RequestOrder;
+    QTest::newRow("completion order") << QModbusTcpServer::CompletionOrder;
+}
+
+void tst_QModbusTcpServer::concurrentProcessing()
+{
+    QFETCH(QModbusTcpServer::ResponseOrder, order);
+
+    const int port = freePort();
+    QVERIFY(port > 0);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+
+    GatedServer server;
+    server.setResponseOrder(order);
+    QVERIFY(startServer(&server, &pool, port));
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, quint16(port));
+    QVERIFY(client.waitForConnected(5000));
+
+    // the second request is processed while the first one still blocks
+    client.write(readRequest(1, 0) + readRequest(2, 1));
+    QTRY_COMPARE(server.otherReads.load(), 1);
+
+    // response ADU: MBAP header, function code, byte count and one register
+    enum { ResponseSize = 7 + 2 + 2 };
+    QByteArray responses;
+    if (order == QModbusTcpServer::CompletionOrder) {
+        QTRY_COMPARE((responses += client.readAll()).size(), int(ResponseSize));
+        QCOMPARE(transactionId(responses), quint16(2));
+    } else {
+        QTest::qWait(50);
+        QCOMPARE(client.bytesAvailable(), qint64(0));
+    }
+
+    server.gate.release();
+    QTRY_COMPARE((responses += client.readAll()).size(), 2 * int(ResponseSize));
+
+    const QByteArray first = responses.left(ResponseSize);
+    const QByteArray second = responses.mid(ResponseSize);
+    const QByteArray slow = (transactionId(first) == 1) ? first : second;
+    const QByteArray fast = (transactionId(first) == 1) ? second : first;
+    QCOMPARE(transactionId(first), quint16(order == QModbusTcpServer::RequestOrder ? 1 : 2));
+    QCOMPARE(slow.right(2), QByteArray::fromHex("1111"));
+    QCOMPARE(fast.right(2), QByteArray::fromHex("2222"));
+}
+
+void tst_QModbusTcpServer::serialOnlyInServerThread()
+{
+    const int port = freePort();
+    QVERIFY(port > 0);
+
+    QThreadPool pool;
+    ThreadRecordingServer server;
+    QVERIFY(startServer(&server, &pool, port));
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, quint16(port));
+    QVERIFY(client.waitForConnected(5000));
+
+    // only register access goes to the pool, anything else may touch server state
+    client.write(readRequest(1, 0) + request(2, QModbusPdu::FunctionCode(0x41), QByteArray()));
+    QTRY_VERIFY(server.readThread.load() && server.privateRequestThread.load());
+    QVERIFY(server.readThread.load() != QThread::currentThread());
+    QCOMPARE(server.privateRequestThread.load(), QThread::currentThread());
+}
+
+void tst_QModbusTcpServer::exclusiveReadModifyWrite()
+{
+    const int port = freePort();
+    QVERIFY(port > 0);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+    GatedServer server;
+    QVERIFY(startServer(&server, &pool, port));
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, quint16(port));
+    QVERIFY(client.waitForConnected(5000));
+
+    // address 1: and mask 0x00f0, or mask 0x0005
+    client.write(readRequest(1, 0) + request(2, QModbusPdu::MaskWriteRegister,
+                                             QByteArray::fromHex("000100f00005")));
+    QTRY_COMPARE(server.gatedReads.load(), 1);
+
+    // the mask write waits for the blocked read, although a pool thread is free
+    QTest::qWait(100);
+    quint16 value = 0;
+    QVERIFY(server.data(QModbusDataUnit::HoldingRegisters, 1, &value));
+    QCOMPARE(value, quint16(0x2222));
+
+    server.gate.release();
+    QTRY_VERIFY(server.data(QModbusDataUnit::HoldingRegisters, 1, &value)
+                && value == quint16(0x0025));
+}
+
+void tst_QModbusTcpServer::closeWaitsForPool()
+{
+    const int port = freePort();
+    QVERIFY(port > 0);
+
+    QThreadPool pool;
+    GatedServer server;
+    QVERIFY(startServer(&server, &pool, port));
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, quint16(port));
+    QVERIFY(client.waitForConnected(5000));
+
+    client.write(readRequest(1, 0));
+    QTRY_COMPARE(server.gatedReads.load(), 1);
+
+    QThreadPool opener;
+    opener.start(new GateOpener(&server.gate));
+    server.disconnectDevice();
+    QCOMPARE(server.passedReads.load(), 1);
+    QCOMPARE(server.state(), QModbusDevice::UnconnectedState);
+}
+
+QTEST_MAIN(tst_QModbusTcpServer)
+
+#include "tst_qmodbustcpserver.moc"
@@ -0,0 +1,7 @@
+QT = core testlib serialbus serialbus-private
+TARGET = tst_qmodbustransport
+CONFIG += testcase c++11
+
+CONFIG -= app_bundle
+
+SOURCES += tst_qmodbustransport.cpp
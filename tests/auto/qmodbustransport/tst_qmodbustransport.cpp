@@ -0,0 +1,390 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtSerialBus/qmodbustcpclient.h>
+#include <private/qmodbusadu_p.h>
+#include <private/qmodbusclient_p.h>
+#include <private/qmodbustransport_p.h>
+
+#include <QtTest/QtTest>
+
+Q_DECLARE_METATYPE(QModbusFramer::Role)
+
+// Runs the TCP client protocol over an in-memory transport instead of a socket.
+class MemoryTcpClient : public QModbusTcpClient
+{
+public:
+    explicit MemoryTcpClient(QModbusTransport *transport)
+    {
+        static_cast<QModbusClientPrivate *>(d_ptr.data())->setTransport(transport);
+        setState(QModbusDevice::ConnectedState);
+    }
+};
+
+class tst_QModbusTransport : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void rtuFramer_data();
+    void rtuFramer();
+    void rtuChecksumError();
+    void rtuInvalidFunctionCode();
+    void tcpFramer();
+    void tcpInvalidHeader();
+    void asciiFramer();
+    void asciiErrors();
+    void receiveBuffer();
+    void frameReuse();
+    void memoryTransport();
+    void tcpClientOverMemoryTransport();
+
+private:
+    static QModbusFramer::Result decode(const QModbusFramer &framer, const QByteArray &data,
+                                        QModbusFrame *frame, int *aduSize)
+    {
+        return framer.decode(data.constData(), data.size(), frame, aduSize);
+    }
+};
+
+void tst_QModbusTransport::rtuFramer_data()
+{
+    QTest::addColumn<QModbusFramer::Role>("role");
+    QTest::addColumn<QModbusPdu::FunctionCode>("code");
+    QTest::addColumn<QByteArray>("data");
+
+    QTest::newRow("read holding registers request") << QModbusFramer::ServerRole
+        << QModbusPdu::ReadHoldingRegisters << QByteArray::fromHex("006b0003");
+    QTest::newRow("write multiple registers request") << QModbusFramer::ServerRole
+        << QModbusPdu::WriteMultipleRegisters << QByteArray::fromHex("0001000204000a0102");
+    QTest::newRow("read holding registers response") << QModbusFramer::ClientRole
+        << QModbusPdu::ReadHoldingRegisters << QByteArray::fromHex("06022b00000064");
+    QTest::newRow("exception response") << QModbusFramer::ClientRole
+        << QModbusPdu::FunctionCode(QModbusPdu::ReadHoldingRegisters | QModbusPdu::ExceptionByte)
+        << QByteArray::fromHex("02");
+    QTest::newRow("return query data echo") << QModbusFramer::ClientRole
+        << QModbusPdu::Diagnostics << QByteArray::fromHex("0000a5375aa5");
+}
+
+void tst_QModbusTransport::rtuFramer()
+{
+    QFETCH(QModbusFramer::Role, role);
+    QFETCH(QModbusPdu::FunctionCode, code);
+    QFETCH(QByteArray, data);
+
+    const QModbusRtuFramer framer(role);
+    const QByteArray adu = framer.encode(17, 0, QModbusResponse(code, data));
+    QCOMPARE(adu, QModbusSerialAdu::create(QModbusSerialAdu::Rtu, 17,
+                                           QModbusResponse(code, data)));
+
+    QModbusFrame frame;
+    int aduSize = -1;
+    for (int i = 0; i < adu.size(); ++i)
+        QCOMPARE(decode(framer, adu.left(i), &frame, &aduSize), QModbusFramer::Incomplete);
+
+    // a second frame behind the first one must not be taken into account
+    QCOMPARE(decode(framer, adu + adu, &frame, &aduSize), QModbusFramer::Complete);
+    QCOMPARE(aduSize, adu.size());
+    QCOMPARE(frame.serverAddress, 17);
+    QCOMPARE(frame.functionCode, quint8(code));
+    QCOMPARE(frame.data, data);
+}
+
+void tst_QModbusTransport::rtuChecksumError()
+{
+    const QModbusRtuFramer framer(QModbusFramer::ServerRole);
+    QByteArray adu = QByteArray::fromHex("1103006b00037687");
+    adu[adu.size() - 1] = adu.at(adu.size() - 1) ^ 0x01;
+
+    QModbusFrame frame;
+    int aduSize = -1;
+    QCOMPARE(decode(framer, adu + "\x11", &frame, &aduSize), QModbusFramer::ChecksumError);
+    QCOMPARE(aduSize, adu.size() + 1); // the frame boundary is lost, drop everything
+    QCOMPARE(frame.serverAddress, 0x11);
+
+    // over a byte stream, the next frame may start right behind the first byte
+    const QModbusRtuFramer streamFramer(QModbusFramer::ServerRole, QModbusRtuFramer::SkipByte);
+    QCOMPARE(decode(streamFramer, adu + "\x11", &frame, &aduSize), QModbusFramer::ChecksumError);
+    QCOMPARE(aduSize, 1);
+}
+
+void tst_QModbusTransport::rtuInvalidFunctionCode()
+{
+    const QModbusRtuFramer framer(QModbusFramer::ClientRole);
+    const QByteArray adu = QByteArray::fromHex("11000102");
+
+    QModbusFrame frame;
+    int aduSize = -1;
+    QCOMPARE(decode(framer, adu, &frame, &aduSize), QModbusFramer::Invalid);
+    QCOMPARE(aduSize, adu.size());
+
+    const QModbusRtuFramer streamFramer(QModbusFramer::ClientRole, QModbusRtuFramer::SkipByte);
+    QCOMPARE(decode(streamFramer, adu, &frame, &aduSize), QModbusFramer::Invalid);
+    QCOMPARE(aduSize, 1);
+
+    // a byte count that can never be satisfied ends up as invalid once the maximum is reached
+    QByteArray tooLong = QByteArray::fromHex("1103ff");
+    tooLong.append(QByteArray(QModbusRtuFramer::MaximumAduSize - tooLong.size() - 1, '\0'));
+    QCOMPARE(decode(framer, tooLong, &frame, &aduSize), QModbusFramer::Incomplete);
+    tooLong.append('\0');
+    QCOMPARE(decode(framer, tooLong, &frame, &aduSize), QModbusFramer::Invalid);
+    QCOMPARE(aduSize, tooLong.size());
+}
+
+void tst_QModbusTransport::tcpFramer()
+{
+    const QModbusTcpFramer framer(QModbusFramer::ServerRole);
+    const QModbusRequest request(QModbusPdu::ReadHoldingRegisters, quint16(0x6b), quint16(3));
+
+    const QByteArray adu = framer.encode(0x11, 0x1234, request);
+    QCOMPARE(adu, QByteArray::fromHex("12340000000611" "03006b0003"));
+
+    QModbusFrame frame;
+    int aduSize = -1;
+    for (int i = 0; i < adu.size(); ++i) {
+        QCOMPARE(decode(framer, adu.left(i), &frame, &aduSize), QModbusFramer::Incomplete);
+        if (i >= QModbusTcpFramer::HeaderSize) {
+            QCOMPARE(frame.transactionId, quint16(0x1234));
+            QCOMPARE(frame.serverAddress, 0x11);
+        }
+    }
+
+    QCOMPARE(decode(framer, adu + adu.left(3), &frame, &aduSize), QModbusFramer::Complete);
+    QCOMPARE(aduSize, adu.size());
+    QCOMPARE(frame.transactionId, quint16(0x1234));
+    QCOMPARE(frame.serverAddress, 0x11);
+    QCOMPARE(frame.request().functionCode(), QModbusPdu::ReadHoldingRegisters);
+    QCOMPARE(frame.data, QByteArray::fromHex("006b0003"));
+
+    const QModbusExceptionResponse exception(QModbusPdu::ReadCoils,
+                                             QModbusExceptionResponse::IllegalDataAddress);
+    QCOMPARE(framer.encode(1, 2, exception), QByteArray::fromHex("00020000000301" "8102"));
+}
+
+void tst_QModbusTransport::tcpInvalidHeader()
+{
+    const QModbusTcpFramer framer(QModbusFramer::ClientRole);
+
+    QModbusFrame frame;
+    int aduSize = -1;
+
+    // not Modbus, skip the ADU and continue with the next one
+    const QByteArray otherProtocol = QByteArray::fromHex("00010001000301" "8102");
+    QCOMPARE(decode(framer, otherProtocol + otherProtocol, &frame, &aduSize),
+             QModbusFramer::Invalid);
+    QCOMPARE(aduSize, otherProtocol.size());
+
+    // a length field without PDU or longer than any ADU leaves nothing to resync on
+    const QByteArray empty = QByteArray::fromHex("00010000000101" "0000");
+    QCOMPARE(decode(framer, empty, &frame, &aduSize), QModbusFramer::Invalid);
+    QCOMPARE(aduSize, empty.size());
+
+    const QByteArray huge = QByteArray::fromHex("000100000fff01" "03");
+    QCOMPARE(decode(framer, huge, &frame, &aduSize), QModbusFramer::Invalid);
+    QCOMPARE(aduSize, huge.size());
+}
+
+void tst_QModbusTransport::asciiFramer()
+{
+    const QModbusAsciiFramer framer(QModbusFramer::ServerRole);
+    const QModbusRequest request(QModbusPdu::ReadHoldingRegisters, QByteArray::fromHex("006B0003"));
+
+    const QByteArray adu = framer.encode(17, 0, request);
+    QCOMPARE(adu, QByteArray(":1103006b00037e\r\n"));
+
+    QModbusFrame frame;
+    int aduSize = -1;
+    for (int i = 0; i < adu.size(); ++i)
+        QCOMPARE(decode(framer, adu.left(i), &frame, &aduSize), QModbusFramer::Incomplete);
+
+    QCOMPARE(decode(framer, adu + ":11", &frame, &aduSize), QModbusFramer::Complete);
+    QCOMPARE(aduSize, adu.size());
+    QCOMPARE(frame.serverAddress, 17);
+    QCOMPARE(frame.functionCode, quint8(QModbusPdu::ReadHoldingRegisters));
+    QCOMPARE(frame.data, QByteArray::fromHex("006b0003"));
+
+    const QModbusAsciiFramer custom(QModbusFramer::ServerRole, '!');
+    QCOMPARE(custom.encode(17, 0, request), QByteArray(":1103006b00037e\r!"));
+    QCOMPARE(decode(custom, ":1103006b00037e\r!", &frame, &aduSize), QModbusFramer::Complete);
+}
+
+void tst_QModbusTransport::asciiErrors()
+{
+    const QModbusAsciiFramer framer(QModbusFramer::ServerRole);
+
+    QModbusFrame frame;
+    int aduSize = -1;
+
+    QCOMPARE(decode(framer, "xx:1103006b00037e\r\n", &frame, &aduSize), QModbusFramer::Invalid);
+    QCOMPARE(aduSize, 2);
+
+    QCOMPARE(decode(framer, ":1103006b00037f\r\n", &frame, &aduSize),
+             QModbusFramer::ChecksumError);
+    QCOMPARE(aduSize, 17);
+
+    QCOMPARE(decode(framer, ":1103006b0z037e\r\n", &frame, &aduSize), QModbusFramer::Invalid);
+    QCOMPARE(aduSize, 17);
+
+    QCOMPARE(decode(framer, ":11\r\n", &frame, &aduSize), QModbusFramer::Invalid);
+    QCOMPARE(aduSize, 5);
+
+    const QByteArray endless = ":" + QByteArray(QModbusAsciiFramer::MaximumAduSize, '0');
+    QCOMPARE(decode(framer, endless, &frame, &aduSize), QModbusFramer::Invalid);
+    QCOMPARE(aduSize, endless.size());
+}
+
+void tst_QModbusTransport::receiveBuffer()
+{
+    QModbusReceiveBuffer buffer;
+    QVERIFY(buffer.isEmpty());
+
+    buffer.append("abcdef", 6);
+    QCOMPARE(QByteArray(buffer.data(), buffer.size()), QByteArray("abcdef"));
+
+    buffer.consume(2);
+    QCOMPARE(QByteArray(buffer.data(), buffer.size()), QByteArray("cdef"));
+
+    // force a compaction and a reallocation, the pending bytes must survive both
+    const QByteArray large(1000, 'x');
+    ::memcpy(buffer.reserve(large.size()), large.constData(), large.size());
+    buffer.commit(large.size());
+    QCOMPARE(buffer.size(), 4 + large.size());
+    QCOMPARE(QByteArray(buffer.data(), 4), QByteArray("cdef"));
+    QCOMPARE(QByteArray(buffer.data() + 4, large.size()), large);
+
+    buffer.consume(buffer.size());
+    QVERIFY(buffer.isEmpty());
+
+    buffer.append("gh", 2);
+    buffer.clear();
+    QVERIFY(buffer.isEmpty());
+    QCOMPARE(buffer.size(), 0);
+}
+
+void tst_QModbusTransport::frameReuse()
+{
+    const QModbusTcpFramer framer(QModbusFramer::ServerRole);
+    const QByteArray first = framer.encode(1, 1,
+        QModbusRequest(QModbusRequest::ReadHoldingRegisters, QByteArray::fromHex("00000001")));
+    const QByteArray second = framer.encode(1, 2,
+        QModbusRequest(QModbusRequest::WriteSingleRegister, QByteArray::fromHex("0005abcd")));
+
+    QModbusFrame frame;
+    int aduSize = 0;
+    QCOMPARE(decode(framer, first, &frame, &aduSize), QModbusFramer::Complete);
+    const char *storage = frame.data.constData();
+
+    // decoding into the same frame again keeps its storage
+    QCOMPARE(decode(framer, second, &frame, &aduSize), QModbusFramer::Complete);
+    QCOMPARE(frame.data.constData(), storage);
+    QCOMPARE(frame.data, QByteArray::fromHex("0005abcd"));
+
+    // unless a request still shares it
+    const QModbusRequest kept = frame.request();
+    QCOMPARE(decode(framer, first, &frame, &aduSize), QModbusFramer::Complete);
+    QVERIFY(frame.data.constData() != storage);
+    QCOMPARE(frame.data, QByteArray::fromHex("00000001"));
+    QCOMPARE(kept.data(), QByteArray::fromHex("0005abcd"));
+}
+
+void tst_QModbusTransport::memoryTransport()
+{
+    QModbusMemoryTransport first;
+    QScopedPointer<QModbusMemoryTransport> second(new QModbusMemoryTransport);
+    QVERIFY(!first.isOpen());
+    QCOMPARE(first.write("x"), qint64(-1));
+
+    QModbusMemoryTransport::connectPair(&first, second.data());
+    QVERIFY(first.isOpen());
+    QVERIFY(second->isOpen());
+    QCOMPARE(first.peer(), second.data());
+
+    QSignalSpy readyRead(second.data(), &QModbusTransport::readyRead);
+    QSignalSpy bytesWritten(&first, &QModbusTransport::bytesWritten);
+
+    QCOMPARE(first.write("abc"), qint64(3));
+    QCOMPARE(first.write("de"), qint64(2));
+    QCOMPARE(bytesWritten.count(), 2);
+    QCOMPARE(readyRead.count(), 0); // delivered from the event loop
+
+    QTRY_COMPARE(readyRead.count(), 1);
+    QModbusReceiveBuffer *buffer = second->receiveBuffer();
+    QCOMPARE(QByteArray(buffer->data(), buffer->size()), QByteArray("abcde"));
+    QVERIFY(first.receiveBuffer()->isEmpty());
+
+    second.reset();
+    QVERIFY(!first.isOpen());
+    QCOMPARE(first.write("x"), qint64(-1));
+}
+
+void tst_QModbusTransport::tcpClientOverMemoryTransport()
+{
+    QModbusMemoryTransport clientSide;
+    QModbusMemoryTransport serverSide;
+    QModbusMemoryTransport::connectPair(&clientSide, &serverSide);
+
+    const QModbusTcpFramer framer(QModbusFramer::ServerRole);
+    int requests = 0;
+    connect(&serverSide, &QModbusTransport::readyRead, [&]() {
+        QModbusReceiveBuffer *buffer = serverSide.receiveBuffer();
+        QModbusFrame frame;
+        int aduSize = 0;
+        while (framer.decode(buffer->data(), buffer->size(), &frame, &aduSize)
+               == QModbusFramer::Complete) {
+            buffer->consume(aduSize);
+            ++requests;
+            const QModbusResponse response(frame.request().functionCode(), quint8(4),
+                                           QVector<quint16>() << 0x1234 << 0x5678);
+            serverSide.write(framer.encode(frame.serverAddress, frame.transactionId, response));
+        }
+    });
+
+    MemoryTcpClient client(&clientSide);
+    QModbusReply *reply = client.sendReadRequest(
+        QModbusDataUnit(QModbusDataUnit::HoldingRegisters, 0, 2), 1);
+    QVERIFY(reply);
+
+    QTRY_VERIFY(reply->isFinished());
+    QCOMPARE(requests, 1);
+    QCOMPARE(reply->error(), QModbusDevice::NoError);
+    QCOMPARE(reply->result().values(), QVector<quint16>() << 0x1234 << 0x5678);
+    delete reply;
+}
+
+QTEST_MAIN(tst_QModbusTransport)
+
+#include "tst_qmodbustransport.moc"
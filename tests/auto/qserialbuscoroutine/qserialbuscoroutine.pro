@@ -0,0 +1,14 @@
+QT = core testlib serialbus
+TARGET = tst_qserialbuscoroutine
+CONFIG += testcase
+CONFIG -= app_bundle
+
+# The awaitables need C++20; without coroutine support the test skips itself.
+CONFIG -= c++11 c++14 c++1z
+clang: QMAKE_CXXFLAGS += -std=c++2a
+else:gcc:greaterThan(QT_GCC_MAJOR_VERSION, 9): QMAKE_CXXFLAGS += -std=c++2a -fcoroutines
+msvc: QMAKE_CXXFLAGS += /std:c++latest
+
+INCLUDEPATH += ../shared
+HEADERS += ../shared/canbustestbackend.h
+SOURCES += tst_qserialbuscoroutine.cpp
@@ -0,0 +1,196 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "canbustestbackend.h"
+
+#include <QtSerialBus/qserialbuscoroutine.h>
+
+#include <QtTest/QtTest>
+
+#ifdef QT_SERIALBUS_COROUTINES
+
+static QSerialBusTask awaitReply(QModbusReply *reply, QVector<int> *resumed, int id,
+                                 QModbusResult *result)
+{
+    *result = co_await QModbusReplyAwaiter(nullptr, reply);
+    resumed->append(id);
+}
+
+static QSerialBusTask awaitFrames(QCanBusAwaitableDevice *device, QVector<int> *resumed, int id,
+                                  int *frameCount)
+{
+    const QVector<QCanBusFrame> &frames = co_await device->frames();
+    *frameCount = frames.size();
+    resumed->append(id);
+}
+
+static QSerialBusTask receiveFrames(QCanBusAwaitableDevice *device, int *frameCount, int *steps)
+{
+    while (device->device()->state() == QCanBusDevice::ConnectedState) {
+        *frameCount += (co_await device->frames()).size();
+        ++*steps;
+    }
+}
+
+#endif // QT_SERIALBUS_COROUTINES
+
+class tst_QSerialBusCoroutine : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void finishedReply();
+    void awaitReplyTwice();
+    void awaitFramesTwice();
+    void frameLoop();
+};
+
+void tst_QSerialBusCoroutine::finishedReply()
+{
+#ifdef QT_SERIALBUS_COROUTINES
+    QPointer<QModbusReply> reply = new QModbusReply(QModbusReply::Common, 1);
+    reply->setResult(QModbusDataUnit(QModbusDataUnit::HoldingRegisters, 10, 2));
+    reply->setFinished(true);
+
+    // does not suspend at all
+    QVector<int> resumed;
+    QModbusResult result;
+    awaitReply(reply, &resumed, 1, &result);
+    QCOMPARE(resumed, QVector<int>({ 1 }));
+    QVERIFY(result.isValid());
+    QCOMPARE(result.unit.startAddress(), 10);
+
+    QTRY_VERIFY(reply.isNull());
+#else
+    QSKIP("The compiler does not support C++20 coroutines.");
+#endif
+}
+
+void tst_QSerialBusCoroutine::awaitReplyTwice()
+{
+#ifdef QT_SERIALBUS_COROUTINES
+    QPointer<QModbusReply> reply = new QModbusReply(QModbusReply::Common, 1);
+
+    QVector<int> resumed;
+    QModbusResult first;
+    QModbusResult second;
+    awaitReply(reply, &resumed, 1, &first);
+    awaitReply(reply, &resumed, 2, &second);
+    QVERIFY(resumed.isEmpty());
+
+    // resumed from the event loop, not from within setError()
+    reply->setError(QModbusDevice::TimeoutError, QStringLiteral("timeout"));
+    QVERIFY(resumed.isEmpty());
+    QTRY_COMPARE(resumed, QVector<int>({ 1, 2 }));
+    QCOMPARE(first.error, QModbusDevice::TimeoutError);
+    QCOMPARE(second.error, QModbusDevice::TimeoutError);
+    QCOMPARE(second.errorString, QStringLiteral("timeout"));
+    QVERIFY(!reply->finishedHook());
+
+    QTRY_VERIFY(reply.isNull());
+#else
+    QSKIP("The compiler does not support C++20 coroutines.");
+#endif
+}
+
+void tst_QSerialBusCoroutine::awaitFramesTwice()
+{
+#ifdef QT_SERIALBUS_COROUTINES
+    CanBusTestBackend backend;
+    QVERIFY(backend.connectDevice());
+    QCanBusAwaitableDevice device(&backend);
+
+    QVector<int> resumed;
+    int firstCount = -1;
+    int secondCount = -1;
+    awaitFrames(&device, &resumed, 1, &firstCount);
+    awaitFrames(&device, &resumed, 2, &secondCount);
+    QVERIFY(resumed.isEmpty());
+
+    // every frame is delivered once, to the coroutine that waited first
+    backend.receive(QVector<QCanBusFrame>(3, QCanBusFrame(0x42, QByteArray(1, 'a'))));
+    QVERIFY(resumed.isEmpty());
+    QTRY_COMPARE(resumed, QVector<int>({ 1, 2 }));
+    QCOMPARE(firstCount, 3);
+    QCOMPARE(secondCount, 0);
+    QVERIFY(!backend.receiveHook());
+    QCOMPARE(backend.framesAvailable(), qint64(0));
+#else
+    QSKIP("The compiler does not support C++20 coroutines.");
+#endif
+}
+
+void tst_QSerialBusCoroutine::frameLoop()
+{
+#ifdef QT_SERIALBUS_COROUTINES
+    CanBusTestBackend backend;
+    QVERIFY(backend.connectDevice());
+    QCanBusAwaitableDevice device(&backend);
+
+    // frames queued before the first co_await are picked up without suspending
+    backend.receive(QVector<QCanBusFrame>(2, QCanBusFrame(0x42, QByteArray(1, 'a'))));
+
+    int frameCount = 0;
+    int steps = 0;
+    receiveFrames(&device, &frameCount, &steps);
+    QCOMPARE(frameCount, 2);
+    QCOMPARE(steps, 1);
+
+    for (int i = 0; i < 10; ++i) {
+        backend.receive(QVector<QCanBusFrame>(i + 1, QCanBusFrame(0x42, QByteArray(1, 'b'))));
+        QTRY_COMPARE(steps, 2 + i);
+    }
+    QCOMPARE(frameCount, 2 + 55);
+
+    // batches received before the loop is resumed are taken in one step
+    for (int i = 0; i < 3; ++i)
+        backend.receive(QVector<QCanBusFrame>(1, QCanBusFrame(0x42, QByteArray(1, 'c'))));
+    QTRY_COMPARE(steps, 12);
+    QCOMPARE(frameCount, 2 + 55 + 3);
+
+    // disconnecting resumes the loop a last time with an empty batch
+    backend.disconnectDevice();
+    QTRY_COMPARE(steps, 13);
+    QCOMPARE(frameCount, 60);
+    QVERIFY(!backend.receiveHook());
+#else
+    QSKIP("The compiler does not support C++20 coroutines.");
+#endif
+}
+
+QTEST_MAIN(tst_QSerialBusCoroutine)
+
+#include "tst_qserialbuscoroutine.moc"
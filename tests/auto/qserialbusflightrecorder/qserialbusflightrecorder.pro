@@ -0,0 +1,7 @@
+QT = core testlib serialbus
+TARGET = tst_qserialbusflightrecorder
+CONFIG += testcase c++11
+
+INCLUDEPATH += ../shared
+HEADERS += ../shared/canbustestbackend.h
+SOURCES += tst_qserialbusflightrecorder.cpp
@@ -0,0 +1,317 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "canbustestbackend.h"
+
+#include <QtSerialBus/qcanbusdevice.h>
+#include <QtSerialBus/qcanbusframe.h>
+#include <QtSerialBus/qmodbusrtuserialmaster.h>
+#include <QtSerialBus/qserialbusflightrecorder.h>
+
+#include <QtCore/qbuffer.h>
+#include <QtCore/qtemporarydir.h>
+#include <QtTest/QtTest>
+
+// event layout of the binary format
+struct Event
+{
+    quint64 timestamp;
+    quint16 interface;
+    quint8 type;
+    quint8 flags;
+    quint32 id;
+    quint32 value;
+    quint16 length;
+    quint16 reserved;
+    char data[96];
+};
+
+struct Dump
+{
+    QStringList interfaceNames;
+    QVector<quint16> linkTypes;
+    QVector<Event> events;
+};
+
+static bool parseBinary(const QByteArray &content, Dump *dump)
+{
+    if (!content.startsWith("QSBFLREC"))
+        return false;
+    int position = 8;
+    quint32 header[3];
+    memcpy(header, content.constData() + position, sizeof(header));
+    position += sizeof(header);
+    if (header[0] != 1 || header[1] != sizeof(Event))
+        return false;
+    for (quint32 i = 0; i < header[2]; ++i) {
+        quint16 description[2];
+        memcpy(description, content.constData() + position, sizeof(description));
+        position += sizeof(description);
+        dump->linkTypes.append(description[0]);
+        dump->interfaceNames.append(QString::fromUtf8(content.mid(position, description[1])));
+        position += description[1];
+    }
+    position += 8; // wall clock offset
+    if ((content.size() - position) % int(sizeof(Event)))
+        return false;
+    dump->events.resize((content.size() - position) / int(sizeof(Event)));
+    memcpy(dump->events.data(), content.constData() + position,
+           size_t(dump->events.size()) * sizeof(Event));
+    return true;
+}
+
+class tst_QSerialBusFlightRecorder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void capacity();
+    void canEvents();
+    void overwrite();
+    void detach();
+    void pcapNg();
+    void dumpOnError();
+};
+
+void tst_QSerialBusFlightRecorder::capacity()
+{
+    QCOMPARE(QSerialBusFlightRecorder(0).capacity(), 16);
+    QCOMPARE(QSerialBusFlightRecorder(100).capacity(), 128);
+    QCOMPARE(QSerialBusFlightRecorder(4096).capacity(), 4096);
+
+    QSerialBusFlightRecorder recorder;
+    QCOMPARE(recorder.dumpFormat(), QSerialBusFlightRecorder::BinaryFormat);
+    QVERIFY(!recorder.dumpsOnError());
+    QVERIFY(recorder.dumpFileName().isEmpty());
+    QVERIFY(!recorder.dump());
+}
+
+void tst_QSerialBusFlightRecorder::canEvents()
+{
+    CanBusTestBackend device;
+    device.setObjectName(QStringLiteral("can0"));
+    QSerialBusFlightRecorder recorder;
+    recorder.attach(&device);
+
+    QVERIFY(device.connectDevice());
+    device.receive({ QCanBusFrame(0x123, QByteArray("abc")),
+                     QCanBusFrame(0x1234567, QByteArray(64, 'x')) });
+    device.emulateError(QStringLiteral("bus off"), QCanBusDevice::ConnectionError);
+    QCOMPARE(recorder.eventCount(), quint64(5));
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(recorder.dump(&buffer, QSerialBusFlightRecorder::BinaryFormat));
+
+    Dump dump;
+    QVERIFY(parseBinary(buffer.data(), &dump));
+    QCOMPARE(dump.interfaceNames, QStringList(QStringLiteral("can0")));
+    QCOMPARE(dump.linkTypes.value(0), quint16(227));
+    QCOMPARE(dump.events.size(), 5);
+
+    QCOMPARE(dump.events.at(0).type, quint8(6));
+    QCOMPARE(dump.events.at(0).id, quint32(QCanBusDevice::ConnectingState));
+    QCOMPARE(dump.events.at(1).id, quint32(QCanBusDevice::ConnectedState));
+
+    QCOMPARE(dump.events.at(2).type, quint8(1));
+    QCOMPARE(dump.events.at(2).id, quint32(0x123));
+    QCOMPARE(dump.events.at(2).length, quint16(3));
+    QCOMPARE(QByteArray(dump.events.at(2).data, 3), QByteArray("abc"));
+    QCOMPARE(dump.events.at(2).flags, quint8(0));
+
+    QCOMPARE(dump.events.at(3).id, quint32(0x1234567));
+    QCOMPARE(dump.events.at(3).value, quint32(QCanBusFrame::DataFrame) | 0x100 | 0x200);
+    QCOMPARE(dump.events.at(3).length, quint16(64));
+
+    QCOMPARE(dump.events.at(4).type, quint8(5));
+    QCOMPARE(dump.events.at(4).id, quint32(QCanBusDevice::ConnectionError));
+    QCOMPARE(QByteArray(dump.events.at(4).data, dump.events.at(4).length), QByteArray("bus off"));
+
+    for (int i = 1; i < dump.events.size(); ++i)
+        QVERIFY(dump.events.at(i).timestamp >= dump.events.at(i - 1).timestamp);
+}
+
+void tst_QSerialBusFlightRecorder::overwrite()
+{
+    CanBusTestBackend device;
+    QVERIFY(device.connectDevice());
+    QSerialBusFlightRecorder recorder(16);
+    recorder.attach(&device);
+
+    for (int i = 0; i < 40; ++i)
+        device.receive({ QCanBusFrame(quint32(i), QByteArray(200, 'y')) });
+    QCOMPARE(recorder.eventCount(), quint64(40));
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(recorder.dump(&buffer, QSerialBusFlightRecorder::BinaryFormat));
+    Dump dump;
+    QVERIFY(parseBinary(buffer.data(), &dump));
+    QCOMPARE(dump.events.size(), 16);
+    QCOMPARE(dump.events.first().id, quint32(24));
+    QCOMPARE(dump.events.last().id, quint32(39));
+
+    // not a valid classic frame, but the recorder only truncates
+    QCOMPARE(dump.events.last().length, quint16(200));
+    QCOMPARE(dump.events.last().flags, quint8(0x02));
+
+    recorder.clear();
+    QCOMPARE(recorder.eventCount(), quint64(0));
+    buffer.buffer().clear();
+    buffer.seek(0);
+    QVERIFY(recorder.dump(&buffer, QSerialBusFlightRecorder::BinaryFormat));
+    Dump empty;
+    QVERIFY(parseBinary(buffer.data(), &empty));
+    QVERIFY(empty.events.isEmpty());
+}
+
+void tst_QSerialBusFlightRecorder::detach()
+{
+    CanBusTestBackend device;
+    QVERIFY(device.connectDevice());
+
+    QSerialBusFlightRecorder first;
+    QSerialBusFlightRecorder second;
+    first.attach(&device);
+    device.receive({ QCanBusFrame(1, QByteArray()) });
+    second.attach(&device);
+    device.receive({ QCanBusFrame(2, QByteArray()) });
+    QCOMPARE(first.eventCount(), quint64(1));
+    QCOMPARE(second.eventCount(), quint64(1));
+
+    second.detach(&device);
+    device.receive({ QCanBusFrame(3, QByteArray()) });
+    QCOMPARE(second.eventCount(), quint64(1));
+
+    {
+        QSerialBusFlightRecorder temporary;
+        temporary.attach(&device);
+    }
+    // the destroyed recorder must have detached itself
+    device.receive({ QCanBusFrame(4, QByteArray()) });
+
+    QModbusRtuSerialMaster client;
+    client.setObjectName(QStringLiteral("rtu"));
+    first.attach(&client);
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(first.dump(&buffer, QSerialBusFlightRecorder::BinaryFormat));
+    Dump dump;
+    QVERIFY(parseBinary(buffer.data(), &dump));
+    QCOMPARE(dump.interfaceNames.size(), 2);
+    QCOMPARE(dump.interfaceNames.at(1), QStringLiteral("rtu"));
+    QCOMPARE(dump.linkTypes.at(1), quint16(147));
+}
+
+void tst_QSerialBusFlightRecorder::pcapNg()
+{
+    CanBusTestBackend device;
+    QVERIFY(device.connectDevice());
+    QSerialBusFlightRecorder recorder;
+    recorder.attach(&device);
+
+    QCanBusFrame extended(0x1abcdef, QByteArray("\x01\x02", 2));
+    extended.setExtendedFrameFormat(true);
+    device.receive({ QCanBusFrame(0x7ff, QByteArray("hello")), extended });
+    device.emulateError(QStringLiteral("failure"), QCanBusDevice::ReadError);
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(recorder.dump(&buffer, QSerialBusFlightRecorder::PcapNgFormat));
+    const QByteArray content = buffer.data();
+
+    // walk the blocks: section header, interface description, packets
+    QVector<quint32> types;
+    QVector<QByteArray> packets;
+    int position = 0;
+    while (position + 12 <= content.size()) {
+        quint32 type, length;
+        memcpy(&type, content.constData() + position, 4);
+        memcpy(&length, content.constData() + position + 4, 4);
+        QVERIFY(length % 4 == 0 && position + int(length) <= content.size());
+        quint32 trailer;
+        memcpy(&trailer, content.constData() + position + length - 4, 4);
+        QCOMPARE(trailer, length);
+        types.append(type);
+        if (type == 6) {
+            quint32 captured;
+            memcpy(&captured, content.constData() + position + 20, 4);
+            packets.append(content.mid(position + 28, int(captured)));
+        }
+        position += int(length);
+    }
+    QCOMPARE(position, content.size());
+    QCOMPARE(types, QVector<quint32>({ 0x0a0d0d0a, 1, 6, 6, 6 }));
+
+    QCOMPARE(packets.at(0), QByteArray("\x00\x00\x07\xff\x05\x00\x00\x00hello", 13));
+    QCOMPARE(packets.at(1), QByteArray("\x81\xab\xcd\xef\x02\x00\x00\x00\x01\x02", 10));
+    QVERIFY(packets.at(2).isEmpty()); // the error is a comment
+    QVERIFY(content.contains("failure"));
+}
+
+void tst_QSerialBusFlightRecorder::dumpOnError()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + QStringLiteral("/recorder.pcapng");
+
+    CanBusTestBackend device;
+    QVERIFY(device.connectDevice());
+    QSerialBusFlightRecorder recorder;
+    recorder.attach(&device);
+    recorder.setDumpFileName(fileName);
+    recorder.setDumpFormat(QSerialBusFlightRecorder::PcapNgFormat);
+
+    QSignalSpy spy(&recorder, &QSerialBusFlightRecorder::dumped);
+    device.emulateError(QStringLiteral("ignored"), QCanBusDevice::ReadError);
+    QCOMPARE(spy.count(), 0);
+    QVERIFY(!QFile::exists(fileName));
+
+    recorder.setDumpsOnError(true);
+    device.emulateError(QStringLiteral("dumped"), QCanBusDevice::ReadError);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toString(), fileName);
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray content = file.readAll();
+    QVERIFY(content.startsWith("\x0a\x0d\x0d\x0a"));
+    QVERIFY(content.contains("dumped"));
+}
+
+QTEST_MAIN(tst_QSerialBusFlightRecorder)
+
+#include "tst_qserialbusflightrecorder.moc"
@@ -0,0 +1,7 @@
+QT = core testlib serialbus serialbus-private
+TARGET = tst_qserialbustrace
+CONFIG += testcase c++11
+
+INCLUDEPATH += ../shared
+HEADERS += ../shared/canbustestbackend.h
+SOURCES += tst_qserialbustrace.cpp
@@ -0,0 +1,153 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "canbustestbackend.h"
+
+#include <QtSerialBus/qcanbusdevice.h>
+#include <QtSerialBus/qcanbusframe.h>
+#include <QtSerialBus/private/qserialbustrace_p.h>
+
+#include <QtCore/qtemporarydir.h>
+#include <QtTest/QtTest>
+
+class tst_QSerialBusTrace : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void canEvents();
+    void startTwice();
+
+private:
+    QVector<QSerialBusTrace::Record> readRecords(const QString &fileName);
+};
+
+QVector<QSerialBusTrace::Record> tst_QSerialBusTrace::readRecords(const QString &fileName)
+{
+    QVector<QSerialBusTrace::Record> records;
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return records;
+
+    const QByteArray content = file.readAll();
+    const int headerSize = 16;
+    if (content.size() < headerSize || !content.startsWith("QSBTRACE"))
+        return records;
+
+    quint32 header[2];
+    memcpy(header, content.constData() + 8, sizeof(header));
+    if (header[0] != 1 || header[1] != sizeof(QSerialBusTrace::Record))
+        return records;
+
+    records.resize((content.size() - headerSize) / int(sizeof(QSerialBusTrace::Record)));
+    memcpy(records.data(), content.constData() + headerSize,
+           size_t(records.size()) * sizeof(QSerialBusTrace::Record));
+    return records;
+}
+
+void tst_QSerialBusTrace::canEvents()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + QStringLiteral("/trace.bin");
+
+    CanBusTestBackend device;
+    QVERIFY(device.connectDevice());
+
+    QVERIFY(!QSerialBusTrace::isEnabled());
+    QVERIFY(QSerialBusTrace::start(fileName));
+    QVERIFY(QSerialBusTrace::isEnabled());
+
+    QCanBusFrame extended(0x1234567, QByteArray(3, 'x'));
+    device.receive({ QCanBusFrame(0x123, QByteArray(8, 'a')), extended });
+    QCOMPARE(device.readAllFrames().size(), 2);
+    device.writeFrame(QCanBusFrame(0x42, QByteArray(1, 'b')));
+    device.dequeueOutgoingFrame();
+
+    QSerialBusTrace::stop();
+    QVERIFY(!QSerialBusTrace::isEnabled());
+
+    // nothing is recorded after the sink was stopped
+    device.receive({ extended });
+
+    const QVector<QSerialBusTrace::Record> records = readRecords(fileName);
+    QCOMPARE(records.size(), 6);
+
+    QCOMPARE(records.at(0).event, quint32(QSerialBusTrace::CanFrameReceived));
+    QCOMPARE(records.at(0).arguments[0], quint32(0x123));
+    QCOMPARE(records.at(0).arguments[1], quint32(QCanBusFrame::DataFrame));
+    QCOMPARE(records.at(0).arguments[2], quint32(8));
+
+    QCOMPARE(records.at(1).event, quint32(QSerialBusTrace::CanFrameReceived));
+    QCOMPARE(records.at(1).arguments[0], quint32(0x1234567));
+    QCOMPARE(records.at(1).arguments[1], quint32(QCanBusFrame::DataFrame) | 0x100);
+    QCOMPARE(records.at(1).arguments[2], quint32(3));
+
+    QCOMPARE(records.at(2).event, quint32(QSerialBusTrace::CanFramesEnqueued));
+    QCOMPARE(records.at(2).arguments[0], quint32(2));
+    QCOMPARE(records.at(2).arguments[2], quint32(QSerialBusTrace::ReceiveQueue));
+
+    QCOMPARE(records.at(3).event, quint32(QSerialBusTrace::CanFramesDequeued));
+    QCOMPARE(records.at(3).arguments[0], quint32(2));
+    QCOMPARE(records.at(3).arguments[2], quint32(QSerialBusTrace::ReceiveQueue));
+
+    QCOMPARE(records.at(4).event, quint32(QSerialBusTrace::CanFramesEnqueued));
+    QCOMPARE(records.at(4).arguments[2], quint32(QSerialBusTrace::TransmitQueue));
+    QCOMPARE(records.at(5).event, quint32(QSerialBusTrace::CanFramesDequeued));
+    QCOMPARE(records.at(5).arguments[1], quint32(0));
+    QCOMPARE(records.at(5).arguments[2], quint32(QSerialBusTrace::TransmitQueue));
+
+    for (int i = 1; i < records.size(); ++i)
+        QVERIFY(records.at(i).timestamp >= records.at(i - 1).timestamp);
+}
+
+void tst_QSerialBusTrace::startTwice()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QVERIFY(QSerialBusTrace::start(dir.path() + QStringLiteral("/first.bin")));
+    QVERIFY(!QSerialBusTrace::start(dir.path() + QStringLiteral("/second.bin")));
+    QSerialBusTrace::stop();
+    QVERIFY(!QFile::exists(dir.path() + QStringLiteral("/second.bin")));
+
+    QVERIFY(!QSerialBusTrace::start(dir.path() + QStringLiteral("/missing/trace.bin")));
+    QVERIFY(!QSerialBusTrace::isEnabled());
+}
+
+QTEST_MAIN(tst_QSerialBusTrace)
+
+#include "tst_qserialbustrace.moc"
@@ -0,0 +1,16 @@
+QT = core testlib serialbus serialbus-private serialport
+TARGET = tst_slcanbackend
+CONFIG += testcase c++11
+CONFIG -= app_bundle
+
+# the backend is built into the test, so it does not depend on the installed plugin
+SLCAN_DIR = $$PWD/../../../src/plugins/canbus/slcan
+INCLUDEPATH += $$SLCAN_DIR
+
+HEADERS += \
+    $$SLCAN_DIR/slcanbackend.h \
+    $$SLCAN_DIR/slcancodec.h
+
+SOURCES += tst_slcanbackend.cpp \
+    $$SLCAN_DIR/slcanbackend.cpp \
+    $$SLCAN_DIR/slcancodec.cpp
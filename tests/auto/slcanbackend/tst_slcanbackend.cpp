@@ -0,0 +1,435 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "slcanbackend.h"
+#include "slcancodec.h"
+
+#include <QtCore/qsocketnotifier.h>
+#include <QtTest/QtTest>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+Q_DECLARE_METATYPE(QCanBusFrame)
+
+// The adapter side of a pty pair, answering like a Lawicel adapter.
+class FakeAdapter : public QObject
+{
+public:
+    ~FakeAdapter()
+    {
+        if (slave >= 0)
+            ::close(slave);
+        if (master >= 0)
+            ::close(master);
+    }
+
+    bool open()
+    {
+        master = ::posix_openpt(O_RDWR | O_NOCTTY);
+        if (master < 0 || ::grantpt(master) != 0 || ::unlockpt(master) != 0)
+            return false;
+        portName = QString::fromLocal8Bit(::ptsname(master));
+
+        // keep the slave side open, otherwise the master reports a hangup
+        // whenever the backend closes the port
+        slave = ::open(::ptsname(master), O_RDWR | O_NOCTTY);
+        if (slave < 0)
+            return false;
+
+        ::fcntl(master, F_SETFL, ::fcntl(master, F_GETFL) | O_NONBLOCK);
+        auto notifier = new QSocketNotifier(master, QSocketNotifier::Read, this);
+        connect(notifier, &QSocketNotifier::activated, this, &FakeAdapter::readCommands);
+        return true;
+    }
+
+    void send(const QByteArray &data)
+    {
+        int written = 0;
+        while (written < data.size()) {
+            const ssize_t result = ::write(master, data.constData() + written,
+                                           data.size() - written);
+            if (result < 0) {
+                if (errno != EAGAIN)
+                    return;
+                QTest::qWait(1);
+                continue;
+            }
+            written += int(result);
+        }
+    }
+
+    void releaseReplies()
+    {
+        holdReplies = false;
+        send(heldReplies);
+        heldReplies.clear();
+    }
+
+    QString portName;
+    QByteArray commands;            // everything received from the backend
+    QByteArray rejectedCommands;    // commands answered with BEL
+    bool holdReplies = false;       // collect replies until releaseReplies()
+
+private:
+    void readCommands()
+    {
+        char buffer[4096];
+        const ssize_t bytesRead = ::read(master, buffer, sizeof(buffer));
+        if (bytesRead <= 0)
+            return;
+
+        commands.append(buffer, int(bytesRead));
+        pending.append(buffer, int(bytesRead));
+
+        int start = 0;
+        for (int i = 0; i < pending.size(); ++i) {
+            if (pending.at(i) != '\r')
+                continue;
+            reply(pending.at(start));
+            start = i + 1;
+        }
+        pending.remove(0, start);
+    }
+
+    void reply(char command)
+    {
+        QByteArray answer;
+        if (command != '\r' && rejectedCommands.contains(command)) {
+            answer = "\a";
+        } else {
+            switch (command) {
+            case 't': case 'r': case 'd': case 'b':
+                answer = "z\r";
+                break;
+            case 'T': case 'R': case 'D': case 'B':
+                answer = "Z\r";
+                break;
+            default:
+                answer = "\r";
+                break;
+            }
+        }
+        if (holdReplies)
+            heldReplies.append(answer);
+        else
+            send(answer);
+    }
+
+    int master = -1;
+    int slave = -1;
+    QByteArray pending;
+    QByteArray heldReplies;
+};
+
+class tst_SlcanBackend : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void decode_data();
+    void decode();
+    void encode_data();
+    void encode();
+
+    void init();
+    void cleanup();
+
+    void connectAndWrite();
+    void receiveBatches();
+    void invalidLine();
+    void rejectedOpen();
+    void bitRateChangeWithPendingFrames();
+
+private:
+    FakeAdapter *adapter = nullptr;
+};
+
+void tst_SlcanBackend::decode_data()
+{
+    QTest::addColumn<QByteArray>("line");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<uint>("frameId");
+    QTest::addColumn<bool>("extended");
+    QTest::addColumn<bool>("remote");
+    QTest::addColumn<QByteArray>("payload");
+
+    QTest::newRow("standard") << QByteArray("t1232ABcd") << true << 0x123u << false << false
+                              << QByteArray::fromHex("abcd");
+    QTest::newRow("empty") << QByteArray("t7FF0") << true << 0x7ffu << false << false
+                           << QByteArray();
+    QTest::newRow("extended") << QByteArray("T1ABCDEF081122334455667788") << true << 0x1abcdefu
+                              << true << false << QByteArray::fromHex("1122334455667788");
+    QTest::newRow("time stamp") << QByteArray("t0011FF1234") << true << 0x1u << false << false
+                                << QByteArray::fromHex("ff");
+    QTest::newRow("remote") << QByteArray("r1003") << true << 0x100u << false << true
+                            << QByteArray(3, 0);
+    QTest::newRow("remote extended") << QByteArray("R000000018") << true << 0x1u << true << true
+                                     << QByteArray(8, 0);
+    QTest::newRow("fd") << QByteArray("d0209") + QByteArray(24, '5') << true << 0x20u << false
+                        << false << QByteArray(12, '\x55');
+    QTest::newRow("fd brs") << QByteArray("B00000020F") + QByteArray(128, 'a') << true << 0x20u
+                            << true << false << QByteArray(64, '\xaa');
+
+    QTest::newRow("bad digit") << QByteArray("t1232ABcg") << false << 0u << false << false
+                               << QByteArray();
+    QTest::newRow("bad id") << QByteArray("t8001AA") << false << 0u << false << false
+                            << QByteArray();
+    QTest::newRow("bad extended id") << QByteArray("T200000000") << false << 0u << true << false
+                                     << QByteArray();
+    QTest::newRow("classic length 9") << QByteArray("t1239") + QByteArray(18, '0') << false << 0u
+                                      << false << false << QByteArray();
+    QTest::newRow("short") << QByteArray("t1232AB") << false << 0u << false << false
+                           << QByteArray();
+    QTest::newRow("long") << QByteArray("t1231AB0") << false << 0u << false << false
+                          << QByteArray();
+    QTest::newRow("not a frame") << QByteArray("V1013") << false << 0u << false << false
+                                 << QByteArray();
+}
+
+void tst_SlcanBackend::decode()
+{
+    QFETCH(QByteArray, line);
+    QFETCH(bool, valid);
+
+    QCanBusFrame frame;
+    QCOMPARE(SlcanCodec::decodeFrame(line.constData(), line.size(), &frame), valid);
+    if (!valid)
+        return;
+
+    QFETCH(uint, frameId);
+    QFETCH(bool, extended);
+    QFETCH(bool, remote);
+    QFETCH(QByteArray, payload);
+    QVERIFY(frame.isValid());
+    QCOMPARE(frame.frameId(), frameId);
+    QCOMPARE(frame.hasExtendedFrameFormat(), extended);
+    QCOMPARE(frame.frameType(), remote ? QCanBusFrame::RemoteRequestFrame
+                                       : QCanBusFrame::DataFrame);
+    QCOMPARE(frame.payload(), payload);
+}
+
+void tst_SlcanBackend::encode_data()
+{
+    QTest::addColumn<QCanBusFrame>("frame");
+    QTest::addColumn<QByteArray>("line");
+
+    QTest::newRow("standard") << QCanBusFrame(0x123, QByteArray::fromHex("abcd"))
+                              << QByteArray("t1232ABCD\r");
+    QTest::newRow("extended") << QCanBusFrame(0x1abcdef, QByteArray::fromHex("00ff"))
+                              << QByteArray("T01ABCDEF200FF\r");
+    QCanBusFrame remote(QCanBusFrame::RemoteRequestFrame);
+    remote.setFrameId(0x42);
+    remote.setPayload(QByteArray(4, 0));
+    QTest::newRow("remote") << remote << QByteArray("r0424\r");
+    QTest::newRow("fd padded") << QCanBusFrame(0x7ff, QByteArray(10, '\x11'))
+                               << QByteArray("d7FF9") + QByteArray(20, '1')
+                                  + QByteArray(4, '0') + '\r';
+
+    QCanBusFrame error(QCanBusFrame::ErrorFrame);
+    QTest::newRow("error frame") << error << QByteArray();
+}
+
+void tst_SlcanBackend::encode()
+{
+    QFETCH(QCanBusFrame, frame);
+    QFETCH(QByteArray, line);
+
+    QByteArray out("x");
+    QCOMPARE(SlcanCodec::encodeFrame(frame, &out), !line.isEmpty());
+    QCOMPARE(out, QByteArray("x") + line);
+}
+
+void tst_SlcanBackend::init()
+{
+    adapter = new FakeAdapter;
+    if (!adapter->open())
+        QSKIP("Cannot create a pseudo terminal.");
+}
+
+void tst_SlcanBackend::cleanup()
+{
+    delete adapter;
+    adapter = nullptr;
+}
+
+void tst_SlcanBackend::connectAndWrite()
+{
+    SlcanBackend device(adapter->portName);
+    device.setConfigurationParameter(QCanBusDevice::BitRateKey, 500000);
+    device.setConfigurationParameter(QCanBusDevice::CanFdKey, true);
+    QVERIFY(device.connectDevice());
+    QCOMPARE(device.state(), QCanBusDevice::ConnectedState);
+    QTRY_COMPARE(adapter->commands, QByteArray("C\rS6\rO\r"));
+
+    QSignalSpy written(&device, &QCanBusDevice::framesWritten);
+    QSignalSpy errors(&device, &QCanBusDevice::errorOccurred);
+    QCanBusFrame remote(QCanBusFrame::RemoteRequestFrame);
+    remote.setFrameId(0x1000);
+    remote.setPayload(QByteArray(2, 0));
+    QVERIFY(device.writeFrame(QCanBusFrame(0x123, QByteArray::fromHex("0102"))));
+    QVERIFY(device.writeFrame(remote));
+    QVERIFY(device.writeFrame(QCanBusFrame(0x10, QByteArray(12, '\x7f'))));
+
+    // the three frames are sent in one write
+    QTRY_COMPARE(written.count(), 1);
+    QCOMPARE(written.at(0).at(0).toLongLong(), qint64(3));
+    QTRY_COMPARE(adapter->commands.size(), 7 + 10 + 11 + 30);
+    QCOMPARE(adapter->commands.mid(7),
+             QByteArray("t12320102\rR000010002\rd0109") + QByteArray("7F").repeated(12) + '\r');
+
+    // the acknowledgements of the adapter are no errors
+    QTest::qWait(50);
+    QCOMPARE(errors.count(), 0);
+
+    // changing the bit rate reopens the channel
+    device.setConfigurationParameter(QCanBusDevice::BitRateKey, 125000);
+    QTRY_VERIFY(adapter->commands.endsWith("C\rS4\rO\r"));
+
+    device.disconnectDevice();
+    QCOMPARE(device.state(), QCanBusDevice::UnconnectedState);
+    QTRY_VERIFY(adapter->commands.endsWith("O\rC\r"));
+}
+
+void tst_SlcanBackend::receiveBatches()
+{
+    SlcanBackend device(adapter->portName);
+    QVERIFY(device.connectDevice());
+    QTRY_COMPARE(adapter->commands, QByteArray("C\rO\r"));
+
+    // many frames in one block, split in the middle of a line
+    QByteArray block;
+    const int frameCount = 500;
+    for (int i = 0; i < frameCount; ++i) {
+        QCanBusFrame frame(i % 2 ? 0x100 + i : 0x10000 + i, QByteArray(i % 9, char(i)));
+        frame.setExtendedFrameFormat(!(i % 2));
+        QVERIFY(SlcanCodec::encodeFrame(frame, &block));
+    }
+    const int split = block.size() / 2 + 3;
+    adapter->send(block.left(split));
+    QTest::qWait(20);
+    adapter->send(block.mid(split));
+
+    QVector<QCanBusFrame> frames;
+    const auto readAll = [&]() {
+        while (device.framesAvailable())
+            frames.append(device.readFrame());
+        return frames.size() >= frameCount;
+    };
+    QTRY_VERIFY_WITH_TIMEOUT(readAll(), 10000);
+
+    QCOMPARE(frames.size(), frameCount);
+    for (int i = 0; i < frameCount; ++i) {
+        const QCanBusFrame &frame = frames.at(i);
+        QCOMPARE(frame.frameId(), quint32(i % 2 ? 0x100 + i : 0x10000 + i));
+        QCOMPARE(frame.hasExtendedFrameFormat(), !(i % 2));
+        QCOMPARE(frame.payload(), QByteArray(i % 9, char(i)));
+        QVERIFY(frame.timeStamp().seconds() > 0);
+    }
+}
+
+void tst_SlcanBackend::invalidLine()
+{
+    SlcanBackend device(adapter->portName);
+    QVERIFY(device.connectDevice());
+    QTRY_COMPARE(adapter->commands, QByteArray("C\rO\r"));
+
+    QSignalSpy errors(&device, &QCanBusDevice::errorOccurred);
+    adapter->send("t12X1AA\rV1013\rt0011BB\r");
+    QTRY_COMPARE(device.framesAvailable(), qint64(1));
+    QCOMPARE(device.readFrame().payload(), QByteArray("\xbb"));
+    QCOMPARE(errors.count(), 1);
+    QCOMPARE(errors.at(0).at(0).value<QCanBusDevice::CanBusError>(), QCanBusDevice::ReadError);
+    QCOMPARE(device.state(), QCanBusDevice::ConnectedState);
+
+    // a rejected frame is a write error
+    adapter->rejectedCommands = "t";
+    QVERIFY(device.writeFrame(QCanBusFrame(0x1, QByteArray("a"))));
+    QTRY_COMPARE(errors.count(), 2);
+    QCOMPARE(errors.at(1).at(0).value<QCanBusDevice::CanBusError>(), QCanBusDevice::WriteError);
+}
+
+void tst_SlcanBackend::rejectedOpen()
+{
+    SlcanBackend device(adapter->portName);
+    adapter->rejectedCommands = "CO";
+    QSignalSpy errors(&device, &QCanBusDevice::errorOccurred);
+
+    // the rejected close command is fine, the rejected open is not
+    QVERIFY(device.connectDevice());
+    QTRY_COMPARE(device.state(), QCanBusDevice::UnconnectedState);
+    QCOMPARE(errors.count(), 1);
+    QCOMPARE(device.error(), QCanBusDevice::ConnectionError);
+}
+
+void tst_SlcanBackend::bitRateChangeWithPendingFrames()
+{
+    SlcanBackend device(adapter->portName);
+    QVERIFY(device.connectDevice());
+    QTRY_COMPARE(adapter->commands, QByteArray("C\rO\r"));
+    QTest::qWait(20);
+
+    // the adapter answers the frames only after the channel was reopened
+    QSignalSpy errors(&device, &QCanBusDevice::errorOccurred);
+    adapter->holdReplies = true;
+    adapter->rejectedCommands = "t";
+    QCanBusFrame accepted(0x10000, QByteArray("a"));
+    accepted.setExtendedFrameFormat(true);
+    QVERIFY(device.writeFrame(accepted));
+    QVERIFY(device.writeFrame(QCanBusFrame(0x1, QByteArray("b"))));
+    device.setConfigurationParameter(QCanBusDevice::BitRateKey, 250000);
+    QTRY_VERIFY(adapter->commands.endsWith("C\rS5\rO\r"));
+
+    // Z, BEL for the frames, then CR for each command
+    adapter->releaseReplies();
+    QTRY_COMPARE(errors.count(), 1);
+    QTest::qWait(50);
+    QCOMPARE(errors.count(), 1);
+    QCOMPARE(device.error(), QCanBusDevice::WriteError);
+    QCOMPARE(device.state(), QCanBusDevice::ConnectedState);
+
+    // a later rejected frame is still a write error and not a failed open
+    QVERIFY(device.writeFrame(QCanBusFrame(0x2, QByteArray("c"))));
+    QTRY_COMPARE(errors.count(), 2);
+    QCOMPARE(device.error(), QCanBusDevice::WriteError);
+    QCOMPARE(device.state(), QCanBusDevice::ConnectedState);
+}
+
+QTEST_MAIN(tst_SlcanBackend)
+
+#include "tst_slcanbackend.moc"
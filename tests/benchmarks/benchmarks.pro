@@ -0,0 +1,11 @@
+TEMPLATE = subdirs
+SUBDIRS += qcanbusframe \
+           qcanbusdevice \
+           qcanopensdoclient \
+           qmodbuspdu \
+           qmodbusadu \
+           qmodbusserver \
+           qmodbusclient \
+           modbustcploopback
+
+linux: SUBDIRS += socketcanvcan
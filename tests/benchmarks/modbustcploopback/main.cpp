@@ -0,0 +1,502 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtSerialBus/qmodbustcpclient.h>
+#include <QtSerialBus/qmodbustcpserver.h>
+
+#include <QtCore/qcommandlineparser.h>
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qeventloop.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qprocess.h>
+#include <QtCore/qtextstream.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qtimer.h>
+
+#include <algorithm>
+#include <ctime>
+#include <functional>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+/*
+    End-to-end benchmark of QModbusTcpClient against QModbusTcpServer over
+    the loopback interface.
+
+    The server either runs on a separate thread of this process ("thread")
+    or inside a child process started from the same executable ("process").
+    For every combination of request type, register count, number of client
+    connections (concurrency) and number of outstanding requests per
+    connection (pipelining depth) the benchmark reports requests/s, the
+    p50/p99/p999 round trip latency and the CPU time spent per request.
+
+    Results are written as one JSON object per line (default) or as CSV.
+*/
+
+static const int ServerUnitId = 1;
+static const int MapSize = 10000;
+
+static qint64 cpuTimeUs()
+{
+#ifdef Q_OS_UNIX
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return qint64(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000
+            + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+    }
+#endif
+    return qint64(std::clock()) * 1000000 / CLOCKS_PER_SEC;
+}
+
+static QModbusDataUnitMap createMap()
+{
+    QModbusDataUnitMap map;
+    map.insert(QModbusDataUnit::Coils, { QModbusDataUnit::Coils, 0, MapSize });
+    map.insert(QModbusDataUnit::DiscreteInputs, { QModbusDataUnit::DiscreteInputs, 0, MapSize });
+    map.insert(QModbusDataUnit::InputRegisters, { QModbusDataUnit::InputRegisters, 0, MapSize });
+    map.insert(QModbusDataUnit::HoldingRegisters,
+               { QModbusDataUnit::HoldingRegisters, 0, MapSize });
+    return map;
+}
+
+class ServerHost : public QObject
+{
+    Q_OBJECT
+
+public:
+    Q_INVOKABLE bool start(int port)
+    {
+        server = new QModbusTcpServer(this);
+        server->setServerAddress(ServerUnitId);
+        server->setMap(createMap());
+        server->setConnectionParameter(QModbusDevice::NetworkAddressParameter,
+                                       QStringLiteral("127.0.0.1"));
+        server->setConnectionParameter(QModbusDevice::NetworkPortParameter, port);
+        return server->connectDevice();
+    }
+
+    Q_INVOKABLE void stop()
+    {
+        if (!server)
+            return;
+        server->disconnectDevice();
+        delete server;
+        server = nullptr;
+    }
+
+private:
+    QModbusTcpServer *server = nullptr;
+};
+
+struct RequestKind
+{
+    const char *name;
+    QModbusDataUnit::RegisterType table;
+    bool write;
+    int maxCount;
+};
+
+static const RequestKind requestKinds[] = {
+    { "read-coils", QModbusDataUnit::Coils, false, 2000 },
+    { "read-discrete-inputs", QModbusDataUnit::DiscreteInputs, false, 2000 },
+    { "read-holding-registers", QModbusDataUnit::HoldingRegisters, false, 125 },
+    { "read-input-registers", QModbusDataUnit::InputRegisters, false, 125 },
+    { "write-holding-registers", QModbusDataUnit::HoldingRegisters, true, 123 }
+};
+
+struct BenchCase
+{
+    QString mode;
+    RequestKind kind;
+    int count;
+    int concurrency;
+    int depth;
+};
+
+struct BenchResult
+{
+    int requests = 0;
+    int errors = 0;
+    qint64 wallNs = 0;
+    qint64 cpuUs = 0;
+    QVector<qint64> latenciesNs;
+};
+
+static bool connectClients(const QVector<QModbusTcpClient *> &clients, int port)
+{
+    QEventLoop loop;
+    QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+
+    auto allConnected = [&clients]() {
+        foreach (QModbusTcpClient *client, clients) {
+            if (client->state() != QModbusDevice::ConnectedState)
+                return false;
+        }
+        return true;
+    };
+
+    foreach (QModbusTcpClient *client, clients) {
+        client->setConnectionParameter(QModbusDevice::NetworkAddressParameter,
+                                       QStringLiteral("127.0.0.1"));
+        client->setConnectionParameter(QModbusDevice::NetworkPortParameter, port);
+        client->setTimeout(5000);
+        client->setNumberOfRetries(0);
+        QObject::connect(client, &QModbusDevice::stateChanged, &loop, [&]() {
+            if (allConnected())
+                loop.quit();
+        });
+        client->connectDevice();
+    }
+
+    if (!allConnected())
+        loop.exec();
+    return allConnected();
+}
+
+static BenchResult runRequests(const QVector<QModbusTcpClient *> &clients, const BenchCase &bc,
+                               int total)
+{
+    BenchResult result;
+    result.latenciesNs.reserve(total);
+
+    QModbusDataUnit unit(bc.kind.table, 0, bc.count);
+    if (bc.kind.write) {
+        QVector<quint16> values(bc.count);
+        for (int i = 0; i < values.size(); ++i)
+            values[i] = quint16(i);
+        unit.setValues(values);
+    }
+
+    QEventLoop loop;
+    QElapsedTimer clock;
+    int issued = 0;
+    int completed = 0;
+
+    std::function<void(QModbusTcpClient *)> issue = [&](QModbusTcpClient *client) {
+        if (issued >= total)
+            return;
+        ++issued;
+
+        const qint64 start = clock.nsecsElapsed();
+        QModbusReply *reply = bc.kind.write ? client->sendWriteRequest(unit, ServerUnitId)
+                                            : client->sendReadRequest(unit, ServerUnitId);
+        if (!reply) {
+            ++result.errors;
+            if (++completed == total)
+                loop.quit();
+            return;
+        }
+
+        QObject::connect(reply, &QModbusReply::finished, &loop, [&, reply, client, start]() {
+            result.latenciesNs.append(clock.nsecsElapsed() - start);
+            if (reply->error() != QModbusDevice::NoError)
+                ++result.errors;
+            reply->deleteLater();
+
+            if (++completed == total)
+                loop.quit();
+            else
+                issue(client);
+        });
+    };
+
+    const qint64 cpuStart = cpuTimeUs();
+    clock.start();
+    for (int i = 0; i < bc.depth; ++i) {
+        foreach (QModbusTcpClient *client, clients)
+            issue(client);
+    }
+    if (completed < total)
+        loop.exec();
+
+    result.wallNs = clock.nsecsElapsed();
+    result.cpuUs = cpuTimeUs() - cpuStart;
+    result.requests = completed;
+    return result;
+}
+
+static double percentileUs(QVector<qint64> sorted, double p)
+{
+    if (sorted.isEmpty())
+        return 0.;
+    int index = int(p * sorted.size() + 0.999999) - 1;
+    index = qBound(0, index, sorted.size() - 1);
+    return sorted.at(index) / 1000.;
+}
+
+class Reporter
+{
+public:
+    Reporter(QTextStream &out, bool csv) : out(out), csv(csv)
+    {
+        if (csv) {
+            out << "mode,request,count,concurrency,depth,requests,errors,seconds,"
+                   "requests_per_second,p50_us,p99_us,p999_us,cpu_us_per_request,cpu_scope"
+                << endl;
+        }
+    }
+
+    void report(const BenchCase &bc, BenchResult &result)
+    {
+        std::sort(result.latenciesNs.begin(), result.latenciesNs.end());
+
+        const double seconds = result.wallNs / 1e9;
+        const double rps = seconds > 0 ? result.requests / seconds : 0.;
+        const double cpuPerRequest = result.requests > 0
+            ? double(result.cpuUs) / result.requests : 0.;
+        const QString cpuScope = bc.mode == QLatin1String("thread")
+            ? QStringLiteral("client+server") : QStringLiteral("client");
+
+        if (csv) {
+            out << bc.mode << ',' << bc.kind.name << ',' << bc.count << ','
+                << bc.concurrency << ',' << bc.depth << ',' << result.requests << ','
+                << result.errors << ',' << seconds << ',' << rps << ','
+                << percentileUs(result.latenciesNs, 0.50) << ','
+                << percentileUs(result.latenciesNs, 0.99) << ','
+                << percentileUs(result.latenciesNs, 0.999) << ','
+                << cpuPerRequest << ',' << cpuScope << endl;
+            return;
+        }
+
+        QJsonObject object;
+        object.insert(QStringLiteral("mode"), bc.mode);
+        object.insert(QStringLiteral("request"), QLatin1String(bc.kind.name));
+        object.insert(QStringLiteral("count"), bc.count);
+        object.insert(QStringLiteral("concurrency"), bc.concurrency);
+        object.insert(QStringLiteral("depth"), bc.depth);
+        object.insert(QStringLiteral("requests"), result.requests);
+        object.insert(QStringLiteral("errors"), result.errors);
+        object.insert(QStringLiteral("seconds"), seconds);
+        object.insert(QStringLiteral("requests_per_second"), rps);
+        object.insert(QStringLiteral("p50_us"), percentileUs(result.latenciesNs, 0.50));
+        object.insert(QStringLiteral("p99_us"), percentileUs(result.latenciesNs, 0.99));
+        object.insert(QStringLiteral("p999_us"), percentileUs(result.latenciesNs, 0.999));
+        object.insert(QStringLiteral("cpu_us_per_request"), cpuPerRequest);
+        object.insert(QStringLiteral("cpu_scope"), cpuScope);
+        out << QJsonDocument(object).toJson(QJsonDocument::Compact) << endl;
+    }
+
+private:
+    QTextStream &out;
+    bool csv;
+};
+
+static QVector<int> parseList(const QString &value)
+{
+    QVector<int> result;
+    foreach (const QString &item, value.split(QLatin1Char(','), QString::SkipEmptyParts)) {
+        bool ok = false;
+        const int number = item.trimmed().toInt(&ok);
+        if (ok && number > 0)
+            result.append(number);
+    }
+    return result;
+}
+
+static int serve(int port)
+{
+    ServerHost host;
+    if (!host.start(port))
+        return 1;
+
+    QTextStream out(stdout);
+    out << "READY" << endl;
+    return QCoreApplication::exec();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Modbus TCP loopback benchmark"));
+    parser.addHelpOption();
+
+    const QCommandLineOption modeOption(QStringLiteral("mode"),
+        QStringLiteral("Server placement: thread, process or all."), QStringLiteral("mode"),
+        QStringLiteral("all"));
+    const QCommandLineOption requestOption(QStringLiteral("requests"),
+        QStringLiteral("Measured requests per case."), QStringLiteral("n"),
+        QStringLiteral("20000"));
+    const QCommandLineOption warmupOption(QStringLiteral("warmup"),
+        QStringLiteral("Unmeasured warm-up requests per case."), QStringLiteral("n"),
+        QStringLiteral("1000"));
+    const QCommandLineOption countOption(QStringLiteral("counts"),
+        QStringLiteral("Comma separated register counts."), QStringLiteral("list"),
+        QStringLiteral("1,16,64,125"));
+    const QCommandLineOption concurrencyOption(QStringLiteral("concurrency"),
+        QStringLiteral("Comma separated numbers of client connections."), QStringLiteral("list"),
+        QStringLiteral("1,4"));
+    const QCommandLineOption depthOption(QStringLiteral("depth"),
+        QStringLiteral("Comma separated pipelining depths per connection."),
+        QStringLiteral("list"), QStringLiteral("1,8,32"));
+    const QCommandLineOption filterOption(QStringLiteral("filter"),
+        QStringLiteral("Only run request types containing this string."),
+        QStringLiteral("text"));
+    const QCommandLineOption portOption(QStringLiteral("port"),
+        QStringLiteral("TCP port used by the server."), QStringLiteral("port"),
+        QStringLiteral("15020"));
+    const QCommandLineOption formatOption(QStringLiteral("format"),
+        QStringLiteral("Output format: json or csv."), QStringLiteral("format"),
+        QStringLiteral("json"));
+    const QCommandLineOption outputOption(QStringLiteral("output"),
+        QStringLiteral("Write results to file instead of stdout."), QStringLiteral("file"));
+    const QCommandLineOption serveOption(QStringLiteral("serve"),
+        QStringLiteral("Internal: run only the server on the given port."),
+        QStringLiteral("port"));
+
+    parser.addOptions({ modeOption, requestOption, warmupOption, countOption,
+                        concurrencyOption, depthOption, filterOption, portOption,
+                        formatOption, outputOption, serveOption });
+    parser.process(app);
+
+    if (parser.isSet(serveOption))
+        return serve(parser.value(serveOption).toInt());
+
+    QFile outputFile;
+    if (parser.isSet(outputOption)) {
+        outputFile.setFileName(parser.value(outputOption));
+        if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            qWarning("Cannot open %s", qPrintable(outputFile.fileName()));
+            return 1;
+        }
+    } else {
+        outputFile.open(stdout, QIODevice::WriteOnly);
+    }
+    QTextStream out(&outputFile);
+    Reporter reporter(out, parser.value(formatOption) == QLatin1String("csv"));
+
+    const int total = qMax(1, parser.value(requestOption).toInt());
+    const int warmup = qMax(0, parser.value(warmupOption).toInt());
+    const int port = parser.value(portOption).toInt();
+    const QVector<int> counts = parseList(parser.value(countOption));
+    const QVector<int> concurrencies = parseList(parser.value(concurrencyOption));
+    const QVector<int> depths = parseList(parser.value(depthOption));
+    const QString filter = parser.value(filterOption);
+
+    QStringList modes;
+    const QString mode = parser.value(modeOption);
+    if (mode == QLatin1String("all"))
+        modes << QStringLiteral("thread") << QStringLiteral("process");
+    else
+        modes << mode;
+
+    foreach (const QString &currentMode, modes) {
+        QThread serverThread;
+        ServerHost *host = nullptr;
+        QProcess serverProcess;
+        bool started = false;
+
+        if (currentMode == QLatin1String("thread")) {
+            host = new ServerHost;
+            host->moveToThread(&serverThread);
+            QObject::connect(&serverThread, &QThread::finished, host, &QObject::deleteLater);
+            serverThread.start();
+            QMetaObject::invokeMethod(host, "start", Qt::BlockingQueuedConnection,
+                                      Q_RETURN_ARG(bool, started), Q_ARG(int, port));
+        } else if (currentMode == QLatin1String("process")) {
+            serverProcess.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+            serverProcess.start(QCoreApplication::applicationFilePath(),
+                                { QStringLiteral("--serve"), QString::number(port) });
+            if (serverProcess.waitForStarted(5000)) {
+                while (serverProcess.waitForReadyRead(5000)) {
+                    if (serverProcess.readAll().contains("READY")) {
+                        started = true;
+                        break;
+                    }
+                }
+            }
+        } else {
+            qWarning("Unknown mode %s", qPrintable(currentMode));
+            return 1;
+        }
+
+        if (!started) {
+            qWarning("Cannot start Modbus TCP server in %s mode on port %d",
+                     qPrintable(currentMode), port);
+        } else {
+            for (const RequestKind &kind : requestKinds) {
+                if (!filter.isEmpty() && !QLatin1String(kind.name).contains(filter))
+                    continue;
+                foreach (int count, counts) {
+                    if (count > kind.maxCount)
+                        continue;
+                    foreach (int concurrency, concurrencies) {
+                        QVector<QModbusTcpClient *> clients;
+                        for (int i = 0; i < concurrency; ++i)
+                            clients.append(new QModbusTcpClient);
+
+                        if (!connectClients(clients, port)) {
+                            qWarning("Cannot connect %d clients to port %d", concurrency, port);
+                        } else {
+                            foreach (int depth, depths) {
+                                const BenchCase bc = { currentMode, kind, count, concurrency,
+                                                       depth };
+                                if (warmup > 0)
+                                    runRequests(clients, bc, warmup);
+                                BenchResult result = runRequests(clients, bc, total);
+                                reporter.report(bc, result);
+                            }
+                        }
+
+                        foreach (QModbusTcpClient *client, clients)
+                            client->disconnectDevice();
+                        qDeleteAll(clients);
+                    }
+                }
+            }
+        }
+
+        if (host) {
+            QMetaObject::invokeMethod(host, "stop", Qt::BlockingQueuedConnection);
+            serverThread.quit();
+            serverThread.wait();
+        }
+        if (serverProcess.state() != QProcess::NotRunning) {
+            serverProcess.kill();
+            serverProcess.waitForFinished(5000);
+        }
+    }
+
+    return 0;
+}
+
+#include "main.moc"
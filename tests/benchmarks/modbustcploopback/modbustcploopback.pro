@@ -0,0 +1,7 @@
+QT = core network serialbus
+TARGET = modbustcploopback
+CONFIG += console c++11
+
+CONFIG -= app_bundle
+
+SOURCES += main.cpp
@@ -0,0 +1,9 @@
+QT = core testlib serialbus
+TARGET = tst_bench_qcanbusdevice
+CONFIG += benchmark c++11
+
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../../auto/shared
+HEADERS += ../../auto/shared/canbustestbackend.h
+SOURCES += tst_bench_qcanbusdevice.cpp
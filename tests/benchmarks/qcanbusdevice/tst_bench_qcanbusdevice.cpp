@@ -0,0 +1,170 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "canbustestbackend.h"
+
+#include <QtSerialBus/qcanbusdevice.h>
+#include <QtSerialBus/qcanbusframe.h>
+
+#include <QtTest/QtTest>
+
+// Reference evaluation of a filter list as documented for QCanBusDevice::Filter.
+static bool matches(const QList<QCanBusDevice::Filter> &filters, const QCanBusFrame &frame)
+{
+    if (filters.isEmpty())
+        return true;
+
+    foreach (const QCanBusDevice::Filter &filter, filters) {
+        if (filter.type != QCanBusFrame::InvalidFrame && filter.type != frame.frameType())
+            continue;
+        if (frame.hasExtendedFrameFormat()) {
+            if (!(filter.format & QCanBusDevice::Filter::MatchExtendedFormat))
+                continue;
+        } else if (!(filter.format & QCanBusDevice::Filter::MatchBaseFormat)) {
+            continue;
+        }
+        if ((frame.frameId() & filter.frameIdMask) == (filter.frameId & filter.frameIdMask))
+            return true;
+    }
+    return false;
+}
+
+class tst_Bench_QCanBusDevice : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void enqueueAndRead_data();
+    void enqueueAndRead();
+    void filterEvaluation_data();
+    void filterEvaluation();
+    void configurationParameter_data();
+    void configurationParameter();
+};
+
+void tst_Bench_QCanBusDevice::enqueueAndRead_data()
+{
+    QTest::addColumn<int>("queueDepth");
+
+    QTest::newRow("1") << 1;
+    QTest::newRow("16") << 16;
+    QTest::newRow("256") << 256;
+    QTest::newRow("4096") << 4096;
+}
+
+void tst_Bench_QCanBusDevice::enqueueAndRead()
+{
+    QFETCH(int, queueDepth);
+
+    CanBusTestBackend device;
+    QVERIFY(device.connectDevice());
+
+    const QVector<QCanBusFrame> batch(queueDepth, QCanBusFrame(0x42, QByteArray(8, '\x55')));
+    int read = 0;
+
+    QBENCHMARK {
+        device.receive(batch);
+        while (device.framesAvailable() > 0) {
+            device.readFrame();
+            ++read;
+        }
+    }
+    QVERIFY(read >= queueDepth);
+}
+
+void tst_Bench_QCanBusDevice::filterEvaluation_data()
+{
+    QTest::addColumn<int>("filterCount");
+
+    QTest::newRow("1 filter") << 1;
+    QTest::newRow("16 filters") << 16;
+    QTest::newRow("256 filters") << 256;
+}
+
+void tst_Bench_QCanBusDevice::filterEvaluation()
+{
+    QFETCH(int, filterCount);
+
+    QList<QCanBusDevice::Filter> filters;
+    for (int i = 0; i < filterCount; ++i) {
+        QCanBusDevice::Filter filter;
+        filter.frameId = 0x100 + i;
+        filter.frameIdMask = 0x7ff;
+        filter.type = QCanBusFrame::DataFrame;
+        filter.format = QCanBusDevice::Filter::MatchBaseFormat;
+        filters.append(filter);
+    }
+
+    // half the frames match the last filter, the other half match none
+    QVector<QCanBusFrame> frames;
+    for (int i = 0; i < 64; ++i)
+        frames.append(QCanBusFrame((i % 2) ? 0x100 + filterCount - 1 : 0x7ff, QByteArray(8, 0)));
+
+    int accepted = 0;
+    QBENCHMARK {
+        for (const QCanBusFrame &frame : frames)
+            accepted += matches(filters, frame);
+    }
+    QVERIFY(accepted > 0);
+}
+
+void tst_Bench_QCanBusDevice::configurationParameter_data()
+{
+    QTest::addColumn<int>("keyCount");
+
+    QTest::newRow("4 keys") << 4;
+    QTest::newRow("32 keys") << 32;
+}
+
+void tst_Bench_QCanBusDevice::configurationParameter()
+{
+    QFETCH(int, keyCount);
+
+    CanBusTestBackend device;
+    for (int key = 0; key < keyCount; ++key)
+        device.setConfigurationParameter(QCanBusDevice::UserKey + key, key);
+    const int lastKey = QCanBusDevice::UserKey + keyCount - 1;
+
+    QVariant value;
+    QBENCHMARK {
+        value = device.configurationParameter(lastKey);
+    }
+    QCOMPARE(value.toInt(), keyCount - 1);
+}
+
+QTEST_MAIN(tst_Bench_QCanBusDevice)
+
+#include "tst_bench_qcanbusdevice.moc"
@@ -0,0 +1,169 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtSerialBus/qcanbusframe.h>
+
+#include <QtCore/qbuffer.h>
+#include <QtCore/qdatastream.h>
+#include <QtTest/QtTest>
+
+class tst_Bench_QCanBusFrame : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void constructDefault();
+    void constructWithPayload_data();
+    void constructWithPayload();
+    void copy_data();
+    void copy();
+    void setPayload_data();
+    void setPayload();
+    void isValid();
+    void streamRoundTrip_data();
+    void streamRoundTrip();
+
+private:
+    void addPayloadSizes();
+};
+
+void tst_Bench_QCanBusFrame::addPayloadSizes()
+{
+    QTest::addColumn<int>("payloadSize");
+
+    QTest::newRow("0 bytes") << 0;
+    QTest::newRow("8 bytes") << 8;
+    QTest::newRow("64 bytes") << 64;
+}
+
+void tst_Bench_QCanBusFrame::constructDefault()
+{
+    QBENCHMARK {
+        QCanBusFrame frame;
+        Q_UNUSED(frame);
+    }
+}
+
+void tst_Bench_QCanBusFrame::constructWithPayload_data()
+{
+    addPayloadSizes();
+}
+
+void tst_Bench_QCanBusFrame::constructWithPayload()
+{
+    QFETCH(int, payloadSize);
+    const QByteArray payload(payloadSize, '\x11');
+
+    QBENCHMARK {
+        QCanBusFrame frame(0x123, payload);
+        Q_UNUSED(frame);
+    }
+}
+
+void tst_Bench_QCanBusFrame::copy_data()
+{
+    addPayloadSizes();
+}
+
+void tst_Bench_QCanBusFrame::copy()
+{
+    QFETCH(int, payloadSize);
+    const QCanBusFrame original(0x123, QByteArray(payloadSize, '\x22'));
+
+    QBENCHMARK {
+        QCanBusFrame frame(original);
+        Q_UNUSED(frame);
+    }
+}
+
+void tst_Bench_QCanBusFrame::setPayload_data()
+{
+    addPayloadSizes();
+}
+
+void tst_Bench_QCanBusFrame::setPayload()
+{
+    QFETCH(int, payloadSize);
+    const char *raw = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef";
+    QCanBusFrame frame(0x123);
+
+    // build a fresh payload every time, as a backend does for every received frame
+    QBENCHMARK {
+        frame.setPayload(QByteArray(raw, payloadSize));
+    }
+}
+
+void tst_Bench_QCanBusFrame::isValid()
+{
+    const QCanBusFrame frame(0x1234567, QByteArray(8, '\x33'));
+    bool valid = false;
+
+    QBENCHMARK {
+        valid = frame.isValid();
+    }
+    QVERIFY(valid);
+}
+
+void tst_Bench_QCanBusFrame::streamRoundTrip_data()
+{
+    addPayloadSizes();
+}
+
+void tst_Bench_QCanBusFrame::streamRoundTrip()
+{
+    QFETCH(int, payloadSize);
+    const QCanBusFrame original(0x123, QByteArray(payloadSize, '\x44'));
+
+    QByteArray buffer;
+    buffer.reserve(128);
+    QCanBusFrame copy;
+
+    QBENCHMARK {
+        buffer.resize(0);
+        {
+            QDataStream out(&buffer, QIODevice::WriteOnly);
+            out << original;
+        }
+        QDataStream in(buffer);
+        in >> copy;
+    }
+    QCOMPARE(copy.frameId(), original.frameId());
+    QCOMPARE(copy.payload(), original.payload());
+}
+
+QTEST_MAIN(tst_Bench_QCanBusFrame)
+
+#include "tst_bench_qcanbusframe.moc"
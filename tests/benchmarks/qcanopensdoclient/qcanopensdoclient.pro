@@ -0,0 +1,10 @@
+QT = core testlib serialbus
+TARGET = tst_bench_qcanopensdoclient
+CONFIG += benchmark c++11
+
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../../auto/qcanopensdoclient ../../auto/shared
+HEADERS += ../../auto/qcanopensdoclient/sdoserver.h \
+    ../../auto/shared/canbustestbackend.h
+SOURCES += tst_bench_qcanopensdoclient.cpp
@@ -0,0 +1,121 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "sdoserver.h"
+
+#include <QtSerialBus/qcanopensdoclient.h>
+#include <QtSerialBus/qcanopensdoreply.h>
+
+#include <QtCore/qelapsedtimer.h>
+#include <QtTest/QtTest>
+
+/*
+    Compares segmented and block SDO transfers against a simulated node on an
+    in-process virtual bus. Responses are delivered through the event loop,
+    optionally after a delay standing in for the turnaround time of a real
+    bus. A segmented transfer needs one round trip per 7 bytes, a block
+    transfer one per block of up to 127 segments.
+*/
+
+class tst_Bench_QCanOpenSdoClient : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void transfer_data();
+    void transfer();
+};
+
+void tst_Bench_QCanOpenSdoClient::transfer_data()
+{
+    QTest::addColumn<bool>("upload");
+    QTest::addColumn<QCanOpenSdoClient::TransferMode>("mode");
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("delay");
+
+    const struct { int size; int delay; } cases[] = { { 65536, 0 }, { 4096, 1 } };
+    for (const auto &c : cases) {
+        for (bool upload : { false, true }) {
+            const QString name = QStringLiteral("%1 %2 bytes %3 ms %4")
+                    .arg(upload ? QStringLiteral("upload") : QStringLiteral("download"))
+                    .arg(c.size).arg(c.delay);
+            QTest::newRow(qPrintable(name.arg(QStringLiteral("segmented"))))
+                    << upload << QCanOpenSdoClient::SegmentedTransfer << c.size << c.delay;
+            QTest::newRow(qPrintable(name.arg(QStringLiteral("block"))))
+                    << upload << QCanOpenSdoClient::BlockTransfer << c.size << c.delay;
+        }
+    }
+}
+
+void tst_Bench_QCanOpenSdoClient::transfer()
+{
+    QFETCH(bool, upload);
+    QFETCH(QCanOpenSdoClient::TransferMode, mode);
+    QFETCH(int, size);
+    QFETCH(int, delay);
+
+    SdoServerBackend device(5);
+    QVERIFY(device.connectDevice());
+    device.responseDelay = delay;
+    QCanOpenSdoClient client(&device);
+    client.setTimeout(5000);
+
+    const QByteArray data(size, '\x5a');
+    device.dictionary.insert(SdoServerBackend::key(0x1f50, 1), data);
+
+    qint64 transferred = 0;
+    qint64 elapsed = 0;
+    QBENCHMARK {
+        QElapsedTimer clock;
+        clock.start();
+        QCanOpenSdoReply *reply = upload ? client.upload(5, 0x1f50, 1, mode)
+                                         : client.download(5, 0x1f50, 1, data, mode);
+        QVERIFY(reply);
+        QSignalSpy spy(reply, &QCanOpenSdoReply::finished);
+        QVERIFY(spy.wait(60000));
+        QCOMPARE(reply->error(), QCanOpenSdoReply::NoError);
+        elapsed += clock.nsecsElapsed();
+        transferred += size;
+        delete reply;
+    }
+
+    qDebug("%.0f bytes/s, %d requests", elapsed ? transferred * 1e9 / elapsed : 0.,
+           device.requests);
+}
+
+QTEST_MAIN(tst_Bench_QCanOpenSdoClient)
+
+#include "tst_bench_qcanopensdoclient.moc"
@@ -0,0 +1,9 @@
+requires(contains(QT_CONFIG, private_tests))
+
+QT = core testlib serialbus-private
+TARGET = tst_bench_qmodbusadu
+CONFIG += benchmark c++11
+
+CONFIG -= app_bundle
+
+SOURCES += tst_bench_qmodbusadu.cpp
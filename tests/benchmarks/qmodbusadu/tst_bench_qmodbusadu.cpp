@@ -0,0 +1,148 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtSerialBus/qmodbuspdu.h>
+#include <private/qmodbusadu_p.h>
+
+#include <QtTest/QtTest>
+
+class tst_Bench_QModbusAdu : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void calculateCRC_data();
+    void calculateCRC();
+    void calculateLRC_data();
+    void calculateLRC();
+    void create_data();
+    void create();
+    void parseRtu();
+
+private:
+    void addFrameSizes();
+};
+
+void tst_Bench_QModbusAdu::addFrameSizes()
+{
+    QTest::addColumn<int>("size");
+
+    // smallest request, typical read request, largest RTU frame without CRC
+    QTest::newRow("2 bytes") << 2;
+    QTest::newRow("6 bytes") << 6;
+    QTest::newRow("254 bytes") << 254;
+}
+
+void tst_Bench_QModbusAdu::calculateCRC_data()
+{
+    addFrameSizes();
+}
+
+void tst_Bench_QModbusAdu::calculateCRC()
+{
+    QFETCH(int, size);
+    const QByteArray data(size, '\xa5');
+
+    quint16 crc = 0;
+    QBENCHMARK {
+        crc = QModbusSerialAdu::calculateCRC(data.constData(), data.size());
+    }
+    Q_UNUSED(crc);
+}
+
+void tst_Bench_QModbusAdu::calculateLRC_data()
+{
+    addFrameSizes();
+}
+
+void tst_Bench_QModbusAdu::calculateLRC()
+{
+    QFETCH(int, size);
+    const QByteArray data(size, '\xa5');
+
+    quint8 lrc = 0;
+    QBENCHMARK {
+        lrc = QModbusSerialAdu::calculateLRC(data.constData(), data.size());
+    }
+    Q_UNUSED(lrc);
+}
+
+void tst_Bench_QModbusAdu::create_data()
+{
+    QTest::addColumn<bool>("ascii");
+    QTest::addColumn<int>("registers");
+
+    QTest::newRow("rtu 1 register") << false << 1;
+    QTest::newRow("rtu 123 registers") << false << 123;
+    QTest::newRow("ascii 1 register") << true << 1;
+    QTest::newRow("ascii 123 registers") << true << 123;
+}
+
+void tst_Bench_QModbusAdu::create()
+{
+    QFETCH(bool, ascii);
+    QFETCH(int, registers);
+
+    const QModbusRequest request(QModbusPdu::WriteMultipleRegisters, quint16(0),
+        quint16(registers), quint8(registers * 2), QVector<quint16>(registers, 0x1234));
+    const QModbusSerialAdu::Type type = ascii ? QModbusSerialAdu::Ascii : QModbusSerialAdu::Rtu;
+
+    QByteArray adu;
+    QBENCHMARK {
+        adu = QModbusSerialAdu::create(type, 1, request);
+    }
+    QVERIFY(!adu.isEmpty());
+}
+
+void tst_Bench_QModbusAdu::parseRtu()
+{
+    // the work done by the RTU master for every received response frame
+    const QModbusResponse response(QModbusPdu::ReadHoldingRegisters, quint8(250),
+                                   QVector<quint16>(125, 0x1234));
+    const QByteArray raw = QModbusSerialAdu::create(QModbusSerialAdu::Rtu, 1, response);
+
+    bool valid = false;
+    QBENCHMARK {
+        const QModbusSerialAdu adu(QModbusSerialAdu::Rtu, raw);
+        const int dataSize = QModbusResponse::calculateDataSize(adu.pdu());
+        valid = dataSize == 250 + 1 && adu.matchingChecksum();
+    }
+    QVERIFY(valid);
+}
+
+QTEST_MAIN(tst_Bench_QModbusAdu)
+
+#include "tst_bench_qmodbusadu.moc"
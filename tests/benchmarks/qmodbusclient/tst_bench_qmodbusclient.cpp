@@ -0,0 +1,134 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtSerialBus/qmodbusclient.h>
+
+#include <QtTest/QtTest>
+
+Q_DECLARE_METATYPE(QModbusPdu::FunctionCode)
+Q_DECLARE_METATYPE(QModbusDataUnit::RegisterType)
+
+class BenchClient : public QModbusClient
+{
+public:
+    bool open() override {
+        setState(QModbusDevice::ConnectedState);
+        return true;
+    }
+    void close() override {
+        setState(QModbusDevice::UnconnectedState);
+    }
+    bool processResponse(const QModbusResponse &response, QModbusDataUnit *data) override
+    {
+        return QModbusClient::processResponse(response, data);
+    }
+};
+
+static QByteArray registerPayload(int count)
+{
+    QByteArray payload;
+    payload.reserve(count * 2);
+    for (int i = 0; i < count; ++i)
+        payload.append(char(i >> 8)).append(char(i));
+    return payload;
+}
+
+class tst_Bench_QModbusClient : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void processResponse_data();
+    void processResponse();
+};
+
+void tst_Bench_QModbusClient::processResponse_data()
+{
+    QTest::addColumn<QModbusPdu::FunctionCode>("code");
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<QModbusDataUnit::RegisterType>("type");
+    QTest::addColumn<int>("valueCount");
+
+    QTest::newRow("ReadCoils") << QModbusPdu::ReadCoils
+        << QByteArray::fromHex("64").append(QByteArray(100, '\xa5'))
+        << QModbusDataUnit::Coils << 800;
+    QTest::newRow("ReadDiscreteInputs") << QModbusPdu::ReadDiscreteInputs
+        << QByteArray::fromHex("64").append(QByteArray(100, '\x5a'))
+        << QModbusDataUnit::DiscreteInputs << 800;
+    QTest::newRow("ReadHoldingRegisters 1") << QModbusPdu::ReadHoldingRegisters
+        << QByteArray::fromHex("02").append(registerPayload(1))
+        << QModbusDataUnit::HoldingRegisters << 1;
+    QTest::newRow("ReadHoldingRegisters 125") << QModbusPdu::ReadHoldingRegisters
+        << QByteArray::fromHex("fa").append(registerPayload(125))
+        << QModbusDataUnit::HoldingRegisters << 125;
+    QTest::newRow("ReadInputRegisters 125") << QModbusPdu::ReadInputRegisters
+        << QByteArray::fromHex("fa").append(registerPayload(125))
+        << QModbusDataUnit::InputRegisters << 125;
+    QTest::newRow("WriteSingleCoil") << QModbusPdu::WriteSingleCoil
+        << QByteArray::fromHex("0100ff00") << QModbusDataUnit::Coils << 1;
+    QTest::newRow("WriteSingleRegister") << QModbusPdu::WriteSingleRegister
+        << QByteArray::fromHex("01001234") << QModbusDataUnit::HoldingRegisters << 1;
+    QTest::newRow("WriteMultipleCoils") << QModbusPdu::WriteMultipleCoils
+        << QByteArray::fromHex("01000010") << QModbusDataUnit::Coils << 16;
+    QTest::newRow("WriteMultipleRegisters") << QModbusPdu::WriteMultipleRegisters
+        << QByteArray::fromHex("0100007b") << QModbusDataUnit::HoldingRegisters << 123;
+    QTest::newRow("ReadWriteMultipleRegisters") << QModbusPdu::ReadWriteMultipleRegisters
+        << QByteArray::fromHex("fa").append(registerPayload(125))
+        << QModbusDataUnit::HoldingRegisters << 125;
+}
+
+void tst_Bench_QModbusClient::processResponse()
+{
+    QFETCH(QModbusPdu::FunctionCode, code);
+    QFETCH(QByteArray, data);
+    QFETCH(QModbusDataUnit::RegisterType, type);
+    QFETCH(int, valueCount);
+
+    BenchClient client;
+    const QModbusResponse response(code, data);
+    bool processed = false;
+
+    // the reply's data unit is created from the original request, as sendRequest() does
+    QBENCHMARK {
+        QModbusDataUnit unit(type, 0x0100, quint16(valueCount));
+        processed = client.processResponse(response, &unit);
+    }
+    QVERIFY(processed);
+}
+
+QTEST_MAIN(tst_Bench_QModbusClient)
+
+#include "tst_bench_qmodbusclient.moc"
@@ -0,0 +1,243 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtSerialBus/qmodbuspdu.h>
+
+#include <QtCore/qdatastream.h>
+#include <QtTest/QtTest>
+
+Q_DECLARE_METATYPE(QModbusPdu::FunctionCode)
+
+static QByteArray registerPayload(int count)
+{
+    QByteArray payload;
+    payload.reserve(count * 2);
+    for (int i = 0; i < count; ++i)
+        payload.append(char(i >> 8)).append(char(i));
+    return payload;
+}
+
+class tst_Bench_QModbusPdu : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void encodeRequest_data();
+    void encodeRequest();
+    void decodeRequest_data();
+    void decodeRequest();
+    void decodeResponse_data();
+    void decodeResponse();
+    void encodeData();
+    void decodeData();
+    void requestDataSize_data();
+    void requestDataSize();
+    void responseDataSize_data();
+    void responseDataSize();
+
+private:
+    void addRequests();
+    void addResponses();
+};
+
+void tst_Bench_QModbusPdu::addRequests()
+{
+    QTest::addColumn<QModbusPdu::FunctionCode>("code");
+    QTest::addColumn<QByteArray>("data");
+
+    QTest::newRow("ReadCoils") << QModbusPdu::ReadCoils << QByteArray::fromHex("000007d0");
+    QTest::newRow("ReadHoldingRegisters") << QModbusPdu::ReadHoldingRegisters
+        << QByteArray::fromHex("0000007d");
+    QTest::newRow("WriteSingleRegister") << QModbusPdu::WriteSingleRegister
+        << QByteArray::fromHex("00010003");
+    QTest::newRow("WriteMultipleCoils") << QModbusPdu::WriteMultipleCoils
+        << QByteArray::fromHex("0000001002ffff");
+    QTest::newRow("WriteMultipleRegisters") << QModbusPdu::WriteMultipleRegisters
+        << QByteArray::fromHex("0000007bf6").append(registerPayload(123));
+    QTest::newRow("ReadWriteMultipleRegisters") << QModbusPdu::ReadWriteMultipleRegisters
+        << QByteArray::fromHex("0000000a0000000306").append(registerPayload(3));
+    QTest::newRow("Diagnostics") << QModbusPdu::Diagnostics << QByteArray::fromHex("0000a537");
+    QTest::newRow("ReportServerId") << QModbusPdu::ReportServerId << QByteArray();
+}
+
+void tst_Bench_QModbusPdu::addResponses()
+{
+    QTest::addColumn<QModbusPdu::FunctionCode>("code");
+    QTest::addColumn<QByteArray>("data");
+
+    QTest::newRow("ReadCoils") << QModbusPdu::ReadCoils << QByteArray::fromHex("02cd01");
+    QTest::newRow("ReadHoldingRegisters") << QModbusPdu::ReadHoldingRegisters
+        << QByteArray::fromHex("fa").append(registerPayload(125));
+    QTest::newRow("WriteMultipleRegisters") << QModbusPdu::WriteMultipleRegisters
+        << QByteArray::fromHex("0000007b");
+    QTest::newRow("ReadWriteMultipleRegisters") << QModbusPdu::ReadWriteMultipleRegisters
+        << QByteArray::fromHex("14").append(registerPayload(10));
+    QTest::newRow("GetCommEventLog") << QModbusPdu::GetCommEventLog
+        << QByteArray::fromHex("080000010801212000");
+    QTest::newRow("ReportServerId") << QModbusPdu::ReportServerId
+        << QByteArray::fromHex("030aff00");
+}
+
+void tst_Bench_QModbusPdu::encodeRequest_data()
+{
+    addRequests();
+}
+
+void tst_Bench_QModbusPdu::encodeRequest()
+{
+    QFETCH(QModbusPdu::FunctionCode, code);
+    QFETCH(QByteArray, data);
+
+    const QModbusRequest request(code, data);
+    QByteArray buffer;
+    buffer.reserve(256);
+
+    QBENCHMARK {
+        buffer.resize(0);
+        QDataStream out(&buffer, QIODevice::WriteOnly);
+        out << request;
+    }
+    QCOMPARE(buffer.size(), request.size());
+}
+
+void tst_Bench_QModbusPdu::decodeRequest_data()
+{
+    addRequests();
+}
+
+void tst_Bench_QModbusPdu::decodeRequest()
+{
+    QFETCH(QModbusPdu::FunctionCode, code);
+    QFETCH(QByteArray, data);
+
+    const QByteArray wire = QByteArray(1, char(code)) + data;
+    QModbusRequest request;
+
+    QBENCHMARK {
+        QDataStream in(wire);
+        in >> request;
+    }
+    QCOMPARE(request.functionCode(), code);
+    QCOMPARE(request.data(), data);
+}
+
+void tst_Bench_QModbusPdu::decodeResponse_data()
+{
+    addResponses();
+}
+
+void tst_Bench_QModbusPdu::decodeResponse()
+{
+    QFETCH(QModbusPdu::FunctionCode, code);
+    QFETCH(QByteArray, data);
+
+    const QByteArray wire = QByteArray(1, char(code)) + data;
+    QModbusResponse response;
+
+    QBENCHMARK {
+        QDataStream in(wire);
+        in >> response;
+    }
+    QCOMPARE(response.functionCode(), code);
+    QCOMPARE(response.data(), data);
+}
+
+void tst_Bench_QModbusPdu::encodeData()
+{
+    const QVector<quint16> values(123, 0x1234);
+
+    QBENCHMARK {
+        QModbusRequest request(QModbusPdu::WriteMultipleRegisters, quint16(0), quint16(123),
+                               quint8(246), values);
+        Q_UNUSED(request);
+    }
+}
+
+void tst_Bench_QModbusPdu::decodeData()
+{
+    const QModbusRequest request(QModbusPdu::ReadWriteMultipleRegisters,
+        QByteArray::fromHex("0000000a0000000306").append(registerPayload(3)));
+
+    quint16 readStart = 0, readCount = 0, writeStart = 0, writeCount = 0;
+    quint8 byteCount = 0;
+    QBENCHMARK {
+        request.decodeData(&readStart, &readCount, &writeStart, &writeCount, &byteCount);
+    }
+    QCOMPARE(readCount, quint16(10));
+    QCOMPARE(byteCount, quint8(6));
+}
+
+void tst_Bench_QModbusPdu::requestDataSize_data()
+{
+    addRequests();
+}
+
+void tst_Bench_QModbusPdu::requestDataSize()
+{
+    QFETCH(QModbusPdu::FunctionCode, code);
+    QFETCH(QByteArray, data);
+
+    const QModbusRequest request(code, data);
+    int size = 0;
+
+    QBENCHMARK {
+        size = QModbusRequest::calculateDataSize(request);
+    }
+    QCOMPARE(size, data.size());
+}
+
+void tst_Bench_QModbusPdu::responseDataSize_data()
+{
+    addResponses();
+}
+
+void tst_Bench_QModbusPdu::responseDataSize()
+{
+    QFETCH(QModbusPdu::FunctionCode, code);
+    QFETCH(QByteArray, data);
+
+    const QModbusResponse response(code, data);
+    int size = 0;
+
+    QBENCHMARK {
+        size = QModbusResponse::calculateDataSize(response);
+    }
+    QCOMPARE(size, data.size());
+}
+
+QTEST_MAIN(tst_Bench_QModbusPdu)
+
+#include "tst_bench_qmodbuspdu.moc"
@@ -0,0 +1,156 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtSerialBus/qmodbusserver.h>
+
+#include <QtTest/QtTest>
+
+Q_DECLARE_METATYPE(QModbusPdu::FunctionCode)
+
+class BenchServer : public QModbusServer
+{
+public:
+    bool open() override {
+        setState(QModbusDevice::ConnectedState);
+        return true;
+    }
+    void close() override {
+        setState(QModbusDevice::UnconnectedState);
+    }
+    QModbusResponse processRequest(const QModbusPdu &request) override
+    {
+        return QModbusServer::processRequest(request);
+    }
+};
+
+static QByteArray registerPayload(int count)
+{
+    QByteArray payload;
+    payload.reserve(count * 2);
+    for (int i = 0; i < count; ++i)
+        payload.append(char(i >> 8)).append(char(i));
+    return payload;
+}
+
+class tst_Bench_QModbusServer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void processRequest_data();
+    void processRequest();
+};
+
+void tst_Bench_QModbusServer::processRequest_data()
+{
+    QTest::addColumn<int>("mapSize");
+    QTest::addColumn<QModbusPdu::FunctionCode>("code");
+    QTest::addColumn<QByteArray>("data");
+
+    // All requests address 0x0100, so that they fit into every map size below.
+    const struct {
+        QModbusPdu::FunctionCode code;
+        const char *name;
+        QByteArray data;
+    } requests[] = {
+        { QModbusPdu::ReadCoils, "ReadCoils", QByteArray::fromHex("01000320") },
+        { QModbusPdu::ReadDiscreteInputs, "ReadDiscreteInputs", QByteArray::fromHex("01000320") },
+        { QModbusPdu::ReadHoldingRegisters, "ReadHoldingRegisters",
+          QByteArray::fromHex("0100007d") },
+        { QModbusPdu::ReadInputRegisters, "ReadInputRegisters", QByteArray::fromHex("0100007d") },
+        { QModbusPdu::WriteSingleCoil, "WriteSingleCoil", QByteArray::fromHex("0100ff00") },
+        { QModbusPdu::WriteSingleRegister, "WriteSingleRegister",
+          QByteArray::fromHex("01001234") },
+        { QModbusPdu::ReadExceptionStatus, "ReadExceptionStatus", QByteArray() },
+        { QModbusPdu::Diagnostics, "Diagnostics", QByteArray::fromHex("0000a537") },
+        { QModbusPdu::GetCommEventCounter, "GetCommEventCounter", QByteArray() },
+        { QModbusPdu::GetCommEventLog, "GetCommEventLog", QByteArray() },
+        { QModbusPdu::WriteMultipleCoils, "WriteMultipleCoils",
+          QByteArray::fromHex("0100001002ffff") },
+        { QModbusPdu::WriteMultipleRegisters, "WriteMultipleRegisters",
+          QByteArray::fromHex("0100007bf6").append(registerPayload(123)) },
+        { QModbusPdu::ReportServerId, "ReportServerId", QByteArray() },
+        { QModbusPdu::MaskWriteRegister, "MaskWriteRegister",
+          QByteArray::fromHex("010000f20025") },
+        { QModbusPdu::ReadWriteMultipleRegisters, "ReadWriteMultipleRegisters",
+          QByteArray::fromHex("0100007d02000079f2").append(registerPayload(121)) },
+        { QModbusPdu::ReadFifoQueue, "ReadFifoQueue", QByteArray::fromHex("0100") }
+    };
+
+    static const int mapSizes[] = { 2000, 10000 };
+    for (int mapSize : mapSizes) {
+        for (const auto &request : requests) {
+            QTest::newRow(QByteArray(request.name + QByteArray(" map ")
+                + QByteArray::number(mapSize)).constData())
+                << mapSize << request.code << request.data;
+        }
+    }
+}
+
+void tst_Bench_QModbusServer::processRequest()
+{
+    QFETCH(int, mapSize);
+    QFETCH(QModbusPdu::FunctionCode, code);
+    QFETCH(QByteArray, data);
+
+    BenchServer server;
+    QModbusDataUnitMap map;
+    map.insert(QModbusDataUnit::Coils, { QModbusDataUnit::Coils, 0, quint16(mapSize) });
+    map.insert(QModbusDataUnit::DiscreteInputs,
+               { QModbusDataUnit::DiscreteInputs, 0, quint16(mapSize) });
+    map.insert(QModbusDataUnit::HoldingRegisters,
+               { QModbusDataUnit::HoldingRegisters, 0, quint16(mapSize) });
+    map.insert(QModbusDataUnit::InputRegisters,
+               { QModbusDataUnit::InputRegisters, 0, quint16(mapSize) });
+    QVERIFY(server.setMap(map));
+    QVERIFY(server.connectDevice());
+
+    // the FIFO count of ReadFifoQueue lives in the addressed holding register
+    QVERIFY(server.setData(QModbusDataUnit::HoldingRegisters, 0x0100, 31));
+
+    const QModbusRequest request(code, data);
+    QModbusResponse response;
+
+    QBENCHMARK {
+        response = server.processRequest(request);
+    }
+    QVERIFY2(!response.isException(), qPrintable(QString::number(response.exceptionCode())));
+    QCOMPARE(response.functionCode(), code);
+}
+
+QTEST_MAIN(tst_Bench_QModbusServer)
+
+#include "tst_bench_qmodbusserver.moc"
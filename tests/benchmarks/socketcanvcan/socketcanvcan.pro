@@ -0,0 +1,7 @@
+QT = core testlib serialbus
+TARGET = tst_bench_socketcanvcan
+CONFIG += benchmark c++11
+
+CONFIG -= app_bundle
+
+SOURCES += tst_bench_socketcanvcan.cpp
@@ -0,0 +1,255 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtSerialBus/qcanbus.h>
+#include <QtSerialBus/qcanbusdevice.h>
+#include <QtSerialBus/qcanbusframe.h>
+
+#include <QtCore/qdir.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qprocess.h>
+#include <QtCore/qscopedpointer.h>
+#include <QtTest/QtTest>
+
+#include <algorithm>
+
+#include <sys/resource.h>
+#include <sys/time.h>
+
+/*
+    Drives the socketcan backend over a virtual CAN interface.
+
+    The interface name is taken from QT_CANBUS_BENCH_INTERFACE (default: vcan0).
+    If it does not exist the benchmark tries to create it with "ip link", which
+    requires CAP_NET_ADMIN. All test functions are skipped when neither works.
+
+    One device sends paced batches of frames and a second device on the same
+    interface receives them. Reported are the sustained receive rate, dropped
+    frames, CPU time per frame, the latency from the kernel receive timestamp
+    to readFrame() and the ratio of framesWritten() confirmations to sent frames.
+*/
+
+static qint64 cpuTimeUs()
+{
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return qint64(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000
+        + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static qint64 wallClockUs()
+{
+    timeval now;
+    gettimeofday(&now, nullptr);
+    return qint64(now.tv_sec) * 1000000 + now.tv_usec;
+}
+
+static double percentile(QVector<qint64> &sorted, double p)
+{
+    if (sorted.isEmpty())
+        return 0.;
+    const int index = qBound(0, int(p * sorted.size() + 0.999999) - 1, sorted.size() - 1);
+    return sorted.at(index);
+}
+
+class tst_Bench_SocketCanVcan : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void throughput_data();
+    void throughput();
+
+private:
+    bool interfaceExists() const;
+    QCanBusDevice *createDevice(bool canFd);
+
+    QString interfaceName;
+    bool createdInterface = false;
+    bool available = false;
+};
+
+bool tst_Bench_SocketCanVcan::interfaceExists() const
+{
+    return QDir(QStringLiteral("/sys/class/net/") + interfaceName).exists();
+}
+
+void tst_Bench_SocketCanVcan::initTestCase()
+{
+    interfaceName = QString::fromLocal8Bit(qgetenv("QT_CANBUS_BENCH_INTERFACE"));
+    if (interfaceName.isEmpty())
+        interfaceName = QStringLiteral("vcan0");
+
+    if (!QCanBus::instance()->plugins().contains("socketcan"))
+        return;
+
+    if (!interfaceExists()) {
+        const int added = QProcess::execute(QStringLiteral("ip"),
+            { QStringLiteral("link"), QStringLiteral("add"), QStringLiteral("dev"),
+              interfaceName, QStringLiteral("type"), QStringLiteral("vcan") });
+        createdInterface = (added == 0);
+    }
+    if (!interfaceExists())
+        return;
+
+    QProcess::execute(QStringLiteral("ip"), { QStringLiteral("link"), QStringLiteral("set"),
+                                              QStringLiteral("up"), interfaceName });
+
+    QScopedPointer<QCanBusDevice> probe(createDevice(false));
+    available = probe && probe->state() == QCanBusDevice::ConnectedState;
+}
+
+void tst_Bench_SocketCanVcan::cleanupTestCase()
+{
+    if (createdInterface) {
+        QProcess::execute(QStringLiteral("ip"), { QStringLiteral("link"), QStringLiteral("del"),
+                                                  interfaceName });
+    }
+}
+
+QCanBusDevice *tst_Bench_SocketCanVcan::createDevice(bool canFd)
+{
+    QCanBusDevice *device = QCanBus::instance()->createDevice("socketcan", interfaceName);
+    if (!device)
+        return nullptr;
+    device->setConfigurationParameter(QCanBusDevice::CanFdKey, canFd);
+    device->connectDevice();
+    return device;
+}
+
+void tst_Bench_SocketCanVcan::throughput_data()
+{
+    QTest::addColumn<bool>("canFd");
+    QTest::addColumn<int>("rate");
+    QTest::addColumn<int>("frameCount");
+
+    static const int rates[] = { 1000, 10000, 50000, 100000, 0 };
+    for (int rate : rates) {
+        const QByteArray rateName = rate ? QByteArray::number(rate) : QByteArray("unpaced");
+        QTest::newRow(("classic " + rateName).constData()) << false << rate << 50000;
+        QTest::newRow(("fd " + rateName).constData()) << true << rate << 50000;
+    }
+}
+
+void tst_Bench_SocketCanVcan::throughput()
+{
+    if (!available)
+        QSKIP("No usable virtual CAN interface; set QT_CANBUS_BENCH_INTERFACE or run with CAP_NET_ADMIN.");
+
+    QFETCH(bool, canFd);
+    QFETCH(int, rate);
+    QFETCH(int, frameCount);
+
+    QScopedPointer<QCanBusDevice> sender(createDevice(canFd));
+    QScopedPointer<QCanBusDevice> receiver(createDevice(canFd));
+    QVERIFY(sender && sender->state() == QCanBusDevice::ConnectedState);
+    QVERIFY(receiver && receiver->state() == QCanBusDevice::ConnectedState);
+
+    QCanBusFrame frame(0x123, QByteArray(canFd ? 64 : 8, '\x5a'));
+
+    int sent = 0;
+    int sendFailures = 0;
+    qint64 confirmed = 0;
+    int received = 0;
+    QVector<qint64> latencies;
+    latencies.reserve(frameCount);
+
+    connect(sender.data(), &QCanBusDevice::framesWritten, [&confirmed](qint64 count) {
+        confirmed += count;
+    });
+    connect(receiver.data(), &QCanBusDevice::framesReceived, [&]() {
+        while (receiver->framesAvailable() > 0) {
+            const QCanBusFrame in = receiver->readFrame();
+            const QCanBusFrame::TimeStamp stamp = in.timeStamp();
+            const qint64 kernelUs = stamp.seconds() * 1000000 + stamp.microSeconds();
+            if (kernelUs > 0)
+                latencies.append(wallClockUs() - kernelUs);
+            ++received;
+        }
+    });
+
+    // send in 1 ms slots; an unpaced run sends everything in one burst per slot
+    const int perSlot = rate ? qMax(1, rate / 1000) : frameCount;
+    QTimer pacer;
+    pacer.setInterval(1);
+    connect(&pacer, &QTimer::timeout, [&]() {
+        for (int i = 0; i < perSlot && sent + sendFailures < frameCount; ++i) {
+            if (sender->writeFrame(frame))
+                ++sent;
+            else
+                ++sendFailures;
+        }
+        if (sent + sendFailures >= frameCount)
+            pacer.stop();
+    });
+
+    const qint64 cpuStart = cpuTimeUs();
+    QElapsedTimer clock;
+    clock.start();
+    pacer.start();
+
+    // wait until all frames arrived or no progress has been made for a while
+    int lastReceived = -1;
+    while (received < sent || pacer.isActive()) {
+        QTest::qWait(50);
+        if (!pacer.isActive() && received == lastReceived)
+            break;
+        lastReceived = received;
+    }
+
+    const qint64 elapsedUs = clock.nsecsElapsed() / 1000;
+    const qint64 cpuUs = cpuTimeUs() - cpuStart;
+
+    std::sort(latencies.begin(), latencies.end());
+    const double rxRate = elapsedUs ? received * 1e6 / elapsedUs : 0.;
+
+    qDebug("sent %d, send failures %d, received %d, dropped %d, rx %.0f frames/s, "
+           "cpu %.2f us/frame, rx latency p50 %.0f us p99 %.0f us, tx completion %.1f%%",
+           sent, sendFailures, received, sent - received, rxRate,
+           received ? double(cpuUs) / received : 0.,
+           percentile(latencies, 0.50), percentile(latencies, 0.99),
+           sent ? 100. * confirmed / sent : 0.);
+
+    QTest::setBenchmarkResult(rxRate, QTest::FramesPerSecond);
+}
+
+QTEST_MAIN(tst_Bench_SocketCanVcan)
+
+#include "tst_bench_socketcanvcan.moc"